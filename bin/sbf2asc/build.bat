@@ -3,4 +3,7 @@ Rem Microsoft Visual C++ Compiler
 Rem (c) 2000-2016 Copyright Septentrio NV/SA. All rights reserved.
 
 
-cl -Ox -DNO_DECRYPTION -EHsc sbf2asc.c sbfread.c sbfread_meas.c sbfsvid.c ssngetop.c crc.c mscssntypes.c
+cl -Ox -DNO_DECRYPTION -EHsc sbf2asc.c sbfread.c sbfread_meas.c sbfread_pool.c sbfread_alloc.c sbfout.c sbfarrow.c sbfparquet.c sbfmeasspec.c sbfconsumer.c sbfs4.c sbfplot.c sbfshm.c sbfbatch.c sbfcompress.c sbfrinex.c sbfrinexnav.c sbftime.c sbfsvid.c ssngetop.c crc.c mscssntypes.c
+
+Rem The decoder as a DLL for other languages (see sbfread_lib.h)
+cl -Ox -DNO_DECRYPTION -DSBFREAD_LIB_BUILD -LD sbfread_lib.c sbfread.c sbfread_meas.c sbfread_pool.c sbfread_alloc.c sbfsvid.c crc.c sbfmeasspec.c sbfout.c sbfcompress.c sbftime.c mscssntypes.c -Fesbfread.dll
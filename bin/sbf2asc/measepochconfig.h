@@ -21,11 +21,20 @@
 /* when converting a Measurement SBF block into MeasEpoch_t, support up to
    100 logical channels (a logical channel contains all measurements
    for a given satellite), 3 antennas and up to 8
-   signals per satellite. */
+   signals per satellite.  These dimensions can be reduced at build
+   time (e.g. -DNR_OF_ANTENNAS=1 for single-antenna receivers); the
+   library and the application must then be built with the same
+   values. */
+#ifndef NR_OF_LOGICALCHANNELS
 #define NR_OF_LOGICALCHANNELS           100
+#endif
 
+#ifndef NR_OF_ANTENNAS
 #define NR_OF_ANTENNAS                    3
+#endif
 
+#ifndef MAX_NR_OF_SIGNALS_PER_SATELLITE
 #define MAX_NR_OF_SIGNALS_PER_SATELLITE   8
+#endif
 
 #endif
@@ -20,10 +20,25 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <math.h>
+#include <errno.h>
 
 #include "ssngetop.h"
 #include "sbfread.h"
+#include "sbfout.h"
+#include "sbfarrow.h"
+#include "sbfparquet.h"
+#include "sbfmeasspec.h"
+#include "sbfconsumer.h"
+#include "sbfs4.h"
+#include "sbfplot.h"
+#include "sbfshm.h"
+#include "sbfbatch.h"
+#include "sbfcompress.h"
+#include "sbfrinex.h"
+#include "sbfrinexnav.h"
+#include "sbftime.h"
 #include "sbf2asc_version.h"
+#include "sbf2asc_profiles.h"
 
 static uint32_t OutputPVTcar            = 0;
 static uint32_t OutputPVTgeo            = 0;
@@ -45,13 +60,84 @@ static uint32_t VerboseMode             = 0;
 static uint32_t TimerCounters[2]        = {0, 0};
 static bool     AcceptInvalidTime       = true;
 
+/* format of the output file (-F option) */
+#define OUTPUTFORMAT_ASCII      0
+#define OUTPUTFORMAT_ARROW      1
+#define OUTPUTFORMAT_PARQUET    2
+
+static uint32_t OutputFormat            = OUTPUTFORMAT_ASCII;
+
+/* selection of the observables written in the ascii format (-C
+   option), used instead of the fixed columns of PrintMeasEpoch() */
+static bool          UseMeasSpec        = false;
+static sbfmeasspec_t MeasSpec;
+
+/* format of the time column of the text outputs (-Z option) */
+static sbftime_Format_t TimeFormat      = SBFTIME_GPS;
+
+/* S4 scintillation index (-O s4=file), computed from the C/N0 of the
+   same signals as the column selection used by data.py */
+#define S4_SIGNALS  "wide:cn0/GPSL1CA+GLOL1CA+GALE1BC+BDSB1I"
+
+static uint32_t OutputS4                = 0;
+
+/* downsampled series of an observable for plotting (-O plot=file), as
+   given by the -P option */
+#define PLOT_DEFAULT  "lttb:2000:cn0"
+
+static uint32_t    OutputPlot           = 0;
+static const char* PlotSpec             = PLOT_DEFAULT;
+static sbfplot_t   Plot;
+
+/* decoded measurement epochs published in a shared memory ring for
+   the local processes (-O shm=/name) */
+static uint32_t OutputShm               = 0;
+
+/* RINEX observation and navigation files (-O rinexobs=file and -O
+   rinexnav=file), in the RINEX version of the -R option */
+static uint32_t OutputRinexObs          = 0;
+static uint32_t OutputRinexNav          = 0;
+static uint32_t RinexVersion            = 3;
+
+/* outputs written to their own file (-O option) instead of the -o
+   file, and the files opened for the outputs (at most one per
+   output) */
+#define MAX_OUTPUTFILES  20
+
+static struct
+{
+    char              Name[16];
+    char              FileName[256];
+} OutputFileNames[MAX_OUTPUTFILES];
+
+static uint32_t NrOfOutputFileNames     = 0;
+
+typedef struct
+{
+    const char*       FileName;
+    FILE*             F;
+    bool              Binary;    /* Arrow or Parquet file */
+    uint32_t          NrOfOutputs;
+    sbfout_Stream_t   Out;       /* text files only */
+} OutputFile_t;
+
+/* number of threads formatting the measurements in the text formats
+   (-T option), or 0 to format them in the main thread */
+static uint32_t NrOfFormatThreads       = 0;
+
 static const char usage_msg1[] = "\n"
                                  "sbf2asc -f input_file [-o output_file]\n"
                                  "        [-m][-p][-g][-c][-d][-a][-s]\n"
-                                 "        [-b startepoch][-e endepoch][-i Interval][-v][-V]\n"
+                                 "        [-b startepoch][-e endepoch][-i Interval][-F format][-C columns]\n"
+                                 "        [-O output=file][-P plot][-R version][-T threads][-Z time]\n"
+                                 "        [-v][-V]\n"
                                  "  -f input_file:  (mandatory) Name of the SBF file.\n"
                                  "  -o output_file: Name of the ascii file\n"
-                                 "                   (if not provided, measasc.dat is used).\n"
+                                 "                   (if not provided, measasc.dat is used, or\n"
+                                 "                   measasc.arrow or measasc.parquet with -F).\n"
+                                 "                   The text files (also with -O) ending in .gz or\n"
+                                 "                   .zst are compressed in gzip or zstd format, in\n"
+                                 "                   builds with compression (see the Makefile).\n"
                                  "  -m              Include contents of the MeasEpoch and/or Meas3 blocks.\n"
                                  "  -p              Include contents of the PVTCartesian blocks.\n"
                                  "  -g              Include contents of the PVTGeodetic blocks.\n"
@@ -74,6 +160,66 @@ static const char usage_msg1[] = "\n"
                                  "                  Format: yyyy-mm-dd_hh:mm:ss.sss or hh:mm:ss.sss.\n"
                                  "  -i Interval:    Decimation interval in seconds.\n"
                                  "  -E              Exclude blocks where time stamp is invalid.\n"
+                                 "  -F format       Format of the output file:\n"
+                                 "                    asc:   columns of plain text (default)\n"
+                                 "                    arrow: Apache Arrow IPC file (Feather v2), with\n"
+                                 "                           the measurements only (-m), see below.\n"
+                                 "                    parquet: Apache Parquet file, with the\n"
+                                 "                           measurements of all signals (-m),\n"
+                                 "                           see below.\n"
+                                 "  -C columns      Observables written for each measurement epoch (implies\n"
+                                 "                  -m, -F asc only), as [long:|wide:]FIELDS[/SIGNALS]:\n"
+                                 "                    FIELDS:  comma-separated list of pr, l, doppler, cn0,\n"
+                                 "                             locktime, flags, mp, carriermp, prvar, lvar,\n"
+                                 "                             or all.\n"
+                                 "                    SIGNALS: comma-separated signal groups, each made of\n"
+                                 "                             signal types (GPSL1CA, GALE5a, ...) or\n"
+                                 "                             constellations (GPS, GLO, GAL, BDS, SBS,\n"
+                                 "                             QZS, IRN, MSS) joined by '+' (default: all).\n"
+                                 "                  long: (default) one row per signal: PRN identifier,\n"
+                                 "                  time, signal type and FIELDS.\n"
+                                 "                  wide: one row per satellite: PRN identifier, time, and\n"
+                                 "                  FIELDS for the first available signal of each group.\n"
+                                 "                  Only the selected observables are decoded.\n"
+                                 "                  Example: -C wide:cn0/GPSL1CA+GLOL1CA+GALE1BC+BDSB1I\n"
+                                 "  -O output=file  Write an output to its own file instead of the ascii\n"
+                                 "                  file, and enable it.  output is one of meas, pvtcar,\n"
+                                 "                  pvtgeo, pvtcov, dop, atteuler, attcoveuler, extevent,\n"
+                                 "                  rxstatus, basestation, baseline, baselink, gpsalm,\n"
+                                 "                  auxpos, extsensor, insnavgeod (-m, -p, -g,... above),\n"
+                                 "                  s4: S4 scintillation index, see below,\n"
+                                 "                  plot: downsampled series for plotting (-P),\n"
+                                 "                  shm: decoded epochs in shared memory, see below,\n"
+                                 "                  rinexobs: RINEX observation file, or\n"
+                                 "                  rinexnav: RINEX navigation file.  All the outputs\n"
+                                 "                  are written in one pass over the SBF file.\n"
+                                 "                  With -F arrow or parquet, the other outputs need -O.\n"
+                                 "                  Example: -m -O pvtgeo=pvt.dat -O s4=s4.dat\n"
+                                 "  -P plot         Series of the plot output, as\n"
+                                 "                  [lttb:|minmax:]POINTS[:FIELD[/SIGNALS]]: each\n"
+                                 "                  signal of each satellite is downsampled to POINTS\n"
+                                 "                  points, with Largest-Triangle-Three-Buckets (lttb,\n"
+                                 "                  default) or the smallest and largest value of\n"
+                                 "                  POINTS/2 intervals (minmax).  FIELD and SIGNALS\n"
+                                 "                  are as in -C (default: cn0 of all the signals).\n"
+                                 "                  Default: " PLOT_DEFAULT "\n"
+                                 "  -R version      RINEX version of rinexobs and rinexnav: 3 (3.04,\n"
+                                 "                  default) or 4\n"
+                                 "                  (4.00).\n"
+                                 "  -T threads      Number of threads formatting the measurements (-m, -C)\n"
+                                 "                  in the asc format while the SBF file is decoded, when\n"
+                                 "                  they are written to their own file, and number of\n"
+                                 "                  threads compressing each .gz or .zst file.  Default:\n"
+                                 "                  0, the main thread does it all.  Needs a build with\n"
+                                 "                  threads (see the Makefile).\n"
+                                 "  -Z time         Format of the time column (Col2) of the text outputs:\n"
+                                 "                    gps:   GPS seconds since Jan 06, 1980 (default)\n"
+                                 "                    gpsns: GPS nanoseconds since Jan 06, 1980\n"
+                                 "                    utcns: UTC nanoseconds since Jan 01, 1970 (Unix\n"
+                                 "                           time, leap seconds from a built-in table)\n"
+                                 "                    iso:   UTC as yyyy-mm-ddThh:mm:ss.ssZ\n"
+                                 "                  With utcns or iso, the arrow and parquet files have\n"
+                                 "                  a utc_ns column (int64) after the others.\n"
                                  "  -v              Verbose mode, progress displayed.\n"
                                  "  -V              Display the sbf2asc version.\n"
                                  "\n"
@@ -106,6 +252,64 @@ static const char usage_msg2[] =
     "Col8:  CNj C/N0 in dB-Hz, or -20000000000 if not available\n"
     "       j is L2P,L2CA,E5a,B2 for GPS, GLO, GAL and BDS respectively\n"
     "\n"
+    "With -F arrow, the same rows are written as the columns:\n"
+    "gps_ns:   time in nanoseconds since Jan 06, 1980 (int64)\n"
+    "svid:     PRN identifier (uint8)\n"
+    "sat:      satellite name, such as G01 or E05 (dictionary-encoded string)\n"
+    "pr1_m, l1_cyc, cn1_dbhz: Pi, Li (float64) and CNi (float32)\n"
+    "pr2_m, l2_cyc, cn2_dbhz: Pj, Lj (float64) and CNj (float32)\n"
+    "The observables that are not available are null.\n"
+    "\n"
+    "With -F parquet, each row holds the observables of one signal of a\n"
+    "satellite (main antenna), in one row group per hour, with the columns:\n"
+    "gps_ns:     time in nanoseconds since Jan 06, 1980 (int64)\n"
+    "svid:       PRN identifier (uint8)\n"
+    "signal:     signal type, such as GPSL1CA or GALE5a (string)\n"
+    "pr_m:       pseudorange in meters (double)\n"
+    "l_cyc:      carrier phase in cycles (double)\n"
+    "doppler_hz: Doppler in Hz (float)\n"
+    "cn0_dbhz:   C/N0 in dB-Hz (float)\n"
+    "The observables that are not available are null.\n"
+    "\n"
+    "s4: S4 scintillation index (-O s4=file), for each minute\n"
+    "Col1:  PRN identifier\n"
+    "Col2:  start of the minute (GPS second since Jan 06, 1980)\n"
+    "Col3:  S4, the standard deviation of the signal-to-noise ratio 10^(CN/10)\n"
+    "       divided by its mean, with CN the C/N0 of L1CA, L1CA, E1 or B1I\n"
+    "       for GPS, GLO, GAL and BDS respectively\n"
+    "Col4:  number of C/N0 samples in the minute (at least 2)\n"
+    "\n"
+    "plot: downsampled series (-O plot=file), the rows of each signal of\n"
+    "each satellite together, written at the end\n"
+    "Col1:  PRN identifier\n"
+    "Col2:  time (GPS second since Jan 06, 1980)\n"
+    "Col3:  signal type\n"
+    "Col4:  FIELD of -P\n"
+    "The smallest and largest values of each interval are kept while the\n"
+    "SBF file is read, so that the spikes of the series are kept in the\n"
+    "POINTS points.\n"
+    "\n"
+    "shm: shared memory (-O shm=/name, in builds with SBFSHM, see the\n"
+    "Makefile): a ring of the last 256 decoded measurement epochs, with all\n"
+    "their valid observables, published as they are decoded for any number\n"
+    "of local readers.  The readers never hold back sbf2asc: a reader that\n"
+    "falls behind is told how many epochs it lost.  See sbfshm.h for the\n"
+    "layout and the functions reading it.  The object is left at the end\n"
+    "(in /dev/shm on Linux), marked as closed.\n"
+    "\n"
+    "rinexobs: RINEX observation file (-O rinexobs=file), with the code,\n"
+    "phase, Doppler and C/N0 of all the signals of the main antenna.  The\n"
+    "header lists the observation types found in the file, and takes the\n"
+    "marker, receiver and antenna from the ReceiverSetup block, and the\n"
+    "approximate position from the first PVTCartesian block, if any.\n"
+    "\n"
+    "rinexnav: RINEX navigation file (-O rinexnav=file), with the GPS,\n"
+    "Galileo, GLONASS, BeiDou and QZSS ephemerides of the GPSNav, GALNav,\n"
+    "GLONav, BDSNav and QZSNav blocks, each written once, in the order of\n"
+    "their time of clock, and the ionosphere and UTC parameters of the\n"
+    "GPSIon, GPSUtc, GALIon, GALUtc, GALGstGps, GLOTime, BDSIon and BDSUtc\n"
+    "blocks (in the header with RINEX 3).\n"
+    "\n"
     "0: PVTCartesian block\n"
     "Col1:  0\n"
     "Col2:  time (GPS second since Jan 06, 1980)\n"
@@ -309,744 +513,1713 @@ static void DisplayProgress(SBFData_t* SBFData)
 }
 
 
+/* observables of the two signals written for each satellite */
+typedef struct
+{
+    double Pi, Li, CNi;
+    double Pj, Lj, CNj;
+} MeasRow_t;
+
+
 /*---------------------------------------------------------------------------*/
-static void PrintMeasEpoch(FILE*          F,
-                           const MeasEpoch_t* const MeasEpoch)
+/* Get the observables of the signals i and j of a satellite.  Returns
+ * false if no pseudorange is available, in which case the satellite is
+ * not written. */
+static bool GetMeasRow(const MeasChannel_t* const ChannelData,
+                       MeasRow_t*                 Row)
 {
-    uint32_t i;
+    uint32_t SigIdx;
 
-    double CurrentTime
-        = (double)MeasEpoch->WNc * (86400.0 * 7.0)
-          + (double)MeasEpoch->TOW_ms / 1000.0;
+    Row->Pi  = F64_NOTVALID;
+    Row->Pj  = F64_NOTVALID;
+    Row->Li  = F64_NOTVALID;
+    Row->Lj  = F64_NOTVALID;
+    Row->CNi = F32_NOTVALID;
+    Row->CNj = F32_NOTVALID;
 
-    /* go through all the available satellites */
-    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    /* go through all the signals available on the main antenna (antenna index 0) */
+    for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
     {
-        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
-        double Pi  = F64_NOTVALID;
-        double Pj  = F64_NOTVALID;
-        double Li  = F64_NOTVALID;
-        double Lj  = F64_NOTVALID;
-        double CNi = F32_NOTVALID;
-        double CNj = F32_NOTVALID;
-        uint32_t SigIdx;
-
-        /* go through all the signals available on the main antenna (antenna index 0) */
-        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+
+        if (MeasSet->flags != 0)
         {
-            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+            SignalType_t SignalType = (SignalType_t)MeasSet->signalType;
 
-            if (MeasSet->flags != 0)
+            /* get the first observables (for signal i) */
+            if (SignalType == SIG_GPSL1CA || SignalType == SIG_GLOL1CA || SignalType == SIG_GALE1BC || SignalType == SIG_BDSB1I)
             {
-                SignalType_t SignalType = (SignalType_t)MeasSet->signalType;
+                Row->Pi  = MeasSet->PR_m;
+                Row->Li  = MeasSet->L_cycles;
+                Row->CNi = MeasSet->CN0_dBHz;
 
-                /* get the first observables (for signal i) */
-                if (SignalType == SIG_GPSL1CA || SignalType == SIG_GLOL1CA || SignalType == SIG_GALE1BC || SignalType == SIG_BDSB1I)
+                /* discard carrier phases with half-cycle ambiguities */
+                if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
                 {
-                    Pi  = MeasSet->PR_m;
-                    Li  = MeasSet->L_cycles;
-                    CNi = MeasSet->CN0_dBHz;
-
-                    /* discard carrier phases with half-cycle ambiguities */
-                    if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
-                    {
-                        Li = F64_NOTVALID;
-                    }
+                    Row->Li = F64_NOTVALID;
                 }
-                /* get the second observables (for signal j) */
-                else if (SignalType == SIG_GPSL2P || SignalType == SIG_GLOL2CA || SignalType == SIG_GALE5a || SignalType == SIG_BDSB2I)
+            }
+            /* get the second observables (for signal j) */
+            else if (SignalType == SIG_GPSL2P || SignalType == SIG_GLOL2CA || SignalType == SIG_GALE5a || SignalType == SIG_BDSB2I)
+            {
+                Row->Pj  = MeasSet->PR_m;
+                Row->Lj  = MeasSet->L_cycles;
+                Row->CNj = MeasSet->CN0_dBHz;
+
+                /* discard carrier phases with half-cycle ambiguities */
+                if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
                 {
-                    Pj  = MeasSet->PR_m;
-                    Lj  = MeasSet->L_cycles;
-                    CNj = MeasSet->CN0_dBHz;
-
-                    /* discard carrier phases with half-cycle ambiguities */
-                    if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
-                    {
-                        Lj = F64_NOTVALID;
-                    }
+                    Row->Lj = F64_NOTVALID;
                 }
             }
         }
-
-        /* print a row only if at least one pseudorange is available for
-           this satellite */
-        if (Pi != F64_NOTVALID || Pj != F64_NOTVALID)
-        {
-            /* see row format in the usage message at the beginning of this file */
-            fprintf(F, "%03d %12.2f %16.3f %16.3f %16.3f %16.3f %16.3f %16.3f\n",
-                    (int)convertSVIDtoSBF(ChannelData->PRN),
-                    CurrentTime,
-                    Pi, Li, CNi,
-                    Pj, Lj, CNj
-                   );
-        }
     }
+
+    return (Row->Pi != F64_NOTVALID || Row->Pj != F64_NOTVALID);
 }
 
 
 /*---------------------------------------------------------------------------*/
-/* Print a DOP field, 15 characters on "F":
- * either "DOP" divided by 100, right-aligned in a 14 char field,
- * or "            NA " if the DOP is not available (value 0). */
-static void PrintPvtDopField(FILE* F, uint16_t DOP)
+/* Write the time column (Col2) of a row to Text, in the format of the
+ * -Z option: the GPS seconds Time_s in a Width-char field with
+ * Decimals decimals by default, or else GPSTime_ns (GPS ns since Jan
+ * 06, 1980) converted by sbftime_Print(), with Decimals decimals in
+ * the ISO format.  Returns Text. */
+static const char* FormatTime(char     Text[SBFTIME_TEXT_SIZE],
+                              int      Width,
+                              int      Decimals,
+                              double   Time_s,
+                              int64_t  GPSTime_ns)
 {
-    if (DOP == 0)
+    if (TimeFormat == SBFTIME_GPS)
     {
-        fprintf(F, "            NA ");
+        (void)snprintf(Text, SBFTIME_TEXT_SIZE, "%*.*f", Width, Decimals, Time_s);
     }
     else
     {
-        fprintf(F, "%14.3f ", (float)DOP / 100.0);
+        (void)sbftime_Print(Text, TimeFormat, GPSTime_ns, (uint32_t)Decimals);
     }
+
+    return Text;
 }
 
+
 /*---------------------------------------------------------------------------*/
-/* Print a HPL or VPL field, 15 characters on "F":
- * either the "XPL", right-aligned in a 14 char field,
- * or "            NA " if the XPL is not available (smaller than -1e10). */
-static void PrintPvtXplField(FILE* F, float XPL)
+/* The Arrow and Parquet files have the utc_ns column (the last one)
+ * when the time is asked in UTC (-Z utcns or iso). */
+static bool HasUTCColumn(void)
 {
-    if (XPL <= -1e10)
-    {
-        fprintf(F, "            NA ");
-    }
-    else
-    {
-        fprintf(F, "%14.3f ", XPL);
-    }
+    return (TimeFormat == SBFTIME_UTCNS || TimeFormat == SBFTIME_ISO);
 }
 
+
 /*---------------------------------------------------------------------------*/
-static void PrintPvtDopLine(FILE* F, DOP_2_0_t* PVTDOP)
+static void PrintMeasEpoch(void*              Context,
+                           const MeasEpoch_t* const MeasEpoch)
 {
-    fprintf(F, "-3  ");
-    //Print the time
-    fprintf(F, "%13.2f ", (float)PVTDOP->WNc * 86400.0 * 7.0 + PVTDOP->TOW / 1000.0);
+    sbfout_Stream_t* Out = (sbfout_Stream_t*)Context;
+    char     Time[SBFTIME_TEXT_SIZE];
+    uint32_t i;
+
+    /* the time is the same for all the rows of the epoch */
+    double CurrentTime
+        = (double)MeasEpoch->WNc * (86400.0 * 7.0)
+          + (double)MeasEpoch->TOW_ms / 1000.0;
 
-    PrintPvtDopField(F, PVTDOP->PDOP);
-    PrintPvtDopField(F, PVTDOP->TDOP);
-    PrintPvtDopField(F, PVTDOP->HDOP);
-    PrintPvtDopField(F, PVTDOP->VDOP);
-    PrintPvtXplField(F, PVTDOP->HPL);
-    PrintPvtXplField(F, PVTDOP->VPL);
+    FormatTime(Time, 12, 2, CurrentTime,
+               sbftime_GetGPSTime_ns(MeasEpoch->WNc, MeasEpoch->TOW_ms));
 
-    fprintf(F, "%3i \n", (int)(PVTDOP->NrSV));
+    /* go through all the available satellites */
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        MeasRow_t Row;
+
+        /* print a row only if at least one pseudorange is available for
+           this satellite */
+        if (GetMeasRow(ChannelData, &Row))
+        {
+            /* see row format in the usage message at the beginning of this file */
+            sbfout_Printf(Out, "%03d %s %16.3f %16.3f %16.3f %16.3f %16.3f %16.3f\n",
+                          (int)convertSVIDtoSBF(ChannelData->PRN),
+                          Time,
+                          Row.Pi, Row.Li, Row.CNi,
+                          Row.Pj, Row.Lj, Row.CNj
+                         );
+        }
+    }
 }
 
 
 /*---------------------------------------------------------------------------*/
-static void CreateAsciiFile(char*     SBFFile,
-                            char*     AsciiFile,
-                            int64_t   ForcedFirstEpoch_ms,
-                            int64_t   ForcedLastEpoch_ms,
-                            int       ForcedInterval_ms)
+/* Columns of the measurements in the Arrow format (see the usage
+ * message).  The dictionary of the satellite names is filled in by
+ * InitArrowSatNames(). */
+#define ARROWCOL_TIME      0
+#define ARROWCOL_SVID      1
+#define ARROWCOL_SAT       2
+#define ARROWCOL_PI        3
+#define ARROWCOL_LI        4
+#define ARROWCOL_CNI       5
+#define ARROWCOL_PJ        6
+#define ARROWCOL_LJ        7
+#define ARROWCOL_CNJ       8
+#define ARROWCOL_UTC       9    /* with -Z utcns or iso only */
+#define NR_OF_ARROWCOLS    10
+
+static const char* ArrowSatNames[256];
+static uint16_t    ArrowSatIndex[256];
+
+static sbfarrow_Column_t ArrowMeasColumns[NR_OF_ARROWCOLS] =
 {
-    SBFData_t  SBFData;
-    uint8_t    SBFBlock[MAX_SBFSIZE];
-    FILE*      F;
+    {"gps_ns",   SBFARROW_INT64,   NULL,          0},
+    {"svid",     SBFARROW_UINT8,   NULL,          0},
+    {"sat",      SBFARROW_DICT16,  ArrowSatNames, 0},
+    {"pr1_m",    SBFARROW_FLOAT64, NULL,          0},
+    {"l1_cyc",   SBFARROW_FLOAT64, NULL,          0},
+    {"cn1_dbhz", SBFARROW_FLOAT32, NULL,          0},
+    {"pr2_m",    SBFARROW_FLOAT64, NULL,          0},
+    {"l2_cyc",   SBFARROW_FLOAT64, NULL,          0},
+    {"cn2_dbhz", SBFARROW_FLOAT32, NULL,          0},
+    {"utc_ns",   SBFARROW_INT64,   NULL,          0}
+};
 
-    /* initialize the data containers that will be used to decode the SBF blocks */
-    InitializeSBFDecoding(SBFFile, &SBFData);
 
-    /* Open the measurements file */
-    F = fopen(AsciiFile, "wt");
+/*---------------------------------------------------------------------------*/
+/* Build the dictionary of a string column from the names of the codes
+ * 0 to NrOfCodes-1: Names[] receives the distinct names, and Index[]
+ * the dictionary index of each code.  Returns the number of names. */
+static uint32_t InitDictionary(const char* (*GetName)(uint32_t),
+                               uint32_t    NrOfCodes,
+                               const char* Names[],
+                               uint16_t    Index[])
+{
+    uint32_t NrOfNames = 0;
+    uint32_t Code, i;
 
-    if (F == NULL)
+    for (Code = 0; Code < NrOfCodes; Code++)
     {
-        perror("Opening of output file failed");
-        return;
-    }
+        const char* Name = GetName(Code);
 
-
-    /* read all SBF blocks from the file, one by one */
-    while (GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
-                        START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
-    {
-        /* Only consider the blocks at the requested interval */
-        if (IncludeThisEpoch(SBFBlock,
-                             ForcedFirstEpoch_ms, ForcedLastEpoch_ms,
-                             ForcedInterval_ms,
-                             AcceptInvalidTime))
+        for (i = 0; i < NrOfNames; i++)
         {
-            if (OutputMeas == 1)
+            if (strcmp(Names[i], Name) == 0)
             {
-                MeasEpoch_t MeasEpoch;
-
-                /* Measurement blocks are collected and decoded using
-                   sbfread_MeasCollectAndDecode().  That function should be
-                   called for all SBF blocks in the file.  It collects all
-                   information from the measurement-related SBF blocks
-                   (MeasEpoch, MeasExtra, Meas3Ranges, Meas3Doppler,...) and
-                   it returns true when a complete measurement epoch is
-                   available. The decoded measurement epoch containing all
-                   observables from all satellites is provided in the
-                   MeasEpoch structure. */
-                if (sbfread_MeasCollectAndDecode(&SBFData, SBFBlock, &MeasEpoch, SBFREAD_ALLMEAS_ENABLED))
-                {
-                    PrintMeasEpoch(F, &MeasEpoch);
-                }
+                break;
             }
-            else
-                switch (SBF_ID_TO_NUMBER(((VoidBlock_t*)SBFBlock)->ID))
-                {
-                case sbfnr_PVTCartesian_1:
-                    if (OutputPVTcar == 1)
-                    {
-                        PVTCartesian_1_0_t* PVT = (PVTCartesian_1_0_t*)SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.3f %14.3f %14.3f %10.3f %10.3f"
-                                " %10.3f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
-                                0,
-                                (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
-                                PVT->X,
-                                PVT->Y,
-                                PVT->Z,
-                                PVT->Vx,
-                                PVT->Vy,
-                                PVT->Vz,
-                                PVT->RxClkBias,
-                                PVT->RxClkDrift,
-                                (int)(PVT->NrSV),
-                                (int)PVT->Mode,
-                                (int)PVT->MeanCorrAge,
-                                (int)PVT->Error,
-                                PVT->Cog
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_PVTCartesian_2:
-                    if (OutputPVTcar == 1)
-                    {
-                        PVTCartesian_2_0_t* PVT = (PVTCartesian_2_0_t*)SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.3f %14.3f %14.3f %10.3f %10.3f"
-                                " %10.3f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
-                                0,
-                                (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
-                                PVT->X,
-                                PVT->Y,
-                                PVT->Z,
-                                PVT->Vx,
-                                PVT->Vy,
-                                PVT->Vz,
-                                PVT->RxClkBias  > -1e10 ? PVT->RxClkBias * 1e-3  : -2e10,
-                                PVT->RxClkDrift > -1e10 ? PVT->RxClkDrift * 1e-6 : -2e10,
-                                (int)(PVT->NrSV),
-                                (int)PVT->Mode,
-                                (int)PVT->MeanCorrAge,
-                                (int)PVT->Error,
-                                PVT->COG
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_PVTGeodetic_1:
-                    if (OutputPVTgeo == 1)
-                    {
-                        PVTGeodetic_1_0_t* PVT = (PVTGeodetic_1_0_t*)SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.11f %15.11f %14.5f %14.5f %10.5f"
-                                " %10.5f %10.5f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
-                                -1,
-                                (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
-                                PVT->Lat,
-                                PVT->Lon,
-                                PVT->Alt,
-                                PVT->GeoidHeight,
-                                PVT->Vn,
-                                PVT->Ve,
-                                PVT->Vu,
-                                PVT->RxClkBias,
-                                PVT->RxClkDrift,
-                                (int)(PVT->NrSV),
-                                (int)PVT->Mode,
-                                (int)PVT->MeanCorrAge,
-                                (int)PVT->Error,
-                                PVT->Cog
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_PVTGeodetic_2:
-                    if (OutputPVTgeo == 1)
-                    {
-                        PVTGeodetic_2_0_t* PVT = (PVTGeodetic_2_0_t*)SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.11f %15.11f %14.5f %14.5f %10.5f"
-                                " %10.5f %10.5f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
-                                -1,
-                                (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
-                                PVT->Lat,
-                                PVT->Lon,
-                                PVT->Alt,
-                                PVT->Undulation,
-                                PVT->Vn,
-                                PVT->Ve,
-                                PVT->Vu,
-                                PVT->RxClkBias  > -1e10 ? PVT->RxClkBias * 1e-3  : -2e10,
-                                PVT->RxClkDrift > -1e10 ? PVT->RxClkDrift * 1e-6 : -2e10,
-                                (int)(PVT->NrSV),
-                                (int)PVT->Mode,
-                                (int)PVT->MeanCorrAge,
-                                (int)PVT->Error,
-                                PVT->COG
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_PosCovCartesian_1:
-                    if (OutputPVTCov == 1)
-                    {
-                        PosCovCartesian_1_0_t* PVTCOV = (PosCovCartesian_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.3f %14.3f %14.3f %14.3f"
-                                " 0 0 0 0 0 0 0 0\n",
-                                -2,
-                                (float)PVTCOV->WNc * 86400.0 * 7.0 + PVTCOV->TOW / 1000.0,
-                                PVTCOV->Cov_xx,
-                                PVTCOV->Cov_yy,
-                                PVTCOV->Cov_zz,
-                                PVTCOV->Cov_tt
-                               );
-                    }
-
-                    break;
-
-
-                case sbfnr_DOP_1:
-                    if (OutputDOP == 1)
-                    {
-                        PrintPvtDopLine(F, (DOP_2_0_t*)SBFBlock);
-                    }
-
-                    break;
-
-                case sbfnr_DOP_2:
-                    if (OutputDOP == 1)
-                    {
-                        PrintPvtDopLine(F, (DOP_2_0_t*)SBFBlock);
-                    }
-
-                    break;
-
-                case sbfnr_AttEuler_1:
-                    if (OutputAttEuler == 1)
-                    {
-                        AttEuler_1_0_t* ATTEULER = (AttEuler_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.5f %14.5f %14.5f"
-                                " %3u %3u %3u 0 0 0 0 0 0\n",
-                                -4,
-                                (float)ATTEULER->WNc * 86400.0 * 7.0 + ATTEULER->TOW / 1000.0,
-                                ATTEULER->Heading,
-                                ATTEULER->Pitch,
-                                ATTEULER->Roll,
-                                (unsigned int)(ATTEULER->Error),
-                                (unsigned int)ATTEULER->Mode,
-                                (unsigned int)(ATTEULER->NRSV)
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_AttCovEuler_1:
-                    if (OutputAttCovEuler == 1)
-                    {
-                        AttCovEuler_1_0_t* ATTCOVEULER = (AttCovEuler_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.2f %14.5f %14.5f %14.5f"
-                                " %3u 0 0 0 0 0 0 0 0\n",
-                                -5,
-                                (float)ATTCOVEULER->WNc * 86400.0 * 7.0 + ATTCOVEULER->TOW / 1000.0,
-                                ATTCOVEULER->Cov_HeadHead,
-                                ATTCOVEULER->Cov_PitchPitch,
-                                ATTCOVEULER->Cov_RollRoll,
-                                (unsigned int)(ATTCOVEULER->Error)
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_ExtEvent_1:
-                    if (OutputExtEvent == 1)
-                    {
-                        ExtEvent_1_0_t* EXTEVENT = (ExtEvent_1_0_t*) SBFBlock;
-
-                        TimerCounters[EXTEVENT->TimerData.Source - 1] += 1;
-
-                        fprintf(F, "%-2i %16.6f %4i %4i %16.6f 0 0 0 0 0 0 0 0 0\n",
-                                -6,
-                                (float)EXTEVENT->TimerData.WNc * 86400.0 * 7.0 + EXTEVENT->TimerData.TOW / 1000.0 + EXTEVENT->TimerData.Offset,
-                                (int)EXTEVENT->TimerData.Source,
-                                (int)TimerCounters[EXTEVENT->TimerData.Source - 1],
-                                (float)EXTEVENT->TimerData.Offset
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_ReceiverStatus_1:
-                    if (OutputReceiverStatus == 1)
-                    {
-                        ReceiverStatus_1_0_t* RXSTATUS = (ReceiverStatus_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.1f %3u %8u %x "
-                                "0 0 0 0 0 0 0 0 0 0 0\n",
-                                -7,
-                                (double)RXSTATUS->WNc * 86400.0 * 7.0 + RXSTATUS->TOW / 1000.0,
-                                (unsigned int)RXSTATUS->CPULoad,
-                                (unsigned int)RXSTATUS->UpTime,
-                                (unsigned int)RXSTATUS->RxStatus
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_ReceiverStatus_2:
-                    if (OutputReceiverStatus == 1)
-                    {
-                        ReceiverStatus_2_1_t* RXSTATUS = (ReceiverStatus_2_1_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.1f %3u %8u %x "
-                                "0 0 0 0 0 0 0 0 0 0 0\n",
-                                -7,
-                                (double)RXSTATUS->WNc * 86400.0 * 7.0 + RXSTATUS->TOW / 1000.0,
-                                (unsigned int)RXSTATUS->CPULoad,
-                                (unsigned int)RXSTATUS->UpTime,
-                                (unsigned int)RXSTATUS->RxStatus
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_BaseStation_1:
-                    if (OutputBaseStation == 1)
-                    {
-                        BaseStation_1_0_t* BASESTATION = (BaseStation_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.1f %5u %1u %1u %14.3f %14.3f %14.3f\n",
-                                -8,
-                                (float)BASESTATION->WNc * 86400.0 * 7.0 + BASESTATION->TOW / 1000.0,
-                                (unsigned int)BASESTATION->BaseStationID,
-                                (unsigned int)(BASESTATION->BaseType),
-                                (unsigned int)(BASESTATION->Source),
-                                BASESTATION->X_L1PhaseCenter,
-                                BASESTATION->Y_L1PhaseCenter,
-                                BASESTATION->Z_L1PhaseCenter
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_BaseLine_1:
-                    if (OutputBaseLine == 1)
-                    {
-                        BaseLine_1_0_t* BASELINE = (BaseLine_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.1f %4u %13.4f %13.4f %13.4f\n",
-                                -9,
-                                (float)BASELINE->WNc * 86400.0 * 7.0 + BASELINE->TOW / 1000.0,
-                                (unsigned int)BASELINE->BaseStationID,
-                                BASELINE->East,
-                                BASELINE->North,
-                                BASELINE->Up
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_BaseLink_1:
-                    if (OutputBaseLink == 1)
-                    {
-                        BaseLink_1_0_t* BASELINK = (BaseLink_1_0_t*) SBFBlock;
-                        fprintf(F, "%-2i %13.1f %10u %10u %10u %10u %10.2f\n",
-                                -10,
-                                (float)BASELINK->WNc * 86400.0 * 7.0 + BASELINK->TOW / 1000.0,
-                                (unsigned int)BASELINK->NrBytesReceived,
-                                (unsigned int)BASELINK->NrBytesAccepted,
-                                (unsigned int)BASELINK->NrMessagesReceived,
-                                (unsigned int)BASELINK->NrMessagesAccepted,
-                                BASELINK->AgeOfLastMsg
-                               );
-                    }
-
-                    break;
-
-
-                case sbfnr_GPSAlm_1:
-                    if (OutputGPSAlm == 1)
-                    {
-                        GPSAlm_1_0_t* GPSALM = (GPSAlm_1_0_t*) SBFBlock;
-                        gpAlm_1_0_t* ALM = &(GPSALM->Alm);
-                        fprintf(F, "%-2i %13.1f %3u %10.3f %10u %10.3f %10.3f %10.3f"
-                                "%10.3f %10.3f %10.3f %10.3f %10.3f %3u %3u %3u %3u\n",
-                                -11,
-                                (float)ALM->WNc * 86400.0 * 7.0 + ALM->TOW / 1000.0,
-                                (unsigned int)(ALM->PRN),
-                                ALM->e,
-                                (unsigned int)ALM->t_oa,
-                                ALM->delta_i,
-                                ALM->OMEGADOT,
-                                ALM->SQRT_A,
-                                ALM->OMEGA_0,
-                                ALM->omega,
-                                ALM->M_0,
-                                ALM->a_f1,
-                                ALM->a_f0,
-                                (unsigned int)(ALM->WN_a),
-                                (unsigned int)(ALM->config),
-                                (unsigned int)(ALM->health8),
-                                (unsigned int)(ALM->health6)
-                               );
-                    }
-
-                    break;
-
-                case sbfnr_AuxAntPositions_1:
-                    if (OutputAuxPos == 1)
-                    {
-                        AuxAntPositions_1_0_t* AUXPOS = (AuxAntPositions_1_0_t*) SBFBlock;
-                        int i = 0;
-
-                        for (i = 0; i < AUXPOS->NbrAuxAntennas; i++)
-                        {
-                            AuxAntPosData_1_0_t* AUXPOSN = &(AUXPOS->AuxAntPositions[i]);
-                            fprintf(F, "%-2i %13.1f %3u %10.3f %10.3f %10.3f"
-                                    "%3u %3u %3u 0 0 0 0 0\n",
-                                    -12,
-                                    (float)AUXPOS->WNc * 86400.0 * 7.0 + AUXPOS->TOW / 1000.0,
-                                    (unsigned int)(AUXPOSN->AuxAntID),
-                                    AUXPOSN->DeltaEast,
-                                    AUXPOSN->DeltaNorth,
-                                    AUXPOSN->DeltaUp,
-                                    (unsigned int)AUXPOSN->NRSV,
-                                    (unsigned int)AUXPOSN->Error,
-                                    (unsigned int)AUXPOSN->AmbiguityType
-                                   );
-                        }
-                    }
-
-                    break;
-
-                case sbfnr_ExtSensorMeas_1:
-                    if (OutputExtSensorMeas == 1)
-                    {
-                        ExtSensorMeas_1_t* EXTSENSMEAS = (ExtSensorMeas_1_t*) SBFBlock;
-                        int i = 0;
-
-                        for (i = 0; i < EXTSENSMEAS->N; i++)
-                        {
-                            ExtSensorMeasSB_t* EXTSENSMEASN = &(EXTSENSMEAS->ExtSensorMeas[i]);
-                            fprintf(F, "%-2i %13.2f %3u %3u %10.3f %10.3f %10.3f"
-                                    " 0 0 0 0 0 0\n",
-                                    -13,
-                                    (float)EXTSENSMEAS->WNc * 86400.0 * 7.0 + EXTSENSMEAS->TOW / 1000.0,
-                                    (unsigned int)EXTSENSMEASN->Source,
-                                    (unsigned int)EXTSENSMEASN->Type,
-                                    /* use the fields of ExtSensorMeasData.Acceleration for the tracing */
-                                    EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationX,
-                                    EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationY,
-                                    EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationZ
-                                   );
-                        }
-                    }
-
-                    break;
-
-                case sbfnr_INSNavGeod_1:
-                    if (OutputINSNavGeod == 1)
-                    {
-                        INSNavGeod_1_t* INSNAVGEOD = (INSNavGeod_1_t*) SBFBlock;
-                        int SBIdx = 0;
-                        fprintf(F, "%-2i %13.2f %14.11f %15.11f %14.5f",
-                                -14,
-                                (float)INSNAVGEOD->WNc * 86400.0 * 7.0 + INSNAVGEOD->TOW / 1000.0,
-                                INSNAVGEOD->Latitude,
-                                INSNAVGEOD->Longitude,
-                                INSNAVGEOD->Height
-                               );
-
-                        /* skip standard deviation subblock if available */
-                        if ((INSNAVGEOD->SBList & 1) != 0)
-                        {
-                            SBIdx++;
-                        }
-
-                        if ((INSNAVGEOD->SBList & 2) != 0)
-                        {
-                            fprintf(F, " %14.5f %14.5f %14.5f\n",
-                                    INSNAVGEOD->INSNavGeodData[SBIdx].Att.Heading,
-                                    INSNAVGEOD->INSNavGeodData[SBIdx].Att.Pitch,
-                                    INSNAVGEOD->INSNavGeodData[SBIdx].Att.Roll);
-                            SBIdx++;
-                        }
-                        else
-                        {
-                            fprintf(F, " %14.5f %14.5f %14.5f\n", -2e10, -2e10, -2e10);
-                        }
-                    }
-
-                    break;
-
-                default:
-                    break;
-                }
         }
 
-        /* display the progress report, if enabled */
-        if (VerboseMode == 1)
+        if (i == NrOfNames)
         {
-            DisplayProgress(&SBFData);
+            Names[NrOfNames++] = Name;
         }
-    }
 
-    if (VerboseMode == 1)
-    {
-        fprintf(stdout, "Creating ASCII file: done      \n");
-        (void)fflush(stdout);
+        Index[Code] = (uint16_t)i;
     }
 
-    /* Closing the opened files */
-    (void)fclose(F);
-
-    CloseSBFFile(&SBFData);
-    return;
+    return NrOfNames;
 }
 
+
 /*---------------------------------------------------------------------------*/
-static int yearOffset[4] = {0, 366, 366 + 365, 366 + 365 + 365};
-static int dayCount[12]  = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+/* Build the dictionary of the "sat" column: the distinct satellite
+ * names of SBFSVIDName[], and the dictionary index of each SVID. */
+static void InitArrowSatNames(void)
+{
+    ArrowMeasColumns[ARROWCOL_SAT].DictionarySize
+        = InitDictionary(getSatelliteNameFromSBF, 256, ArrowSatNames, ArrowSatIndex);
+}
 
-static int ConvertDateToGPSDay(int         year,
-                               int         month,
-                               int         day)
+
+/*---------------------------------------------------------------------------*/
+static void WriteArrowObservable(sbfarrow_Writer_t* Arrow,
+                                 uint32_t           Col,
+                                 double             Value,
+                                 double             NotValid)
 {
-    int  fouryear_interval = year % 4;
-    int  GPSDay;
+    if (Value != NotValid)
+    {
+        if (ArrowMeasColumns[Col].Type == SBFARROW_FLOAT32)
+        {
+            sbfarrow_SetFloat32(Arrow, Col, (float)Value);
+        }
+        else
+        {
+            sbfarrow_SetFloat64(Arrow, Col, Value);
+        }
+    }
+}
 
-    /* # days from beginning of 1980 till beginning of the current
-         4-year period (NB: 1461=365.25*4)*/
-    GPSDay = 1461 * ((year - 1980) / 4);
 
-    /* add the number of days from the beginning of the current 4-year
-       period to the beginning of the current year */
-    GPSDay += yearOffset[fouryear_interval];
+/*---------------------------------------------------------------------------*/
+/* Same as PrintMeasEpoch(), in the Arrow format. */
+static void WriteMeasEpochArrow(void*              Context,
+                                const MeasEpoch_t* const MeasEpoch)
+{
+    sbfarrow_Writer_t* Arrow = (sbfarrow_Writer_t*)Context;
+    uint32_t i;
 
-    /* add number of full days elapsed since the beginning of the
-       current year */
-    GPSDay += dayCount[month - 1] + day - 1;
+    int64_t CurrentTime_ns
+        = ((int64_t)MeasEpoch->WNc * (86400 * 7 * 1000) + MeasEpoch->TOW_ms) * 1000000;
+    int64_t CurrentUTCTime_ns = sbftime_GetUTCTime_ns(CurrentTime_ns);
 
-    /* compensate for leap year */
-    if ((fouryear_interval == 0) && (month >= 3))
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
     {
-        GPSDay++;
-    }
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        MeasRow_t Row;
 
-    /* GPS time starts January 6th, 1980, so remove 5 days */
-    GPSDay -= 5;
+        if (GetMeasRow(ChannelData, &Row))
+        {
+            uint8_t SVID = convertSVIDtoSBF(ChannelData->PRN);
+
+            sbfarrow_SetInt64(Arrow, ARROWCOL_TIME, CurrentTime_ns);
+            sbfarrow_SetUInt8(Arrow, ARROWCOL_SVID, SVID);
+            sbfarrow_SetIndex(Arrow, ARROWCOL_SAT, ArrowSatIndex[SVID]);
+            WriteArrowObservable(Arrow, ARROWCOL_PI,  Row.Pi,  F64_NOTVALID);
+            WriteArrowObservable(Arrow, ARROWCOL_LI,  Row.Li,  F64_NOTVALID);
+            WriteArrowObservable(Arrow, ARROWCOL_CNI, Row.CNi, F32_NOTVALID);
+            WriteArrowObservable(Arrow, ARROWCOL_PJ,  Row.Pj,  F64_NOTVALID);
+            WriteArrowObservable(Arrow, ARROWCOL_LJ,  Row.Lj,  F64_NOTVALID);
+            WriteArrowObservable(Arrow, ARROWCOL_CNJ, Row.CNj, F32_NOTVALID);
+
+            if (HasUTCColumn())
+            {
+                sbfarrow_SetInt64(Arrow, ARROWCOL_UTC, CurrentUTCTime_ns);
+            }
 
-    return GPSDay;
+            sbfarrow_EndRow(Arrow);
+        }
+    }
 }
 
 
 /*---------------------------------------------------------------------------*/
-double ConvertDateTimeToGPSsec(int         year,
-                               int         month,
-                               int         day,
-                               int         hour,
-                               int         min,
-                               double      sec)
+/* Columns of the measurements in the Parquet format (see the usage
+ * message).  The dictionary of the signal names is filled in by
+ * InitParquetSignalNames(). */
+#define PQCOL_TIME         0
+#define PQCOL_SVID         1
+#define PQCOL_SIGNAL       2
+#define PQCOL_PR           3
+#define PQCOL_L            4
+#define PQCOL_DOPPLER      5
+#define PQCOL_CN0          6
+#define PQCOL_UTC          7    /* with -Z utcns or iso only */
+#define NR_OF_PQCOLS       8
+
+/* duration of the row groups of the Parquet files */
+#define PQ_ROWGROUP_NS     (3600LL * 1000000000LL)
+
+static const char* ParquetSignalNames[256];
+static uint16_t    ParquetSignalIndex[256];
+static int64_t     ParquetRowGroup = -1;
+
+static sbfparquet_Column_t ParquetMeasColumns[NR_OF_PQCOLS] =
 {
-    uint32_t GPSday = ConvertDateToGPSDay(year, month, day);
-
-    return (GPSday * 86400.0 + (double)(hour * 3600 + min * 60) + sec);
-}
+    {"gps_ns",     SBFPARQUET_INT64,  false, NULL,               0},
+    {"svid",       SBFPARQUET_UINT8,  false, NULL,               256},
+    {"signal",     SBFPARQUET_STRING, false, ParquetSignalNames, 0},
+    {"pr_m",       SBFPARQUET_DOUBLE, true,  NULL,               0},
+    {"l_cyc",      SBFPARQUET_DOUBLE, true,  NULL,               0},
+    {"doppler_hz", SBFPARQUET_FLOAT,  true,  NULL,               0},
+    {"cn0_dbhz",   SBFPARQUET_FLOAT,  true,  NULL,               0},
+    {"utc_ns",     SBFPARQUET_INT64,  false, NULL,               0}
+};
 
 
 /*---------------------------------------------------------------------------*/
-int main(int argc, char* argv[])
+/* Build the dictionary of the "signal" column from SBFSignalName[]. */
+static void InitParquetSignalNames(void)
 {
-    char       SBFFileName[256];
-    char       AsciiFileName[256];
-    int        optionchar;
-    double     Interval;
+    ParquetMeasColumns[PQCOL_SIGNAL].DictionarySize
+        = InitDictionary(getSignalName, 256, ParquetSignalNames, ParquetSignalIndex);
+}
 
-    int        year, month, day, hour, min;
-    double     sec;
-    char       dummy;
-    int64_t    ForcedFirstEpoch_ms, ForcedLastEpoch_ms;
-    int        ForcedInterval_ms;
 
-    /* Set the file names to an empty string. */
-    SBFFileName[0]   = '\0';
-    AsciiFileName[0] = '\0';
+/*---------------------------------------------------------------------------*/
+/* Write the observables of all the signals of the main antenna, one
+ * row per signal, in the Parquet format.  A new row group is started
+ * at each hour. */
+static void WriteMeasEpochParquet(void*                Context,
+                                  const MeasEpoch_t* const MeasEpoch)
+{
+    sbfparquet_Writer_t* Parquet = (sbfparquet_Writer_t*)Context;
+    uint32_t i, SigIdx;
 
-    /* No specs on the first and last epoch to put on the file */
-    ForcedFirstEpoch_ms  = FIRSTEPOCHms_DONTCARE;
-    ForcedLastEpoch_ms   = LASTEPOCHms_DONTCARE;
-    ForcedInterval_ms    = INTERVALms_DONTCARE;
+    int64_t CurrentTime_ns
+        = ((int64_t)MeasEpoch->WNc * (86400 * 7 * 1000) + MeasEpoch->TOW_ms) * 1000000;
+    int64_t CurrentUTCTime_ns = sbftime_GetUTCTime_ns(CurrentTime_ns);
 
-    /* Parse the command line options: */
-    ssn_opterr = 0;    /* Warn the user if an invalid option was entered. */
+    if (CurrentTime_ns / PQ_ROWGROUP_NS != ParquetRowGroup)
+    {
+        sbfparquet_EndRowGroup(Parquet);
+        ParquetRowGroup = CurrentTime_ns / PQ_ROWGROUP_NS;
+    }
 
-    while ((optionchar = ssn_getopt(argc, argv, "f:o:b:e:mgcpsadjIvVEi:xtnlkhu")) != -1)
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
     {
-        switch (optionchar)
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        uint8_t SVID = convertSVIDtoSBF(ChannelData->PRN);
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
         {
-        case 'b':
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
 
-            /* First time to include in the file */
-            /* If there is a '-' in the argument, we assume that a date
-                              * is provided */
-            if (strchr(ssn_optarg, '-') != NULL)
-            {
-                (void)sscanf(ssn_optarg, "%d%c%d%c%d%c%d%c%d%c%lf",
-                             &year, &dummy, &month, &dummy, &day, &dummy,
-                             &hour, &dummy, &min, &dummy, &sec);
-                ForcedFirstEpoch_ms
-                    = (int64_t)(ConvertDateTimeToGPSsec(year, month, day, hour, min, sec)
-                                * 1000.0 + 0.5);
-            }
-            else
+            if (MeasSet->flags == 0)
             {
-                (void)sscanf(ssn_optarg, "%d%c%d%c%lf",
-                             &hour, &dummy, &min, &dummy, &sec);
-                ForcedFirstEpoch_ms = hour * 3600000 + min * 60000 + (int64_t)(sec * 1000 + 0.5);
+                continue;
             }
 
-            break;
+            sbfparquet_SetInt64(Parquet, PQCOL_TIME, CurrentTime_ns);
+            sbfparquet_SetUInt8(Parquet, PQCOL_SVID, SVID);
+            sbfparquet_SetIndex(Parquet, PQCOL_SIGNAL, ParquetSignalIndex[MeasSet->signalType]);
 
-        case 'e':
+            if (MeasSet->PR_m != F64_NOTVALID)
+            {
+                sbfparquet_SetDouble(Parquet, PQCOL_PR, MeasSet->PR_m);
+            }
 
-            /* Last time to include in the file */
-            if (strchr(ssn_optarg, '-') != NULL)
+            /* discard carrier phases with half-cycle ambiguities */
+            if (MeasSet->L_cycles != F64_NOTVALID &&
+                (MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) == 0)
             {
-                (void)sscanf(ssn_optarg, "%d%c%d%c%d%c%d%c%d%c%lf",
-                             &year, &dummy, &month, &dummy, &day, &dummy,
-                             &hour, &dummy, &min, &dummy, &sec);
-                ForcedLastEpoch_ms
-                    = (int64_t)(ConvertDateTimeToGPSsec(year, month, day, hour, min, sec)
-                                * 1000.0 + 0.5);
+                sbfparquet_SetDouble(Parquet, PQCOL_L, MeasSet->L_cycles);
             }
-            else
+
+            if (MeasSet->doppler_Hz != F32_NOTVALID)
             {
-                (void)sscanf(ssn_optarg, "%d%c%d%c%lf",
-                             &hour, &dummy, &min, &dummy, &sec);
-                ForcedLastEpoch_ms = hour * 3600000 + min * 60000 + (int64_t)(sec * 1000 + 0.5);
+                sbfparquet_SetFloat(Parquet, PQCOL_DOPPLER, MeasSet->doppler_Hz);
             }
 
-            break;
+            if (MeasSet->CN0_dBHz != F32_NOTVALID)
+            {
+                sbfparquet_SetFloat(Parquet, PQCOL_CN0, MeasSet->CN0_dBHz);
+            }
 
-        case 'i':
-            if (sscanf(ssn_optarg, "%lf", &Interval) != 1)
+            if (HasUTCColumn())
             {
-                fprintf(stderr, "Unparsable argument '%s'.\n", ssn_optarg);
-                usage();
-                return 3;
+                sbfparquet_SetInt64(Parquet, PQCOL_UTC, CurrentUTCTime_ns);
             }
 
-            ForcedInterval_ms = (uint32_t)(Interval * 1000.0 + 0.5);
-            break;
+            sbfparquet_EndRow(Parquet);
+        }
+    }
+}
 
-        case 'f':
-            strncpy(SBFFileName, ssn_optarg, sizeof(SBFFileName));
-            SBFFileName[sizeof(SBFFileName) - 1] = '\0';
-            break;
+
+/*---------------------------------------------------------------------------*/
+/* Print a DOP field, 15 characters on "F":
+ * either "DOP" divided by 100, right-aligned in a 14 char field,
+ * or "            NA " if the DOP is not available (value 0). */
+static void PrintPvtDopField(sbfout_Stream_t* Out, uint16_t DOP)
+{
+    if (DOP == 0)
+    {
+        sbfout_Printf(Out, "            NA ");
+    }
+    else
+    {
+        sbfout_Printf(Out, "%14.3f ", (float)DOP / 100.0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Print a HPL or VPL field, 15 characters on "F":
+ * either the "XPL", right-aligned in a 14 char field,
+ * or "            NA " if the XPL is not available (smaller than -1e10). */
+static void PrintPvtXplField(sbfout_Stream_t* Out, float XPL)
+{
+    if (XPL <= -1e10)
+    {
+        sbfout_Printf(Out, "            NA ");
+    }
+    else
+    {
+        sbfout_Printf(Out, "%14.3f ", XPL);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static void PrintPvtDopLine(void* Context, const void* SBFBlock)
+{
+    sbfout_Stream_t* Out = (sbfout_Stream_t*)Context;
+    const DOP_2_0_t* PVTDOP = (const DOP_2_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+
+    sbfout_Printf(Out, "-3  ");
+    //Print the time
+    sbfout_Printf(Out, "%s ", FormatTime(Time, 13, 2, (float)PVTDOP->WNc * 86400.0 * 7.0 + PVTDOP->TOW / 1000.0,
+                                         sbftime_GetGPSTime_ns(PVTDOP->WNc, PVTDOP->TOW)));
+
+    PrintPvtDopField(Out, PVTDOP->PDOP);
+    PrintPvtDopField(Out, PVTDOP->TDOP);
+    PrintPvtDopField(Out, PVTDOP->HDOP);
+    PrintPvtDopField(Out, PVTDOP->VDOP);
+    PrintPvtXplField(Out, PVTDOP->HPL);
+    PrintPvtXplField(Out, PVTDOP->VPL);
+
+    sbfout_Printf(Out, "%3i \n", (int)(PVTDOP->NrSV));
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* The block handlers below write a row, or a row per sub-block, to the
+ * sbfout stream given as Context.  See usage_msg2 and usage_msg3 for
+ * the columns. */
+static void PrintPVTCartesian1(void* Context, const void* SBFBlock)
+{
+    const PVTCartesian_1_0_t* PVT = (const PVTCartesian_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.3f %14.3f %14.3f %10.3f %10.3f"
+                  " %10.3f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
+                  0,
+                  FormatTime(Time, 13, 2, (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(PVT->WNc, PVT->TOW)),
+                  PVT->X,
+                  PVT->Y,
+                  PVT->Z,
+                  PVT->Vx,
+                  PVT->Vy,
+                  PVT->Vz,
+                  PVT->RxClkBias,
+                  PVT->RxClkDrift,
+                  (int)(PVT->NrSV),
+                  (int)PVT->Mode,
+                  (int)PVT->MeanCorrAge,
+                  (int)PVT->Error,
+                  PVT->Cog
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintPVTCartesian2(void* Context, const void* SBFBlock)
+{
+    const PVTCartesian_2_0_t* PVT = (const PVTCartesian_2_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.3f %14.3f %14.3f %10.3f %10.3f"
+                  " %10.3f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
+                  0,
+                  FormatTime(Time, 13, 2, (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(PVT->WNc, PVT->TOW)),
+                  PVT->X,
+                  PVT->Y,
+                  PVT->Z,
+                  PVT->Vx,
+                  PVT->Vy,
+                  PVT->Vz,
+                  PVT->RxClkBias  > -1e10 ? PVT->RxClkBias * 1e-3  : -2e10,
+                  PVT->RxClkDrift > -1e10 ? PVT->RxClkDrift * 1e-6 : -2e10,
+                  (int)(PVT->NrSV),
+                  (int)PVT->Mode,
+                  (int)PVT->MeanCorrAge,
+                  (int)PVT->Error,
+                  PVT->COG
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintPVTGeodetic1(void* Context, const void* SBFBlock)
+{
+    const PVTGeodetic_1_0_t* PVT = (const PVTGeodetic_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.11f %15.11f %14.5f %14.5f %10.5f"
+                  " %10.5f %10.5f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
+                  -1,
+                  FormatTime(Time, 13, 2, (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(PVT->WNc, PVT->TOW)),
+                  PVT->Lat,
+                  PVT->Lon,
+                  PVT->Alt,
+                  PVT->GeoidHeight,
+                  PVT->Vn,
+                  PVT->Ve,
+                  PVT->Vu,
+                  PVT->RxClkBias,
+                  PVT->RxClkDrift,
+                  (int)(PVT->NrSV),
+                  (int)PVT->Mode,
+                  (int)PVT->MeanCorrAge,
+                  (int)PVT->Error,
+                  PVT->Cog
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintPVTGeodetic2(void* Context, const void* SBFBlock)
+{
+    const PVTGeodetic_2_0_t* PVT = (const PVTGeodetic_2_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.11f %15.11f %14.5f %14.5f %10.5f"
+                  " %10.5f %10.5f %15.8e %13.6e %3i %3i %3i %3i %10.3f\n",
+                  -1,
+                  FormatTime(Time, 13, 2, (float)PVT->WNc * 86400.0 * 7.0 + PVT->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(PVT->WNc, PVT->TOW)),
+                  PVT->Lat,
+                  PVT->Lon,
+                  PVT->Alt,
+                  PVT->Undulation,
+                  PVT->Vn,
+                  PVT->Ve,
+                  PVT->Vu,
+                  PVT->RxClkBias  > -1e10 ? PVT->RxClkBias * 1e-3  : -2e10,
+                  PVT->RxClkDrift > -1e10 ? PVT->RxClkDrift * 1e-6 : -2e10,
+                  (int)(PVT->NrSV),
+                  (int)PVT->Mode,
+                  (int)PVT->MeanCorrAge,
+                  (int)PVT->Error,
+                  PVT->COG
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintPosCovCartesian1(void* Context, const void* SBFBlock)
+{
+    const PosCovCartesian_1_0_t* PVTCOV = (const PosCovCartesian_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.3f %14.3f %14.3f %14.3f"
+                  " 0 0 0 0 0 0 0 0\n",
+                  -2,
+                  FormatTime(Time, 13, 2, (float)PVTCOV->WNc * 86400.0 * 7.0 + PVTCOV->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(PVTCOV->WNc, PVTCOV->TOW)),
+                  PVTCOV->Cov_xx,
+                  PVTCOV->Cov_yy,
+                  PVTCOV->Cov_zz,
+                  PVTCOV->Cov_tt
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintAttEuler1(void* Context, const void* SBFBlock)
+{
+    const AttEuler_1_0_t* ATTEULER = (const AttEuler_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.5f %14.5f %14.5f"
+                  " %3u %3u %3u 0 0 0 0 0 0\n",
+                  -4,
+                  FormatTime(Time, 13, 2, (float)ATTEULER->WNc * 86400.0 * 7.0 + ATTEULER->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(ATTEULER->WNc, ATTEULER->TOW)),
+                  ATTEULER->Heading,
+                  ATTEULER->Pitch,
+                  ATTEULER->Roll,
+                  (unsigned int)(ATTEULER->Error),
+                  (unsigned int)ATTEULER->Mode,
+                  (unsigned int)(ATTEULER->NRSV)
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintAttCovEuler1(void* Context, const void* SBFBlock)
+{
+    const AttCovEuler_1_0_t* ATTCOVEULER = (const AttCovEuler_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %14.5f %14.5f %14.5f"
+                  " %3u 0 0 0 0 0 0 0 0\n",
+                  -5,
+                  FormatTime(Time, 13, 2, (float)ATTCOVEULER->WNc * 86400.0 * 7.0 + ATTCOVEULER->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(ATTCOVEULER->WNc, ATTCOVEULER->TOW)),
+                  ATTCOVEULER->Cov_HeadHead,
+                  ATTCOVEULER->Cov_PitchPitch,
+                  ATTCOVEULER->Cov_RollRoll,
+                  (unsigned int)(ATTCOVEULER->Error)
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintExtEvent1(void* Context, const void* SBFBlock)
+{
+    const ExtEvent_1_0_t* EXTEVENT = (const ExtEvent_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+
+    TimerCounters[EXTEVENT->TimerData.Source - 1] += 1;
+
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %4i %4i %16.6f 0 0 0 0 0 0 0 0 0\n",
+                  -6,
+                  FormatTime(Time, 16, 6, (float)EXTEVENT->TimerData.WNc * 86400.0 * 7.0 + EXTEVENT->TimerData.TOW / 1000.0 + EXTEVENT->TimerData.Offset,
+                             sbftime_GetGPSTime_ns(EXTEVENT->TimerData.WNc, EXTEVENT->TimerData.TOW)
+                             + llround(EXTEVENT->TimerData.Offset * 1e9)),
+                  (int)EXTEVENT->TimerData.Source,
+                  (int)TimerCounters[EXTEVENT->TimerData.Source - 1],
+                  (float)EXTEVENT->TimerData.Offset
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintReceiverStatus1(void* Context, const void* SBFBlock)
+{
+    const ReceiverStatus_1_0_t* RXSTATUS = (const ReceiverStatus_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %3u %8u %x "
+                  "0 0 0 0 0 0 0 0 0 0 0\n",
+                  -7,
+                  FormatTime(Time, 13, 1, (double)RXSTATUS->WNc * 86400.0 * 7.0 + RXSTATUS->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(RXSTATUS->WNc, RXSTATUS->TOW)),
+                  (unsigned int)RXSTATUS->CPULoad,
+                  (unsigned int)RXSTATUS->UpTime,
+                  (unsigned int)RXSTATUS->RxStatus
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintReceiverStatus2(void* Context, const void* SBFBlock)
+{
+    const ReceiverStatus_2_1_t* RXSTATUS = (const ReceiverStatus_2_1_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %3u %8u %x "
+                  "0 0 0 0 0 0 0 0 0 0 0\n",
+                  -7,
+                  FormatTime(Time, 13, 1, (double)RXSTATUS->WNc * 86400.0 * 7.0 + RXSTATUS->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(RXSTATUS->WNc, RXSTATUS->TOW)),
+                  (unsigned int)RXSTATUS->CPULoad,
+                  (unsigned int)RXSTATUS->UpTime,
+                  (unsigned int)RXSTATUS->RxStatus
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintBaseStation1(void* Context, const void* SBFBlock)
+{
+    const BaseStation_1_0_t* BASESTATION = (const BaseStation_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %5u %1u %1u %14.3f %14.3f %14.3f\n",
+                  -8,
+                  FormatTime(Time, 13, 1, (float)BASESTATION->WNc * 86400.0 * 7.0 + BASESTATION->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(BASESTATION->WNc, BASESTATION->TOW)),
+                  (unsigned int)BASESTATION->BaseStationID,
+                  (unsigned int)(BASESTATION->BaseType),
+                  (unsigned int)(BASESTATION->Source),
+                  BASESTATION->X_L1PhaseCenter,
+                  BASESTATION->Y_L1PhaseCenter,
+                  BASESTATION->Z_L1PhaseCenter
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintBaseLine1(void* Context, const void* SBFBlock)
+{
+    const BaseLine_1_0_t* BASELINE = (const BaseLine_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %4u %13.4f %13.4f %13.4f\n",
+                  -9,
+                  FormatTime(Time, 13, 1, (float)BASELINE->WNc * 86400.0 * 7.0 + BASELINE->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(BASELINE->WNc, BASELINE->TOW)),
+                  (unsigned int)BASELINE->BaseStationID,
+                  BASELINE->East,
+                  BASELINE->North,
+                  BASELINE->Up
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintBaseLink1(void* Context, const void* SBFBlock)
+{
+    const BaseLink_1_0_t* BASELINK = (const BaseLink_1_0_t*)SBFBlock;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %10u %10u %10u %10u %10.2f\n",
+                  -10,
+                  FormatTime(Time, 13, 1, (float)BASELINK->WNc * 86400.0 * 7.0 + BASELINK->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(BASELINK->WNc, BASELINK->TOW)),
+                  (unsigned int)BASELINK->NrBytesReceived,
+                  (unsigned int)BASELINK->NrBytesAccepted,
+                  (unsigned int)BASELINK->NrMessagesReceived,
+                  (unsigned int)BASELINK->NrMessagesAccepted,
+                  BASELINK->AgeOfLastMsg
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintGPSAlm1(void* Context, const void* SBFBlock)
+{
+    const GPSAlm_1_0_t* GPSALM = (const GPSAlm_1_0_t*)SBFBlock;
+    const gpAlm_1_0_t*  ALM = &(GPSALM->Alm);
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf((sbfout_Stream_t*)Context,
+                  "%-2i %s %3u %10.3f %10u %10.3f %10.3f %10.3f"
+                  "%10.3f %10.3f %10.3f %10.3f %10.3f %3u %3u %3u %3u\n",
+                  -11,
+                  FormatTime(Time, 13, 1, (float)ALM->WNc * 86400.0 * 7.0 + ALM->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(ALM->WNc, ALM->TOW)),
+                  (unsigned int)(ALM->PRN),
+                  ALM->e,
+                  (unsigned int)ALM->t_oa,
+                  ALM->delta_i,
+                  ALM->OMEGADOT,
+                  ALM->SQRT_A,
+                  ALM->OMEGA_0,
+                  ALM->omega,
+                  ALM->M_0,
+                  ALM->a_f1,
+                  ALM->a_f0,
+                  (unsigned int)(ALM->WN_a),
+                  (unsigned int)(ALM->config),
+                  (unsigned int)(ALM->health8),
+                  (unsigned int)(ALM->health6)
+                 );
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintAuxAntPositions1(void* Context, const void* SBFBlock)
+{
+    const AuxAntPositions_1_0_t* AUXPOS = (const AuxAntPositions_1_0_t*)SBFBlock;
+    sbfread_SubBlockView_t SubBlocks;
+    AuxAntPosData_1_0_t    Scratch;
+    uint32_t i = 0;
+    char Time[SBFTIME_TEXT_SIZE];
+
+    sbfread_SubBlockView_Init(&SubBlocks, AUXPOS, AUXPOS->AuxAntPositions,
+                              AUXPOS->NbrAuxAntennas, AUXPOS->SBSize,
+                              sizeof(AuxAntPosData_1_0_t));
+
+    for (i = 0; i < SubBlocks.N; i++)
+    {
+        const AuxAntPosData_1_0_t* AUXPOSN = sbfread_SubBlockView_Get(&SubBlocks, i, &Scratch);
+        sbfout_Printf((sbfout_Stream_t*)Context,
+                      "%-2i %s %3u %10.3f %10.3f %10.3f"
+                      "%3u %3u %3u 0 0 0 0 0\n",
+                      -12,
+                      FormatTime(Time, 13, 1, (float)AUXPOS->WNc * 86400.0 * 7.0 + AUXPOS->TOW / 1000.0,
+                                 sbftime_GetGPSTime_ns(AUXPOS->WNc, AUXPOS->TOW)),
+                      (unsigned int)(AUXPOSN->AuxAntID),
+                      AUXPOSN->DeltaEast,
+                      AUXPOSN->DeltaNorth,
+                      AUXPOSN->DeltaUp,
+                      (unsigned int)AUXPOSN->NRSV,
+                      (unsigned int)AUXPOSN->Error,
+                      (unsigned int)AUXPOSN->AmbiguityType
+                     );
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintExtSensorMeas1(void* Context, const void* SBFBlock)
+{
+    const ExtSensorMeas_1_t* EXTSENSMEAS = (const ExtSensorMeas_1_t*)SBFBlock;
+    sbfread_SubBlockView_t SubBlocks;
+    ExtSensorMeasSB_t      Scratch;
+    uint32_t i = 0;
+    char Time[SBFTIME_TEXT_SIZE];
+
+    sbfread_SubBlockView_Init(&SubBlocks, EXTSENSMEAS, EXTSENSMEAS->ExtSensorMeas,
+                              EXTSENSMEAS->N, EXTSENSMEAS->SBSize,
+                              sizeof(ExtSensorMeasSB_t));
+
+    for (i = 0; i < SubBlocks.N; i++)
+    {
+        const ExtSensorMeasSB_t* EXTSENSMEASN = sbfread_SubBlockView_Get(&SubBlocks, i, &Scratch);
+        sbfout_Printf((sbfout_Stream_t*)Context,
+                      "%-2i %s %3u %3u %10.3f %10.3f %10.3f"
+                      " 0 0 0 0 0 0\n",
+                      -13,
+                      FormatTime(Time, 13, 2, (float)EXTSENSMEAS->WNc * 86400.0 * 7.0 + EXTSENSMEAS->TOW / 1000.0,
+                                 sbftime_GetGPSTime_ns(EXTSENSMEAS->WNc, EXTSENSMEAS->TOW)),
+                      (unsigned int)EXTSENSMEASN->Source,
+                      (unsigned int)EXTSENSMEASN->Type,
+                      /* use the fields of ExtSensorMeasData.Acceleration for the tracing */
+                      EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationX,
+                      EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationY,
+                      EXTSENSMEASN->ExtSensorMeasData.Acceleration.AccelerationZ
+                     );
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void PrintINSNavGeod1(void* Context, const void* SBFBlock)
+{
+    sbfout_Stream_t*      Out = (sbfout_Stream_t*)Context;
+    const INSNavGeod_1_t* INSNAVGEOD = (const INSNavGeod_1_t*)SBFBlock;
+    int SBIdx = 0;
+    char Time[SBFTIME_TEXT_SIZE];
+    sbfout_Printf(Out, "%-2i %s %14.11f %15.11f %14.5f",
+                  -14,
+                  FormatTime(Time, 13, 2, (float)INSNAVGEOD->WNc * 86400.0 * 7.0 + INSNAVGEOD->TOW / 1000.0,
+                             sbftime_GetGPSTime_ns(INSNAVGEOD->WNc, INSNAVGEOD->TOW)),
+                  INSNAVGEOD->Latitude,
+                  INSNAVGEOD->Longitude,
+                  INSNAVGEOD->Height
+                 );
+
+    /* skip standard deviation subblock if available */
+    if ((INSNAVGEOD->SBList & 1) != 0)
+    {
+        SBIdx++;
+    }
+
+    if ((INSNAVGEOD->SBList & 2) != 0)
+    {
+        sbfout_Printf(Out, " %14.5f %14.5f %14.5f\n",
+                      INSNAVGEOD->INSNavGeodData[SBIdx].Att.Heading,
+                      INSNAVGEOD->INSNavGeodData[SBIdx].Att.Pitch,
+                      INSNAVGEOD->INSNavGeodData[SBIdx].Att.Roll);
+        SBIdx++;
+    }
+    else
+    {
+        sbfout_Printf(Out, " %14.5f %14.5f %14.5f\n", -2e10, -2e10, -2e10);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* The outputs of the non-measurement blocks: name used with -O, flag
+ * set by the option of the output, and handler of each block number. */
+typedef struct
+{
+    const char*                Name;
+    uint32_t*                  Enabled;
+    uint16_t                   BlockNumber;
+    sbfconsumer_BlockHandler_t Handler;
+} BlockOutput_t;
+
+static const BlockOutput_t BlockOutputs[] =
+{
+    {"pvtcar",      &OutputPVTcar,         sbfnr_PVTCartesian_1,    PrintPVTCartesian1},
+    {"pvtcar",      &OutputPVTcar,         sbfnr_PVTCartesian_2,    PrintPVTCartesian2},
+    {"pvtgeo",      &OutputPVTgeo,         sbfnr_PVTGeodetic_1,     PrintPVTGeodetic1},
+    {"pvtgeo",      &OutputPVTgeo,         sbfnr_PVTGeodetic_2,     PrintPVTGeodetic2},
+    {"pvtcov",      &OutputPVTCov,         sbfnr_PosCovCartesian_1, PrintPosCovCartesian1},
+    {"dop",         &OutputDOP,            sbfnr_DOP_1,             PrintPvtDopLine},
+    {"dop",         &OutputDOP,            sbfnr_DOP_2,             PrintPvtDopLine},
+    {"atteuler",    &OutputAttEuler,       sbfnr_AttEuler_1,        PrintAttEuler1},
+    {"attcoveuler", &OutputAttCovEuler,    sbfnr_AttCovEuler_1,     PrintAttCovEuler1},
+    {"extevent",    &OutputExtEvent,       sbfnr_ExtEvent_1,        PrintExtEvent1},
+    {"rxstatus",    &OutputReceiverStatus, sbfnr_ReceiverStatus_1,  PrintReceiverStatus1},
+    {"rxstatus",    &OutputReceiverStatus, sbfnr_ReceiverStatus_2,  PrintReceiverStatus2},
+    {"basestation", &OutputBaseStation,    sbfnr_BaseStation_1,     PrintBaseStation1},
+    {"baseline",    &OutputBaseLine,       sbfnr_BaseLine_1,        PrintBaseLine1},
+    {"baselink",    &OutputBaseLink,       sbfnr_BaseLink_1,        PrintBaseLink1},
+    {"gpsalm",      &OutputGPSAlm,         sbfnr_GPSAlm_1,          PrintGPSAlm1},
+    {"auxpos",      &OutputAuxPos,         sbfnr_AuxAntPositions_1, PrintAuxAntPositions1},
+    {"extsensor",   &OutputExtSensorMeas,  sbfnr_ExtSensorMeas_1,   PrintExtSensorMeas1},
+    {"insnavgeod",  &OutputINSNavGeod,     sbfnr_INSNavGeod_1,      PrintINSNavGeod1}
+};
+
+#define NR_OF_BLOCKOUTPUTS  (sizeof(BlockOutputs) / sizeof(BlockOutputs[0]))
+
+
+/*---------------------------------------------------------------------------*/
+/* The measurement epoch handlers of the -C, S4 and plot outputs */
+static void PrintMeasEpochSpec(void* Context, const MeasEpoch_t* MeasEpoch)
+{
+    sbfmeasspec_PrintEpoch((sbfout_Stream_t*)Context, &MeasSpec, MeasEpoch);
+}
+
+static void AddS4Epoch(void* Context, const MeasEpoch_t* MeasEpoch)
+{
+    sbfs4_AddEpoch((sbfs4_t*)Context, MeasEpoch);
+}
+
+static void AddPlotEpoch(void* Context, const MeasEpoch_t* MeasEpoch)
+{
+    sbfplot_AddEpoch((sbfplot_t*)Context, MeasEpoch);
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* The measurements in the text formats, written by Format in the main
+ * thread, or in batches by the threads of Batch (see sbfbatch.h). */
+typedef struct
+{
+    sbfout_Stream_t*           Out;
+    sbfconsumer_EpochHandler_t Format;
+    sbfbatch_t*                Batch;
+} MeasText_t;
+
+static void WriteMeasEpochText(void* Context, const MeasEpoch_t* MeasEpoch)
+{
+    MeasText_t* Text = (MeasText_t*)Context;
+
+    if (Text->Batch != NULL)
+    {
+        sbfbatch_AddEpoch(Text->Batch, MeasEpoch);
+    }
+    else
+    {
+        Text->Format(Text->Out, MeasEpoch);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Set the file name of an output (-O option).  Returns false if
+ * NameAndFile is not of the form name=file with a known name. */
+static bool SetOutputFile(const char* NameAndFile)
+{
+    const char* Equal = strchr(NameAndFile, '=');
+    size_t      NameLen;
+    uint32_t    i;
+    bool        Known = false;
+
+    if (Equal == NULL || Equal[1] == '\0' ||
+        NrOfOutputFileNames >= MAX_OUTPUTFILES)
+    {
+        return false;
+    }
+
+    NameLen = (size_t)(Equal - NameAndFile);
+
+    if (NameLen >= sizeof(OutputFileNames[0].Name))
+    {
+        return false;
+    }
+
+    memcpy(OutputFileNames[NrOfOutputFileNames].Name, NameAndFile, NameLen);
+    OutputFileNames[NrOfOutputFileNames].Name[NameLen] = '\0';
+
+    /* enable the output */
+    if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "meas") == 0)
+    {
+        OutputMeas = 1;
+        Known = true;
+    }
+    else if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "s4") == 0)
+    {
+        OutputS4 = 1;
+        Known = true;
+    }
+    else if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "plot") == 0)
+    {
+        OutputPlot = 1;
+        Known = true;
+    }
+    else if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "shm") == 0)
+    {
+        OutputShm = 1;
+        Known = true;
+    }
+    else if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "rinexobs") == 0)
+    {
+        OutputRinexObs = 1;
+        Known = true;
+    }
+    else if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, "rinexnav") == 0)
+    {
+        OutputRinexNav = 1;
+        Known = true;
+    }
+
+    for (i = 0; i < NR_OF_BLOCKOUTPUTS; i++)
+    {
+        if (strcmp(OutputFileNames[NrOfOutputFileNames].Name, BlockOutputs[i].Name) == 0)
+        {
+            *BlockOutputs[i].Enabled = 1;
+            Known = true;
+        }
+    }
+
+    if (Known)
+    {
+        strncpy(OutputFileNames[NrOfOutputFileNames].FileName, Equal + 1,
+                sizeof(OutputFileNames[0].FileName));
+        OutputFileNames[NrOfOutputFileNames].FileName[sizeof(OutputFileNames[0].FileName) - 1] = '\0';
+        NrOfOutputFileNames++;
+    }
+
+    return Known;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Get the file name of an output: the one given with -O, or the -o
+ * file. */
+static const char* GetOutputFileName(const char* Name,
+                                     const char* AsciiFile)
+{
+    uint32_t i;
+
+    /* the last -O of an output is used */
+    for (i = NrOfOutputFileNames; i > 0; i--)
+    {
+        if (strcmp(OutputFileNames[i - 1].Name, Name) == 0)
+        {
+            return OutputFileNames[i - 1].FileName;
+        }
+    }
+
+    return AsciiFile;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Get the output file FileName, after opening it if it is not yet open
+ * for another output.  Binary is true for the Arrow and Parquet files,
+ * which cannot be shared, and which are written by the caller without
+ * the sbfout stream.  Returns NULL on failure. */
+static OutputFile_t* GetOutputFile(OutputFile_t Files[],
+                                   uint32_t*    NrOfFiles,
+                                   const char*  FileName,
+                                   bool         Binary)
+{
+    OutputFile_t* File;
+    uint32_t      Compression;
+    uint32_t      i;
+
+    for (i = 0; i < *NrOfFiles; i++)
+    {
+        if (strcmp(Files[i].FileName, FileName) == 0)
+        {
+            if (Binary || Files[i].Binary)
+            {
+                fprintf(stderr, "The output file %s cannot be shared by the"
+                        " %s output and the text outputs (see -O).\n",
+                        FileName, OutputFormat == OUTPUTFORMAT_ARROW ? "arrow" : "parquet");
+                return NULL;
+            }
+
+            Files[i].NrOfOutputs++;
+            return &Files[i];
+        }
+    }
+
+    Compression = sbfcompress_GetFormat(FileName);
+
+    if (Compression != SBFCOMPRESS_NONE && Binary)
+    {
+        fprintf(stderr, "The %s output cannot be compressed: %s.\n",
+                OutputFormat == OUTPUTFORMAT_ARROW ? "arrow" : "parquet", FileName);
+        return NULL;
+    }
+
+    if (Compression != SBFCOMPRESS_NONE && !sbfcompress_IsAvailable(Compression))
+    {
+        fprintf(stderr, "The compression of %s is not supported by this build"
+                " (see the Makefile).\n", FileName);
+        return NULL;
+    }
+
+    File = &Files[*NrOfFiles];
+    File->FileName    = FileName;
+    File->Binary      = Binary;
+    File->NrOfOutputs = 1;
+    File->F        = fopen(FileName, (Binary || Compression != SBFCOMPRESS_NONE) ? "wb" : "wt");
+
+    if (File->F == NULL)
+    {
+        perror("Opening of output file failed");
+        return NULL;
+    }
+
+    /* the output is formatted in a large buffer which is written to
+       the file in one go when full, or compressed on the -T threads */
+    if (!Binary &&
+        !(Compression != SBFCOMPRESS_NONE ?
+          sbfout_OpenCompressed(&File->Out, File->F, Compression, NrOfFormatThreads) :
+          sbfout_Open(&File->Out, File->F)))
+    {
+        perror("Allocation of output buffer failed");
+        (void)fclose(File->F);
+        return NULL;
+    }
+
+    (*NrOfFiles)++;
+
+    return File;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* Add the constellations, signals and fields needed by Spec to Mask. */
+static void AddDecodeMask(sbfread_DecodeMask_t* Mask,
+                          const sbfmeasspec_t*  Spec)
+{
+    sbfread_DecodeMask_t SpecMask;
+
+    sbfmeasspec_GetDecodeMask(Spec, &SpecMask);
+
+    Mask->Constellations |= SpecMask.Constellations;
+    Mask->SignalTypes    |= SpecMask.SignalTypes;
+    Mask->Antennas       |= SpecMask.Antennas;
+    Mask->Fields         |= SpecMask.Fields;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void CreateAsciiFile(char*     SBFFile,
+                            char*     AsciiFile,
+                            int64_t   ForcedFirstEpoch_ms,
+                            int64_t   ForcedLastEpoch_ms,
+                            int       ForcedInterval_ms)
+{
+    static sbfconsumer_Table_t Consumers;
+    static sbfs4_t       S4;
+    static sbfmeasspec_t S4Spec;
+    static sbfshm_t      Shm;
+    sbfrinex_Obs_t* RinexObs = NULL;
+    sbfrinex_Nav_t* RinexNav = NULL;
+    sbfshm_t*  Published = NULL;
+    SBFData_t  SBFData;
+    uint8_t    SBFBlock[MAX_SBFSIZE];
+    OutputFile_t Files[MAX_OUTPUTFILES];
+    uint32_t   NrOfFiles = 0;
+    OutputFile_t* File;
+    sbfarrow_Writer_t Arrow;
+    sbfparquet_Writer_t Parquet;
+    MeasText_t MeasText = {NULL, NULL, NULL};
+    OutputFile_t* MeasFile = NULL;
+    int32_t    CloseStatus;
+    bool       Ok = true;
+    uint32_t   i;
+
+    /* initialize the data containers that will be used to decode the SBF blocks */
+    if (InitializeSBFDecoding(SBFFile, &SBFData) != 0)
+    {
+        perror("Opening of SBF file failed");
+        exit(EXIT_FAILURE);
+    }
+
+    /* each output registers its handlers, which write to the file of
+       the output, so that all the outputs are written in one pass over
+       the SBF file */
+    sbfconsumer_Init(&Consumers);
+
+    if (OutputMeas == 1)
+    {
+        File = GetOutputFile(Files, &NrOfFiles, GetOutputFileName("meas", AsciiFile),
+                             OutputFormat != OUTPUTFORMAT_ASCII);
+        Ok = (File != NULL);
+
+        if (Ok && OutputFormat == OUTPUTFORMAT_ARROW)
+        {
+            InitArrowSatNames();
+            Ok = sbfarrow_Open(&Arrow, File->F, ArrowMeasColumns,
+                               HasUTCColumn() ? NR_OF_ARROWCOLS : NR_OF_ARROWCOLS - 1, 0);
+            (void)sbfconsumer_RegisterEpoch(&Consumers, WriteMeasEpochArrow, &Arrow);
+        }
+        else if (Ok && OutputFormat == OUTPUTFORMAT_PARQUET)
+        {
+            InitParquetSignalNames();
+            Ok = sbfparquet_Open(&Parquet, File->F, ParquetMeasColumns,
+                                 HasUTCColumn() ? NR_OF_PQCOLS : NR_OF_PQCOLS - 1, 0);
+            (void)sbfconsumer_RegisterEpoch(&Consumers, WriteMeasEpochParquet, &Parquet);
+        }
+        else if (Ok)
+        {
+            MeasText.Out    = &File->Out;
+            MeasText.Format = UseMeasSpec ? PrintMeasEpochSpec : PrintMeasEpoch;
+            MeasFile        = File;
+            (void)sbfconsumer_RegisterEpoch(&Consumers, WriteMeasEpochText, &MeasText);
+        }
+
+        if (!Ok && File != NULL)
+        {
+            perror("Allocation of output buffers failed");
+            (void)fclose(File->F);
+            NrOfFiles--;
+        }
+    }
+
+    if (Ok && OutputS4 == 1)
+    {
+        File = GetOutputFile(Files, &NrOfFiles, GetOutputFileName("s4", AsciiFile), false);
+        Ok = (File != NULL);
+
+        if (Ok)
+        {
+            (void)sbfmeasspec_Parse(&S4Spec, S4_SIGNALS);
+            S4Spec.TimeFormat = TimeFormat;
+            sbfs4_Init(&S4, &File->Out, &S4Spec);
+            (void)sbfconsumer_RegisterEpoch(&Consumers, AddS4Epoch, &S4);
+        }
+    }
+
+    if (Ok && OutputPlot == 1)
+    {
+        File = GetOutputFile(Files, &NrOfFiles, GetOutputFileName("plot", AsciiFile), false);
+        Ok = (File != NULL);
+
+        if (Ok)
+        {
+            (void)sbfplot_Parse(&Plot, PlotSpec);
+            Plot.Spec.TimeFormat = TimeFormat;
+            sbfplot_Init(&Plot, &File->Out);
+            (void)sbfconsumer_RegisterEpoch(&Consumers, AddPlotEpoch, &Plot);
+        }
+    }
+
+    /* the shared memory is not a file: -O shm=/name is needed */
+    if (Ok && OutputShm == 1)
+    {
+        Ok = sbfshm_Create(&Shm, GetOutputFileName("shm", AsciiFile));
+
+        if (!Ok && errno == ENOSYS)
+        {
+            fprintf(stderr, "The shm output is not supported by this build"
+                    " (see the Makefile).\n");
+        }
+        else if (!Ok)
+        {
+            perror("Creation of shared memory failed");
+        }
+        else
+        {
+            Published = &Shm;
+            (void)sbfconsumer_RegisterEpoch(&Consumers, sbfshm_AddEpoch, &Shm);
+        }
+    }
+
+    if (Ok && OutputRinexObs == 1)
+    {
+        File = GetOutputFile(Files, &NrOfFiles, GetOutputFileName("rinexobs", AsciiFile), false);
+        Ok = (File != NULL);
+
+        if (Ok)
+        {
+            RinexObs = sbfrinex_CreateObs(&File->Out, RinexVersion, VERSION_STRING);
+            Ok = (RinexObs != NULL);
+
+            if (!Ok)
+            {
+                perror("Creation of temporary RINEX file failed");
+            }
+        }
+
+        if (Ok)
+        {
+            (void)sbfconsumer_RegisterEpoch(&Consumers, sbfrinex_AddEpoch, RinexObs);
+            (void)sbfconsumer_RegisterBlock(&Consumers, sbfnr_ReceiverSetup_1, INTERVALms_DONTCARE,
+                                            sbfrinex_AddReceiverSetup, RinexObs);
+            (void)sbfconsumer_RegisterBlock(&Consumers, sbfnr_PVTCartesian_2, INTERVALms_DONTCARE,
+                                            sbfrinex_AddPVTCartesian, RinexObs);
+        }
+    }
+
+    if (Ok && OutputRinexNav == 1)
+    {
+        File = GetOutputFile(Files, &NrOfFiles, GetOutputFileName("rinexnav", AsciiFile), false);
+        Ok = (File != NULL);
+
+        if (Ok)
+        {
+            RinexNav = sbfrinex_CreateNav(&File->Out, RinexVersion, VERSION_STRING);
+            Ok = (RinexNav != NULL);
+
+            if (!Ok)
+            {
+                perror("Allocation of RINEX navigation data failed");
+            }
+        }
+
+        /* all the ephemerides are kept, whatever the -i interval */
+        for (i = 0; Ok && i < SBFRINEX_NR_OF_NAVBLOCKS; i++)
+        {
+            (void)sbfconsumer_RegisterBlock(&Consumers, sbfrinex_NavBlockNumbers[i], INTERVALms_DONTCARE,
+                                            sbfrinex_AddNavBlock, RinexNav);
+        }
+    }
+
+    for (i = 0; Ok && i < NR_OF_BLOCKOUTPUTS; i++)
+    {
+        if (*BlockOutputs[i].Enabled == 1)
+        {
+            File = GetOutputFile(Files, &NrOfFiles,
+                                 GetOutputFileName(BlockOutputs[i].Name, AsciiFile), false);
+            Ok = (File != NULL);
+
+            if (Ok)
+            {
+                (void)sbfconsumer_RegisterBlock(&Consumers, BlockOutputs[i].BlockNumber,
+                                                ForcedInterval_ms,
+                                                BlockOutputs[i].Handler, &File->Out);
+            }
+        }
+    }
+
+    /* the measurements are formatted in parallel if they have their
+       own file: the rows of the other outputs would otherwise have to
+       be kept in order with them */
+    if (Ok && MeasFile != NULL && MeasFile->NrOfOutputs == 1)
+    {
+        MeasText.Batch = sbfbatch_Create(NrOfFormatThreads, &SBFData, MeasText.Out, MeasText.Format);
+    }
+
+    /* without any output, an empty file is created */
+    if (Ok && NrOfFiles == 0 && OutputShm == 0)
+    {
+        Ok = (GetOutputFile(Files, &NrOfFiles, AsciiFile, false) != NULL);
+    }
+
+    if (!Ok)
+    {
+        if (RinexObs != NULL)
+        {
+            (void)sbfrinex_CloseObs(RinexObs);
+        }
+
+        if (RinexNav != NULL)
+        {
+            (void)sbfrinex_CloseNav(RinexNav);
+        }
+
+        if (Published != NULL)
+        {
+            sbfshm_Close(Published);
+        }
+
+        for (i = 0; i < NrOfFiles; i++)
+        {
+            if (!Files[i].Binary)
+            {
+                (void)sbfout_Close(&Files[i].Out);
+            }
+
+            (void)fclose(Files[i].F);
+        }
+
+        (void)CloseSBFFile(&SBFData);
+        return;
+    }
+
+    /* the measurement epochs are decimated by the decoder itself, as
+       the Meas3 reference epochs are needed even when they are not
+       printed */
+    sbfread_SetMeasDecimation(&SBFData, (uint32_t)ForcedInterval_ms);
+
+    /* the observables that are not written are not decoded: with -C,
+       the S4 index and the plot series, only the observables of their
+       signals are needed (RINEX and the shared memory need them all) */
+    if ((OutputMeas == 0 || UseMeasSpec) && OutputRinexObs == 0 && OutputShm == 0 &&
+        (OutputMeas == 1 || OutputS4 == 1 || OutputPlot == 1))
+    {
+        sbfread_DecodeMask_t Mask;
+
+        memset(&Mask, 0, sizeof(Mask));
+
+        if (OutputMeas == 1)
+        {
+            AddDecodeMask(&Mask, &MeasSpec);
+        }
+
+        if (OutputS4 == 1)
+        {
+            AddDecodeMask(&Mask, &S4Spec);
+        }
+
+        if (OutputPlot == 1)
+        {
+            AddDecodeMask(&Mask, &Plot.Spec);
+        }
+
+        sbfread_SetDecodeMask(&SBFData, &Mask);
+    }
+
+    /* read all SBF blocks from the file, one by one */
+    while (GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                        START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
+    {
+        /* Only consider the blocks in the requested time span.  The
+           decimation interval is applied by the handlers of the
+           non-measurement blocks, and by the decoder for the
+           measurement epochs. */
+        if (IncludeThisEpoch(SBFBlock,
+                             ForcedFirstEpoch_ms, ForcedLastEpoch_ms,
+                             INTERVALms_DONTCARE,
+                             AcceptInvalidTime))
+        {
+            sbfconsumer_Dispatch(&Consumers, &SBFData, SBFBlock);
+        }
+
+        /* display the progress report, if enabled */
+        if (VerboseMode == 1)
+        {
+            DisplayProgress(&SBFData);
+        }
+    }
+
+    if (VerboseMode == 1)
+    {
+        fprintf(stdout, "Creating ASCII file: done      \n");
+        (void)fflush(stdout);
+    }
+
+    /* Closing the opened files */
+    sbfbatch_Destroy(MeasText.Batch);
+
+    if (OutputS4 == 1)
+    {
+        sbfs4_Close(&S4);
+    }
+
+    if (OutputPlot == 1 && sbfplot_Close(&Plot) != 0)
+    {
+        perror("Allocation of plot series failed");
+    }
+
+    if (Published != NULL)
+    {
+        sbfshm_Close(Published);
+    }
+
+    if (RinexObs != NULL && sbfrinex_CloseObs(RinexObs) != 0)
+    {
+        perror("Writing of RINEX file failed");
+    }
+
+    if (RinexNav != NULL && sbfrinex_CloseNav(RinexNav) != 0)
+    {
+        perror("Writing of RINEX navigation file failed");
+    }
+
+    for (i = 0; i < NrOfFiles; i++)
+    {
+        if (!Files[i].Binary)
+        {
+            CloseStatus = sbfout_Close(&Files[i].Out);
+        }
+        else if (OutputFormat == OUTPUTFORMAT_ARROW)
+        {
+            CloseStatus = sbfarrow_Close(&Arrow);
+        }
+        else
+        {
+            CloseStatus = sbfparquet_Close(&Parquet);
+        }
+
+        if (CloseStatus != 0)
+        {
+            perror("Writing of output file failed");
+        }
+
+        (void)fclose(Files[i].F);
+    }
+
+    (void)CloseSBFFile(&SBFData);
+    return;
+}
+
+/*---------------------------------------------------------------------------*/
+static int yearOffset[4] = {0, 366, 366 + 365, 366 + 365 + 365};
+static int dayCount[12]  = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+static int ConvertDateToGPSDay(int         year,
+                               int         month,
+                               int         day)
+{
+    int  fouryear_interval = year % 4;
+    int  GPSDay;
+
+    /* # days from beginning of 1980 till beginning of the current
+         4-year period (NB: 1461=365.25*4)*/
+    GPSDay = 1461 * ((year - 1980) / 4);
+
+    /* add the number of days from the beginning of the current 4-year
+       period to the beginning of the current year */
+    GPSDay += yearOffset[fouryear_interval];
+
+    /* add number of full days elapsed since the beginning of the
+       current year */
+    GPSDay += dayCount[month - 1] + day - 1;
+
+    /* compensate for leap year */
+    if ((fouryear_interval == 0) && (month >= 3))
+    {
+        GPSDay++;
+    }
+
+    /* GPS time starts January 6th, 1980, so remove 5 days */
+    GPSDay -= 5;
+
+    return GPSDay;
+}
+
+
+/*---------------------------------------------------------------------------*/
+double ConvertDateTimeToGPSsec(int         year,
+                               int         month,
+                               int         day,
+                               int         hour,
+                               int         min,
+                               double      sec)
+{
+    uint32_t GPSday = ConvertDateToGPSDay(year, month, day);
+
+    return (GPSday * 86400.0 + (double)(hour * 3600 + min * 60) + sec);
+}
+
+
+#ifdef SBF2ASC_PROFILE_MAIN
+/*---------------------------------------------------------------------------*/
+static uint32_t GetFileAntennas(char* SBFFile)
+/* returns the antennas seen in the measurement blocks of the first
+   SBF2ASC_PROFILE_PROBE_EPOCHS epochs of the file, as a mask with the
+   bit (1<<AntIdx) set for each of them */
+{
+    static SBFData_t SBFData;
+    static uint8_t   SBFBlock[MAX_SBFSIZE];
+    uint32_t  Antennas = 0;
+    uint32_t  NrOfEpochs = 0;
+    uint32_t  TOW = UINT32_MAX;
+
+    if (InitializeSBFDecoding(SBFFile, &SBFData) != 0)
+    {
+        return 0;
+    }
+
+    while (GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                        START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
+    {
+        const uint32_t BlockAntennas = sbfread_GetMeasBlockAntennas(SBFBlock);
+
+        if (BlockAntennas != 0 && ((HeaderAndTimeBlock_t*)SBFBlock)->TOW != TOW)
+        {
+            if (++NrOfEpochs > SBF2ASC_PROFILE_PROBE_EPOCHS)
+            {
+                break;
+            }
+
+            TOW = ((HeaderAndTimeBlock_t*)SBFBlock)->TOW;
+        }
+
+        Antennas |= BlockAntennas;
+    }
+
+    (void)CloseSBFFile(&SBFData);
+
+    return Antennas;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int SBF2ASC_PROFILE_MAIN(int argc, char* argv[], bool LastProfile)
+#else
+/*---------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+#endif
+{
+    char       SBFFileName[256];
+    char       AsciiFileName[256];
+    int        optionchar;
+    double     Interval;
+
+    int        year, month, day, hour, min;
+    double     sec;
+    char       dummy;
+    int64_t    ForcedFirstEpoch_ms, ForcedLastEpoch_ms;
+    int        ForcedInterval_ms;
+
+    /* Set the file names to an empty string. */
+    SBFFileName[0]   = '\0';
+    AsciiFileName[0] = '\0';
+
+    /* No specs on the first and last epoch to put on the file */
+    ForcedFirstEpoch_ms  = FIRSTEPOCHms_DONTCARE;
+    ForcedLastEpoch_ms   = LASTEPOCHms_DONTCARE;
+    ForcedInterval_ms    = INTERVALms_DONTCARE;
+
+    /* Parse the command line options: */
+    ssn_opterr = 0;    /* Warn the user if an invalid option was entered. */
+
+    while ((optionchar = ssn_getopt(argc, argv, "f:o:b:e:mgcpsadjIvVEi:xtnlkhuF:C:O:P:R:T:Z:")) != -1)
+    {
+        switch (optionchar)
+        {
+        case 'b':
+
+            /* First time to include in the file */
+            /* If there is a '-' in the argument, we assume that a date
+                              * is provided */
+            if (strchr(ssn_optarg, '-') != NULL)
+            {
+                (void)sscanf(ssn_optarg, "%d%c%d%c%d%c%d%c%d%c%lf",
+                             &year, &dummy, &month, &dummy, &day, &dummy,
+                             &hour, &dummy, &min, &dummy, &sec);
+                ForcedFirstEpoch_ms
+                    = (int64_t)(ConvertDateTimeToGPSsec(year, month, day, hour, min, sec)
+                                * 1000.0 + 0.5);
+            }
+            else
+            {
+                (void)sscanf(ssn_optarg, "%d%c%d%c%lf",
+                             &hour, &dummy, &min, &dummy, &sec);
+                ForcedFirstEpoch_ms = hour * 3600000 + min * 60000 + (int64_t)(sec * 1000 + 0.5);
+            }
+
+            break;
+
+        case 'e':
+
+            /* Last time to include in the file */
+            if (strchr(ssn_optarg, '-') != NULL)
+            {
+                (void)sscanf(ssn_optarg, "%d%c%d%c%d%c%d%c%d%c%lf",
+                             &year, &dummy, &month, &dummy, &day, &dummy,
+                             &hour, &dummy, &min, &dummy, &sec);
+                ForcedLastEpoch_ms
+                    = (int64_t)(ConvertDateTimeToGPSsec(year, month, day, hour, min, sec)
+                                * 1000.0 + 0.5);
+            }
+            else
+            {
+                (void)sscanf(ssn_optarg, "%d%c%d%c%lf",
+                             &hour, &dummy, &min, &dummy, &sec);
+                ForcedLastEpoch_ms = hour * 3600000 + min * 60000 + (int64_t)(sec * 1000 + 0.5);
+            }
+
+            break;
+
+        case 'i':
+            if (sscanf(ssn_optarg, "%lf", &Interval) != 1)
+            {
+                fprintf(stderr, "Unparsable argument '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            ForcedInterval_ms = (uint32_t)(Interval * 1000.0 + 0.5);
+            break;
+
+        case 'F':
+            if (strcmp(ssn_optarg, "asc") == 0)
+            {
+                OutputFormat = OUTPUTFORMAT_ASCII;
+            }
+            else if (strcmp(ssn_optarg, "arrow") == 0)
+            {
+                OutputFormat = OUTPUTFORMAT_ARROW;
+            }
+            else if (strcmp(ssn_optarg, "parquet") == 0)
+            {
+                OutputFormat = OUTPUTFORMAT_PARQUET;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown output format '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            break;
+
+        case 'f':
+            strncpy(SBFFileName, ssn_optarg, sizeof(SBFFileName));
+            SBFFileName[sizeof(SBFFileName) - 1] = '\0';
+            break;
 
         case 'o':
             strncpy(AsciiFileName, ssn_optarg, sizeof(AsciiFileName));
@@ -1125,6 +2298,70 @@ int main(int argc, char* argv[])
             AcceptInvalidTime = false;
             break;
 
+        case 'C':
+            if (!sbfmeasspec_Parse(&MeasSpec, ssn_optarg))
+            {
+                fprintf(stderr, "Invalid column selection '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            UseMeasSpec = true;
+            OutputMeas  = 1;
+            break;
+
+        case 'P':
+            if (!sbfplot_Parse(&Plot, ssn_optarg))
+            {
+                fprintf(stderr, "Invalid plot series '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            PlotSpec = ssn_optarg;
+            break;
+
+        case 'R':
+            if (sscanf(ssn_optarg, "%u", &RinexVersion) != 1 ||
+                (RinexVersion != 3 && RinexVersion != 4))
+            {
+                fprintf(stderr, "Unsupported RINEX version '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            break;
+
+        case 'T':
+            if (sscanf(ssn_optarg, "%u", &NrOfFormatThreads) != 1)
+            {
+                fprintf(stderr, "Unparsable argument '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            break;
+
+        case 'Z':
+            if (!sbftime_ParseFormat(ssn_optarg, &TimeFormat))
+            {
+                fprintf(stderr, "Unknown time format '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            break;
+
+        case 'O':
+            if (!SetOutputFile(ssn_optarg))
+            {
+                fprintf(stderr, "Invalid output '%s'.\n", ssn_optarg);
+                usage();
+                return 3;
+            }
+
+            break;
+
         case 'V':
             fprintf(stdout, "%s\n", VERSION_STRING);
             return 0;
@@ -1156,12 +2393,44 @@ int main(int argc, char* argv[])
         return 3;
     }
 
+    MeasSpec.TimeFormat = TimeFormat;
+
+    if (UseMeasSpec && OutputFormat != OUTPUTFORMAT_ASCII)
+    {
+        fprintf(stderr, "The column selection (-C) requires the asc format.\n");
+        return 3;
+    }
+
+    /* The Arrow and Parquet files hold the measurements only */
+    if (OutputFormat != OUTPUTFORMAT_ASCII && OutputMeas != 1)
+    {
+        fprintf(stderr, "The %s format requires the measurements (-m).\n",
+                OutputFormat == OUTPUTFORMAT_ARROW ? "arrow" : "parquet");
+        return 3;
+    }
+
     /* If no AsciiFileName has been given, then use "measasc.dat" as
      * default: */
     if (strlen(AsciiFileName) == 0)
     {
-        strcpy(AsciiFileName, "measasc.dat");
+        strcpy(AsciiFileName,
+               OutputFormat == OUTPUTFORMAT_ARROW   ? "measasc.arrow" :
+               OutputFormat == OUTPUTFORMAT_PARQUET ? "measasc.parquet" : "measasc.dat");
+    }
+
+#ifdef SBF2ASC_PROFILE_MAIN
+    /* the file has more antennas than this profile: it is converted by
+       the next one */
+    if (!LastProfile && (GetFileAntennas(SBFFileName) >> NR_OF_ANTENNAS) != 0)
+    {
+        return SBF2ASC_PROFILE_TOO_SMALL;
+    }
+
+    if (VerboseMode == 1)
+    {
+        fprintf(stdout, "Epoch profile: %d antenna(s)\n", NR_OF_ANTENNAS);
     }
+#endif
 
     CreateAsciiFile(SBFFileName, AsciiFileName,
                     ForcedFirstEpoch_ms, ForcedLastEpoch_ms, ForcedInterval_ms);
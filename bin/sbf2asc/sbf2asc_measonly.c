@@ -30,7 +30,11 @@ void main(int argc, char* argv[])
     MeasEpoch_t MeasEpoch;
 
     /* initialize the data containers that will be used to decode the SBF blocks */
-    InitializeSBFDecoding(argv[1], &SBFData);
+    if (InitializeSBFDecoding(argv[1], &SBFData) != 0)
+    {
+        perror("Opening of SBF file failed");
+        return;
+    }
 
     /* read all SBF blocks from the file, one by one */
     while (GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
@@ -0,0 +1,56 @@
+/*
+ * sbf2asc_profiles.c: main() of sbf2asc built for several epoch
+ *                     profiles, selecting the profile at run time
+ *                     (see sbf2asc_profiles.h).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stddef.h>
+
+#include "sbf2asc_profiles.h"
+
+#ifndef SBF2ASC_PROFILE_LIST
+# error SBF2ASC_PROFILE_LIST must list the profiles, see the Makefile
+#endif
+
+#define X(N) SBF2ASC_PROFILE_DECLARE(N)
+SBF2ASC_PROFILE_LIST
+#undef X
+
+typedef int (*sbf2asc_Main_t)(int argc, char* argv[], bool LastProfile);
+
+static const sbf2asc_Main_t Profiles[] =
+{
+#define X(N) sbf2asc_Main_##N,
+    SBF2ASC_PROFILE_LIST
+#undef X
+};
+
+#define NR_OF_PROFILES  (sizeof(Profiles) / sizeof(Profiles[0]))
+
+
+/*---------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    size_t i;
+    int    Result = SBF2ASC_PROFILE_TOO_SMALL;
+
+    /* the smallest profile that supports the antennas of the file */
+    for (i = 0; i < NR_OF_PROFILES && Result == SBF2ASC_PROFILE_TOO_SMALL; i++)
+    {
+        Result = Profiles[i](argc, argv, i + 1 == NR_OF_PROFILES);
+    }
+
+    return Result;
+}
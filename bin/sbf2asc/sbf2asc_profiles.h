@@ -0,0 +1,43 @@
+/*
+ * sbf2asc_profiles.h: sbf2asc built for several epoch profiles (see
+ * EPOCH_PROFILES in the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBF2ASC_PROFILES_H
+#define SBF2ASC_PROFILES_H 1
+
+#include <stdbool.h>
+
+/* With EPOCH_PROFILES, the whole program is built once per number of
+   antennas N, with -DNR_OF_ANTENNAS=N and its main() renamed
+   sbf2asc_Main_N() (SBF2ASC_PROFILE_MAIN).  Each build is linked into
+   a single object of which only sbf2asc_Main_N() stays global, so that
+   the builds do not clash, and sbf2asc_profiles.c calls them from the
+   smallest to the largest profile.  A profile that sees more antennas
+   in the first SBF2ASC_PROFILE_PROBE_EPOCHS measurement epochs of the
+   file than it supports returns SBF2ASC_PROFILE_TOO_SMALL before
+   writing anything, unless it is the last one (LastProfile), which
+   converts the file whatever its antennas. */
+#define SBF2ASC_PROFILE_PROBE_EPOCHS  10
+#define SBF2ASC_PROFILE_TOO_SMALL     (-1)
+
+/* sbf2asc_profiles.c is built with SBF2ASC_PROFILE_LIST set to
+   X(N1) X(N2)..., the numbers of antennas of the profiles in
+   increasing order */
+#define SBF2ASC_PROFILE_DECLARE(N) \
+    int sbf2asc_Main_##N(int argc, char* argv[], bool LastProfile);
+
+#endif
+/* End of "ifndef SBF2ASC_PROFILES_H" */
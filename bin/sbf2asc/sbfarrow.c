@@ -0,0 +1,957 @@
+/*
+ * sbfarrow.c: Self-contained writer of Apache Arrow IPC files
+ *             (Feather v2).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* An Arrow IPC file is made of:
+ *
+ *   "ARROW1\0\0"
+ *   the schema message
+ *   one dictionary batch message per dictionary-encoded column
+ *   the record batch messages
+ *   the end-of-stream marker
+ *   the footer, which lists the offsets of all the messages
+ *   the length of the footer (int32) and "ARROW1"
+ *
+ * Each message is a continuation marker (0xFFFFFFFF), the length of
+ * its metadata, the metadata as a flatbuffer (Message.fbs) padded to 8
+ * bytes, and the body with the column buffers, each padded to 8
+ * bytes.  The flatbuffers are built by the minimal builder below,
+ * which, as the reference implementation, fills its buffer from the
+ * end: children are created before their parents.  The column values
+ * are written in the byte order of the host, which must be
+ * little-endian as for the SBF decoding itself.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sbfarrow.h"
+
+/* Arrow metadata version V5 */
+#define SBFARROW_METADATA_V5       4
+
+/* MessageHeader union */
+#define SBFARROW_HEADER_SCHEMA     1
+#define SBFARROW_HEADER_DICTBATCH  2
+#define SBFARROW_HEADER_RECBATCH   3
+
+/* Type union */
+#define SBFARROW_TYPE_INT          2
+#define SBFARROW_TYPE_FLOAT        3
+#define SBFARROW_TYPE_UTF8         5
+
+/* FloatingPoint precision */
+#define SBFARROW_PRECISION_SINGLE  1
+#define SBFARROW_PRECISION_DOUBLE  2
+
+#define SBFARROW_ALIGN8(x)  (((x) + 7) & ~(size_t)7)
+
+/* maximum number of fields in a table */
+#define SBFARROW_FB_MAX_FIELDS     8
+
+struct sbfarrow_Fb_s
+{
+    uint8_t*          Buf;
+    size_t            Cap;
+    size_t            Size;         /* bytes used, at the end of Buf */
+    size_t            MinAlign;
+    size_t            TableStart;   /* Size when the table was started */
+    uint32_t          NrOfFields;
+    uint16_t          FieldId[SBFARROW_FB_MAX_FIELDS];
+    size_t            FieldRef[SBFARROW_FB_MAX_FIELDS];
+    bool              Error;
+};
+
+typedef struct sbfarrow_Fb_s sbfarrow_Fb_t;
+
+/* objects in the flatbuffer are referred to by their distance from
+   the end of the buffer, which does not change while the buffer grows
+   towards its start */
+typedef size_t sbfarrow_Ref_t;
+
+static const uint8_t Magic[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+static const uint8_t Zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_Push(sbfarrow_Fb_t* Fb,
+                             const void*    Data,
+                             size_t         Len)
+{
+    if (Len == 0)
+    {
+        return;
+    }
+
+    if (Fb->Cap - Fb->Size < Len)
+    {
+        size_t   NewCap = Fb->Cap * 2 + Len;
+        uint8_t* NewBuf = (uint8_t*)malloc(NewCap);
+
+        if (NewBuf == NULL)
+        {
+            Fb->Error = true;
+            return;
+        }
+
+        memcpy(NewBuf + NewCap - Fb->Size, Fb->Buf + Fb->Cap - Fb->Size, Fb->Size);
+        free(Fb->Buf);
+        Fb->Buf = NewBuf;
+        Fb->Cap = NewCap;
+    }
+
+    Fb->Size += Len;
+    memcpy(Fb->Buf + Fb->Cap - Fb->Size, Data, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_PushLE(sbfarrow_Fb_t* Fb,
+                               uint64_t       Value,
+                               size_t         Len)
+{
+    uint8_t Bytes[8];
+    size_t  i;
+
+    for (i = 0; i < Len; i++)
+    {
+        Bytes[i] = (uint8_t)(Value >> (8 * i));
+    }
+
+    sbfarrow_Fb_Push(Fb, Bytes, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_Prep(sbfarrow_Fb_t* Fb,
+                             size_t         Align,
+                             size_t         Additional)
+/* pads the buffer so that it is aligned on Align bytes once Additional
+   more bytes are pushed */
+{
+    size_t Pad = (0 - (Fb->Size + Additional)) & (Align - 1);
+
+    if (Align > Fb->MinAlign)
+    {
+        Fb->MinAlign = Align;
+    }
+
+    sbfarrow_Fb_Push(Fb, Zeros, Pad);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_Reset(sbfarrow_Fb_t* Fb)
+{
+    Fb->Size     = 0;
+    Fb->MinAlign = 1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_Fb_String(sbfarrow_Fb_t* Fb,
+                                         const char*    String)
+{
+    size_t Len = strlen(String);
+
+    sbfarrow_Fb_Prep(Fb, 4, Len + 1);
+    sbfarrow_Fb_Push(Fb, Zeros, 1);
+    sbfarrow_Fb_Push(Fb, String, Len);
+    sbfarrow_Fb_PushLE(Fb, Len, 4);
+
+    return Fb->Size;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_Fb_OffsetVector(sbfarrow_Fb_t*        Fb,
+                                               const sbfarrow_Ref_t* Refs,
+                                               uint32_t              Count)
+{
+    uint32_t i;
+
+    sbfarrow_Fb_Prep(Fb, 4, 4 * (size_t)Count);
+
+    for (i = Count; i > 0; i--)
+    {
+        sbfarrow_Fb_PushLE(Fb, Fb->Size + 4 - Refs[i - 1], 4);
+    }
+
+    sbfarrow_Fb_PushLE(Fb, Count, 4);
+
+    return Fb->Size;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_Fb_StructVector(sbfarrow_Fb_t* Fb,
+                                               const uint8_t* Structs,
+                                               size_t         StructSize,
+                                               uint32_t       Count)
+/* vector of Count structs of StructSize bytes, aligned on 8 bytes */
+{
+    uint32_t i;
+
+    sbfarrow_Fb_Prep(Fb, 8, StructSize * Count);
+
+    for (i = Count; i > 0; i--)
+    {
+        sbfarrow_Fb_Push(Fb, Structs + (i - 1) * StructSize, StructSize);
+    }
+
+    sbfarrow_Fb_PushLE(Fb, Count, 4);
+
+    return Fb->Size;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_StartTable(sbfarrow_Fb_t* Fb)
+{
+    Fb->TableStart = Fb->Size;
+    Fb->NrOfFields = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_AddScalar(sbfarrow_Fb_t* Fb,
+                                  uint16_t       Id,
+                                  uint64_t       Value,
+                                  size_t         Len)
+{
+    sbfarrow_Fb_Prep(Fb, Len, Len);
+    sbfarrow_Fb_PushLE(Fb, Value, Len);
+
+    Fb->FieldId[Fb->NrOfFields]  = Id;
+    Fb->FieldRef[Fb->NrOfFields] = Fb->Size;
+    Fb->NrOfFields++;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Fb_AddOffset(sbfarrow_Fb_t* Fb,
+                                  uint16_t       Id,
+                                  sbfarrow_Ref_t Ref)
+{
+    sbfarrow_Fb_Prep(Fb, 4, 4);
+    sbfarrow_Fb_PushLE(Fb, Fb->Size + 4 - Ref, 4);
+
+    Fb->FieldId[Fb->NrOfFields]  = Id;
+    Fb->FieldRef[Fb->NrOfFields] = Fb->Size;
+    Fb->NrOfFields++;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_Fb_EndTable(sbfarrow_Fb_t* Fb)
+/* writes the table offset to its vtable, and the vtable itself just
+   before the table */
+{
+    uint16_t       Slots[SBFARROW_FB_MAX_FIELDS];
+    uint32_t       NrOfSlots = 0;
+    sbfarrow_Ref_t Table;
+    sbfarrow_Ref_t VTable;
+    uint32_t       i;
+
+    sbfarrow_Fb_Prep(Fb, 4, 4);
+    sbfarrow_Fb_PushLE(Fb, 0, 4);
+    Table = Fb->Size;
+
+    memset(Slots, 0, sizeof(Slots));
+
+    for (i = 0; i < Fb->NrOfFields; i++)
+    {
+        Slots[Fb->FieldId[i]] = (uint16_t)(Table - Fb->FieldRef[i]);
+
+        if (Fb->FieldId[i] + 1U > NrOfSlots)
+        {
+            NrOfSlots = Fb->FieldId[i] + 1U;
+        }
+    }
+
+    for (i = NrOfSlots; i > 0; i--)
+    {
+        sbfarrow_Fb_PushLE(Fb, Slots[i - 1], 2);
+    }
+
+    sbfarrow_Fb_PushLE(Fb, Table - Fb->TableStart, 2);
+    sbfarrow_Fb_PushLE(Fb, 4 + 2 * NrOfSlots, 2);
+    VTable = Fb->Size;
+
+    /* the table starts with the (signed) offset from its vtable */
+    if (!Fb->Error)
+    {
+        uint32_t SOffset = (uint32_t)(VTable - Table);
+        uint8_t* p       = Fb->Buf + Fb->Cap - Table;
+
+        p[0] = (uint8_t)SOffset;
+        p[1] = (uint8_t)(SOffset >> 8);
+        p[2] = (uint8_t)(SOffset >> 16);
+        p[3] = (uint8_t)(SOffset >> 24);
+    }
+
+    return Table;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static const uint8_t* sbfarrow_Fb_Finish(sbfarrow_Fb_t* Fb,
+                                         sbfarrow_Ref_t Root)
+/* adds the offset to the root table, and returns the start of the
+   flatbuffer (of Fb->Size bytes) */
+{
+    sbfarrow_Fb_Prep(Fb, Fb->MinAlign, 4);
+    sbfarrow_Fb_PushLE(Fb, Fb->Size + 4 - Root, 4);
+
+    return Fb->Buf + Fb->Cap - Fb->Size;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_Fb_IntType(sbfarrow_Fb_t* Fb,
+                                          uint32_t       BitWidth,
+                                          bool           Signed)
+{
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddScalar(Fb, 0, BitWidth, 4);
+    sbfarrow_Fb_AddScalar(Fb, 1, Signed ? 1 : 0, 1);
+
+    return sbfarrow_Fb_EndTable(Fb);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_BuildSchema(sbfarrow_Writer_t* Writer)
+{
+    sbfarrow_Fb_t* Fb = Writer->Fb;
+    sbfarrow_Ref_t Fields[SBFARROW_MAX_COLUMNS];
+    sbfarrow_Ref_t FieldsVector;
+    uint32_t       Col;
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        const sbfarrow_Column_t* Column = &Writer->Columns[Col];
+        sbfarrow_Ref_t           Name;
+        sbfarrow_Ref_t           Type;
+        sbfarrow_Ref_t           Dictionary = 0;
+        sbfarrow_Ref_t           Children;
+        uint8_t                  TypeType;
+
+        Name = sbfarrow_Fb_String(Fb, Column->Name);
+
+        switch (Column->Type)
+        {
+        case SBFARROW_INT64:
+            TypeType = SBFARROW_TYPE_INT;
+            Type     = sbfarrow_Fb_IntType(Fb, 64, true);
+            break;
+
+        case SBFARROW_UINT8:
+            TypeType = SBFARROW_TYPE_INT;
+            Type     = sbfarrow_Fb_IntType(Fb, 8, false);
+            break;
+
+        case SBFARROW_FLOAT32:
+        case SBFARROW_FLOAT64:
+            TypeType = SBFARROW_TYPE_FLOAT;
+            sbfarrow_Fb_StartTable(Fb);
+            sbfarrow_Fb_AddScalar(Fb, 0, Column->Type == SBFARROW_FLOAT32 ?
+                                  SBFARROW_PRECISION_SINGLE : SBFARROW_PRECISION_DOUBLE, 2);
+            Type = sbfarrow_Fb_EndTable(Fb);
+            break;
+
+        default:
+        {
+            /* the type of the field is the type of the dictionary
+               values; the type of the indices is in the encoding */
+            sbfarrow_Ref_t IndexType = sbfarrow_Fb_IntType(Fb, 16, true);
+
+            sbfarrow_Fb_StartTable(Fb);
+            sbfarrow_Fb_AddScalar(Fb, 0, Col, 8);   /* dictionary id */
+            sbfarrow_Fb_AddOffset(Fb, 1, IndexType);
+            Dictionary = sbfarrow_Fb_EndTable(Fb);
+
+            TypeType = SBFARROW_TYPE_UTF8;
+            sbfarrow_Fb_StartTable(Fb);
+            Type = sbfarrow_Fb_EndTable(Fb);
+            break;
+        }
+        }
+
+        Children = sbfarrow_Fb_OffsetVector(Fb, NULL, 0);
+
+        sbfarrow_Fb_StartTable(Fb);
+        sbfarrow_Fb_AddOffset(Fb, 0, Name);
+        sbfarrow_Fb_AddScalar(Fb, 1, 1, 1);          /* nullable */
+        sbfarrow_Fb_AddScalar(Fb, 2, TypeType, 1);
+        sbfarrow_Fb_AddOffset(Fb, 3, Type);
+
+        if (Dictionary != 0)
+        {
+            sbfarrow_Fb_AddOffset(Fb, 4, Dictionary);
+        }
+
+        sbfarrow_Fb_AddOffset(Fb, 5, Children);
+        Fields[Col] = sbfarrow_Fb_EndTable(Fb);
+    }
+
+    FieldsVector = sbfarrow_Fb_OffsetVector(Fb, Fields, Writer->NrOfColumns);
+
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddScalar(Fb, 0, 0, 2);              /* little-endian */
+    sbfarrow_Fb_AddOffset(Fb, 1, FieldsVector);
+
+    return sbfarrow_Fb_EndTable(Fb);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfarrow_Ref_t sbfarrow_BuildRecordBatch(sbfarrow_Fb_t* Fb,
+                                                int64_t        Length,
+                                                const int64_t* Nodes,
+                                                uint32_t       NrOfNodes,
+                                                const int64_t* Buffers,
+                                                uint32_t       NrOfBuffers)
+/* Nodes are the (length, null count) pairs of the columns, and Buffers
+   the (offset, length) pairs of their buffers in the message body */
+{
+    uint8_t        Structs[2 * SBFARROW_MAX_COLUMNS * 16];
+    sbfarrow_Ref_t NodesVector;
+    sbfarrow_Ref_t BuffersVector;
+    uint32_t       i, j;
+
+    for (i = 0; i < 2 * NrOfNodes; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            Structs[8 * i + j] = (uint8_t)((uint64_t)Nodes[i] >> (8 * j));
+        }
+    }
+
+    NodesVector = sbfarrow_Fb_StructVector(Fb, Structs, 16, NrOfNodes);
+
+    for (i = 0; i < 2 * NrOfBuffers; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            Structs[8 * i + j] = (uint8_t)((uint64_t)Buffers[i] >> (8 * j));
+        }
+    }
+
+    BuffersVector = sbfarrow_Fb_StructVector(Fb, Structs, 16, NrOfBuffers);
+
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddScalar(Fb, 0, (uint64_t)Length, 8);
+    sbfarrow_Fb_AddOffset(Fb, 1, NodesVector);
+    sbfarrow_Fb_AddOffset(Fb, 2, BuffersVector);
+
+    return sbfarrow_Fb_EndTable(Fb);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Write(sbfarrow_Writer_t* Writer,
+                           const void*        Data,
+                           size_t             Len)
+{
+    sbfout_Write(&Writer->Out, Data, Len);
+    Writer->Offset += (int64_t)Len;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_WritePadding(sbfarrow_Writer_t* Writer)
+/* pads the file to a multiple of 8 bytes */
+{
+    sbfarrow_Write(Writer, Zeros, (size_t)(-Writer->Offset & 7));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_WriteMessage(sbfarrow_Writer_t* Writer,
+                                  uint8_t            HeaderType,
+                                  sbfarrow_Ref_t     Header,
+                                  int64_t            BodyLength,
+                                  sbfarrow_Block_t*  Block)
+/* writes the metadata of a message whose header has just been built;
+   the body has to be written next */
+{
+    sbfarrow_Fb_t* Fb = Writer->Fb;
+    const uint8_t* Metadata;
+    uint8_t        Prefix[8] = {0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0};
+    size_t         Len;
+    sbfarrow_Ref_t Message;
+
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddScalar(Fb, 3, (uint64_t)BodyLength, 8);
+    sbfarrow_Fb_AddOffset(Fb, 2, Header);
+    sbfarrow_Fb_AddScalar(Fb, 0, SBFARROW_METADATA_V5, 2);
+    sbfarrow_Fb_AddScalar(Fb, 1, HeaderType, 1);
+    Message  = sbfarrow_Fb_EndTable(Fb);
+    Metadata = sbfarrow_Fb_Finish(Fb, Message);
+
+    if (Fb->Error)
+    {
+        Writer->Error = true;
+        return;
+    }
+
+    Len = SBFARROW_ALIGN8(Fb->Size);
+    Prefix[4] = (uint8_t)Len;
+    Prefix[5] = (uint8_t)(Len >> 8);
+    Prefix[6] = (uint8_t)(Len >> 16);
+    Prefix[7] = (uint8_t)(Len >> 24);
+
+    if (Block != NULL)
+    {
+        Block->Offset         = Writer->Offset;
+        Block->MetaDataLength = (int32_t)(8 + Len);
+        Block->BodyLength     = BodyLength;
+    }
+
+    sbfarrow_Write(Writer, Prefix, sizeof(Prefix));
+    sbfarrow_Write(Writer, Metadata, Fb->Size);
+    sbfarrow_WritePadding(Writer);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static size_t sbfarrow_ValueSize(sbfarrow_Type_t Type)
+{
+    switch (Type)
+    {
+    case SBFARROW_INT64:
+    case SBFARROW_FLOAT64:
+        return 8;
+
+    case SBFARROW_FLOAT32:
+        return 4;
+
+    case SBFARROW_DICT16:
+        return 2;
+
+    default:
+        return 1;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_WriteDictionary(sbfarrow_Writer_t* Writer,
+                                     uint32_t           Col)
+/* writes the values of the dictionary of column Col as a utf8 array */
+{
+    const sbfarrow_Column_t* Column = &Writer->Columns[Col];
+    sbfarrow_Fb_t*           Fb = Writer->Fb;
+    int64_t                  Nodes[2];
+    int64_t                  Buffers[6];
+    size_t                   DataLen = 0;
+    uint8_t                  Offset[4];
+    sbfarrow_Ref_t           Data;
+    sbfarrow_Ref_t           Batch;
+    uint32_t                 i;
+
+    for (i = 0; i < Column->DictionarySize; i++)
+    {
+        DataLen += strlen(Column->Dictionary[i]);
+    }
+
+    Nodes[0]   = Column->DictionarySize;
+    Nodes[1]   = 0;
+    Buffers[0] = 0;          /* no validity bitmap */
+    Buffers[1] = 0;
+    Buffers[2] = 0;          /* offsets */
+    Buffers[3] = 4 * ((int64_t)Column->DictionarySize + 1);
+    Buffers[4] = (int64_t)SBFARROW_ALIGN8((size_t)Buffers[3]);
+    Buffers[5] = (int64_t)DataLen;
+
+    sbfarrow_Fb_Reset(Fb);
+    Data = sbfarrow_BuildRecordBatch(Fb, Column->DictionarySize, Nodes, 1, Buffers, 3);
+
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddScalar(Fb, 0, Col, 8);
+    sbfarrow_Fb_AddOffset(Fb, 1, Data);
+    Batch = sbfarrow_Fb_EndTable(Fb);
+
+    sbfarrow_WriteMessage(Writer, SBFARROW_HEADER_DICTBATCH, Batch,
+                          Buffers[4] + (int64_t)SBFARROW_ALIGN8(DataLen),
+                          &Writer->Dictionaries[Writer->NrOfDictionaries++]);
+
+    DataLen = 0;
+
+    for (i = 0; i <= Column->DictionarySize; i++)
+    {
+        Offset[0] = (uint8_t)DataLen;
+        Offset[1] = (uint8_t)(DataLen >> 8);
+        Offset[2] = (uint8_t)(DataLen >> 16);
+        Offset[3] = (uint8_t)(DataLen >> 24);
+        sbfarrow_Write(Writer, Offset, 4);
+
+        if (i < Column->DictionarySize)
+        {
+            DataLen += strlen(Column->Dictionary[i]);
+        }
+    }
+
+    sbfarrow_WritePadding(Writer);
+
+    for (i = 0; i < Column->DictionarySize; i++)
+    {
+        sbfarrow_Write(Writer, Column->Dictionary[i], strlen(Column->Dictionary[i]));
+    }
+
+    sbfarrow_WritePadding(Writer);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_WriteBatch(sbfarrow_Writer_t* Writer)
+/* writes the rows of the current batch as a record batch message */
+{
+    int64_t           Nodes[2 * SBFARROW_MAX_COLUMNS];
+    int64_t           Buffers[4 * SBFARROW_MAX_COLUMNS];
+    int64_t           BodyLength = 0;
+    size_t            BitmapLen = ((size_t)Writer->NrOfRows + 7) / 8;
+    sbfarrow_Ref_t    Batch;
+    sbfarrow_Block_t* Block;
+    uint32_t          Col;
+
+    if (Writer->NrOfBatches == Writer->BatchesSize)
+    {
+        uint32_t          NewSize = Writer->BatchesSize * 2 + 16;
+        sbfarrow_Block_t* NewBatches = (sbfarrow_Block_t*)realloc(Writer->Batches,
+                                                                  NewSize * sizeof(sbfarrow_Block_t));
+
+        if (NewBatches == NULL)
+        {
+            Writer->Error = true;
+            return;
+        }
+
+        Writer->Batches     = NewBatches;
+        Writer->BatchesSize = NewSize;
+    }
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        size_t   ValuesLen = Writer->NrOfRows * sbfarrow_ValueSize(Writer->Columns[Col].Type);
+        uint32_t NrOfValid = 0;
+        size_t   i;
+
+        for (i = 0; i < BitmapLen; i++)
+        {
+            uint32_t Bits = Writer->Validity[Col][i];
+
+            for (; Bits != 0; Bits &= Bits - 1)
+            {
+                NrOfValid++;
+            }
+        }
+
+        Nodes[2 * Col]     = Writer->NrOfRows;
+        Nodes[2 * Col + 1] = Writer->NrOfRows - NrOfValid;
+
+        /* the validity bitmap can be left out when there are no nulls */
+        Buffers[4 * Col]     = BodyLength;
+        Buffers[4 * Col + 1] = NrOfValid < Writer->NrOfRows ? (int64_t)BitmapLen : 0;
+        BodyLength          += (int64_t)SBFARROW_ALIGN8((size_t)Buffers[4 * Col + 1]);
+        Buffers[4 * Col + 2] = BodyLength;
+        Buffers[4 * Col + 3] = (int64_t)ValuesLen;
+        BodyLength          += (int64_t)SBFARROW_ALIGN8(ValuesLen);
+    }
+
+    sbfarrow_Fb_Reset(Writer->Fb);
+    Batch = sbfarrow_BuildRecordBatch(Writer->Fb, Writer->NrOfRows,
+                                      Nodes, Writer->NrOfColumns,
+                                      Buffers, 2 * Writer->NrOfColumns);
+
+    Block = &Writer->Batches[Writer->NrOfBatches++];
+    sbfarrow_WriteMessage(Writer, SBFARROW_HEADER_RECBATCH, Batch, BodyLength, Block);
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        size_t ValueSize = sbfarrow_ValueSize(Writer->Columns[Col].Type);
+
+        sbfarrow_Write(Writer, Writer->Validity[Col], (size_t)Buffers[4 * Col + 1]);
+        sbfarrow_WritePadding(Writer);
+        sbfarrow_Write(Writer, Writer->Values[Col], (size_t)Buffers[4 * Col + 3]);
+        sbfarrow_WritePadding(Writer);
+
+        /* unset values of the next batch are null and 0 */
+        memset(Writer->Validity[Col], 0, BitmapLen);
+        memset(Writer->Values[Col], 0, Writer->NrOfRows * ValueSize);
+    }
+
+    Writer->NrOfRows = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_WriteFooter(sbfarrow_Writer_t* Writer)
+{
+    static const uint8_t Trailer[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+    sbfarrow_Fb_t*       Fb = Writer->Fb;
+    sbfarrow_Ref_t       Schema;
+    sbfarrow_Ref_t       Dictionaries;
+    sbfarrow_Ref_t       Batches;
+    sbfarrow_Ref_t       Footer;
+    const uint8_t*       Data;
+    uint8_t              Len[4];
+    uint32_t             i;
+
+    sbfarrow_Fb_Reset(Fb);
+    Schema = sbfarrow_BuildSchema(Writer);
+
+    /* the Block structs: offset, metaDataLength, 4 bytes of padding
+       and bodyLength */
+    sbfarrow_Fb_Prep(Fb, 8, 24 * (size_t)Writer->NrOfBatches);
+
+    for (i = Writer->NrOfBatches; i > 0; i--)
+    {
+        sbfarrow_Fb_PushLE(Fb, (uint64_t)Writer->Batches[i - 1].BodyLength, 8);
+        sbfarrow_Fb_PushLE(Fb, 0, 4);
+        sbfarrow_Fb_PushLE(Fb, (uint32_t)Writer->Batches[i - 1].MetaDataLength, 4);
+        sbfarrow_Fb_PushLE(Fb, (uint64_t)Writer->Batches[i - 1].Offset, 8);
+    }
+
+    sbfarrow_Fb_PushLE(Fb, Writer->NrOfBatches, 4);
+    Batches = Fb->Size;
+
+    sbfarrow_Fb_Prep(Fb, 8, 24 * (size_t)Writer->NrOfDictionaries);
+
+    for (i = Writer->NrOfDictionaries; i > 0; i--)
+    {
+        sbfarrow_Fb_PushLE(Fb, (uint64_t)Writer->Dictionaries[i - 1].BodyLength, 8);
+        sbfarrow_Fb_PushLE(Fb, 0, 4);
+        sbfarrow_Fb_PushLE(Fb, (uint32_t)Writer->Dictionaries[i - 1].MetaDataLength, 4);
+        sbfarrow_Fb_PushLE(Fb, (uint64_t)Writer->Dictionaries[i - 1].Offset, 8);
+    }
+
+    sbfarrow_Fb_PushLE(Fb, Writer->NrOfDictionaries, 4);
+    Dictionaries = Fb->Size;
+
+    sbfarrow_Fb_StartTable(Fb);
+    sbfarrow_Fb_AddOffset(Fb, 1, Schema);
+    sbfarrow_Fb_AddOffset(Fb, 2, Dictionaries);
+    sbfarrow_Fb_AddOffset(Fb, 3, Batches);
+    sbfarrow_Fb_AddScalar(Fb, 0, SBFARROW_METADATA_V5, 2);
+    Footer = sbfarrow_Fb_EndTable(Fb);
+    Data   = sbfarrow_Fb_Finish(Fb, Footer);
+
+    if (Fb->Error)
+    {
+        Writer->Error = true;
+        return;
+    }
+
+    Len[0] = (uint8_t)Fb->Size;
+    Len[1] = (uint8_t)(Fb->Size >> 8);
+    Len[2] = (uint8_t)(Fb->Size >> 16);
+    Len[3] = (uint8_t)(Fb->Size >> 24);
+
+    sbfarrow_Write(Writer, Data, Fb->Size);
+    sbfarrow_Write(Writer, Len, sizeof(Len));
+    sbfarrow_Write(Writer, Trailer, sizeof(Trailer));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_Free(sbfarrow_Writer_t* Writer)
+{
+    uint32_t Col;
+
+    for (Col = 0; Col < SBFARROW_MAX_COLUMNS; Col++)
+    {
+        free(Writer->Values[Col]);
+        free(Writer->Validity[Col]);
+        Writer->Values[Col]   = NULL;
+        Writer->Validity[Col] = NULL;
+    }
+
+    if (Writer->Fb != NULL)
+    {
+        free(Writer->Fb->Buf);
+        free(Writer->Fb);
+        Writer->Fb = NULL;
+    }
+
+    free(Writer->Dictionaries);
+    free(Writer->Batches);
+    Writer->Dictionaries = NULL;
+    Writer->Batches      = NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfarrow_Open(sbfarrow_Writer_t*       Writer,
+                   FILE*                    F,
+                   const sbfarrow_Column_t* Columns,
+                   uint32_t                 NrOfColumns,
+                   uint32_t                 RowsPerBatch)
+{
+    sbfarrow_Ref_t Schema;
+    uint32_t       Col;
+
+    memset(Writer, 0, sizeof(*Writer));
+
+    if (NrOfColumns == 0 || NrOfColumns > SBFARROW_MAX_COLUMNS)
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    Writer->Columns      = Columns;
+    Writer->NrOfColumns  = NrOfColumns;
+    Writer->RowsPerBatch = RowsPerBatch != 0 ? RowsPerBatch : SBFARROW_ROWS_PER_BATCH;
+
+    Writer->Fb           = (sbfarrow_Fb_t*)calloc(1, sizeof(sbfarrow_Fb_t));
+    Writer->Dictionaries = (sbfarrow_Block_t*)calloc(NrOfColumns, sizeof(sbfarrow_Block_t));
+
+    if (Writer->Fb == NULL || Writer->Dictionaries == NULL)
+    {
+        sbfarrow_Free(Writer);
+        return false;
+    }
+
+    for (Col = 0; Col < NrOfColumns; Col++)
+    {
+        Writer->Values[Col]   = (uint8_t*)calloc(Writer->RowsPerBatch, sbfarrow_ValueSize(Columns[Col].Type));
+        Writer->Validity[Col] = (uint8_t*)calloc((Writer->RowsPerBatch + 7) / 8, 1);
+
+        if (Writer->Values[Col] == NULL || Writer->Validity[Col] == NULL)
+        {
+            sbfarrow_Free(Writer);
+            return false;
+        }
+    }
+
+    if (!sbfout_Open(&Writer->Out, F))
+    {
+        sbfarrow_Free(Writer);
+        return false;
+    }
+
+    sbfarrow_Write(Writer, Magic, sizeof(Magic));
+
+    sbfarrow_Fb_Reset(Writer->Fb);
+    Schema = sbfarrow_BuildSchema(Writer);
+    sbfarrow_WriteMessage(Writer, SBFARROW_HEADER_SCHEMA, Schema, 0, NULL);
+
+    for (Col = 0; Col < NrOfColumns; Col++)
+    {
+        if (Columns[Col].Type == SBFARROW_DICT16)
+        {
+            sbfarrow_WriteDictionary(Writer, Col);
+        }
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfarrow_SetValue(sbfarrow_Writer_t* Writer,
+                              uint32_t           Col,
+                              const void*        Value,
+                              size_t             Size)
+{
+    uint32_t Row = Writer->NrOfRows;
+
+    memcpy(Writer->Values[Col] + Row * Size, Value, Size);
+    Writer->Validity[Col][Row >> 3] |= (uint8_t)(1 << (Row & 7));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_SetInt64(sbfarrow_Writer_t* Writer, uint32_t Col, int64_t Value)
+{
+    sbfarrow_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_SetUInt8(sbfarrow_Writer_t* Writer, uint32_t Col, uint8_t Value)
+{
+    sbfarrow_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_SetFloat32(sbfarrow_Writer_t* Writer, uint32_t Col, float Value)
+{
+    sbfarrow_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_SetFloat64(sbfarrow_Writer_t* Writer, uint32_t Col, double Value)
+{
+    sbfarrow_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_SetIndex(sbfarrow_Writer_t* Writer, uint32_t Col, uint32_t Index)
+{
+    int16_t Value = (int16_t)Index;
+
+    sbfarrow_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfarrow_EndRow(sbfarrow_Writer_t* Writer)
+{
+    Writer->NrOfRows++;
+
+    if (Writer->NrOfRows == Writer->RowsPerBatch)
+    {
+        sbfarrow_WriteBatch(Writer);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfarrow_Close(sbfarrow_Writer_t* Writer)
+{
+    static const uint8_t EndOfStream[8] = {0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0};
+    bool                 Error;
+
+    if (Writer->NrOfRows > 0)
+    {
+        sbfarrow_WriteBatch(Writer);
+    }
+
+    sbfarrow_Write(Writer, EndOfStream, sizeof(EndOfStream));
+    sbfarrow_WriteFooter(Writer);
+
+    Error = Writer->Error;
+    sbfarrow_Free(Writer);
+
+    if (sbfout_Close(&Writer->Out) != 0)
+    {
+        return -1;
+    }
+
+    if (Error)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * sbfarrow.h: Declaration of a self-contained writer of Apache Arrow
+ *             IPC files (Feather v2), used to write the decoded SBF
+ *             data as columns that can be memory-mapped by pandas or
+ *             pyarrow without any parsing.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFARROW_H
+#define SBFARROW_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* maximum number of columns of an Arrow file */
+#define SBFARROW_MAX_COLUMNS  64
+
+/* default number of rows per record batch */
+#define SBFARROW_ROWS_PER_BATCH  65536
+
+typedef enum
+{
+    SBFARROW_INT64,
+    SBFARROW_UINT8,
+    SBFARROW_FLOAT32,
+    SBFARROW_FLOAT64,
+    SBFARROW_DICT16       /* utf8 strings, dictionary-encoded with
+                             int16 indices */
+} sbfarrow_Type_t;
+
+typedef struct
+{
+    const char*         Name;
+    sbfarrow_Type_t     Type;
+    const char* const*  Dictionary;      /* SBFARROW_DICT16 only: the
+                                            distinct values */
+    uint32_t            DictionarySize;
+} sbfarrow_Column_t;
+
+/* file offset and size of an IPC message, as listed in the footer */
+typedef struct
+{
+    int64_t             Offset;
+    int32_t             MetaDataLength;
+    int64_t             BodyLength;
+} sbfarrow_Block_t;
+
+typedef struct
+{
+    sbfout_Stream_t           Out;
+    int64_t                   Offset;         /* bytes written so far */
+    const sbfarrow_Column_t*  Columns;
+    uint32_t                  NrOfColumns;
+    uint32_t                  RowsPerBatch;
+    uint32_t                  NrOfRows;       /* rows in the current batch */
+    uint8_t*                  Values[SBFARROW_MAX_COLUMNS];
+    uint8_t*                  Validity[SBFARROW_MAX_COLUMNS];
+    sbfarrow_Block_t*         Dictionaries;
+    uint32_t                  NrOfDictionaries;
+    sbfarrow_Block_t*         Batches;
+    uint32_t                  NrOfBatches;
+    uint32_t                  BatchesSize;    /* allocated entries */
+    struct sbfarrow_Fb_s*     Fb;             /* flatbuffer builder */
+    bool                      Error;          /* out of memory */
+} sbfarrow_Writer_t;
+
+/* Start an Arrow IPC file with the given columns on F, which must be
+   open for writing in binary mode.  The Columns array must stay valid
+   until sbfarrow_Close().  The rows are written in record batches of
+   RowsPerBatch rows (0 selects SBFARROW_ROWS_PER_BATCH), so that the
+   memory used does not depend on the length of the file.  Returns
+   false if the buffers cannot be allocated. */
+bool sbfarrow_Open(sbfarrow_Writer_t*       Writer,
+                   FILE*                    F,
+                   const sbfarrow_Column_t* Columns,
+                   uint32_t                 NrOfColumns,
+                   uint32_t                 RowsPerBatch);
+
+/* Set the value of column Col in the current row.  Columns that are
+   not set are null. */
+void sbfarrow_SetInt64(sbfarrow_Writer_t* Writer, uint32_t Col, int64_t Value);
+void sbfarrow_SetUInt8(sbfarrow_Writer_t* Writer, uint32_t Col, uint8_t Value);
+void sbfarrow_SetFloat32(sbfarrow_Writer_t* Writer, uint32_t Col, float Value);
+void sbfarrow_SetFloat64(sbfarrow_Writer_t* Writer, uint32_t Col, double Value);
+
+/* Set column Col to entry Index of its dictionary. */
+void sbfarrow_SetIndex(sbfarrow_Writer_t* Writer, uint32_t Col, uint32_t Index);
+
+/* Terminate the current row. */
+void sbfarrow_EndRow(sbfarrow_Writer_t* Writer);
+
+/* Write the last record batch and the footer, and free the buffers.
+   The file itself is not closed.  Returns 0 on success, or -1 if
+   anything could not be written (errno is set). */
+int32_t sbfarrow_Close(sbfarrow_Writer_t* Writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
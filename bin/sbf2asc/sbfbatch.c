@@ -0,0 +1,248 @@
+/*
+ * sbfbatch.c: Formatting of the measurement epochs by a pool of worker
+ *             threads, in batches.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "sbfbatch.h"
+#include "sbfread_pool.h"
+
+/* the epochs of a batch, taken from the epoch pool of the decoder and
+   copied up to the last channel in use, and the text formatted by each
+   worker */
+typedef struct
+{
+    struct sbfbatch_s* Batch;
+    uint32_t          NrOfEpochs;
+    MeasEpoch_t*      Epoch[SBFBATCH_EPOCHS];
+    sbfout_Stream_t*  Parts;       /* one memory stream per worker */
+} sbfbatch_Epochs_t;
+
+struct sbfbatch_s
+{
+    SBFData_t*        SBFData;     /* owner of the epoch pool */
+    sbfread_Pool_t*   Pool;
+    uint32_t          NrOfThreads;
+    sbfout_Stream_t*  Out;
+    sbfconsumer_EpochHandler_t Format;
+    sbfbatch_Epochs_t Epochs[2];   /* one is filled while the other
+                                      is formatted */
+    uint32_t          Fill;        /* index of the batch being filled */
+    bool              Busy;        /* the other batch is being formatted */
+};
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfbatch_Job(void* Arg, uint32_t WorkerIdx)
+/* formats the share of the batch of a worker: a contiguous range of
+   epochs, so that the parts can be written one after the other */
+{
+    sbfbatch_Epochs_t* Epochs = (sbfbatch_Epochs_t*)Arg;
+    uint32_t           N      = Epochs->Batch->NrOfThreads;
+    uint32_t           First  = Epochs->NrOfEpochs * WorkerIdx / N;
+    uint32_t           Last   = Epochs->NrOfEpochs * (WorkerIdx + 1) / N;
+    uint32_t           i;
+
+    for (i = First; i < Last; i++)
+    {
+        Epochs->Batch->Format(&Epochs->Parts[WorkerIdx], Epochs->Epoch[i]);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfbatch_Finish(sbfbatch_t* Batch)
+/* waits for the batch being formatted, if any, and writes it */
+{
+    sbfbatch_Epochs_t* Epochs = &Batch->Epochs[1 - Batch->Fill];
+    uint32_t           i;
+
+    if (!Batch->Busy)
+    {
+        return;
+    }
+
+    sbfread_Pool_Wait(Batch->Pool);
+
+    for (i = 0; i < Batch->NrOfThreads; i++)
+    {
+        sbfout_Stream_t* Part = &Epochs->Parts[i];
+
+        sbfout_Write(Batch->Out, Part->Data, Part->Used);
+        Part->Used = 0;
+
+        if (Part->Error != 0 && Batch->Out->Error == 0)
+        {
+            Batch->Out->Error = Part->Error;
+        }
+    }
+
+    for (i = 0; i < Epochs->NrOfEpochs; i++)
+    {
+        sbfread_FreeMeasEpoch(Batch->SBFData, Epochs->Epoch[i]);
+    }
+
+    Epochs->NrOfEpochs = 0;
+    Batch->Busy        = false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfbatch_Start(sbfbatch_t* Batch)
+/* gives the batch being filled to the workers */
+{
+    sbfbatch_Finish(Batch);
+
+    sbfread_Pool_Start(Batch->Pool, sbfbatch_Job, &Batch->Epochs[Batch->Fill]);
+
+    Batch->Busy = true;
+    Batch->Fill = 1 - Batch->Fill;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfbatch_Free(sbfbatch_t* Batch)
+{
+    uint32_t b, i;
+
+    sbfread_Pool_Destroy(Batch->Pool);
+
+    for (b = 0; b < 2; b++)
+    {
+        if (Batch->Epochs[b].Parts != NULL)
+        {
+            for (i = 0; i < Batch->NrOfThreads; i++)
+            {
+                (void)sbfout_Close(&Batch->Epochs[b].Parts[i]);
+            }
+        }
+
+        free(Batch->Epochs[b].Parts);
+    }
+
+    free(Batch);
+}
+
+
+/*---------------------------------------------------------------------------*/
+sbfbatch_t* sbfbatch_Create(uint32_t                   NrOfThreads,
+                            SBFData_t*                 SBFData,
+                            sbfout_Stream_t*           Out,
+                            sbfconsumer_EpochHandler_t Format)
+{
+    sbfbatch_t* Batch;
+    uint32_t    b, i;
+    bool        Ok = true;
+
+    if (NrOfThreads == 0)
+    {
+        return NULL;
+    }
+
+    Batch = (sbfbatch_t*)calloc(1, sizeof(*Batch));
+
+    if (Batch == NULL)
+    {
+        return NULL;
+    }
+
+    Batch->NrOfThreads = NrOfThreads;
+    Batch->SBFData     = SBFData;
+    Batch->Out         = Out;
+    Batch->Format      = Format;
+
+    for (b = 0; b < 2; b++)
+    {
+        sbfbatch_Epochs_t* Epochs = &Batch->Epochs[b];
+
+        Epochs->Batch = Batch;
+        Epochs->Parts = (sbfout_Stream_t*)calloc(NrOfThreads, sizeof(sbfout_Stream_t));
+        Ok = Ok && (Epochs->Parts != NULL);
+
+        for (i = 0; Ok && i < NrOfThreads; i++)
+        {
+            Ok = sbfout_OpenMemory(&Epochs->Parts[i]);
+        }
+    }
+
+    /* the threads are created last, as sbfread_Pool_Create() returns
+       NULL in the builds without threads */
+    if (Ok)
+    {
+        Batch->Pool = sbfread_Pool_Create(NrOfThreads);
+    }
+
+    if (Batch->Pool == NULL)
+    {
+        sbfbatch_Free(Batch);
+        return NULL;
+    }
+
+    return Batch;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfbatch_AddEpoch(void*              Context,
+                       const MeasEpoch_t* MeasEpoch)
+{
+    sbfbatch_t*        Batch  = (sbfbatch_t*)Context;
+    sbfbatch_Epochs_t* Epochs = &Batch->Epochs[Batch->Fill];
+    MeasEpoch_t*       Copy   = sbfread_AllocMeasEpoch(Batch->SBFData);
+
+    if (Copy == NULL)
+    {
+        /* out of memory: write everything up to this epoch, and this
+           epoch, directly */
+        if (Epochs->NrOfEpochs > 0)
+        {
+            sbfbatch_Start(Batch);
+        }
+
+        sbfbatch_Finish(Batch);
+        Batch->Format(Batch->Out, MeasEpoch);
+        return;
+    }
+
+    memcpy(Copy, MeasEpoch, offsetof(MeasEpoch_t, channelData)
+           + MeasEpoch->nbrElements * sizeof(MeasChannel_t));
+    Epochs->Epoch[Epochs->NrOfEpochs++] = Copy;
+
+    if (Epochs->NrOfEpochs == SBFBATCH_EPOCHS)
+    {
+        sbfbatch_Start(Batch);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfbatch_Destroy(sbfbatch_t* Batch)
+{
+    if (Batch == NULL)
+    {
+        return;
+    }
+
+    if (Batch->Epochs[Batch->Fill].NrOfEpochs > 0)
+    {
+        sbfbatch_Start(Batch);
+    }
+
+    sbfbatch_Finish(Batch);
+    sbfbatch_Free(Batch);
+}
@@ -0,0 +1,72 @@
+/*
+ * sbfbatch.h: Declaration of the formatting of the measurement epochs
+ *             by a pool of worker threads, in batches.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFBATCH_H
+#define SBFBATCH_H 1
+
+#include <stdint.h>
+
+#include "sbfread.h"
+#include "sbfout.h"
+#include "sbfconsumer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* number of epochs formatted together */
+#ifndef SBFBATCH_EPOCHS
+#define SBFBATCH_EPOCHS  64
+#endif
+
+typedef struct sbfbatch_s sbfbatch_t;
+
+/* Format the epochs with Format(Stream, MeasEpoch) on NrOfThreads
+   worker threads, and write the result to Out.  Format must only
+   depend on the epoch and on data that does not change while
+   formatting: each worker calls it with its own memory stream.
+
+   The epochs are copied in a batch, into epochs taken from the pool of
+   SBFData (sbfread_AllocMeasEpoch()) and given back once written, so
+   that no memory is allocated once the pool holds two batches.  When
+   the batch is full, it is given to the workers, which format a part
+   of it each while the caller decodes the next batch.  The parts are
+   then written to Out in order, so that the output is the same as when
+   calling Format(Out, MeasEpoch) for each epoch.  The batch must be
+   destroyed before SBFData is closed.
+
+   Returns NULL if the threads are not available in this build (see
+   SBFREAD_THREADS) or cannot be created. */
+sbfbatch_t* sbfbatch_Create(uint32_t                   NrOfThreads,
+                            SBFData_t*                 SBFData,
+                            sbfout_Stream_t*           Out,
+                            sbfconsumer_EpochHandler_t Format);
+
+/* Add an epoch to the batch, with the signature of an epoch handler of
+   sbfconsumer (Context is the sbfbatch_t). */
+void sbfbatch_AddEpoch(void*              Context,
+                       const MeasEpoch_t* MeasEpoch);
+
+/* Format and write the last epochs, stop the threads and free Batch.
+   Batch may be NULL. */
+void sbfbatch_Destroy(sbfbatch_t* Batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
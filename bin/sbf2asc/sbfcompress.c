@@ -0,0 +1,461 @@
+/*
+ * sbfcompress.c: Compression of the output streams in gzip or zstd
+ *                format, in blocks compressed in parallel.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sbfcompress.h"
+#include "sbfread_pool.h"
+
+#if SBFOUT_GZIP
+#include <zlib.h>
+#endif
+
+#if SBFOUT_ZSTD
+#include <zstd.h>
+#endif
+
+/* compression levels: the defaults of gzip and zstd */
+#define SBFCOMPRESS_GZIP_LEVEL  6
+#define SBFCOMPRESS_ZSTD_LEVEL  3
+
+/* a block of the output and its compressed version */
+typedef struct
+{
+    char*   In;
+    size_t  InLen;
+    char*   Out;
+    size_t  OutSize;
+    size_t  OutLen;
+    int     Error;
+#if SBFOUT_GZIP
+    z_stream Deflate;
+    bool     DeflateInit;
+#endif
+#if SBFOUT_ZSTD
+    ZSTD_CCtx* CCtx;
+#endif
+} sbfcompress_Block_t;
+
+/* the blocks compressed together, one per worker */
+typedef struct
+{
+    struct sbfcompress_s* Compress;
+    sbfcompress_Block_t*  Blocks;
+    uint32_t              NrOfBlocks;   /* blocks filled */
+} sbfcompress_Set_t;
+
+struct sbfcompress_s
+{
+    FILE*             F;
+    uint32_t          Format;
+    size_t            BlockSize;
+    sbfread_Pool_t*   Pool;
+    uint32_t          NrOfThreads;  /* blocks per set: 1 without pool */
+    sbfcompress_Set_t Sets[2];      /* one is filled while the other is
+                                       compressed */
+    uint32_t          Fill;         /* index of the set being filled */
+    bool              Busy;         /* the other set is being compressed */
+    bool              Empty;        /* nothing was written so far */
+    int               Error;        /* errno of the first error, or 0 */
+};
+
+
+/*---------------------------------------------------------------------------*/
+uint32_t sbfcompress_GetFormat(const char* FileName)
+{
+    size_t Len = strlen(FileName);
+
+    if (Len > 3 && strcmp(FileName + Len - 3, ".gz") == 0)
+    {
+        return SBFCOMPRESS_GZIP;
+    }
+
+    if (Len > 4 && strcmp(FileName + Len - 4, ".zst") == 0)
+    {
+        return SBFCOMPRESS_ZSTD;
+    }
+
+    return SBFCOMPRESS_NONE;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfcompress_IsAvailable(uint32_t Format)
+{
+    return (Format == SBFCOMPRESS_GZIP && SBFOUT_GZIP) ||
+           (Format == SBFCOMPRESS_ZSTD && SBFOUT_ZSTD);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static size_t sbfcompress_Bound(sbfcompress_t* Compress)
+/* the largest size of a compressed block */
+{
+#if SBFOUT_GZIP
+    if (Compress->Format == SBFCOMPRESS_GZIP)
+    {
+        /* compressBound() counts the 6 bytes of the zlib header and
+           trailer, the gzip ones take 18 */
+        return (size_t)compressBound((uLong)Compress->BlockSize) + 32;
+    }
+#endif
+
+#if SBFOUT_ZSTD
+    if (Compress->Format == SBFCOMPRESS_ZSTD)
+    {
+        return ZSTD_compressBound(Compress->BlockSize);
+    }
+#endif
+
+    (void)Compress;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfcompress_Block(sbfcompress_t*       Compress,
+                              sbfcompress_Block_t* Block)
+/* compresses a block as a gzip member or a zstd frame on its own */
+{
+    Block->OutLen = 0;
+    Block->Error  = 0;
+
+#if SBFOUT_GZIP
+    if (Compress->Format == SBFCOMPRESS_GZIP)
+    {
+        z_stream* Deflate = &Block->Deflate;
+
+        if (!Block->DeflateInit)
+        {
+            memset(Deflate, 0, sizeof(*Deflate));
+
+            /* 15 + 16: a gzip header and trailer around the deflate data */
+            if (deflateInit2(Deflate, SBFCOMPRESS_GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                Block->Error = ENOMEM;
+                return;
+            }
+
+            Block->DeflateInit = true;
+        }
+        else if (deflateReset(Deflate) != Z_OK)
+        {
+            Block->Error = EIO;
+            return;
+        }
+
+        Deflate->next_in   = (Bytef*)Block->In;
+        Deflate->avail_in  = (uInt)Block->InLen;
+        Deflate->next_out  = (Bytef*)Block->Out;
+        Deflate->avail_out = (uInt)Block->OutSize;
+
+        if (deflate(Deflate, Z_FINISH) != Z_STREAM_END)
+        {
+            Block->Error = EIO;
+            return;
+        }
+
+        Block->OutLen = Block->OutSize - Deflate->avail_out;
+    }
+#endif
+
+#if SBFOUT_ZSTD
+    if (Compress->Format == SBFCOMPRESS_ZSTD)
+    {
+        size_t Len;
+
+        if (Block->CCtx == NULL)
+        {
+            Block->CCtx = ZSTD_createCCtx();
+
+            if (Block->CCtx == NULL)
+            {
+                Block->Error = ENOMEM;
+                return;
+            }
+        }
+
+        Len = ZSTD_compressCCtx(Block->CCtx, Block->Out, Block->OutSize,
+                                Block->In, Block->InLen, SBFCOMPRESS_ZSTD_LEVEL);
+
+        if (ZSTD_isError(Len))
+        {
+            Block->Error = EIO;
+            return;
+        }
+
+        Block->OutLen = Len;
+    }
+#endif
+
+    (void)Compress;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfcompress_Job(void* Arg, uint32_t WorkerIdx)
+/* compresses the block of a worker, if the set has one for it */
+{
+    sbfcompress_Set_t* Set = (sbfcompress_Set_t*)Arg;
+
+    if (WorkerIdx < Set->NrOfBlocks)
+    {
+        sbfcompress_Block(Set->Compress, &Set->Blocks[WorkerIdx]);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfcompress_Finish(sbfcompress_t* Compress)
+/* waits for the set being compressed, if any, and writes it */
+{
+    sbfcompress_Set_t* Set = &Compress->Sets[1 - Compress->Fill];
+    uint32_t           i;
+
+    if (!Compress->Busy)
+    {
+        return;
+    }
+
+    if (Compress->Pool != NULL)
+    {
+        sbfread_Pool_Wait(Compress->Pool);
+    }
+
+    for (i = 0; i < Set->NrOfBlocks; i++)
+    {
+        sbfcompress_Block_t* Block = &Set->Blocks[i];
+
+        if (Compress->Error != 0)
+        {
+            break;
+        }
+
+        if (Block->Error != 0)
+        {
+            Compress->Error = Block->Error;
+        }
+        else if (fwrite(Block->Out, 1, Block->OutLen, Compress->F) != Block->OutLen)
+        {
+            Compress->Error = errno != 0 ? errno : EIO;
+        }
+    }
+
+    Set->NrOfBlocks = 0;
+    Compress->Busy  = false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfcompress_Start(sbfcompress_t* Compress)
+/* gives the set being filled to the workers, or compresses it right away
+   without workers */
+{
+    sbfcompress_Set_t* Set = &Compress->Sets[Compress->Fill];
+    uint32_t           i;
+
+    sbfcompress_Finish(Compress);
+
+    if (Compress->Pool != NULL)
+    {
+        sbfread_Pool_Start(Compress->Pool, sbfcompress_Job, Set);
+    }
+    else
+    {
+        for (i = 0; i < Set->NrOfBlocks; i++)
+        {
+            sbfcompress_Block(Compress, &Set->Blocks[i]);
+        }
+    }
+
+    Compress->Busy = true;
+    Compress->Fill = 1 - Compress->Fill;
+
+    if (Compress->Pool == NULL)
+    {
+        sbfcompress_Finish(Compress);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfcompress_Free(sbfcompress_t* Compress)
+{
+    uint32_t s, i;
+
+    sbfread_Pool_Destroy(Compress->Pool);
+
+    for (s = 0; s < 2; s++)
+    {
+        sbfcompress_Block_t* Blocks = Compress->Sets[s].Blocks;
+
+        if (Blocks == NULL)
+        {
+            continue;
+        }
+
+        for (i = 0; i < Compress->NrOfThreads; i++)
+        {
+#if SBFOUT_GZIP
+            if (Blocks[i].DeflateInit)
+            {
+                (void)deflateEnd(&Blocks[i].Deflate);
+            }
+#endif
+#if SBFOUT_ZSTD
+            ZSTD_freeCCtx(Blocks[i].CCtx);
+#endif
+            free(Blocks[i].In);
+            free(Blocks[i].Out);
+        }
+
+        free(Blocks);
+    }
+
+    free(Compress);
+}
+
+
+/*---------------------------------------------------------------------------*/
+sbfcompress_t* sbfcompress_Create(FILE*    F,
+                                  uint32_t Format,
+                                  size_t   BlockSize,
+                                  uint32_t NrOfThreads)
+{
+    sbfcompress_t* Compress;
+    uint32_t       s, i;
+    bool           Ok = true;
+
+    if (!sbfcompress_IsAvailable(Format))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    Compress = (sbfcompress_t*)calloc(1, sizeof(*Compress));
+
+    if (Compress == NULL)
+    {
+        return NULL;
+    }
+
+    Compress->F         = F;
+    Compress->Format    = Format;
+    Compress->BlockSize = BlockSize;
+    Compress->Empty     = true;
+
+    /* without threads (or in the builds without them), the blocks are
+       compressed one at a time by the caller */
+    if (NrOfThreads > 0)
+    {
+        Compress->Pool = sbfread_Pool_Create(NrOfThreads);
+    }
+
+    Compress->NrOfThreads = Compress->Pool != NULL ? NrOfThreads : 1;
+
+    for (s = 0; s < 2; s++)
+    {
+        sbfcompress_Set_t* Set = &Compress->Sets[s];
+
+        Set->Compress = Compress;
+        Set->Blocks   = (sbfcompress_Block_t*)calloc(Compress->NrOfThreads, sizeof(sbfcompress_Block_t));
+        Ok = Ok && (Set->Blocks != NULL);
+
+        for (i = 0; Ok && i < Compress->NrOfThreads; i++)
+        {
+            Set->Blocks[i].OutSize = sbfcompress_Bound(Compress);
+            Set->Blocks[i].In      = (char*)malloc(BlockSize);
+            Set->Blocks[i].Out     = (char*)malloc(Set->Blocks[i].OutSize);
+            Ok = (Set->Blocks[i].In != NULL && Set->Blocks[i].Out != NULL);
+        }
+    }
+
+    if (!Ok)
+    {
+        sbfcompress_Free(Compress);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return Compress;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfcompress_Write(sbfcompress_t* Compress,
+                       char**         Block,
+                       size_t         Len)
+{
+    sbfcompress_Set_t*   Set = &Compress->Sets[Compress->Fill];
+    sbfcompress_Block_t* Slot;
+    char*                Buffer;
+
+    if (Len == 0)
+    {
+        return;
+    }
+
+    /* the full buffer of the caller is swapped with the empty one of
+       the slot, instead of copying it */
+    Slot        = &Set->Blocks[Set->NrOfBlocks++];
+    Buffer      = Slot->In;
+    Slot->In    = *Block;
+    Slot->InLen = Len;
+    *Block      = Buffer;
+
+    Compress->Empty = false;
+
+    if (Set->NrOfBlocks == Compress->NrOfThreads)
+    {
+        sbfcompress_Start(Compress);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfcompress_Close(sbfcompress_t* Compress)
+{
+    sbfcompress_Set_t* Set = &Compress->Sets[Compress->Fill];
+    int                Error;
+
+    /* an empty file is not a valid gzip or zstd file: it gets an empty
+       member or frame */
+    if (Compress->Empty)
+    {
+        Set->Blocks[Set->NrOfBlocks++].InLen = 0;
+    }
+
+    if (Set->NrOfBlocks > 0)
+    {
+        sbfcompress_Start(Compress);
+    }
+
+    sbfcompress_Finish(Compress);
+
+    if (fflush(Compress->F) != 0 && Compress->Error == 0)
+    {
+        Compress->Error = errno != 0 ? errno : EIO;
+    }
+
+    Error = Compress->Error;
+    sbfcompress_Free(Compress);
+
+    return Error;
+}
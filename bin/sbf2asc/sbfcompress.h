@@ -0,0 +1,82 @@
+/*
+ * sbfcompress.h: Declaration of the compression of the output streams
+ *                in gzip or zstd format, in blocks compressed in
+ *                parallel.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFCOMPRESS_H
+#define SBFCOMPRESS_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The compression formats are only available when building with
+   SBFOUT_GZIP (zlib) and/or SBFOUT_ZSTD (libzstd) set to 1, see the
+   Makefile. */
+#ifndef SBFOUT_GZIP
+#define SBFOUT_GZIP 0
+#endif
+
+#ifndef SBFOUT_ZSTD
+#define SBFOUT_ZSTD 0
+#endif
+
+#define SBFCOMPRESS_NONE   0
+#define SBFCOMPRESS_GZIP   1   /* .gz */
+#define SBFCOMPRESS_ZSTD   2   /* .zst */
+
+typedef struct sbfcompress_s sbfcompress_t;
+
+/* Get the compression format of a file from its extension. */
+uint32_t sbfcompress_GetFormat(const char* FileName);
+
+/* Returns true if Format is available in this build. */
+bool sbfcompress_IsAvailable(uint32_t Format);
+
+/* Start compressing to F, which must be open for writing in binary
+   mode, the blocks of up to BlockSize bytes given to
+   sbfcompress_Write().  Each block is compressed independently, as a
+   gzip member or a zstd frame: the file is a valid gzip or zstd file
+   made of several members or frames.  With NrOfThreads > 0 (and
+   SBFREAD_THREADS builds), the blocks are compressed by NrOfThreads
+   worker threads at a time, while the caller fills the next ones.
+   Returns NULL if Format is not available or on allocation failure. */
+sbfcompress_t* sbfcompress_Create(FILE*    F,
+                                  uint32_t Format,
+                                  size_t   BlockSize,
+                                  uint32_t NrOfThreads);
+
+/* Compress the Len bytes of *Block.  The buffer is kept until it is
+   compressed: *Block is replaced by an empty buffer of BlockSize
+   bytes, to be filled by the caller. */
+void sbfcompress_Write(sbfcompress_t* Compress,
+                       char**         Block,
+                       size_t         Len);
+
+/* Compress and write the last blocks, and free Compress.  The file is
+   not closed.  Returns 0 on success, or the errno of the first error. */
+int sbfcompress_Close(sbfcompress_t* Compress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * sbfconsumer.c: Dispatch of the SBF blocks and of the decoded
+ *                measurement epochs to the outputs of sbf2asc.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "sbfconsumer.h"
+
+#define SBFCONSUMER_NONE  0xff
+
+
+/*---------------------------------------------------------------------------*/
+void sbfconsumer_Init(sbfconsumer_Table_t* Table)
+{
+    memset(Table->First, SBFCONSUMER_NONE, sizeof(Table->First));
+    Table->NrOfBlockHandlers = 0;
+    Table->NrOfEpochHandlers = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfconsumer_RegisterBlock(sbfconsumer_Table_t*       Table,
+                               uint16_t                   BlockNumber,
+                               int                        Interval_ms,
+                               sbfconsumer_BlockHandler_t Handler,
+                               void*                      Context)
+{
+    sbfconsumer_BlockEntry_t* Entry;
+    uint8_t*                  Link;
+
+    if (Table->NrOfBlockHandlers >= SBFCONSUMER_MAX_HANDLERS ||
+        BlockNumber >= SBFCONSUMER_NR_OF_BLOCKNUMBERS)
+    {
+        return false;
+    }
+
+    Entry = &Table->BlockHandlers[Table->NrOfBlockHandlers];
+    Entry->Handler     = Handler;
+    Entry->Context     = Context;
+    Entry->Interval_ms = Interval_ms;
+    Entry->Next        = SBFCONSUMER_NONE;
+
+    /* append to the list of the block number, to keep the handlers in
+       the order of registration */
+    Link = &Table->First[BlockNumber];
+
+    while (*Link != SBFCONSUMER_NONE)
+    {
+        Link = &Table->BlockHandlers[*Link].Next;
+    }
+
+    *Link = (uint8_t)Table->NrOfBlockHandlers;
+    Table->NrOfBlockHandlers++;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfconsumer_RegisterEpoch(sbfconsumer_Table_t*       Table,
+                               sbfconsumer_EpochHandler_t Handler,
+                               void*                      Context)
+{
+    if (Table->NrOfEpochHandlers >= SBFCONSUMER_MAX_HANDLERS)
+    {
+        return false;
+    }
+
+    Table->EpochHandlers[Table->NrOfEpochHandlers].Handler = Handler;
+    Table->EpochHandlers[Table->NrOfEpochHandlers].Context = Context;
+    Table->NrOfEpochHandlers++;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfconsumer_Dispatch(sbfconsumer_Table_t* Table,
+                          SBFData_t*           SBFData,
+                          void*                SBFBlock)
+{
+    uint16_t BlockNumber = SBF_ID_TO_NUMBER(((VoidBlock_t*)SBFBlock)->ID);
+    uint8_t  Idx = Table->First[BlockNumber];
+
+    if (Idx != SBFCONSUMER_NONE)
+    {
+        /* same test as the interval check of IncludeThisEpoch() */
+        int TOW_ms = (int)(((HeaderAndTimeBlock_t*)SBFBlock)->TOW);
+
+        do
+        {
+            const sbfconsumer_BlockEntry_t* Entry = &Table->BlockHandlers[Idx];
+
+            if (TOW_ms % Entry->Interval_ms == 0)
+            {
+                Entry->Handler(Entry->Context, SBFBlock);
+            }
+
+            Idx = Entry->Next;
+        }
+        while (Idx != SBFCONSUMER_NONE);
+    }
+
+    if (Table->NrOfEpochHandlers > 0 &&
+        sbfread_MeasCollectAndDecode(SBFData, SBFBlock, &Table->MeasEpoch,
+                                     SBFREAD_ALLMEAS_ENABLED))
+    {
+        uint32_t i;
+
+        for (i = 0; i < Table->NrOfEpochHandlers; i++)
+        {
+            Table->EpochHandlers[i].Handler(Table->EpochHandlers[i].Context,
+                                            &Table->MeasEpoch);
+        }
+    }
+}
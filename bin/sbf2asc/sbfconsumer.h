@@ -0,0 +1,108 @@
+/*
+ * sbfconsumer.h: Declaration of the dispatch of the SBF blocks and of
+ *                the decoded measurement epochs to the outputs of
+ *                sbf2asc.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFCONSUMER_H
+#define SBFCONSUMER_H 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "measepoch.h"
+#include "sbfread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* maximum number of block handlers and of epoch handlers */
+#define SBFCONSUMER_MAX_HANDLERS     64
+
+/* number of SBF block numbers (13 bits) */
+#define SBFCONSUMER_NR_OF_BLOCKNUMBERS  8192
+
+/* handler called for each SBF block with one of the block numbers it
+   is registered for */
+typedef void (*sbfconsumer_BlockHandler_t)(void*       Context,
+                                           const void* SBFBlock);
+
+/* handler called for each decoded measurement epoch */
+typedef void (*sbfconsumer_EpochHandler_t)(void*              Context,
+                                           const MeasEpoch_t* MeasEpoch);
+
+typedef struct
+{
+    sbfconsumer_BlockHandler_t Handler;
+    void*             Context;
+    int               Interval_ms;  /* decimation interval */
+    uint8_t           Next;         /* next handler of the same block
+                                       number, or 0xff */
+} sbfconsumer_BlockEntry_t;
+
+typedef struct
+{
+    sbfconsumer_EpochHandler_t Handler;
+    void*             Context;
+} sbfconsumer_EpochEntry_t;
+
+typedef struct
+{
+    /* first handler of each block number, or 0xff if the blocks with
+       that number are not consumed */
+    uint8_t           First[SBFCONSUMER_NR_OF_BLOCKNUMBERS];
+    uint32_t          NrOfBlockHandlers;
+    sbfconsumer_BlockEntry_t BlockHandlers[SBFCONSUMER_MAX_HANDLERS];
+    uint32_t          NrOfEpochHandlers;
+    sbfconsumer_EpochEntry_t EpochHandlers[SBFCONSUMER_MAX_HANDLERS];
+    MeasEpoch_t       MeasEpoch;
+} sbfconsumer_Table_t;
+
+/* Empty the dispatch table. */
+void sbfconsumer_Init(sbfconsumer_Table_t* Table);
+
+/* Call Handler(Context, SBFBlock) for each SBF block with the given
+   number (as returned by SBF_ID_TO_NUMBER()) and a TOW multiple of
+   Interval_ms.  The handlers of a block number are called in the
+   order in which they were registered.  Returns false if the table is
+   full. */
+bool sbfconsumer_RegisterBlock(sbfconsumer_Table_t*       Table,
+                               uint16_t                   BlockNumber,
+                               int                        Interval_ms,
+                               sbfconsumer_BlockHandler_t Handler,
+                               void*                      Context);
+
+/* Call Handler(Context, MeasEpoch) for each measurement epoch.  The
+   measurement blocks are only decoded if at least one epoch handler
+   is registered.  Returns false if the table is full. */
+bool sbfconsumer_RegisterEpoch(sbfconsumer_Table_t*       Table,
+                               sbfconsumer_EpochHandler_t Handler,
+                               void*                      Context);
+
+/* Pass an SBF block to the handlers registered for its number, and to
+   sbfread_MeasCollectAndDecode().  When the block completes a
+   measurement epoch, it is passed to all the epoch handlers.  The
+   blocks must be passed in the order in which they are read from the
+   file. */
+void sbfconsumer_Dispatch(sbfconsumer_Table_t* Table,
+                          SBFData_t*           SBFData,
+                          void*                SBFBlock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * sbfmeasspec.c: Selection of the observables written by sbf2asc for
+ *                each measurement epoch.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "sbfmeasspec.h"
+#include "sbfsvid.h"
+
+/* name and format of each field, and the parts of the measurement
+   blocks that the decoder needs for it */
+typedef struct
+{
+    const char*       Name;
+    bool              Integer;
+    int               Width;
+    int               Precision;
+    uint32_t          DecodeFields;   /* SBFREAD_FIELD_xxx */
+} sbfmeasspec_FieldInfo_t;
+
+static const sbfmeasspec_FieldInfo_t FieldInfo[SBFMEASSPEC_NR_OF_FIELDS] =
+{
+    {"pr",        false, 16, 3, SBFREAD_FIELD_FULLRANGE},
+    {"l",         false, 16, 3, SBFREAD_FIELD_FULLRANGE},
+    {"doppler",   false, 12, 3, SBFREAD_FIELD_DOPPLER},
+    {"cn0",       false,  8, 3, SBFREAD_FIELD_CN0HIRES | SBFREAD_FIELD_FULLRANGE},
+    {"locktime",  true,  10, 0, SBFREAD_FIELD_MPINFO},
+    {"flags",     true,   3, 0, SBFREAD_FIELD_PPINFO},
+    {"mp",        true,   6, 0, SBFREAD_FIELD_MPINFO},
+    {"carriermp", true,   4, 0, SBFREAD_FIELD_MPINFO},
+    {"prvar",     false, 12, 4, SBFREAD_FIELD_MPINFO},
+    {"lvar",      false, 12, 8, SBFREAD_FIELD_MPINFO}
+};
+
+/* prefix of the signal names of each constellation, and its bit in
+   sbfread_DecodeMask_t.Constellations */
+static const struct
+{
+    const char*       Prefix;
+    uint32_t          SatSys;
+} Constellations[] =
+{
+    {"GPS", MEAS3_SYS_GPS},
+    {"GLO", MEAS3_SYS_GLO},
+    {"GAL", MEAS3_SYS_GAL},
+    {"BDS", MEAS3_SYS_BDS},
+    {"SBS", MEAS3_SYS_SBAS},
+    {"QZS", MEAS3_SYS_QZS},
+    {"IRN", MEAS3_SYS_IRN},
+    {"MSS", MEAS3_SYS_MAX}    /* L-band beams, not covered by Meas3 */
+};
+
+#define NR_OF_CONSTELLATIONS  (sizeof(Constellations) / sizeof(Constellations[0]))
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfmeasspec_Equal(const char* Token,
+                              size_t      Len,
+                              const char* Name)
+/* case-insensitive comparison of a token with a name */
+{
+    size_t i;
+
+    if (strlen(Name) != Len)
+    {
+        return false;
+    }
+
+    for (i = 0; i < Len; i++)
+    {
+        if (tolower((unsigned char)Token[i]) != tolower((unsigned char)Name[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfmeasspec_AddSignals(sbfmeasspec_t* Spec,
+                                   const char*    Token,
+                                   size_t         Len,
+                                   uint32_t       Group)
+/* adds a signal type, a constellation or "all" to a group */
+{
+    bool     Found = false;
+    uint32_t SignalType;
+
+    for (SignalType = 0; SignalType < 64; SignalType++)
+    {
+        const char* Name = getSignalName(SignalType);
+        bool        All = sbfmeasspec_Equal(Token, Len, "all");
+        bool        Selected = All || (Name[0] != '\0' && sbfmeasspec_Equal(Token, Len, Name));
+        uint32_t    c;
+
+        /* a constellation selects all its signals */
+        for (c = 0; c < NR_OF_CONSTELLATIONS; c++)
+        {
+            if (sbfmeasspec_Equal(Token, Len, Constellations[c].Prefix) &&
+                strncmp(Name, Constellations[c].Prefix, 3) == 0)
+            {
+                Selected = true;
+            }
+        }
+
+        if (!Selected)
+        {
+            continue;
+        }
+
+        /* a signal can only be in one group */
+        if (Spec->Group[SignalType] != 0 && Spec->Group[SignalType] != Group + 1)
+        {
+            return false;
+        }
+
+        Spec->Group[SignalType] = (uint8_t)(Group + 1);
+        Spec->SignalTypes |= 1ULL << SignalType;
+
+        /* "all" also selects the signal types without a name */
+        for (c = 0; c < NR_OF_CONSTELLATIONS; c++)
+        {
+            if (All || strncmp(Name, Constellations[c].Prefix, 3) == 0)
+            {
+                Spec->Constellations |= 1UL << Constellations[c].SatSys;
+            }
+        }
+
+        Found = true;
+    }
+
+    return Found;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfmeasspec_Parse(sbfmeasspec_t* Spec,
+                       const char*    Text)
+{
+    const char* p = Text;
+    uint32_t    Group = 0;
+
+    memset(Spec, 0, sizeof(*Spec));
+
+    if (strncmp(p, "wide:", 5) == 0)
+    {
+        Spec->Wide = true;
+        p += 5;
+    }
+    else if (strncmp(p, "long:", 5) == 0)
+    {
+        p += 5;
+    }
+
+    /* the fields */
+    for (;;)
+    {
+        size_t   Len = strcspn(p, ",/");
+        uint32_t Field;
+
+        if (sbfmeasspec_Equal(p, Len, "all"))
+        {
+            for (Field = 0; Field < SBFMEASSPEC_NR_OF_FIELDS; Field++)
+            {
+                Spec->Fields[Field] = (uint8_t)Field;
+            }
+
+            Spec->NrOfFields = SBFMEASSPEC_NR_OF_FIELDS;
+        }
+        else
+        {
+            for (Field = 0; Field < SBFMEASSPEC_NR_OF_FIELDS; Field++)
+            {
+                if (sbfmeasspec_Equal(p, Len, FieldInfo[Field].Name))
+                {
+                    break;
+                }
+            }
+
+            if (Field == SBFMEASSPEC_NR_OF_FIELDS || Spec->NrOfFields == SBFMEASSPEC_NR_OF_FIELDS)
+            {
+                return false;
+            }
+
+            Spec->Fields[Spec->NrOfFields++] = (uint8_t)Field;
+        }
+
+        p += Len;
+
+        if (*p != ',')
+        {
+            break;
+        }
+
+        p++;
+    }
+
+    /* the signals: all of them by default */
+    if (*p == '\0')
+    {
+        Spec->NrOfGroups = 1;
+        return sbfmeasspec_AddSignals(Spec, "all", 3, 0);
+    }
+
+    p++;
+
+    for (;;)
+    {
+        size_t Len = strcspn(p, "+,");
+
+        /* the groups only matter in the wide form */
+        if (Group == SBFMEASSPEC_MAX_GROUPS ||
+            !sbfmeasspec_AddSignals(Spec, p, Len, Spec->Wide ? Group : 0))
+        {
+            return false;
+        }
+
+        p += Len;
+
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        if (*p++ == ',')
+        {
+            Group++;
+        }
+    }
+
+    Spec->NrOfGroups = Spec->Wide ? Group + 1 : 1;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfmeasspec_GetDecodeMask(const sbfmeasspec_t*  Spec,
+                               sbfread_DecodeMask_t* Mask)
+{
+    uint32_t i;
+
+    Mask->Constellations = Spec->Constellations;
+    Mask->SignalTypes    = Spec->SignalTypes;
+    Mask->Antennas       = 1;   /* main antenna */
+    Mask->Fields         = 0;
+
+    for (i = 0; i < Spec->NrOfFields; i++)
+    {
+        Mask->Fields |= FieldInfo[Spec->Fields[i]].DecodeFields;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+double sbfmeasspec_GetField(const MeasSet_t*    MeasSet,
+                            sbfmeasspec_Field_t Field)
+{
+    switch (Field)
+    {
+    case SBFMEASSPEC_PR:
+        return MeasSet->PR_m;
+
+    case SBFMEASSPEC_L:
+        /* discard carrier phases with half-cycle ambiguities */
+        if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
+        {
+            return F64_NOTVALID;
+        }
+
+        return MeasSet->L_cycles;
+
+    case SBFMEASSPEC_DOPPLER:
+        return MeasSet->doppler_Hz;
+
+    case SBFMEASSPEC_CN0:
+        return MeasSet->CN0_dBHz;
+
+    case SBFMEASSPEC_LOCKTIME:
+        return MeasSet->PLLTimer_ms;
+
+    case SBFMEASSPEC_FLAGS:
+        return MeasSet->flags;
+
+    case SBFMEASSPEC_MP:
+        return MeasSet->MP_mm;
+
+    case SBFMEASSPEC_CARRIERMP:
+        return MeasSet->CarrierMP_1_512c;
+
+    case SBFMEASSPEC_PRVAR:
+        return MeasSet->PRvariance_m2;
+
+    default:
+        return MeasSet->Lvariance_cycles2;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfmeasspec_PutField(sbfout_Stream_t*    Out,
+                          sbfmeasspec_Field_t Field,
+                          double              Value)
+{
+    const sbfmeasspec_FieldInfo_t* Info = &FieldInfo[Field];
+
+    sbfout_Write(Out, " ", 1);
+
+    if (Info->Integer)
+    {
+        sbfout_PutInt(Out, (int64_t)Value, Info->Width);
+    }
+    else
+    {
+        sbfout_PutFixed(Out, Value, Info->Width, Info->Precision);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfmeasspec_PrintFields(sbfout_Stream_t*     Out,
+                                    const sbfmeasspec_t* Spec,
+                                    const MeasSet_t*     MeasSet)
+/* writes the selected fields of a signal, or -20000000000 for all of
+   them if MeasSet is NULL */
+{
+    uint32_t i;
+
+    for (i = 0; i < Spec->NrOfFields; i++)
+    {
+        sbfmeasspec_Field_t Field = (sbfmeasspec_Field_t)Spec->Fields[i];
+
+        sbfmeasspec_PutField(Out, Field,
+                             MeasSet != NULL ? sbfmeasspec_GetField(MeasSet, Field) : F64_NOTVALID);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfmeasspec_PrintEpoch(sbfout_Stream_t*     Out,
+                            const sbfmeasspec_t* Spec,
+                            const MeasEpoch_t*   MeasEpoch)
+{
+    char     Time[1 + SBFTIME_TEXT_SIZE];
+    int      TimeLen;
+    uint32_t i, SigIdx;
+
+    /* the time is the same for all the rows of the epoch */
+    if (Spec->TimeFormat == SBFTIME_GPS)
+    {
+        TimeLen = snprintf(Time, sizeof(Time), " %12.2f",
+                           (double)MeasEpoch->WNc * (86400.0 * 7.0)
+                           + (double)MeasEpoch->TOW_ms / 1000.0);
+    }
+    else
+    {
+        Time[0] = ' ';
+        TimeLen = 1 + sbftime_Print(Time + 1, Spec->TimeFormat,
+                                    sbftime_GetGPSTime_ns(MeasEpoch->WNc, MeasEpoch->TOW_ms), 2);
+    }
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        const MeasSet_t*           GroupSet[SBFMEASSPEC_MAX_GROUPS] = {NULL};
+        uint8_t                    SVID = convertSVIDtoSBF(ChannelData->PRN);
+        char                       SVIDText[3];
+        bool                       Found = false;
+
+        SVIDText[0] = (char)('0' + SVID / 100);
+        SVIDText[1] = (char)('0' + SVID / 10 % 10);
+        SVIDText[2] = (char)('0' + SVID % 10);
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+            uint32_t               Group;
+
+            if (MeasSet->flags == 0 || MeasSet->signalType >= 64 ||
+                Spec->Group[MeasSet->signalType] == 0)
+            {
+                continue;
+            }
+
+            if (Spec->Wide)
+            {
+                /* the first signal of each group is written */
+                Group = Spec->Group[MeasSet->signalType] - 1U;
+
+                if (GroupSet[Group] == NULL)
+                {
+                    GroupSet[Group] = MeasSet;
+                    Found = true;
+                }
+            }
+            else
+            {
+                sbfout_Write(Out, SVIDText, sizeof(SVIDText));
+                sbfout_Write(Out, Time, (size_t)TimeLen);
+                sbfout_Write(Out, " ", 1);
+                sbfout_PutInt(Out, MeasSet->signalType, 2);
+                sbfmeasspec_PrintFields(Out, Spec, MeasSet);
+                sbfout_Write(Out, "\n", 1);
+            }
+        }
+
+        if (Found)
+        {
+            uint32_t Group;
+
+            sbfout_Write(Out, SVIDText, sizeof(SVIDText));
+            sbfout_Write(Out, Time, (size_t)TimeLen);
+
+            for (Group = 0; Group < Spec->NrOfGroups; Group++)
+            {
+                sbfmeasspec_PrintFields(Out, Spec, GroupSet[Group]);
+            }
+
+            sbfout_Write(Out, "\n", 1);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * sbfmeasspec.h: Declaration of the selection of the observables
+ *                written by sbf2asc for each measurement epoch.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFMEASSPEC_H
+#define SBFMEASSPEC_H 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "measepoch.h"
+#include "sbfread.h"
+#include "sbfout.h"
+#include "sbftime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* observables that can be selected */
+typedef enum
+{
+    SBFMEASSPEC_PR,           /* pseudorange, in m */
+    SBFMEASSPEC_L,            /* carrier phase, in cycles */
+    SBFMEASSPEC_DOPPLER,      /* Doppler, in Hz */
+    SBFMEASSPEC_CN0,          /* C/N0, in dB-Hz */
+    SBFMEASSPEC_LOCKTIME,     /* PLL lock time, in ms */
+    SBFMEASSPEC_FLAGS,        /* MEASFLAG_xxx bit field */
+    SBFMEASSPEC_MP,           /* code multipath correction, in mm */
+    SBFMEASSPEC_CARRIERMP,    /* carrier multipath correction, in 1/512 cycles */
+    SBFMEASSPEC_PRVAR,        /* pseudorange variance, in m^2 */
+    SBFMEASSPEC_LVAR,         /* carrier phase variance, in cycles^2 */
+    SBFMEASSPEC_NR_OF_FIELDS
+} sbfmeasspec_Field_t;
+
+/* maximum number of signal groups in the wide form */
+#define SBFMEASSPEC_MAX_GROUPS  16
+
+typedef struct
+{
+    bool              Wide;            /* one row per satellite instead
+                                          of one row per signal */
+    uint32_t          NrOfFields;
+    uint8_t           Fields[SBFMEASSPEC_NR_OF_FIELDS];
+    uint32_t          NrOfGroups;      /* columns groups of the wide form */
+    uint8_t           Group[64];       /* 1 + group of each signal type,
+                                          or 0 if not selected */
+    uint64_t          SignalTypes;     /* bit (1<<SIG_xxx) of the selected
+                                          signal types */
+    uint32_t          Constellations;  /* as in sbfread_DecodeMask_t */
+    sbftime_Format_t  TimeFormat;      /* of the time column, SBFTIME_GPS
+                                          unless set after parsing */
+} sbfmeasspec_t;
+
+/* Parse a selection of observables, in the form
+
+     [long:|wide:]FIELDS[/SIGNALS]
+
+   FIELDS is a comma-separated list of pr, l, doppler, cn0, locktime,
+   flags, mp, carriermp, prvar and lvar, or "all".  SIGNALS is a
+   comma-separated list of signal groups, each made of signal types
+   (GPSL1CA, GALE5a, ...) or constellations (GPS, GLO, GAL, BDS, SBS,
+   QZS, IRN, MSS) joined by '+'.  All the signals are selected if
+   SIGNALS is not given.
+
+   In the long form (the default), a row is written for each selected
+   signal of each satellite.  In the wide form, a row is written for
+   each satellite with one of the selected signals, with the fields of
+   each group in turn: for instance "wide:pr,cn0/GPSL1CA+GALE1BC,
+   GPSL2P+GALE5a" writes the L1/E1 and L2/E5a observables of the GPS
+   and Galileo satellites side by side.
+
+   Returns false if Text is not a valid selection. */
+bool sbfmeasspec_Parse(sbfmeasspec_t* Spec,
+                       const char*    Text);
+
+/* Get the decode mask that makes the decoder skip the observables,
+   signals and constellations that are not selected. */
+void sbfmeasspec_GetDecodeMask(const sbfmeasspec_t*  Spec,
+                               sbfread_DecodeMask_t* Mask);
+
+/* Get a field of a signal, as written by sbfmeasspec_PrintEpoch():
+   F64_NOTVALID or F32_NOTVALID if it is not available. */
+double sbfmeasspec_GetField(const MeasSet_t*    MeasSet,
+                            sbfmeasspec_Field_t Field);
+
+/* Write a space and Value, in the column format of Field. */
+void sbfmeasspec_PutField(sbfout_Stream_t*    Out,
+                          sbfmeasspec_Field_t Field,
+                          double              Value);
+
+/* Write the selected observables of the main antenna of an epoch.
+   Each row starts with the SBF SVID and the time (GPS seconds, or
+   the TimeFormat of Spec), and, in the long form, the signal type.  The observables that are not
+   available are written as -20000000000. */
+void sbfmeasspec_PrintEpoch(sbfout_Stream_t*     Out,
+                            const sbfmeasspec_t* Spec,
+                            const MeasEpoch_t*   MeasEpoch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,874 @@
+/*
+ * sbfout.c: Buffered output streams used to write the decoded SBF
+ *           data, with a fast formatter for the numeric fields.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#if defined(_MSC_VER)
+#define SBFOUT_USE_FWRITE 1
+#else
+#include <unistd.h>
+#endif
+
+#include "sbfout.h"
+#include "sbfcompress.h"
+
+/* room kept free in the buffer before formatting a field, which is
+   more than any field formatted by the fast paths */
+#define SBFOUT_FIELD_MAX  128
+
+/* room kept free before formatting a double with the C library: up to
+   309 digits before the decimal point with "%f", plus the precision */
+#define SBFOUT_DOUBLE_MAX  512
+
+/* exact powers of 10 */
+static const double Pow10[23] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* 2^52: above this, doubles have no fractional part left */
+#define SBFOUT_FIXED_MAX  4503599627370496.0
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfout_WriteToFile(sbfout_Stream_t* Out,
+                               const char*      Data,
+                               size_t           Len)
+{
+    if (Out->Error != 0)
+    {
+        return;
+    }
+
+#if SBFOUT_USE_FWRITE
+
+    if (fwrite(Data, 1, Len, Out->F) != Len)
+    {
+        Out->Error = errno != 0 ? errno : EIO;
+    }
+
+#else
+
+    while (Len > 0)
+    {
+        ssize_t Written = write(fileno(Out->F), Data, Len);
+
+        if (Written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            Out->Error = errno;
+            return;
+        }
+
+        Data += Written;
+        Len  -= (size_t)Written;
+    }
+
+#endif
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfout_Open(sbfout_Stream_t* Out,
+                 FILE*            F)
+{
+    memset(Out, 0, sizeof(*Out));
+
+    Out->Data = (char*)malloc(SBFOUT_BUFFER_SIZE);
+
+    if (Out->Data == NULL)
+    {
+        return false;
+    }
+
+    Out->F    = F;
+    Out->Size = SBFOUT_BUFFER_SIZE;
+
+    /* anything already written with stdio must come first */
+    (void)fflush(F);
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfout_OpenCompressed(sbfout_Stream_t* Out,
+                           FILE*            F,
+                           uint32_t         Format,
+                           uint32_t         NrOfThreads)
+{
+    if (!sbfout_Open(Out, F))
+    {
+        return false;
+    }
+
+    Out->Compress = sbfcompress_Create(F, Format, Out->Size, NrOfThreads);
+
+    if (Out->Compress == NULL)
+    {
+        int Error = errno;
+
+        free(Out->Data);
+        Out->Data = NULL;
+        errno = Error;
+        return false;
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfout_OpenMemory(sbfout_Stream_t* Out)
+{
+    memset(Out, 0, sizeof(*Out));
+
+    Out->Data = (char*)malloc(SBFOUT_BUFFER_SIZE);
+
+    if (Out->Data == NULL)
+    {
+        return false;
+    }
+
+    Out->Size = SBFOUT_BUFFER_SIZE;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfout_Grow(sbfout_Stream_t* Out,
+                        size_t           Len)
+/* makes room for Len more bytes in the buffer of a memory stream.  If
+   the buffer cannot be enlarged, its contents are dropped and the
+   error is reported by sbfout_Close(). */
+{
+    size_t Size = Out->Size * 2;
+    char*  Data;
+
+    if (Size < Out->Used + Len)
+    {
+        Size = Out->Used + Len;
+    }
+
+    Data = (char*)realloc(Out->Data, Size);
+
+    if (Data == NULL)
+    {
+        if (Out->Error == 0)
+        {
+            Out->Error = ENOMEM;
+        }
+
+        Out->Used = 0;
+        return;
+    }
+
+    Out->Data = Data;
+    Out->Size = Size;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfout_Flush(sbfout_Stream_t* Out)
+{
+    if (Out->F == NULL)
+    {
+        return;
+    }
+
+    if (Out->Compress != NULL)
+    {
+        /* the buffer is swapped with an empty one */
+        sbfcompress_Write(Out->Compress, &Out->Data, Out->Used);
+    }
+    else
+    {
+        sbfout_WriteToFile(Out, Out->Data, Out->Used);
+    }
+
+    Out->Used = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfout_Close(sbfout_Stream_t* Out)
+{
+    sbfout_Flush(Out);
+
+    if (Out->Compress != NULL)
+    {
+        int Error = sbfcompress_Close(Out->Compress);
+
+        if (Error != 0 && Out->Error == 0)
+        {
+            Out->Error = Error;
+        }
+
+        Out->Compress = NULL;
+    }
+
+    free(Out->Data);
+    Out->Data = NULL;
+    Out->Size = 0;
+
+    if (Out->Error != 0)
+    {
+        errno = Out->Error;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static char* sbfout_Reserve(sbfout_Stream_t* Out,
+                            size_t           Len)
+/* makes sure Len bytes are free in the buffer and returns a pointer to
+   them */
+{
+    if (Out->F == NULL)
+    {
+        /* the callers asking for the whole buffer get as much room as
+           with a file stream */
+        if (Len > SBFOUT_BUFFER_SIZE)
+        {
+            Len = SBFOUT_BUFFER_SIZE;
+        }
+
+        if (Out->Size - Out->Used < Len)
+        {
+            sbfout_Grow(Out, Len);
+        }
+    }
+    else if (Out->Size - Out->Used < Len)
+    {
+        sbfout_Flush(Out);
+    }
+
+    return Out->Data + Out->Used;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfout_Write(sbfout_Stream_t* Out,
+                  const void*      Data,
+                  size_t           Len)
+{
+    if (Out->Size - Out->Used < Len)
+    {
+        if (Out->F == NULL)
+        {
+            sbfout_Grow(Out, Len);
+
+            if (Out->Size - Out->Used < Len)
+            {
+                return;
+            }
+        }
+        else
+        {
+            sbfout_Flush(Out);
+
+            if (Len >= Out->Size && Out->Compress == NULL)
+            {
+                sbfout_WriteToFile(Out, (const char*)Data, Len);
+                return;
+            }
+
+            /* the compressed streams go through the buffer */
+            while (Len >= Out->Size)
+            {
+                memcpy(Out->Data, Data, Out->Size);
+                Out->Used = Out->Size;
+                Data      = (const char*)Data + Out->Size;
+                Len      -= Out->Size;
+                sbfout_Flush(Out);
+            }
+        }
+    }
+
+    memcpy(Out->Data + Out->Used, Data, Len);
+    Out->Used += Len;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static char* sbfout_Digits(char* End, uint64_t Value, int MinDigits)
+/* writes the decimal digits of Value backwards from End, with at least
+   MinDigits digits, and returns a pointer to the first digit */
+{
+    char* p = End;
+
+    do
+    {
+        *--p = (char)('0' + Value % 10);
+        Value /= 10;
+        MinDigits--;
+    }
+    while (Value != 0 || MinDigits > 0);
+
+    return p;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static size_t sbfout_Pad(char*       Dest,
+                         const char* Field,
+                         size_t      Len,
+                         int         Width,
+                         bool        LeftAlign)
+/* copies Field padded with spaces to Width characters, and returns the
+   number of characters written */
+{
+    size_t Pad = (Width > 0 && (size_t)Width > Len) ? (size_t)Width - Len : 0;
+
+    if (LeftAlign)
+    {
+        memcpy(Dest, Field, Len);
+        memset(Dest + Len, ' ', Pad);
+    }
+    else
+    {
+        memset(Dest, ' ', Pad);
+        memcpy(Dest + Pad, Field, Len);
+    }
+
+    return Len + Pad;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfout_Fixed(char*  Dest,
+                         size_t* Len,
+                         double Value,
+                         int    Width,
+                         int    Precision,
+                         bool   LeftAlign)
+/* formats Value as "%W.Pf".  The result is exact: the product
+   Value*10^P is computed as the sum of two doubles, from which the
+   integer to print is rounded.  Returns false, and the caller has to
+   fall back to the C library, if the value is too large or too close
+   to a rounding tie to be sure to round as printf. */
+{
+    char     Field[48];
+    char*    End = Field + sizeof(Field);
+    char*    p;
+    double   Abs = fabs(Value);
+    double   Scaled;
+    double   Int;
+    double   Frac;
+    uint64_t N;
+
+    if (Precision > 17)
+    {
+        return false;
+    }
+
+    Scaled = Abs * Pow10[Precision];
+
+    /* also catches NaN and infinity */
+    if (!(Scaled < SBFOUT_FIXED_MAX))
+    {
+        return false;
+    }
+
+    Int  = floor(Scaled);
+    Frac = (Scaled - Int) + fma(Abs, Pow10[Precision], -Scaled);
+
+    if (Frac < 0.0)
+    {
+        Int  -= 1.0;
+        Frac += 1.0;
+    }
+
+    if (fabs(Frac - 0.5) < 1e-6)
+    {
+        return false;
+    }
+
+    N = (uint64_t)Int + (Frac > 0.5 ? 1 : 0);
+
+    if (Precision > 0)
+    {
+        p = sbfout_Digits(End, N % (uint64_t)Pow10[Precision], Precision);
+        *--p = '.';
+        p = sbfout_Digits(p, N / (uint64_t)Pow10[Precision], 1);
+    }
+    else
+    {
+        p = sbfout_Digits(End, N, 1);
+    }
+
+    if (signbit(Value))
+    {
+        *--p = '-';
+    }
+
+    *Len = sbfout_Pad(Dest, p, (size_t)(End - p), Width, LeftAlign);
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static size_t sbfout_Integer(char*    Dest,
+                             uint64_t Magnitude,
+                             bool     Negative,
+                             unsigned Base,
+                             int      Width,
+                             bool     LeftAlign,
+                             bool     ZeroPad)
+/* formats an integer as "%Wd", "%-Wd", "%0Wd" or their %u/%x
+   equivalents */
+{
+    static const char Hex[] = "0123456789abcdef";
+    char  Field[SBFOUT_FIELD_MAX / 2 + 1];  /* up to the widest zero padded field */
+    char* End = Field + sizeof(Field);
+    char* p   = End;
+    int   MinDigits = 1;
+
+    if (ZeroPad && !LeftAlign)
+    {
+        MinDigits = Width - (Negative ? 1 : 0);
+    }
+
+    if (Base == 16)
+    {
+        do
+        {
+            *--p = Hex[Magnitude & 0xf];
+            Magnitude >>= 4;
+            MinDigits--;
+        }
+        while (Magnitude != 0 || MinDigits > 0);
+    }
+    else
+    {
+        p = sbfout_Digits(End, Magnitude, MinDigits);
+    }
+
+    if (Negative)
+    {
+        *--p = '-';
+    }
+
+    return sbfout_Pad(Dest, p, (size_t)(End - p), Width, LeftAlign);
+}
+
+
+#define SBFOUT_SNPRINTF(Dest, Room, Fmt, Width, Precision, Value)               \
+    ((Precision) >= 0 ? snprintf(Dest, Room, Fmt, Width, Precision, Value) :    \
+                        snprintf(Dest, Room, Fmt, Width, Value))
+
+/* formats one conversion with the C library into the buffer.  Fmt is
+   the conversion with its width and precision given as '*'.  A field
+   that does not fit is formatted again once the room it needs is
+   reserved, or in a separate buffer if it is larger than the output
+   buffer. */
+#define SBFOUT_LIBC(Out, Fmt, Width, Precision, Value)                         \
+    do                                                                          \
+    {                                                                           \
+        size_t Room = (Out)->Size - (Out)->Used;                                \
+        int    N    = SBFOUT_SNPRINTF((Out)->Data + (Out)->Used, Room, Fmt,     \
+                                      Width, Precision, Value);                 \
+                                                                                \
+        if (N >= 0 && (size_t)N >= Room)                                        \
+        {                                                                       \
+            (void)sbfout_Reserve(Out, (size_t)N + 1);                           \
+                                                                                \
+            if ((Out)->Size - (Out)->Used > (size_t)N)                          \
+            {                                                                   \
+                (void)SBFOUT_SNPRINTF((Out)->Data + (Out)->Used, (size_t)N + 1, \
+                                      Fmt, Width, Precision, Value);            \
+            }                                                                   \
+            else                                                                \
+            {                                                                   \
+                char* Field = (char*)malloc((size_t)N + 1);                     \
+                                                                                \
+                if (Field != NULL)                                              \
+                {                                                               \
+                    (void)SBFOUT_SNPRINTF(Field, (size_t)N + 1, Fmt, Width,     \
+                                          Precision, Value);                    \
+                    sbfout_Write(Out, Field, (size_t)N);                        \
+                    free(Field);                                                \
+                }                                                               \
+                                                                                \
+                N = 0;                                                          \
+            }                                                                   \
+        }                                                                       \
+                                                                                \
+        if (N > 0)                                                              \
+        {                                                                       \
+            (Out)->Used += (size_t)N;                                           \
+        }                                                                       \
+    }                                                                           \
+    while (0)
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfout_Spaces(sbfout_Stream_t* Out,
+                          size_t           Width,
+                          size_t           Len)
+/* pads a field of Len characters to Width with spaces */
+{
+    static const char Spaces[] = "                                                                ";
+
+    while (Width > Len)
+    {
+        size_t N = Width - Len < sizeof(Spaces) - 1 ? Width - Len : sizeof(Spaces) - 1;
+
+        sbfout_Write(Out, Spaces, N);
+        Len += N;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfout_Printf(sbfout_Stream_t* Out,
+                   const char*      Format,
+                   ...)
+{
+    va_list     Args;
+    const char* f = Format;
+
+    va_start(Args, Format);
+
+    while (*f != '\0')
+    {
+        const char* Spec;
+        const char* LengthStart;
+        char        Conv;
+        char        Flags[8];      /* flags other than '-' and '0' */
+        int         NrOfFlags = 0;
+        int         Width = 0;
+        int         Precision = -1;
+        int         LengthLen;
+        bool        LeftAlign = false;
+        bool        ZeroPad = false;
+        bool        Wide;          /* too wide for the fields formatted here */
+        char        Fmt[32];
+        size_t      Len;
+
+        /* copy the text up to the next conversion */
+        if (*f != '%')
+        {
+            const char* Next = strchr(f, '%');
+            size_t      TextLen = Next != NULL ? (size_t)(Next - f) : strlen(f);
+
+            sbfout_Write(Out, f, TextLen);
+            f += TextLen;
+            continue;
+        }
+
+        Spec = f++;
+
+        if (*f == '%')
+        {
+            sbfout_Write(Out, "%", 1);
+            f++;
+            continue;
+        }
+
+        /* parse the conversion specification */
+        for (; *f == '-' || *f == '0' || *f == '+' || *f == ' ' || *f == '#'; f++)
+        {
+            if (*f == '-')
+            {
+                LeftAlign = true;
+            }
+            else if (*f == '0')
+            {
+                ZeroPad = true;
+            }
+            else if (NrOfFlags < (int)sizeof(Flags) - 1)
+            {
+                Flags[NrOfFlags++] = *f;
+            }
+        }
+
+        Flags[NrOfFlags] = '\0';
+
+        if (*f == '*')
+        {
+            Width = va_arg(Args, int);
+            f++;
+
+            if (Width < 0)
+            {
+                LeftAlign = true;
+                Width = -Width;
+            }
+        }
+        else
+        {
+            for (; *f >= '0' && *f <= '9'; f++)
+            {
+                Width = Width * 10 + (*f - '0');
+            }
+        }
+
+        if (*f == '.')
+        {
+            f++;
+            Precision = 0;
+
+            if (*f == '*')
+            {
+                Precision = va_arg(Args, int);
+                f++;
+            }
+            else
+            {
+                for (; *f >= '0' && *f <= '9'; f++)
+                {
+                    Precision = Precision * 10 + (*f - '0');
+                }
+            }
+        }
+
+        LengthStart = f;
+
+        while (*f == 'h' || *f == 'l' || *f == 'z' || *f == 'j' || *f == 't' || *f == 'L')
+        {
+            f++;
+        }
+
+        LengthLen = (int)(f - LengthStart);
+        Conv      = *f;
+
+        if (Conv == '\0')
+        {
+            /* incomplete: print it as is */
+            sbfout_Write(Out, Spec, (size_t)(f - Spec));
+            break;
+        }
+
+        f++;
+
+        if (LengthLen > 2)
+        {
+            /* not supported: print it as is */
+            sbfout_Write(Out, Spec, (size_t)(f - Spec));
+            continue;
+        }
+
+        /* the wider fields go through the C library */
+        Wide = Width > SBFOUT_FIELD_MAX / 2 || Precision > SBFOUT_FIELD_MAX / 2;
+
+        (void)sbfout_Reserve(Out, SBFOUT_FIELD_MAX);
+
+        if (Conv == 'f' || Conv == 'F' || Conv == 'e' || Conv == 'E' ||
+            Conv == 'g' || Conv == 'G' || Conv == 'a' || Conv == 'A')
+        {
+            if (*LengthStart == 'L')
+            {
+                long double Value = va_arg(Args, long double);
+
+                (void)snprintf(Fmt, sizeof(Fmt), "%%%s%s%s*%sL%c", Flags, LeftAlign ? "-" : "", ZeroPad ? "0" : "",
+                               Precision >= 0 ? ".*" : "", Conv);
+                SBFOUT_LIBC(Out, Fmt, Width, Precision, Value);
+            }
+            else
+            {
+                double Value = va_arg(Args, double);
+
+                /* large values (up to 308 digits) and rounding ties go
+                   through the C library */
+                if ((Conv == 'f' || Conv == 'F') && NrOfFlags == 0 && !ZeroPad && !Wide &&
+                    sbfout_Fixed(Out->Data + Out->Used, &Len, Value, Width, Precision < 0 ? 6 : Precision, LeftAlign))
+                {
+                    Out->Used += Len;
+                }
+                else
+                {
+                    (void)sbfout_Reserve(Out, SBFOUT_DOUBLE_MAX);
+                    (void)snprintf(Fmt, sizeof(Fmt), "%%%s%s%s*%s%c", Flags, LeftAlign ? "-" : "", ZeroPad ? "0" : "",
+                                   Precision >= 0 ? ".*" : "", Conv);
+                    SBFOUT_LIBC(Out, Fmt, Width, Precision, Value);
+                }
+            }
+        }
+        else if (Conv == 'd' || Conv == 'i' || Conv == 'u' || Conv == 'x' || Conv == 'X' || Conv == 'o')
+        {
+            bool     Signed = (Conv == 'd' || Conv == 'i');
+            int64_t  SValue;
+            uint64_t UValue;
+            char     L0 = LengthLen > 0 ? LengthStart[0] : '\0';
+            char     L1 = LengthLen > 1 ? LengthStart[1] : '\0';
+
+            if (L0 == 'h' && L1 == 'h')
+            {
+                UValue = (unsigned char)va_arg(Args, unsigned int);
+                SValue = (signed char)UValue;
+            }
+            else if (L0 == 'h')
+            {
+                UValue = (unsigned short)va_arg(Args, unsigned int);
+                SValue = (short)UValue;
+            }
+            else if (L0 == 'l' && L1 == 'l')
+            {
+                UValue = va_arg(Args, unsigned long long);
+                SValue = (int64_t)UValue;
+            }
+            else if (L0 == 'l')
+            {
+                UValue = va_arg(Args, unsigned long);
+                SValue = Signed ? (int64_t)(long)UValue : (int64_t)UValue;
+            }
+            else if (L0 == 'z' || L0 == 't')
+            {
+                UValue = va_arg(Args, size_t);
+                SValue = Signed ? (int64_t)(ptrdiff_t)UValue : (int64_t)UValue;
+            }
+            else if (L0 == 'j')
+            {
+                UValue = (uint64_t)va_arg(Args, uintmax_t);
+                SValue = (int64_t)UValue;
+            }
+            else
+            {
+                UValue = va_arg(Args, unsigned int);
+                SValue = Signed ? (int64_t)(int)UValue : (int64_t)UValue;
+            }
+
+            if (NrOfFlags == 0 && Precision < 0 && !Wide && Conv != 'X' && Conv != 'o')
+            {
+                if (Signed)
+                {
+                    Out->Used += sbfout_Integer(Out->Data + Out->Used,
+                                                SValue < 0 ? 0 - (uint64_t)SValue : (uint64_t)SValue, SValue < 0,
+                                                10, Width, LeftAlign, ZeroPad);
+                }
+                else
+                {
+                    Out->Used += sbfout_Integer(Out->Data + Out->Used, UValue, false,
+                                                Conv == 'x' ? 16 : 10, Width, LeftAlign, ZeroPad);
+                }
+            }
+            else
+            {
+                (void)snprintf(Fmt, sizeof(Fmt), "%%%s%s%s*%sll%c", Flags, LeftAlign ? "-" : "", ZeroPad ? "0" : "",
+                               Precision >= 0 ? ".*" : "", Conv);
+
+                if (Signed)
+                {
+                    SBFOUT_LIBC(Out, Fmt, Width, Precision, (long long)SValue);
+                }
+                else
+                {
+                    SBFOUT_LIBC(Out, Fmt, Width, Precision, (unsigned long long)UValue);
+                }
+            }
+        }
+        else if (Conv == 'c')
+        {
+            int Value = va_arg(Args, int);
+
+            (void)snprintf(Fmt, sizeof(Fmt), "%%%s*c", LeftAlign ? "-" : "");
+            SBFOUT_LIBC(Out, Fmt, Width, -1, Value);
+        }
+        else if (Conv == 's')
+        {
+            const char* Value = va_arg(Args, const char*);
+            size_t      StrLen = strlen(Value);
+
+            if (Precision >= 0 && (size_t)Precision < StrLen)
+            {
+                StrLen = (size_t)Precision;
+            }
+
+            if (!LeftAlign)
+            {
+                sbfout_Spaces(Out, (size_t)Width, StrLen);
+            }
+
+            sbfout_Write(Out, Value, StrLen);
+
+            if (LeftAlign)
+            {
+                sbfout_Spaces(Out, (size_t)Width, StrLen);
+            }
+        }
+        else if (Conv == 'p')
+        {
+            void* Value = va_arg(Args, void*);
+
+            (void)snprintf(Fmt, sizeof(Fmt), "%%%s*p", LeftAlign ? "-" : "");
+            SBFOUT_LIBC(Out, Fmt, Width, -1, Value);
+        }
+        else
+        {
+            /* unknown conversion: print it as is */
+            sbfout_Write(Out, Spec, (size_t)(f - Spec));
+        }
+    }
+
+    va_end(Args);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfout_PutFixed(sbfout_Stream_t* Out,
+                     double           Value,
+                     int              Width,
+                     int              Precision)
+{
+    size_t Len;
+
+    (void)sbfout_Reserve(Out, SBFOUT_FIELD_MAX);
+
+    if (Width >= 0 && Width <= SBFOUT_FIELD_MAX / 2 && Precision >= 0 &&
+        sbfout_Fixed(Out->Data + Out->Used, &Len, Value, Width, Precision, false))
+    {
+        Out->Used += Len;
+    }
+    else
+    {
+        sbfout_Printf(Out, "%*.*f", Width, Precision, Value);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfout_PutInt(sbfout_Stream_t* Out,
+                   int64_t          Value,
+                   int              Width)
+{
+    if (Width >= 0 && Width <= SBFOUT_FIELD_MAX / 2)
+    {
+        (void)sbfout_Reserve(Out, SBFOUT_FIELD_MAX);
+        Out->Used += sbfout_Integer(Out->Data + Out->Used,
+                                    Value < 0 ? 0 - (uint64_t)Value : (uint64_t)Value, Value < 0,
+                                    10, Width, false, false);
+    }
+    else
+    {
+        sbfout_Printf(Out, "%*lld", Width, (long long)Value);
+    }
+}
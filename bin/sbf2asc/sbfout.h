@@ -0,0 +1,110 @@
+/*
+ * sbfout.h: Declaration of the buffered output streams used to write
+ *           the decoded SBF data.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFOUT_H
+#define SBFOUT_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size of the output buffer, which is written to the file in one go
+   when full */
+#ifndef SBFOUT_BUFFER_SIZE
+#define SBFOUT_BUFFER_SIZE  (1 << 20)
+#endif
+
+typedef struct
+{
+    FILE*             F;      /* NULL for the memory streams */
+    char*             Data;
+    size_t            Size;
+    size_t            Used;
+    int               Error;  /* errno of the first failed write, or 0 */
+    struct sbfcompress_s* Compress;  /* NULL if not compressed */
+} sbfout_Stream_t;
+
+/* Start buffering the output to F, which must be open for writing.
+   Returns false if the buffer cannot be allocated. */
+bool sbfout_Open(sbfout_Stream_t* Out,
+                 FILE*            F);
+
+/* Same as sbfout_Open(), with each full buffer compressed in Format
+   (SBFCOMPRESS_GZIP or SBFCOMPRESS_ZSTD, see sbfcompress.h) before
+   being written to F, which must be open in binary mode.  The buffers
+   are compressed by NrOfThreads worker threads (0: by the caller).
+   Returns false if Format is not available in this build (errno is
+   EINVAL) or on allocation failure. */
+bool sbfout_OpenCompressed(sbfout_Stream_t* Out,
+                           FILE*            F,
+                           uint32_t         Format,
+                           uint32_t         NrOfThreads);
+
+/* Start buffering the output in memory only, for instance to format
+   part of a file in another thread.  The buffer grows as needed, and
+   its contents (Data, Used) are used by the caller, typically with
+   sbfout_Write() to a file stream, before setting Used back to 0.
+   Returns false if the buffer cannot be allocated. */
+bool sbfout_OpenMemory(sbfout_Stream_t* Out);
+
+/* Write Len bytes from Data. */
+void sbfout_Write(sbfout_Stream_t* Out,
+                  const void*      Data,
+                  size_t           Len);
+
+/* Formatted output, with the same format string and the same result
+   as fprintf().  The %f and integer conversions are formatted without
+   going through the C library, which makes sbfout_Printf() several
+   times faster than fprintf() for the tables written by sbf2asc. */
+void sbfout_Printf(sbfout_Stream_t* Out,
+                   const char*      Format,
+                   ...)
+#if defined(__GNUC__)
+__attribute__((format(printf, 2, 3)))
+#endif
+;
+
+/* Same as sbfout_Printf(Out, "%*.*f", Width, Precision, Value) and
+   sbfout_Printf(Out, "%*lld", Width, Value), without parsing a format
+   string, for the tables whose columns are chosen at run time. */
+void sbfout_PutFixed(sbfout_Stream_t* Out,
+                     double           Value,
+                     int              Width,
+                     int              Precision);
+
+void sbfout_PutInt(sbfout_Stream_t* Out,
+                   int64_t          Value,
+                   int              Width);
+
+/* Write the buffered data to the file (nothing for the memory
+   streams).  The compressed streams hand it to the compression. */
+void sbfout_Flush(sbfout_Stream_t* Out);
+
+/* Flush and free the buffer.  The file itself is not closed.  Returns
+   0 on success, or -1 if any write failed (errno is set). */
+int32_t sbfout_Close(sbfout_Stream_t* Out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
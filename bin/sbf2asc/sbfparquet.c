@@ -0,0 +1,1385 @@
+/*
+ * sbfparquet.c: Self-contained writer of Apache Parquet files.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* A Parquet file is made of:
+ *
+ *   "PAR1"
+ *   the row groups, each with one column chunk per column
+ *   the file metadata (FileMetaData), Thrift compact-encoded
+ *   the length of the metadata (int32) and "PAR1"
+ *
+ * A column chunk is an optional dictionary page followed by data
+ * pages, each with a Thrift-encoded PageHeader.  The pages are not
+ * compressed, but encoded according to the type of the column:
+ *
+ *   INT64:         DELTA_BINARY_PACKED
+ *   UINT8, STRING: a PLAIN dictionary page with all the entries of the
+ *                  dictionary, and RLE_DICTIONARY data pages
+ *   FLOAT, DOUBLE: PLAIN
+ *
+ * The definition levels of the optional columns are RLE-encoded.  The
+ * metadata of each column chunk has the min/max statistics of its
+ * values, so that readers can skip the row groups by time or
+ * satellite.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sbfparquet.h"
+
+/* Type */
+#define PQ_TYPE_INT32               1
+#define PQ_TYPE_INT64               2
+#define PQ_TYPE_FLOAT               4
+#define PQ_TYPE_DOUBLE              5
+#define PQ_TYPE_BYTE_ARRAY          6
+
+/* Encoding */
+#define PQ_ENCODING_PLAIN           0
+#define PQ_ENCODING_RLE             3
+#define PQ_ENCODING_DELTA_BINARY    5
+#define PQ_ENCODING_RLE_DICTIONARY  8
+
+/* PageType */
+#define PQ_PAGE_DATA                0
+#define PQ_PAGE_DICTIONARY          2
+
+/* ConvertedType */
+#define PQ_CONVERTED_UTF8           0
+#define PQ_CONVERTED_UINT_8         11
+
+/* Thrift compact protocol types */
+#define TC_TRUE                     1
+#define TC_FALSE                    2
+#define TC_BYTE                     3
+#define TC_I16                      4
+#define TC_I32                      5
+#define TC_I64                      6
+#define TC_BINARY                   8
+#define TC_LIST                     9
+#define TC_STRUCT                   12
+
+/* DELTA_BINARY_PACKED block layout */
+#define PQ_DELTA_BLOCK              128
+#define PQ_DELTA_MINIBLOCKS         4
+#define PQ_DELTA_MINIBLOCK          (PQ_DELTA_BLOCK / PQ_DELTA_MINIBLOCKS)
+
+#define PQ_MAX_DEPTH                8
+
+static const uint8_t Magic[4] = {'P', 'A', 'R', '1'};
+
+/* Thrift compact protocol encoder: the field ids are encoded as the
+   difference with the previous field of the same struct */
+typedef struct
+{
+    sbfparquet_Buffer_t* B;
+    int16_t              LastId[PQ_MAX_DEPTH];
+    uint32_t             Depth;
+} sbfparquet_Thrift_t;
+
+/* bit-packing, least significant bit first */
+typedef struct
+{
+    sbfparquet_Buffer_t* B;
+    uint64_t             Acc;
+    uint32_t             Bits;
+} sbfparquet_BitWriter_t;
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_Put(sbfparquet_Buffer_t* B,
+                           const void*          Data,
+                           size_t               Len)
+{
+    if (B->Cap - B->Size < Len)
+    {
+        size_t   NewCap = B->Cap * 2 + Len + 4096;
+        uint8_t* NewData = (uint8_t*)realloc(B->Data, NewCap);
+
+        if (NewData == NULL)
+        {
+            B->Error = true;
+            return;
+        }
+
+        B->Data = NewData;
+        B->Cap  = NewCap;
+    }
+
+    if (Len > 0)
+    {
+        memcpy(B->Data + B->Size, Data, Len);
+        B->Size += Len;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_PutByte(sbfparquet_Buffer_t* B,
+                               uint8_t              Byte)
+{
+    sbfparquet_Put(B, &Byte, 1);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_PutLE(sbfparquet_Buffer_t* B,
+                             uint64_t             Value,
+                             size_t               Len)
+{
+    uint8_t Bytes[8];
+    size_t  i;
+
+    for (i = 0; i < Len; i++)
+    {
+        Bytes[i] = (uint8_t)(Value >> (8 * i));
+    }
+
+    sbfparquet_Put(B, Bytes, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_PutVarint(sbfparquet_Buffer_t* B,
+                                 uint64_t             Value)
+{
+    uint8_t Bytes[10];
+    size_t  Len = 0;
+
+    while (Value >= 0x80)
+    {
+        Bytes[Len++] = (uint8_t)(Value | 0x80);
+        Value >>= 7;
+    }
+
+    Bytes[Len++] = (uint8_t)Value;
+
+    sbfparquet_Put(B, Bytes, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint64_t sbfparquet_ZigZag(int64_t Value)
+{
+    return ((uint64_t)Value << 1) ^ (uint64_t)(Value >> 63);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfparquet_BitWidth(uint64_t Value)
+/* number of bits needed to store Value */
+{
+    uint32_t Width = 0;
+
+    for (; Value != 0; Value >>= 1)
+    {
+        Width++;
+    }
+
+    return Width;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_Init(sbfparquet_Thrift_t* T,
+                              sbfparquet_Buffer_t* B)
+{
+    T->B         = B;
+    T->Depth     = 0;
+    T->LastId[0] = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_Field(sbfparquet_Thrift_t* T,
+                               uint8_t              Type,
+                               int16_t              Id)
+{
+    int32_t Delta = Id - T->LastId[T->Depth];
+
+    if (Delta > 0 && Delta <= 15)
+    {
+        sbfparquet_PutByte(T->B, (uint8_t)((Delta << 4) | Type));
+    }
+    else
+    {
+        sbfparquet_PutByte(T->B, Type);
+        sbfparquet_PutVarint(T->B, sbfparquet_ZigZag(Id));
+    }
+
+    T->LastId[T->Depth] = Id;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_I32(sbfparquet_Thrift_t* T, int16_t Id, int32_t Value)
+{
+    sbfparquet_T_Field(T, TC_I32, Id);
+    sbfparquet_PutVarint(T->B, sbfparquet_ZigZag(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_I64(sbfparquet_Thrift_t* T, int16_t Id, int64_t Value)
+{
+    sbfparquet_T_Field(T, TC_I64, Id);
+    sbfparquet_PutVarint(T->B, sbfparquet_ZigZag(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_Binary(sbfparquet_Thrift_t* T, int16_t Id, const void* Data, size_t Len)
+{
+    sbfparquet_T_Field(T, TC_BINARY, Id);
+    sbfparquet_PutVarint(T->B, Len);
+    sbfparquet_Put(T->B, Data, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_String(sbfparquet_Thrift_t* T, int16_t Id, const char* String)
+{
+    sbfparquet_T_Binary(T, Id, String, strlen(String));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_BeginStruct(sbfparquet_Thrift_t* T, int16_t Id)
+{
+    sbfparquet_T_Field(T, TC_STRUCT, Id);
+    T->LastId[++T->Depth] = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_BeginList(sbfparquet_Thrift_t* T, int16_t Id, uint8_t ElemType, uint32_t Count)
+{
+    sbfparquet_T_Field(T, TC_LIST, Id);
+
+    if (Count < 15)
+    {
+        sbfparquet_PutByte(T->B, (uint8_t)((Count << 4) | ElemType));
+    }
+    else
+    {
+        sbfparquet_PutByte(T->B, (uint8_t)(0xf0 | ElemType));
+        sbfparquet_PutVarint(T->B, Count);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_BeginElement(sbfparquet_Thrift_t* T)
+/* starts a struct element of a list */
+{
+    T->LastId[++T->Depth] = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_EndStruct(sbfparquet_Thrift_t* T)
+{
+    sbfparquet_PutByte(T->B, 0);
+
+    if (T->Depth > 0)
+    {
+        T->Depth--;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_BitPut(sbfparquet_BitWriter_t* W,
+                              uint64_t                Value,
+                              uint32_t                Width)
+{
+    if (Width > 32)
+    {
+        sbfparquet_BitPut(W, Value & 0xffffffffU, 32);
+        sbfparquet_BitPut(W, Value >> 32, Width - 32);
+        return;
+    }
+
+    if (Width < 32)
+    {
+        Value &= ((uint64_t)1 << Width) - 1;
+    }
+
+    W->Acc  |= Value << W->Bits;
+    W->Bits += Width;
+
+    while (W->Bits >= 8)
+    {
+        sbfparquet_PutByte(W->B, (uint8_t)W->Acc);
+        W->Acc  >>= 8;
+        W->Bits -= 8;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_BitFlush(sbfparquet_BitWriter_t* W)
+{
+    if (W->Bits > 0)
+    {
+        sbfparquet_PutByte(W->B, (uint8_t)W->Acc);
+    }
+
+    W->Acc  = 0;
+    W->Bits = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_BitPackGroups(sbfparquet_Buffer_t* B,
+                                     const uint16_t*      Values,
+                                     uint32_t             Count,
+                                     uint32_t             Width)
+/* a bit-packed run of the RLE/bit-packing hybrid encoding, padded to a
+   multiple of 8 values */
+{
+    sbfparquet_BitWriter_t W = {B, 0, 0};
+    uint32_t               Groups = (Count + 7) / 8;
+    uint32_t               i;
+
+    sbfparquet_PutVarint(B, ((uint64_t)Groups << 1) | 1);
+
+    for (i = 0; i < Groups * 8; i++)
+    {
+        sbfparquet_BitPut(&W, i < Count ? Values[i] : 0, Width);
+    }
+
+    sbfparquet_BitFlush(&W);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_RleHybrid(sbfparquet_Buffer_t* B,
+                                 const uint16_t*      Values,
+                                 uint32_t             Count,
+                                 uint32_t             Width)
+/* RLE/bit-packing hybrid encoding: runs of at least 8 equal values are
+   run-length encoded, the other values are bit-packed by groups of 8 */
+{
+    uint32_t LitStart = 0;
+    uint32_t NrOfLit  = 0;
+    uint32_t i = 0;
+
+    while (i < Count)
+    {
+        uint32_t Run = 1;
+
+        while (i + Run < Count && Values[i + Run] == Values[i])
+        {
+            Run++;
+        }
+
+        if (Run >= 8 && NrOfLit % 8 != 0)
+        {
+            /* the bit-packed values before a run must make full
+               groups: complete them with the start of the run */
+            uint32_t Fill = 8 - NrOfLit % 8;
+
+            NrOfLit += Fill;
+            i       += Fill;
+            Run     -= Fill;
+        }
+
+        if (Run >= 8)
+        {
+            if (NrOfLit > 0)
+            {
+                sbfparquet_BitPackGroups(B, Values + LitStart, NrOfLit, Width);
+            }
+
+            sbfparquet_PutVarint(B, (uint64_t)Run << 1);
+            sbfparquet_PutLE(B, Values[i], (Width + 7) / 8);
+
+            i       += Run;
+            LitStart = i;
+            NrOfLit  = 0;
+        }
+        else
+        {
+            NrOfLit += Run;
+            i       += Run;
+        }
+    }
+
+    if (NrOfLit > 0)
+    {
+        sbfparquet_BitPackGroups(B, Values + LitStart, NrOfLit, Width);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_DeltaBinaryPacked(sbfparquet_Buffer_t* B,
+                                         const int64_t*       Values,
+                                         uint32_t             Count)
+{
+    uint32_t First;
+
+    sbfparquet_PutVarint(B, PQ_DELTA_BLOCK);
+    sbfparquet_PutVarint(B, PQ_DELTA_MINIBLOCKS);
+    sbfparquet_PutVarint(B, Count);
+    sbfparquet_PutVarint(B, sbfparquet_ZigZag(Count > 0 ? Values[0] : 0));
+
+    for (First = 1; First < Count; First += PQ_DELTA_BLOCK)
+    {
+        uint64_t               Deltas[PQ_DELTA_BLOCK];
+        uint8_t                Widths[PQ_DELTA_MINIBLOCKS];
+        uint32_t               NrOfDeltas = Count - First;
+        int64_t                MinDelta;
+        sbfparquet_BitWriter_t W = {B, 0, 0};
+        uint32_t               i, m;
+
+        if (NrOfDeltas > PQ_DELTA_BLOCK)
+        {
+            NrOfDeltas = PQ_DELTA_BLOCK;
+        }
+
+        /* the deltas wrap around like the int64 values */
+        for (i = 0; i < NrOfDeltas; i++)
+        {
+            Deltas[i] = (uint64_t)Values[First + i] - (uint64_t)Values[First + i - 1];
+        }
+
+        MinDelta = INT64_MAX;
+
+        for (i = 0; i < NrOfDeltas; i++)
+        {
+            if ((int64_t)Deltas[i] < MinDelta)
+            {
+                MinDelta = (int64_t)Deltas[i];
+            }
+        }
+
+        /* the unused miniblocks are padded with MinDelta */
+        for (i = 0; i < PQ_DELTA_BLOCK; i++)
+        {
+            Deltas[i] = i < NrOfDeltas ? Deltas[i] - (uint64_t)MinDelta : 0;
+        }
+
+        for (m = 0; m < PQ_DELTA_MINIBLOCKS; m++)
+        {
+            uint64_t Max = 0;
+
+            for (i = m * PQ_DELTA_MINIBLOCK; i < (m + 1) * PQ_DELTA_MINIBLOCK; i++)
+            {
+                Max |= Deltas[i];
+            }
+
+            Widths[m] = (uint8_t)sbfparquet_BitWidth(Max);
+        }
+
+        sbfparquet_PutVarint(B, sbfparquet_ZigZag(MinDelta));
+        sbfparquet_Put(B, Widths, sizeof(Widths));
+
+        /* the miniblocks after the last delta are left out */
+        for (m = 0; m * PQ_DELTA_MINIBLOCK < NrOfDeltas; m++)
+        {
+            for (i = m * PQ_DELTA_MINIBLOCK; i < (m + 1) * PQ_DELTA_MINIBLOCK; i++)
+            {
+                sbfparquet_BitPut(&W, Deltas[i], Widths[m]);
+            }
+        }
+
+        sbfparquet_BitFlush(&W);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static size_t sbfparquet_ValueSize(sbfparquet_Type_t Type)
+{
+    switch (Type)
+    {
+    case SBFPARQUET_INT64:
+    case SBFPARQUET_DOUBLE:
+        return 8;
+
+    case SBFPARQUET_FLOAT:
+        return 4;
+
+    case SBFPARQUET_STRING:
+        return 2;
+
+    default:
+        return 1;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_SetError(sbfparquet_Writer_t* Writer,
+                                int                  Error)
+{
+    if (Writer->Error == 0)
+    {
+        Writer->Error = Error;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_Write(sbfparquet_Writer_t* Writer,
+                             const void*          Data,
+                             size_t               Len)
+{
+    sbfout_Write(&Writer->Out, Data, Len);
+    Writer->Offset += (int64_t)Len;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_PageHeader(sbfparquet_Writer_t* Writer,
+                                  int32_t              PageType,
+                                  int32_t              PageSize,
+                                  int32_t              NrOfValues,
+                                  int32_t              Encoding)
+/* encodes the header of a page in Writer->Meta */
+{
+    sbfparquet_Thrift_t T;
+
+    Writer->Meta.Size = 0;
+    sbfparquet_T_Init(&T, &Writer->Meta);
+
+    sbfparquet_T_I32(&T, 1, PageType);
+    sbfparquet_T_I32(&T, 2, PageSize);         /* uncompressed */
+    sbfparquet_T_I32(&T, 3, PageSize);         /* compressed */
+
+    if (PageType == PQ_PAGE_DATA)
+    {
+        sbfparquet_T_BeginStruct(&T, 5);
+        sbfparquet_T_I32(&T, 1, NrOfValues);
+        sbfparquet_T_I32(&T, 2, Encoding);
+        sbfparquet_T_I32(&T, 3, PQ_ENCODING_RLE);   /* definition levels */
+        sbfparquet_T_I32(&T, 4, PQ_ENCODING_RLE);   /* repetition levels */
+        sbfparquet_T_EndStruct(&T);
+    }
+    else
+    {
+        sbfparquet_T_BeginStruct(&T, 7);
+        sbfparquet_T_I32(&T, 1, NrOfValues);
+        sbfparquet_T_I32(&T, 2, Encoding);
+        sbfparquet_T_EndStruct(&T);
+    }
+
+    sbfparquet_T_EndStruct(&T);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_UpdateStats(sbfparquet_Writer_t* Writer,
+                                   uint32_t             Col,
+                                   const uint8_t*       Values,
+                                   uint32_t             Count)
+/* adds the Count (non-null) values of a page to the statistics of the
+   column chunk */
+{
+    sbfparquet_ColumnState_t* State = &Writer->State[Col];
+    sbfparquet_Chunk_t*       Chunk = &State->Chunk;
+    uint32_t                  i;
+
+    for (i = 0; i < Count; i++)
+    {
+        int64_t IValue = 0;
+        double  DValue = 0.0;
+
+        switch (Writer->Columns[Col].Type)
+        {
+        case SBFPARQUET_INT64:
+            memcpy(&IValue, Values + 8 * i, 8);
+            break;
+
+        case SBFPARQUET_UINT8:
+            IValue = Values[i];
+            break;
+
+        case SBFPARQUET_STRING:
+        {
+            uint16_t Index;
+
+            /* the min and max strings are found when the row group is
+               written */
+            memcpy(&Index, Values + 2 * i, 2);
+            State->Used[Index] = 1;
+            continue;
+        }
+
+        case SBFPARQUET_FLOAT:
+        {
+            float FValue;
+
+            memcpy(&FValue, Values + 4 * i, 4);
+            DValue = FValue;
+            break;
+        }
+
+        default:
+            memcpy(&DValue, Values + 8 * i, 8);
+            break;
+        }
+
+        if (Writer->Columns[Col].Type == SBFPARQUET_FLOAT || Writer->Columns[Col].Type == SBFPARQUET_DOUBLE)
+        {
+            /* NaN values are not ordered */
+            if (DValue != DValue)
+            {
+                continue;
+            }
+
+            if (!Chunk->HasMinMax || DValue < Chunk->DMin)
+            {
+                Chunk->DMin = DValue;
+            }
+
+            if (!Chunk->HasMinMax || DValue > Chunk->DMax)
+            {
+                Chunk->DMax = DValue;
+            }
+        }
+        else
+        {
+            if (!Chunk->HasMinMax || IValue < Chunk->IMin)
+            {
+                Chunk->IMin = IValue;
+            }
+
+            if (!Chunk->HasMinMax || IValue > Chunk->IMax)
+            {
+                Chunk->IMax = IValue;
+            }
+        }
+
+        Chunk->HasMinMax = true;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_WritePage(sbfparquet_Writer_t* Writer,
+                                 uint32_t             Col)
+/* encodes the rows of the current page of a column to its spill file */
+{
+    const sbfparquet_Column_t* Column = &Writer->Columns[Col];
+    sbfparquet_ColumnState_t*  State = &Writer->State[Col];
+    sbfparquet_Buffer_t*       Page = &Writer->Page;
+    size_t                     ValueSize = sbfparquet_ValueSize(Column->Type);
+    uint32_t                   NrOfRows = Writer->NrOfRows;
+    uint32_t                   NrOfValues = 0;
+    int32_t                    Encoding;
+    uint32_t                   i;
+
+    Page->Size = 0;
+
+    if (Column->Optional)
+    {
+        uint16_t* Levels = (uint16_t*)malloc(NrOfRows * sizeof(uint16_t) + 1);
+        size_t    Start;
+
+        if (Levels == NULL)
+        {
+            sbfparquet_SetError(Writer, ENOMEM);
+            return;
+        }
+
+        for (i = 0; i < NrOfRows; i++)
+        {
+            Levels[i] = State->Defined[i];
+        }
+
+        /* the definition levels are prefixed by their length */
+        sbfparquet_PutLE(Page, 0, 4);
+        Start = Page->Size;
+        sbfparquet_RleHybrid(Page, Levels, NrOfRows, 1);
+        free(Levels);
+
+        if (!Page->Error)
+        {
+            size_t Len = Page->Size - Start;
+
+            Page->Data[Start - 4] = (uint8_t)Len;
+            Page->Data[Start - 3] = (uint8_t)(Len >> 8);
+            Page->Data[Start - 2] = (uint8_t)(Len >> 16);
+            Page->Data[Start - 1] = (uint8_t)(Len >> 24);
+        }
+    }
+
+    /* keep the non-null values only */
+    for (i = 0; i < NrOfRows; i++)
+    {
+        if (State->Defined[i] || !Column->Optional)
+        {
+            memmove(State->Values + NrOfValues * ValueSize, State->Values + i * ValueSize, ValueSize);
+            NrOfValues++;
+        }
+    }
+
+    sbfparquet_UpdateStats(Writer, Col, State->Values, NrOfValues);
+
+    switch (Column->Type)
+    {
+    case SBFPARQUET_INT64:
+        Encoding = PQ_ENCODING_DELTA_BINARY;
+        sbfparquet_DeltaBinaryPacked(Page, (const int64_t*)(void*)State->Values, NrOfValues);
+        break;
+
+    case SBFPARQUET_UINT8:
+    case SBFPARQUET_STRING:
+    {
+        uint16_t* Indices = (uint16_t*)malloc(NrOfValues * sizeof(uint16_t) + 1);
+        uint32_t  Width = sbfparquet_BitWidth(Column->DictionarySize - 1);
+
+        if (Indices == NULL)
+        {
+            sbfparquet_SetError(Writer, ENOMEM);
+            return;
+        }
+
+        for (i = 0; i < NrOfValues; i++)
+        {
+            if (Column->Type == SBFPARQUET_UINT8)
+            {
+                Indices[i] = State->Values[i];
+            }
+            else
+            {
+                memcpy(&Indices[i], State->Values + 2 * i, 2);
+            }
+        }
+
+        Width = Width > 0 ? Width : 1;
+        Encoding = PQ_ENCODING_RLE_DICTIONARY;
+        sbfparquet_PutByte(Page, (uint8_t)Width);
+        sbfparquet_RleHybrid(Page, Indices, NrOfValues, Width);
+        free(Indices);
+        break;
+    }
+
+    default:
+        Encoding = PQ_ENCODING_PLAIN;
+        sbfparquet_Put(Page, State->Values, NrOfValues * ValueSize);
+        break;
+    }
+
+    if (Page->Error)
+    {
+        sbfparquet_SetError(Writer, ENOMEM);
+        return;
+    }
+
+    sbfparquet_PageHeader(Writer, PQ_PAGE_DATA, (int32_t)Page->Size, (int32_t)NrOfRows, Encoding);
+
+    if (fwrite(Writer->Meta.Data, 1, Writer->Meta.Size, State->Spill) != Writer->Meta.Size ||
+        fwrite(Page->Data, 1, Page->Size, State->Spill) != Page->Size)
+    {
+        sbfparquet_SetError(Writer, errno != 0 ? errno : EIO);
+    }
+
+    State->SpillSize        += (int64_t)(Writer->Meta.Size + Page->Size);
+    State->Chunk.NrOfValues += NrOfRows;
+    State->Chunk.NullCount  += NrOfRows - NrOfValues;
+
+    /* unset values of the next page are null and 0 */
+    memset(State->Values, 0, NrOfRows * ValueSize);
+    memset(State->Defined, 0, NrOfRows);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_WriteDictionaryPage(sbfparquet_Writer_t* Writer,
+                                           uint32_t             Col)
+{
+    const sbfparquet_Column_t* Column = &Writer->Columns[Col];
+    sbfparquet_Buffer_t*       Page = &Writer->Page;
+    uint32_t                   i;
+
+    Page->Size = 0;
+
+    for (i = 0; i < Column->DictionarySize; i++)
+    {
+        if (Column->Type == SBFPARQUET_UINT8)
+        {
+            sbfparquet_PutLE(Page, i, 4);
+        }
+        else
+        {
+            size_t Len = strlen(Column->Dictionary[i]);
+
+            sbfparquet_PutLE(Page, Len, 4);
+            sbfparquet_Put(Page, Column->Dictionary[i], Len);
+        }
+    }
+
+    if (Page->Error)
+    {
+        sbfparquet_SetError(Writer, ENOMEM);
+        return;
+    }
+
+    sbfparquet_PageHeader(Writer, PQ_PAGE_DICTIONARY, (int32_t)Page->Size,
+                          (int32_t)Column->DictionarySize, PQ_ENCODING_PLAIN);
+    sbfparquet_Write(Writer, Writer->Meta.Data, Writer->Meta.Size);
+    sbfparquet_Write(Writer, Page->Data, Page->Size);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_CopySpill(sbfparquet_Writer_t* Writer,
+                                 uint32_t             Col)
+/* copies the encoded pages of a column to the file */
+{
+    sbfparquet_ColumnState_t* State = &Writer->State[Col];
+    uint8_t                   Data[16384];
+    int64_t                   Left = State->SpillSize;
+
+    if (fflush(State->Spill) != 0 || fseek(State->Spill, 0, SEEK_SET) != 0)
+    {
+        sbfparquet_SetError(Writer, errno != 0 ? errno : EIO);
+        return;
+    }
+
+    while (Left > 0)
+    {
+        size_t Len = Left < (int64_t)sizeof(Data) ? (size_t)Left : sizeof(Data);
+
+        if (fread(Data, 1, Len, State->Spill) != Len)
+        {
+            sbfparquet_SetError(Writer, errno != 0 ? errno : EIO);
+            break;
+        }
+
+        sbfparquet_Write(Writer, Data, Len);
+        Left -= (int64_t)Len;
+    }
+
+    (void)fseek(State->Spill, 0, SEEK_SET);
+    State->SpillSize = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_EndRowGroup(sbfparquet_Writer_t* Writer)
+{
+    uint32_t Col;
+
+    if (Writer->NrOfRows > 0)
+    {
+        for (Col = 0; Col < Writer->NrOfColumns; Col++)
+        {
+            sbfparquet_WritePage(Writer, Col);
+        }
+
+        Writer->NrOfRows = 0;
+    }
+
+    if (Writer->RowGroupRows == 0)
+    {
+        return;
+    }
+
+    if (Writer->NrOfRowGroups == Writer->RowGroupsSize)
+    {
+        uint32_t            NewSize = Writer->RowGroupsSize * 2 + 16;
+        sbfparquet_Chunk_t* NewChunks = (sbfparquet_Chunk_t*)realloc(Writer->Chunks,
+                                        (size_t)NewSize * Writer->NrOfColumns * sizeof(sbfparquet_Chunk_t));
+        int64_t*            NewSizes;
+
+        if (NewChunks == NULL)
+        {
+            sbfparquet_SetError(Writer, ENOMEM);
+            return;
+        }
+
+        Writer->Chunks = NewChunks;
+        NewSizes = (int64_t*)realloc(Writer->RowGroupSizes, NewSize * sizeof(int64_t));
+
+        if (NewSizes == NULL)
+        {
+            sbfparquet_SetError(Writer, ENOMEM);
+            return;
+        }
+
+        Writer->RowGroupSizes = NewSizes;
+        Writer->RowGroupsSize = NewSize;
+    }
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        const sbfparquet_Column_t* Column = &Writer->Columns[Col];
+        sbfparquet_ColumnState_t*  State = &Writer->State[Col];
+        sbfparquet_Chunk_t*        Chunk = &State->Chunk;
+
+        Chunk->Offset = Writer->Offset;
+
+        if (Column->Type == SBFPARQUET_UINT8 || Column->Type == SBFPARQUET_STRING)
+        {
+            sbfparquet_WriteDictionaryPage(Writer, Col);
+        }
+
+        Chunk->DataPageOffset = Writer->Offset;
+        sbfparquet_CopySpill(Writer, Col);
+        Chunk->Size = Writer->Offset - Chunk->Offset;
+
+        /* the min and max strings, as indices in the dictionary */
+        if (Column->Type == SBFPARQUET_STRING)
+        {
+            uint32_t i;
+
+            for (i = 0; i < Column->DictionarySize; i++)
+            {
+                if (State->Used[i])
+                {
+                    if (!Chunk->HasMinMax || strcmp(Column->Dictionary[i], Column->Dictionary[Chunk->IMin]) < 0)
+                    {
+                        Chunk->IMin = i;
+                    }
+
+                    if (!Chunk->HasMinMax || strcmp(Column->Dictionary[i], Column->Dictionary[Chunk->IMax]) > 0)
+                    {
+                        Chunk->IMax = i;
+                    }
+
+                    Chunk->HasMinMax = true;
+                }
+            }
+
+            memset(State->Used, 0, Column->DictionarySize);
+        }
+
+        Writer->Chunks[(size_t)Writer->NrOfRowGroups * Writer->NrOfColumns + Col] = *Chunk;
+        memset(Chunk, 0, sizeof(*Chunk));
+    }
+
+    Writer->RowGroupSizes[Writer->NrOfRowGroups++] = Writer->RowGroupRows;
+    Writer->RowGroupRows = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_T_Stat(sbfparquet_Thrift_t*       T,
+                              int16_t                    Id,
+                              const sbfparquet_Column_t* Column,
+                              int64_t                    IValue,
+                              double                     DValue)
+/* a min or max statistic, encoded as a PLAIN value */
+{
+    uint8_t Bytes[8];
+    size_t  Len;
+    size_t  i;
+
+    switch (Column->Type)
+    {
+    case SBFPARQUET_STRING:
+        sbfparquet_T_String(T, Id, Column->Dictionary[IValue]);
+        return;
+
+    case SBFPARQUET_FLOAT:
+    {
+        float    FValue = (float)DValue;
+        uint32_t Bits;
+
+        memcpy(&Bits, &FValue, 4);
+        IValue = Bits;
+        Len = 4;
+        break;
+    }
+
+    case SBFPARQUET_DOUBLE:
+        memcpy(&IValue, &DValue, 8);
+        Len = 8;
+        break;
+
+    case SBFPARQUET_UINT8:
+        Len = 4;
+        break;
+
+    default:
+        Len = 8;
+        break;
+    }
+
+    for (i = 0; i < Len; i++)
+    {
+        Bytes[i] = (uint8_t)((uint64_t)IValue >> (8 * i));
+    }
+
+    sbfparquet_T_Binary(T, Id, Bytes, Len);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_WriteFooter(sbfparquet_Writer_t* Writer)
+{
+    static const int32_t PhysicalType[] =
+    {
+        PQ_TYPE_INT64, PQ_TYPE_INT32, PQ_TYPE_FLOAT, PQ_TYPE_DOUBLE, PQ_TYPE_BYTE_ARRAY
+    };
+    sbfparquet_Thrift_t T;
+    int64_t             NrOfRows = 0;
+    uint32_t            RowGroup, Col;
+
+    Writer->Meta.Size = 0;
+    sbfparquet_T_Init(&T, &Writer->Meta);
+
+    for (RowGroup = 0; RowGroup < Writer->NrOfRowGroups; RowGroup++)
+    {
+        NrOfRows += Writer->RowGroupSizes[RowGroup];
+    }
+
+    sbfparquet_T_I32(&T, 1, 2);                              /* version */
+
+    /* schema: the root and the columns */
+    sbfparquet_T_BeginList(&T, 2, TC_STRUCT, Writer->NrOfColumns + 1);
+    sbfparquet_T_BeginElement(&T);
+    sbfparquet_T_String(&T, 4, "schema");
+    sbfparquet_T_I32(&T, 5, (int32_t)Writer->NrOfColumns);
+    sbfparquet_T_EndStruct(&T);
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        const sbfparquet_Column_t* Column = &Writer->Columns[Col];
+
+        sbfparquet_T_BeginElement(&T);
+        sbfparquet_T_I32(&T, 1, PhysicalType[Column->Type]);
+        sbfparquet_T_I32(&T, 3, Column->Optional ? 1 : 0);  /* repetition */
+        sbfparquet_T_String(&T, 4, Column->Name);
+
+        if (Column->Type == SBFPARQUET_UINT8)
+        {
+            sbfparquet_T_I32(&T, 6, PQ_CONVERTED_UINT_8);
+            sbfparquet_T_BeginStruct(&T, 10);                /* LogicalType */
+            sbfparquet_T_BeginStruct(&T, 10);                /* INTEGER */
+            sbfparquet_T_Field(&T, TC_BYTE, 1);
+            sbfparquet_PutByte(T.B, 8);                      /* bitWidth */
+            sbfparquet_T_Field(&T, TC_FALSE, 2);             /* isSigned */
+            sbfparquet_T_EndStruct(&T);
+            sbfparquet_T_EndStruct(&T);
+        }
+        else if (Column->Type == SBFPARQUET_STRING)
+        {
+            sbfparquet_T_I32(&T, 6, PQ_CONVERTED_UTF8);
+            sbfparquet_T_BeginStruct(&T, 10);                /* LogicalType */
+            sbfparquet_T_BeginStruct(&T, 1);                 /* STRING */
+            sbfparquet_T_EndStruct(&T);
+            sbfparquet_T_EndStruct(&T);
+        }
+
+        sbfparquet_T_EndStruct(&T);
+    }
+
+    sbfparquet_T_I64(&T, 3, NrOfRows);
+
+    sbfparquet_T_BeginList(&T, 4, TC_STRUCT, Writer->NrOfRowGroups);
+
+    for (RowGroup = 0; RowGroup < Writer->NrOfRowGroups; RowGroup++)
+    {
+        const sbfparquet_Chunk_t* Chunks = &Writer->Chunks[(size_t)RowGroup * Writer->NrOfColumns];
+        int64_t                   Size = 0;
+
+        sbfparquet_T_BeginElement(&T);
+        sbfparquet_T_BeginList(&T, 1, TC_STRUCT, Writer->NrOfColumns);
+
+        for (Col = 0; Col < Writer->NrOfColumns; Col++)
+        {
+            const sbfparquet_Column_t* Column = &Writer->Columns[Col];
+            const sbfparquet_Chunk_t*  Chunk = &Chunks[Col];
+            bool                       Dictionary = (Column->Type == SBFPARQUET_UINT8 ||
+                                                     Column->Type == SBFPARQUET_STRING);
+
+            Size += Chunk->Size;
+
+            sbfparquet_T_BeginElement(&T);                   /* ColumnChunk */
+            sbfparquet_T_I64(&T, 2, Chunk->Offset);
+            sbfparquet_T_BeginStruct(&T, 3);                 /* ColumnMetaData */
+            sbfparquet_T_I32(&T, 1, PhysicalType[Column->Type]);
+
+            if (Dictionary)
+            {
+                sbfparquet_T_BeginList(&T, 2, TC_I32, 3);
+                sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(PQ_ENCODING_PLAIN));
+                sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(PQ_ENCODING_RLE));
+                sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(PQ_ENCODING_RLE_DICTIONARY));
+            }
+            else
+            {
+                sbfparquet_T_BeginList(&T, 2, TC_I32, 2);
+                sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(Column->Type == SBFPARQUET_INT64 ?
+                                                            PQ_ENCODING_DELTA_BINARY : PQ_ENCODING_PLAIN));
+                sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(PQ_ENCODING_RLE));
+            }
+
+            sbfparquet_T_BeginList(&T, 3, TC_BINARY, 1);     /* path_in_schema */
+            sbfparquet_PutVarint(T.B, strlen(Column->Name));
+            sbfparquet_Put(T.B, Column->Name, strlen(Column->Name));
+
+            sbfparquet_T_I32(&T, 4, 0);                      /* UNCOMPRESSED */
+            sbfparquet_T_I64(&T, 5, Chunk->NrOfValues);
+            sbfparquet_T_I64(&T, 6, Chunk->Size);
+            sbfparquet_T_I64(&T, 7, Chunk->Size);
+            sbfparquet_T_I64(&T, 9, Chunk->DataPageOffset);
+
+            if (Dictionary)
+            {
+                sbfparquet_T_I64(&T, 11, Chunk->Offset);
+            }
+
+            sbfparquet_T_BeginStruct(&T, 12);                /* Statistics */
+            sbfparquet_T_I64(&T, 3, Chunk->NullCount);
+
+            if (Chunk->HasMinMax)
+            {
+                /* zeros are written as -0.0 for the min and +0.0 for
+                   the max */
+                sbfparquet_T_Stat(&T, 5, Column, Chunk->IMax, Chunk->DMax == 0.0 ? 0.0 : Chunk->DMax);
+                sbfparquet_T_Stat(&T, 6, Column, Chunk->IMin, Chunk->DMin == 0.0 ? -0.0 : Chunk->DMin);
+            }
+
+            sbfparquet_T_EndStruct(&T);
+            sbfparquet_T_EndStruct(&T);
+            sbfparquet_T_EndStruct(&T);
+        }
+
+        sbfparquet_T_I64(&T, 2, Size);                       /* total_byte_size */
+        sbfparquet_T_I64(&T, 3, Writer->RowGroupSizes[RowGroup]);
+        sbfparquet_T_I64(&T, 5, Chunks[0].Offset);           /* file_offset */
+        sbfparquet_T_I64(&T, 6, Size);                       /* total_compressed_size */
+        sbfparquet_T_Field(&T, TC_I16, 7);                   /* ordinal */
+        sbfparquet_PutVarint(T.B, sbfparquet_ZigZag(RowGroup));
+        sbfparquet_T_EndStruct(&T);
+    }
+
+    sbfparquet_T_String(&T, 6, "sbf2asc");                   /* created_by */
+
+    /* column_orders: the min and max follow the order of the types */
+    sbfparquet_T_BeginList(&T, 7, TC_STRUCT, Writer->NrOfColumns);
+
+    for (Col = 0; Col < Writer->NrOfColumns; Col++)
+    {
+        sbfparquet_T_BeginElement(&T);
+        sbfparquet_T_BeginStruct(&T, 1);                     /* TYPE_ORDER */
+        sbfparquet_T_EndStruct(&T);
+        sbfparquet_T_EndStruct(&T);
+    }
+
+    sbfparquet_T_EndStruct(&T);
+
+    if (Writer->Meta.Error)
+    {
+        sbfparquet_SetError(Writer, ENOMEM);
+        return;
+    }
+
+    sbfparquet_Write(Writer, Writer->Meta.Data, Writer->Meta.Size);
+    Writer->Page.Size = 0;
+    sbfparquet_PutLE(&Writer->Page, Writer->Meta.Size, 4);
+    sbfparquet_Put(&Writer->Page, Magic, sizeof(Magic));
+    sbfparquet_Write(Writer, Writer->Page.Data, Writer->Page.Size);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_Free(sbfparquet_Writer_t* Writer)
+{
+    uint32_t Col;
+
+    for (Col = 0; Col < SBFPARQUET_MAX_COLUMNS; Col++)
+    {
+        sbfparquet_ColumnState_t* State = &Writer->State[Col];
+
+        free(State->Values);
+        free(State->Defined);
+        free(State->Used);
+
+        if (State->Spill != NULL)
+        {
+            (void)fclose(State->Spill);
+        }
+
+        memset(State, 0, sizeof(*State));
+    }
+
+    free(Writer->Page.Data);
+    free(Writer->Meta.Data);
+    free(Writer->Chunks);
+    free(Writer->RowGroupSizes);
+    memset(&Writer->Page, 0, sizeof(Writer->Page));
+    memset(&Writer->Meta, 0, sizeof(Writer->Meta));
+    Writer->Chunks        = NULL;
+    Writer->RowGroupSizes = NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfparquet_Open(sbfparquet_Writer_t*       Writer,
+                     FILE*                      F,
+                     const sbfparquet_Column_t* Columns,
+                     uint32_t                   NrOfColumns,
+                     uint32_t                   RowsPerPage)
+{
+    uint32_t Col;
+
+    memset(Writer, 0, sizeof(*Writer));
+
+    if (NrOfColumns == 0 || NrOfColumns > SBFPARQUET_MAX_COLUMNS)
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    Writer->Columns     = Columns;
+    Writer->NrOfColumns = NrOfColumns;
+    Writer->RowsPerPage = RowsPerPage != 0 ? RowsPerPage : SBFPARQUET_ROWS_PER_PAGE;
+
+    for (Col = 0; Col < NrOfColumns; Col++)
+    {
+        sbfparquet_ColumnState_t* State = &Writer->State[Col];
+
+        State->Values  = (uint8_t*)calloc(Writer->RowsPerPage, sbfparquet_ValueSize(Columns[Col].Type));
+        State->Defined = (uint8_t*)calloc(Writer->RowsPerPage, 1);
+        State->Used    = (uint8_t*)calloc(Columns[Col].DictionarySize + 1, 1);
+
+        if (State->Values == NULL || State->Defined == NULL || State->Used == NULL)
+        {
+            sbfparquet_Free(Writer);
+            errno = ENOMEM;
+            return false;
+        }
+
+        State->Spill = tmpfile();
+
+        if (State->Spill == NULL)
+        {
+            int Error = errno;
+
+            sbfparquet_Free(Writer);
+            errno = Error;
+            return false;
+        }
+    }
+
+    if (!sbfout_Open(&Writer->Out, F))
+    {
+        sbfparquet_Free(Writer);
+        errno = ENOMEM;
+        return false;
+    }
+
+    sbfparquet_Write(Writer, Magic, sizeof(Magic));
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfparquet_SetValue(sbfparquet_Writer_t* Writer,
+                                uint32_t             Col,
+                                const void*          Value,
+                                size_t               Size)
+{
+    sbfparquet_ColumnState_t* State = &Writer->State[Col];
+    uint32_t                  Row = Writer->NrOfRows;
+
+    memcpy(State->Values + Row * Size, Value, Size);
+    State->Defined[Row] = 1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_SetInt64(sbfparquet_Writer_t* Writer, uint32_t Col, int64_t Value)
+{
+    sbfparquet_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_SetUInt8(sbfparquet_Writer_t* Writer, uint32_t Col, uint8_t Value)
+{
+    sbfparquet_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_SetFloat(sbfparquet_Writer_t* Writer, uint32_t Col, float Value)
+{
+    sbfparquet_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_SetDouble(sbfparquet_Writer_t* Writer, uint32_t Col, double Value)
+{
+    sbfparquet_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_SetIndex(sbfparquet_Writer_t* Writer, uint32_t Col, uint32_t Index)
+{
+    uint16_t Value = (uint16_t)Index;
+
+    sbfparquet_SetValue(Writer, Col, &Value, sizeof(Value));
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfparquet_EndRow(sbfparquet_Writer_t* Writer)
+{
+    Writer->NrOfRows++;
+    Writer->RowGroupRows++;
+
+    if (Writer->NrOfRows == Writer->RowsPerPage)
+    {
+        uint32_t Col;
+
+        for (Col = 0; Col < Writer->NrOfColumns; Col++)
+        {
+            sbfparquet_WritePage(Writer, Col);
+        }
+
+        Writer->NrOfRows = 0;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfparquet_Close(sbfparquet_Writer_t* Writer)
+{
+    int Error;
+
+    sbfparquet_EndRowGroup(Writer);
+    sbfparquet_WriteFooter(Writer);
+
+    Error = Writer->Error;
+    sbfparquet_Free(Writer);
+
+    if (sbfout_Close(&Writer->Out) != 0)
+    {
+        return -1;
+    }
+
+    if (Error != 0)
+    {
+        errno = Error;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * sbfparquet.h: Declaration of a self-contained writer of Apache
+ *               Parquet files, used to archive the decoded SBF data.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFPARQUET_H
+#define SBFPARQUET_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* maximum number of columns of a Parquet file */
+#define SBFPARQUET_MAX_COLUMNS  32
+
+/* default number of rows per data page */
+#define SBFPARQUET_ROWS_PER_PAGE  65536
+
+typedef enum
+{
+    SBFPARQUET_INT64,     /* DELTA_BINARY_PACKED */
+    SBFPARQUET_UINT8,     /* dictionary of the values 0 to
+                             DictionarySize-1, RLE-encoded indices */
+    SBFPARQUET_FLOAT,     /* PLAIN */
+    SBFPARQUET_DOUBLE,    /* PLAIN */
+    SBFPARQUET_STRING     /* dictionary of the strings in Dictionary,
+                             RLE-encoded indices */
+} sbfparquet_Type_t;
+
+typedef struct
+{
+    const char*         Name;
+    sbfparquet_Type_t   Type;
+    bool                Optional;        /* the column can hold nulls */
+    const char* const*  Dictionary;      /* SBFPARQUET_STRING only */
+    uint32_t            DictionarySize;  /* SBFPARQUET_UINT8 and
+                                            SBFPARQUET_STRING */
+} sbfparquet_Column_t;
+
+/* metadata of a column chunk, kept for the footer */
+typedef struct
+{
+    int64_t             Offset;          /* of the first page */
+    int64_t             DataPageOffset;
+    int64_t             Size;            /* of all the pages */
+    int64_t             NrOfValues;
+    int64_t             NullCount;
+    bool                HasMinMax;
+    int64_t             IMin, IMax;      /* integer columns, and
+                                            dictionary indices */
+    double              DMin, DMax;      /* floating-point columns */
+} sbfparquet_Chunk_t;
+
+/* state of a column while a row group is written */
+typedef struct
+{
+    uint8_t*            Values;          /* the values of a page */
+    uint8_t*            Defined;         /* 1 for each non-null value */
+    FILE*               Spill;           /* encoded pages of the row group */
+    int64_t             SpillSize;
+    sbfparquet_Chunk_t  Chunk;
+    uint8_t*            Used;            /* dictionary entries used */
+} sbfparquet_ColumnState_t;
+
+/* a growing byte buffer */
+typedef struct
+{
+    uint8_t*            Data;
+    size_t              Size;
+    size_t              Cap;
+    bool                Error;           /* out of memory */
+} sbfparquet_Buffer_t;
+
+typedef struct
+{
+    sbfout_Stream_t           Out;
+    int64_t                   Offset;         /* bytes written so far */
+    const sbfparquet_Column_t* Columns;
+    uint32_t                  NrOfColumns;
+    uint32_t                  RowsPerPage;
+    uint32_t                  NrOfRows;       /* rows in the current page */
+    int64_t                   RowGroupRows;   /* rows in the current row group */
+    sbfparquet_ColumnState_t  State[SBFPARQUET_MAX_COLUMNS];
+    sbfparquet_Buffer_t       Page;           /* page being encoded */
+    sbfparquet_Buffer_t       Meta;           /* Thrift-encoded metadata */
+    sbfparquet_Chunk_t*       Chunks;         /* NrOfColumns per row group */
+    int64_t*                  RowGroupSizes;  /* rows of each row group */
+    uint32_t                  NrOfRowGroups;
+    uint32_t                  RowGroupsSize;  /* allocated row groups */
+    int                       Error;          /* errno of the first error */
+} sbfparquet_Writer_t;
+
+/* Start a Parquet file with the given columns on F, which must be open
+   for writing in binary mode.  The Columns array, and the
+   dictionaries, must stay valid until sbfparquet_Close().  The rows
+   are encoded by pages of RowsPerPage rows (0 selects
+   SBFPARQUET_ROWS_PER_PAGE), which are kept in temporary files until
+   the row group is complete, so that the memory used does not depend
+   on the size of the row groups.  Returns false, with errno set, if
+   the buffers or the temporary files cannot be created. */
+bool sbfparquet_Open(sbfparquet_Writer_t*       Writer,
+                     FILE*                      F,
+                     const sbfparquet_Column_t* Columns,
+                     uint32_t                   NrOfColumns,
+                     uint32_t                   RowsPerPage);
+
+/* Set the value of column Col in the current row.  Optional columns
+   that are not set are null, other columns are 0. */
+void sbfparquet_SetInt64(sbfparquet_Writer_t* Writer, uint32_t Col, int64_t Value);
+void sbfparquet_SetUInt8(sbfparquet_Writer_t* Writer, uint32_t Col, uint8_t Value);
+void sbfparquet_SetFloat(sbfparquet_Writer_t* Writer, uint32_t Col, float Value);
+void sbfparquet_SetDouble(sbfparquet_Writer_t* Writer, uint32_t Col, double Value);
+
+/* Set a SBFPARQUET_STRING column to entry Index of its dictionary. */
+void sbfparquet_SetIndex(sbfparquet_Writer_t* Writer, uint32_t Col, uint32_t Index);
+
+/* Terminate the current row. */
+void sbfparquet_EndRow(sbfparquet_Writer_t* Writer);
+
+/* Write the current row group, if it has any rows.  The next rows go
+   to a new row group. */
+void sbfparquet_EndRowGroup(sbfparquet_Writer_t* Writer);
+
+/* Write the last row group and the footer, and free the buffers.  The
+   file itself is not closed.  Returns 0 on success, or -1 if anything
+   could not be written (errno is set). */
+int32_t sbfparquet_Close(sbfparquet_Writer_t* Writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,407 @@
+/*
+ * sbfplot.c: Downsampled series of an observable, for plotting.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "sbfplot.h"
+#include "sbfsvid.h"
+#include "sbftime.h"
+
+/* largest number of points of a series */
+#define SBFPLOT_MAX_POINTS  1000000
+
+/* initial number of buckets of a series */
+#define SBFPLOT_MIN_CAPACITY  64
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfplot_Parse(sbfplot_t*  Plot,
+                   const char* Text)
+{
+    const char*   p = Text;
+    char*         End;
+    unsigned long Points;
+
+    Plot->Method = SBFPLOT_LTTB;
+
+    if (strncmp(p, "lttb:", 5) == 0)
+    {
+        p += 5;
+    }
+    else if (strncmp(p, "minmax:", 7) == 0)
+    {
+        Plot->Method = SBFPLOT_MINMAX;
+        p += 7;
+    }
+
+    Points = strtoul(p, &End, 10);
+
+    if (End == p || Points < 4 || Points > SBFPLOT_MAX_POINTS)
+    {
+        return false;
+    }
+
+    Plot->Points = (uint32_t)Points;
+    p = End;
+
+    if (*p == '\0')
+    {
+        p = "cn0";
+    }
+    else if (*p++ != ':')
+    {
+        return false;
+    }
+
+    /* a single field, one row per signal */
+    return (sbfmeasspec_Parse(&Plot->Spec, p) &&
+            !Plot->Spec.Wide && Plot->Spec.NrOfFields == 1);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfplot_Init(sbfplot_t*       Plot,
+                  sbfout_Stream_t* Out)
+{
+    Plot->Out    = Out;
+    Plot->Failed = false;
+    memset(Plot->Series, 0, sizeof(Plot->Series));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfplot_MergeBuckets(sbfplot_Series_t* Series,
+                                 uint32_t          Factor)
+/* merges the buckets of a series Factor by Factor */
+{
+    uint32_t NrOfBuckets = 0;
+    uint32_t i, j;
+
+    for (i = 0; i < Series->NrOfBuckets; i += Factor)
+    {
+        sbfplot_Bucket_t Merged = Series->Buckets[i];
+
+        for (j = i + 1; j < i + Factor && j < Series->NrOfBuckets; j++)
+        {
+            if (Series->Buckets[j].Min.Value < Merged.Min.Value)
+            {
+                Merged.Min = Series->Buckets[j].Min;
+            }
+
+            if (Series->Buckets[j].Max.Value > Merged.Max.Value)
+            {
+                Merged.Max = Series->Buckets[j].Max;
+            }
+        }
+
+        Series->Buckets[NrOfBuckets++] = Merged;
+    }
+
+    Series->NrOfBuckets = NrOfBuckets;
+    Series->BucketSize *= Factor;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfplot_AddSample(sbfplot_t*         Plot,
+                              sbfplot_Series_t** SeriesPtr,
+                              int64_t            Time_ns,
+                              double             Value)
+/* adds a sample to a series, created at its first sample */
+{
+    sbfplot_Series_t* Series = *SeriesPtr;
+    sbfplot_Bucket_t* Bucket;
+
+    if (Series == NULL)
+    {
+        Series = (sbfplot_Series_t*)calloc(1, sizeof(*Series));
+
+        if (Series == NULL)
+        {
+            Plot->Failed = true;
+            return;
+        }
+
+        Series->BucketSize = 1;
+        *SeriesPtr = Series;
+    }
+
+    if (Series->NrOfBuckets > 0 && Series->NrInBucket < Series->BucketSize)
+    {
+        Bucket = &Series->Buckets[Series->NrOfBuckets - 1];
+
+        if (Value < Bucket->Min.Value)
+        {
+            Bucket->Min.Time_ns = Time_ns;
+            Bucket->Min.Value   = Value;
+        }
+
+        if (Value > Bucket->Max.Value)
+        {
+            Bucket->Max.Time_ns = Time_ns;
+            Bucket->Max.Value   = Value;
+        }
+
+        Series->NrInBucket++;
+        return;
+    }
+
+    /* all the buckets are full: they are merged two by two */
+    if (Series->NrOfBuckets == 2 * Plot->Points)
+    {
+        sbfplot_MergeBuckets(Series, 2);
+    }
+
+    if (Series->NrOfBuckets == Series->Capacity)
+    {
+        uint32_t          Capacity = Series->Capacity * 2;
+        sbfplot_Bucket_t* Buckets;
+
+        if (Capacity < SBFPLOT_MIN_CAPACITY)
+        {
+            Capacity = SBFPLOT_MIN_CAPACITY;
+        }
+
+        if (Capacity > 2 * Plot->Points)
+        {
+            Capacity = 2 * Plot->Points;
+        }
+
+        Buckets = (sbfplot_Bucket_t*)realloc(Series->Buckets, Capacity * sizeof(*Buckets));
+
+        if (Buckets == NULL)
+        {
+            Plot->Failed = true;
+            return;
+        }
+
+        Series->Buckets  = Buckets;
+        Series->Capacity = Capacity;
+    }
+
+    Bucket = &Series->Buckets[Series->NrOfBuckets++];
+    Bucket->Min.Time_ns = Time_ns;
+    Bucket->Min.Value   = Value;
+    Bucket->Max         = Bucket->Min;
+    Series->NrInBucket  = 1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfplot_AddEpoch(sbfplot_t*         Plot,
+                      const MeasEpoch_t* MeasEpoch)
+{
+    sbfmeasspec_Field_t Field = (sbfmeasspec_Field_t)Plot->Spec.Fields[0];
+    int64_t             Time_ns;
+    uint32_t            i, SigIdx;
+
+    if (MeasEpoch->TOW_ms == U32_NOTVALID || MeasEpoch->WNc == U16_NOTVALID)
+    {
+        return;
+    }
+
+    Time_ns = sbftime_GetGPSTime_ns(MeasEpoch->WNc, MeasEpoch->TOW_ms);
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        uint8_t                    SVID = convertSVIDtoSBF(ChannelData->PRN);
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+            double                 Value;
+
+            if (MeasSet->flags == 0 || MeasSet->signalType >= 64 ||
+                Plot->Spec.Group[MeasSet->signalType] == 0)
+            {
+                continue;
+            }
+
+            Value = sbfmeasspec_GetField(MeasSet, Field);
+
+            if (Value != F64_NOTVALID && Value != (double)F32_NOTVALID)
+            {
+                sbfplot_AddSample(Plot, &Plot->Series[SVID][MeasSet->signalType], Time_ns, Value);
+            }
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfplot_WritePoint(sbfplot_t*             Plot,
+                               uint32_t               SVID,
+                               uint32_t               SignalType,
+                               const sbfplot_Point_t* Point)
+/* writes a row, as in the long form of sbfmeasspec_PrintEpoch() */
+{
+    char Time[SBFTIME_TEXT_SIZE];
+
+    (void)sbftime_Print(Time, Plot->Spec.TimeFormat, Point->Time_ns, 2);
+    sbfout_Printf(Plot->Out, "%03u %12s %2u", SVID, Time, SignalType);
+    sbfmeasspec_PutField(Plot->Out, (sbfmeasspec_Field_t)Plot->Spec.Fields[0], Point->Value);
+    sbfout_Write(Plot->Out, "\n", 1);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double sbfplot_GetTime(const sbfplot_Point_t* Point,
+                              int64_t                Origin_ns)
+/* time of a point since Origin_ns, in s */
+{
+    return (double)(Point->Time_ns - Origin_ns) * 1e-9;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfplot_WriteLTTB(sbfplot_t*             Plot,
+                              uint32_t               SVID,
+                              uint32_t               SignalType,
+                              const sbfplot_Point_t* Points,
+                              uint32_t               NrOfPoints)
+/* writes the Plot->Points points selected among NrOfPoints (more than
+   Plot->Points) by the Largest-Triangle-Three-Buckets algorithm: the
+   first and last points, and in each of the Plot->Points-2 buckets of
+   the points in between, the point of the largest triangle with the
+   previous selected point and the mean of the next bucket */
+{
+    uint64_t NrOfBuckets = Plot->Points - 2;
+    uint64_t Span = NrOfPoints - 2;
+    uint32_t Selected = 0;
+    uint32_t Bucket, j;
+
+    /* the times are relative to the first point, in s */
+    int64_t  Origin_ns = Points[0].Time_ns;
+
+    sbfplot_WritePoint(Plot, SVID, SignalType, &Points[0]);
+
+    for (Bucket = 0; Bucket < NrOfBuckets; Bucket++)
+    {
+        uint32_t Start    = (uint32_t)(1 + Bucket * Span / NrOfBuckets);
+        uint32_t End      = (uint32_t)(1 + (Bucket + 1) * Span / NrOfBuckets);
+        uint32_t NextEnd  = (uint32_t)(1 + (Bucket + 2) * Span / NrOfBuckets);
+        double   MeanTime = 0.0;
+        double   MeanValue = 0.0;
+        double   Time = sbfplot_GetTime(&Points[Selected], Origin_ns);
+        double   Value = Points[Selected].Value;
+        double   MaxArea = -1.0;
+        uint32_t Next = Start;
+
+        /* the next bucket of the last one is the last point */
+        if (Bucket + 1 == NrOfBuckets)
+        {
+            NextEnd = NrOfPoints;
+        }
+
+        for (j = End; j < NextEnd; j++)
+        {
+            MeanTime  += sbfplot_GetTime(&Points[j], Origin_ns);
+            MeanValue += Points[j].Value;
+        }
+
+        MeanTime  /= (double)(NextEnd - End);
+        MeanValue /= (double)(NextEnd - End);
+
+        for (j = Start; j < End; j++)
+        {
+            double Area = fabs((Time - MeanTime) * (Points[j].Value - Value)
+                               - (Time - sbfplot_GetTime(&Points[j], Origin_ns)) * (MeanValue - Value));
+
+            if (Area > MaxArea)
+            {
+                MaxArea = Area;
+                Next    = j;
+            }
+        }
+
+        Selected = Next;
+        sbfplot_WritePoint(Plot, SVID, SignalType, &Points[Selected]);
+    }
+
+    sbfplot_WritePoint(Plot, SVID, SignalType, &Points[NrOfPoints - 1]);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfplot_Close(sbfplot_t* Plot)
+{
+    /* the smallest and largest values of at most 2*Points buckets */
+    sbfplot_Point_t* Points = (sbfplot_Point_t*)malloc(4 * (size_t)Plot->Points * sizeof(*Points));
+    uint32_t         SVID, SignalType, i;
+
+    if (Points == NULL)
+    {
+        Plot->Failed = true;
+    }
+
+    for (SVID = 0; SVID < 256; SVID++)
+    {
+        for (SignalType = 0; SignalType < 64; SignalType++)
+        {
+            sbfplot_Series_t* Series = Plot->Series[SVID][SignalType];
+            uint32_t          NrOfPoints = 0;
+
+            if (Series == NULL)
+            {
+                continue;
+            }
+
+            if (Plot->Method == SBFPLOT_MINMAX && Series->NrOfBuckets > Plot->Points / 2)
+            {
+                sbfplot_MergeBuckets(Series, (Series->NrOfBuckets + Plot->Points / 2 - 1) / (Plot->Points / 2));
+            }
+
+            /* the smallest and largest values of each bucket, in time
+               order */
+            for (i = 0; Points != NULL && i < Series->NrOfBuckets; i++)
+            {
+                const sbfplot_Bucket_t* Bucket = &Series->Buckets[i];
+                bool                    MinFirst = (Bucket->Min.Time_ns <= Bucket->Max.Time_ns);
+
+                Points[NrOfPoints++] = MinFirst ? Bucket->Min : Bucket->Max;
+
+                if (Bucket->Min.Time_ns != Bucket->Max.Time_ns)
+                {
+                    Points[NrOfPoints++] = MinFirst ? Bucket->Max : Bucket->Min;
+                }
+            }
+
+            if (Plot->Method == SBFPLOT_LTTB && NrOfPoints > Plot->Points)
+            {
+                sbfplot_WriteLTTB(Plot, SVID, SignalType, Points, NrOfPoints);
+            }
+            else
+            {
+                for (i = 0; i < NrOfPoints; i++)
+                {
+                    sbfplot_WritePoint(Plot, SVID, SignalType, &Points[i]);
+                }
+            }
+
+            free(Series->Buckets);
+            free(Series);
+            Plot->Series[SVID][SignalType] = NULL;
+        }
+    }
+
+    free(Points);
+
+    return Plot->Failed ? ENOMEM : 0;
+}
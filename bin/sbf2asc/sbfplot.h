@@ -0,0 +1,116 @@
+/*
+ * sbfplot.h: Declaration of the downsampled series of an observable,
+ *            for plotting.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFPLOT_H
+#define SBFPLOT_H 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "measepoch.h"
+#include "sbfmeasspec.h"
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* downsampling methods */
+typedef enum
+{
+    SBFPLOT_LTTB,       /* Largest-Triangle-Three-Buckets */
+    SBFPLOT_MINMAX      /* smallest and largest value of each bucket */
+} sbfplot_Method_t;
+
+typedef struct
+{
+    int64_t           Time_ns;     /* GPS ns since Jan 06, 1980 */
+    double            Value;
+} sbfplot_Point_t;
+
+/* the smallest and largest values of consecutive samples */
+typedef struct
+{
+    sbfplot_Point_t   Min;
+    sbfplot_Point_t   Max;
+} sbfplot_Bucket_t;
+
+/* the samples of a signal of a satellite, in at most 2*Points buckets
+   of BucketSize samples */
+typedef struct
+{
+    uint32_t          NrOfBuckets;
+    uint32_t          Capacity;
+    uint32_t          BucketSize;  /* a power of 2 */
+    uint32_t          NrInBucket;  /* samples in the last bucket */
+    sbfplot_Bucket_t* Buckets;
+} sbfplot_Series_t;
+
+typedef struct
+{
+    sbfout_Stream_t*  Out;
+    sbfmeasspec_t     Spec;        /* observable and signals, see
+                                      sbfplot_Parse() */
+    sbfplot_Method_t  Method;
+    uint32_t          Points;      /* per series */
+    bool              Failed;      /* memory allocation failed */
+    sbfplot_Series_t* Series[256][64];  /* by SBF SVID and signal type,
+                                           NULL until the first sample */
+} sbfplot_t;
+
+/* Parse the downsampling of the series, in the form
+
+     [lttb:|minmax:]POINTS[:FIELD[/SIGNALS]]
+
+   POINTS is the number of points of each series (at least 4), FIELD
+   one of the fields and SIGNALS the signals of sbfmeasspec_Parse() (in
+   the long form).  The default FIELD is cn0, for all the signals.
+   Returns false if Text is not valid. */
+bool sbfplot_Parse(sbfplot_t*  Plot,
+                   const char* Text);
+
+/* Start collecting the series of the Plot parsed by sbfplot_Parse(),
+   written to Out by sbfplot_Close().  The time column of the rows is in
+   the TimeFormat of the Spec of Plot. */
+void sbfplot_Init(sbfplot_t*       Plot,
+                  sbfout_Stream_t* Out);
+
+/* Add the valid values of the selected field and signals of the main
+   antenna of an epoch.  The memory of each series is bounded: the
+   smallest and largest values of consecutive samples are kept in
+   buckets, whose size doubles when 2*Points buckets are full, so that
+   the spikes are never dropped whatever the length of the file. */
+void sbfplot_AddEpoch(sbfplot_t*         Plot,
+                      const MeasEpoch_t* MeasEpoch);
+
+/* Downsample each series to Points points, write them, and free the
+   series.  With SBFPLOT_LTTB, the points are selected among the
+   smallest and largest values of the buckets with the
+   Largest-Triangle-Three-Buckets algorithm; with SBFPLOT_MINMAX, the
+   buckets are merged into Points/2 buckets, whose smallest and largest
+   values are written in time order.  The rows of each series are
+   together, in the order of the SBF SVID and of the signal type, with
+   the SVID, the time, the signal type and the value as in the long
+   form of sbfmeasspec_PrintEpoch().  Returns 0 on success, or ENOMEM
+   if the memory of a series could not be allocated. */
+int sbfplot_Close(sbfplot_t* Plot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
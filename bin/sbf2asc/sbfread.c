@@ -33,7 +33,6 @@
 
 /* SBF sync bytes */
 static const char SYNC_STRING[3] = "$@";
-static int intCRCErrors = 0;
 
 /*---------------------------------------------------------------------------*/
 bool IsTimeValid(void* SBFBlock)
@@ -160,6 +159,62 @@ void AlignSubBlockSize(void*  SBFBlock,
 
 }
 
+/*---------------------------------------------------------------------------*/
+void sbfread_SubBlockView_Init(sbfread_SubBlockView_t* View,
+                               const void*  SBFBlock,
+                               const void*  FirstSubBlock,
+                               uint32_t     N,
+                               uint32_t     SBSize,
+                               size_t       StructSize)
+
+/* Prepare a view on the N sub-blocks of SBFBlock, starting at
+ * FirstSubBlock and SBSize bytes apart, to read them as structures
+ * of StructSize bytes with sbfread_SubBlockView_Get().  This is the
+ * in-place alternative to AlignSubBlockSize().  N is reduced to the
+ * number of sub-blocks that fit in the block length.
+ */
+{
+    size_t Offset = (size_t)((const uint8_t*)FirstSubBlock - (const uint8_t*)SBFBlock);
+    size_t Length = ((const HeaderBlock_t*)SBFBlock)->Length;
+
+    View->Base       = (const uint8_t*)FirstSubBlock;
+    View->SBSize     = SBSize;
+    View->StructSize = (uint32_t)StructSize;
+    View->N          = 0;
+
+    if (SBSize != 0 && Length > Offset)
+    {
+        size_t MaxN = (Length - Offset) / SBSize;
+
+        View->N = (N < MaxN) ? N : (uint32_t)MaxN;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+const void* sbfread_SubBlockView_Get(const sbfread_SubBlockView_t* View,
+                                     uint32_t Idx,
+                                     void*    Scratch)
+
+/* Returns sub-block Idx (smaller than View->N) of the view.  If the
+ * sub-blocks in the SBF block are at least as large as the structure,
+ * the returned pointer points into the SBF block itself.  Otherwise
+ * the sub-block is copied into Scratch, which must be StructSize
+ * bytes large, with the fields it does not contain set to 0.
+ */
+{
+    const uint8_t* SubBlock = View->Base + (size_t)Idx * View->SBSize;
+
+    if (View->SBSize >= View->StructSize)
+    {
+        return SubBlock;
+    }
+
+    memcpy(Scratch, SubBlock, View->SBSize);
+    memset((uint8_t*)Scratch + View->SBSize, 0, View->StructSize - View->SBSize);
+
+    return Scratch;
+}
+
 /*---------------------------------------------------------------------------*/
 ssnOff_t GetSBFFilePos(SBFData_t* SBFData)
 /* Get the current SBF file pointer position in bytes from the
@@ -172,7 +227,8 @@ ssnOff_t GetSBFFilePos(SBFData_t* SBFData)
 
 /*---------------------------------------------------------------------------*/
 ssnOff_t GetSBFFileLength(SBFData_t* SBFData)
-/* Get the length of the SBF file in bytes.
+/* Get the length of the SBF file in bytes, or -1 if the file
+ * cannot be positioned.
  */
 {
 
@@ -181,14 +237,14 @@ ssnOff_t GetSBFFileLength(SBFData_t* SBFData)
 
     if (ssnfseek(SBFData->F, 0, SEEK_END) != 0)
     {
-        TerminateProgram;
+        return -1;
     }
 
     FileLength = (ssnOff_t)ssnftell(SBFData->F);
 
     if (ssnfseek(SBFData->F, CurrentPos, SEEK_SET) != 0)
     {
-        TerminateProgram;
+        return -1;
     }
 
     return FileLength;
@@ -196,10 +252,10 @@ ssnOff_t GetSBFFileLength(SBFData_t* SBFData)
 }
 
 /*--------------------------------------------------------------------------*/
-int GetCRCErrors()
-/* Returns the number of CRC errors present */
+int GetCRCErrors(const SBFData_t* SBFData)
+/* Returns the number of CRC errors found so far in the SBF stream */
 {
-    return intCRCErrors;
+    return SBFData->CRCErrors;
 }
 
 
@@ -231,6 +287,8 @@ int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer)
  *        argument.
  *   -1   if the tentative block is not a valid SBF block. In
  *        this case the file pointer is not changed, neither SBFBlock.
+ *   -5   if the file pointer could not be restored after an invalid
+ *        block.
  */
 {
     VoidBlock_t* VoidBlock = (VoidBlock_t*)Buffer;
@@ -249,7 +307,7 @@ int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer)
          * -1 */
         if (ssnfseek(SBFData->F, InitialFilePos, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -5;
         }
 
         return -1;
@@ -267,7 +325,7 @@ int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer)
 
         if (ssnfseek(SBFData->F, InitialFilePos, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -5;
         }
 
         return -2;
@@ -283,7 +341,7 @@ int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer)
          * -1 */
         if (ssnfseek(SBFData->F, InitialFilePos, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -5;
         }
 
         return -3;
@@ -293,13 +351,13 @@ int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer)
     if (CRCIsValid(Buffer) == false)
     {
         /* Increase the number of CRC errors */
-        intCRCErrors++;
+        SBFData->CRCErrors++;
 
         /* If CRC not valid, go back to the initial file position and
          * return -1. */
         if (ssnfseek(SBFData->F, InitialFilePos, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -5;
         }
 
         return -4;
@@ -375,6 +433,7 @@ int32_t GetNextBlockWithEscape(SBFData_t* SBFData, void* SBFBlock,
  *    0  if a block having one of the two numbers has been found.
  *       In this case, the SBF block is returned in the SBFBlock argument
  *   -1  if no block could be found.
+ *   -2  if the file could not be positioned.
  */
 {
     bool     BlockFound;
@@ -397,7 +456,7 @@ int32_t GetNextBlockWithEscape(SBFData_t* SBFData, void* SBFBlock,
     if ((FilePos & START_POS_FIELD) == START_POS_SET)
         if (ssnfseek(SBFData->F, 0, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -2;
         }
 
     do
@@ -425,7 +484,10 @@ int32_t GetNextBlockWithEscape(SBFData_t* SBFData, void* SBFBlock,
                 /* Valid block found, remember it. */
                 BlockFound = true;
 
-                /* Copy the block contents to the SBFBlock pointer. */
+                /* Copy the block contents to the SBFBlock pointer,
+                 * after saving the measurement blocks of the current
+                 * epoch still held there. */
+                sbfread_DetachMeasBlocks(SBFData, SBFBlock, (size_t)(Buffer.VoidBlock.Length));
                 memcpy(SBFBlock, Buffer.Data, (size_t)(Buffer.VoidBlock.Length));
 
             }
@@ -442,7 +504,7 @@ int32_t GetNextBlockWithEscape(SBFData_t* SBFData, void* SBFBlock,
     {
         if (ssnfseek(SBFData->F, InitialFilePos, SEEK_SET) != 0)
         {
-            TerminateProgram;
+            return -2;
         }
     }
 
@@ -452,8 +514,8 @@ int32_t GetNextBlockWithEscape(SBFData_t* SBFData, void* SBFBlock,
 
 
 /*---------------------------------------------------------------------------*/
-void InitializeSBFDecoding(char* FileName,
-                           SBFData_t* SBFData)
+int32_t InitializeSBFDecoding(char* FileName,
+                              SBFData_t* SBFData)
 
 /* Initialize the reading of a SBF file, and prepare the SBFData_t
  * structure which is used by most of the functions in this file.
@@ -468,7 +530,10 @@ void InitializeSBFDecoding(char* FileName,
  *              are set to -1.0 if irrelevant (i.e. when no
  *              measurement epoch is found in the file, or only one)
  *
- * Return : none
+ * Return :
+ *    0  on success
+ *   -1  if the file could not be opened (errno is set by fopen), in
+ *       which case SBFData is left untouched.
  */
 
 {
@@ -479,13 +544,13 @@ void InitializeSBFDecoding(char* FileName,
         /* Open the SBF file in read/binary mode. */
         if ((file = fopen(FileName, "rb")) == NULL)
         {
-            TerminateProgram;
+            return -1;
         }
     }
 
     InitializeSBFDecodingWithExistingFile(file, SBFData);
 
-    return;
+    return 0;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -512,8 +577,6 @@ void InitializeSBFDecodingWithExistingFile(FILE* file,
 {
     int ant;
 
-    intCRCErrors = 0;
-
     memset(SBFData, 0, sizeof(SBFData_t));
 
     if (file != NULL)
@@ -523,11 +586,15 @@ void InitializeSBFDecodingWithExistingFile(FILE* file,
 
     // otherwise, SBFData->F remains NULL from memset
 
+    sbfread_ObjPool_Init(&(SBFData->MeasEpochPool), sizeof(MeasEpoch_t), SBFREAD_MEASEPOCHPOOL_CHUNK);
+
     for (ant = 0; ant < NR_OF_ANTENNAS; ant++)
     {
         SBFData->RefEpoch[ant].TOW_ms = U32_NOTVALID;
     }
 
+    sbfread_SetDecodeMask(SBFData, NULL);
+
     SBFData->MeasCollect_CurrentTOW        = U32_NOTVALID;
     SBFData->TOWAtLastMeasEpoch            = U32_NOTVALID;
     SBFData->MeasCollect_PredictEndOfEpoch = true;
@@ -538,16 +605,96 @@ void InitializeSBFDecodingWithExistingFile(FILE* file,
 
 
 /*---------------------------------------------------------------------------*/
-void CloseSBFFile(SBFData_t* SBFData)
+int32_t CloseSBFFile(SBFData_t* SBFData)
+/* Close the SBF file.  Returns 0 on success, -1 if fclose failed
+ * (errno is set by fclose). */
 {
-    /* Close the SBF file. */
+    sbfread_ReleaseMeasDecoding(SBFData);
+
     if (fclose(SBFData->F) != 0)
     {
-        TerminateProgram;
+        return -1;
     }
 
+    return 0;
 }
 
+/* range of GLONASS frequency numbers covered by the wavelength table */
+#define GLOFN_MIN    (-8)
+#define GLOFN_MAX    (12)
+#define NR_OF_GLOFN  (GLOFN_MAX - GLOFN_MIN + 1)
+
+#define GLOL1WAVELENGTH(fn)  (c84 / (L1GLOFREQ + (fn) * 562500))
+#define GLOL2WAVELENGTH(fn)  (c84 / (L2GLOFREQ + (fn) * 437500))
+
+#define WAVELENGTH_ALLFN(w) \
+    { w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w, w }
+
+#define GLOL1_ALLFN \
+    { GLOL1WAVELENGTH(-8), GLOL1WAVELENGTH(-7), GLOL1WAVELENGTH(-6), \
+      GLOL1WAVELENGTH(-5), GLOL1WAVELENGTH(-4), GLOL1WAVELENGTH(-3), \
+      GLOL1WAVELENGTH(-2), GLOL1WAVELENGTH(-1), GLOL1WAVELENGTH(0),  \
+      GLOL1WAVELENGTH(1),  GLOL1WAVELENGTH(2),  GLOL1WAVELENGTH(3),  \
+      GLOL1WAVELENGTH(4),  GLOL1WAVELENGTH(5),  GLOL1WAVELENGTH(6),  \
+      GLOL1WAVELENGTH(7),  GLOL1WAVELENGTH(8),  GLOL1WAVELENGTH(9),  \
+      GLOL1WAVELENGTH(10), GLOL1WAVELENGTH(11), GLOL1WAVELENGTH(12) }
+
+#define GLOL2_ALLFN \
+    { GLOL2WAVELENGTH(-8), GLOL2WAVELENGTH(-7), GLOL2WAVELENGTH(-6), \
+      GLOL2WAVELENGTH(-5), GLOL2WAVELENGTH(-4), GLOL2WAVELENGTH(-3), \
+      GLOL2WAVELENGTH(-2), GLOL2WAVELENGTH(-1), GLOL2WAVELENGTH(0),  \
+      GLOL2WAVELENGTH(1),  GLOL2WAVELENGTH(2),  GLOL2WAVELENGTH(3),  \
+      GLOL2WAVELENGTH(4),  GLOL2WAVELENGTH(5),  GLOL2WAVELENGTH(6),  \
+      GLOL2WAVELENGTH(7),  GLOL2WAVELENGTH(8),  GLOL2WAVELENGTH(9),  \
+      GLOL2WAVELENGTH(10), GLOL2WAVELENGTH(11), GLOL2WAVELENGTH(12) }
+
+/* carrier wavelength in meters, indexed by signal type and by GLONASS
+   frequency number + 8.  Signal types not listed in SignalType_t get
+   the L1 wavelength. */
+static const double Wavelength_m[SIG_LAST][NR_OF_GLOFN] =
+{
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_GPSL1CA */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_GPSL1P  */
+    WAVELENGTH_ALLFN(L2WAVELENGTH),    /* SIG_GPSL2P  */
+    WAVELENGTH_ALLFN(L2WAVELENGTH),    /* SIG_GPSL2C  */
+    WAVELENGTH_ALLFN(L5WAVELENGTH),    /* SIG_GPSL5   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_GPSL1C  */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_QZSL1CA */
+    WAVELENGTH_ALLFN(L2WAVELENGTH),    /* SIG_QZSL2C  */
+    GLOL1_ALLFN,                       /* SIG_GLOL1CA */
+    GLOL1_ALLFN,                       /* SIG_GLOL1P  */
+    GLOL2_ALLFN,                       /* SIG_GLOL2P  */
+    GLOL2_ALLFN,                       /* SIG_GLOL2CA */
+    WAVELENGTH_ALLFN(L3WAVELENGTH),    /* SIG_GLOL3   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_BDSB1C  */
+    WAVELENGTH_ALLFN(L5WAVELENGTH),    /* SIG_BDSB2a  */
+    WAVELENGTH_ALLFN(L5WAVELENGTH),    /* SIG_IRNL5   */
+    WAVELENGTH_ALLFN(E5aWAVELENGTH),   /* SIG_RES16_  */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_GALE1BC */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* reserved    */
+    WAVELENGTH_ALLFN(E6WAVELENGTH),    /* SIG_GALE6BC */
+    WAVELENGTH_ALLFN(E5aWAVELENGTH),   /* SIG_GALE5a  */
+    WAVELENGTH_ALLFN(E5bWAVELENGTH),   /* SIG_GALE5b  */
+    WAVELENGTH_ALLFN(E5WAVELENGTH),    /* SIG_GALE5   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_MSS     */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_SBSL1CA */
+    WAVELENGTH_ALLFN(L5WAVELENGTH),    /* SIG_SBSL5   */
+    WAVELENGTH_ALLFN(L5WAVELENGTH),    /* SIG_QZSL5   */
+    WAVELENGTH_ALLFN(E6WAVELENGTH),    /* SIG_QZSL6   */
+    WAVELENGTH_ALLFN(E2WAVELENGTH),    /* SIG_BDSB1I  */
+    WAVELENGTH_ALLFN(E5bWAVELENGTH),   /* SIG_BDSB2I  */
+    WAVELENGTH_ALLFN(B3WAVELENGTH),    /* SIG_BDSB3   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_UNUSED  */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_QZSL1C  */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_QZSL1S  */
+    WAVELENGTH_ALLFN(E5bWAVELENGTH),   /* SIG_BDSB2b  */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* reserved    */
+    WAVELENGTH_ALLFN(S1WAVELENGTH),    /* SIG_IRNS1   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_IRNL1   */
+    WAVELENGTH_ALLFN(L1WAVELENGTH),    /* SIG_QZSL1CB */
+    WAVELENGTH_ALLFN(L5WAVELENGTH)     /* SIG_QZSL5S  */
+};
+
 /*---------------------------------------------------------------------------*/
 double GetWavelength_m(SignalType_t SignalType, int GLOfn)
 /* returns the carrier wavelength corresponding to a given Type field
@@ -563,86 +710,26 @@ double GetWavelength_m(SignalType_t SignalType, int GLOfn)
 {
     double wavelength;
 
-    switch (SignalType)
+    if ((uint32_t)SignalType >= (uint32_t)SIG_LAST)
     {
-    case SIG_GPSL1CA:
-    case SIG_GPSL1P:
-    case SIG_GPSL1C:
-    case SIG_GALE1BC:
-    case SIG_SBSL1CA:
-    case SIG_QZSL1CA:
-    case SIG_QZSL1CB:
-    case SIG_QZSL1C:
-    case SIG_QZSL1S:
-    case SIG_BDSB1C:
-    case SIG_IRNL1:
         wavelength = L1WAVELENGTH;
-        break;
-
-    case SIG_GPSL2P:
-    case SIG_GPSL2C:
-    case SIG_QZSL2C:
-        wavelength = L2WAVELENGTH;
-        break;
-
-    case SIG_GALE5:
-        wavelength = E5WAVELENGTH;
-        break;
-
-    case SIG_GALE5a:
-    case SIG_RES16_:
-        wavelength = E5aWAVELENGTH;
-        break;
-
-    case SIG_GALE5b:
-    case SIG_BDSB2I:
-    case SIG_BDSB2b:
-        wavelength = E5bWAVELENGTH;
-        break;
-
-    case SIG_GALE6BC:
-    case SIG_QZSL6:
-        wavelength = E6WAVELENGTH;
-        break;
-
-    case SIG_GPSL5:
-    case SIG_SBSL5:
-    case SIG_QZSL5:
-    case SIG_QZSL5S:
-    case SIG_IRNL5:
-    case SIG_BDSB2a:
-        wavelength = L5WAVELENGTH;
-        break;
-
-    case SIG_BDSB1I:
-        wavelength = E2WAVELENGTH;
-        break;
-
-    case SIG_BDSB3:
-        wavelength = B3WAVELENGTH;
-        break;
-
-    case SIG_GLOL1CA:
-    case SIG_GLOL1P:
-        wavelength = c84 / (L1GLOFREQ + GLOfn * 562500);
-        break;
-
-    case SIG_GLOL2CA:
-    case SIG_GLOL2P:
-        wavelength = c84 / (L2GLOFREQ + GLOfn * 437500);
-        break;
-
-    case SIG_GLOL3:
-        wavelength = L3WAVELENGTH;
-        break;
-
-    case SIG_IRNS1:
-        wavelength = S1WAVELENGTH;
-        break;
-
-    default:
-        wavelength = L1WAVELENGTH;
-        break;
+    }
+    else if (GLOfn >= GLOFN_MIN && GLOfn <= GLOFN_MAX)
+    {
+        wavelength = Wavelength_m[SignalType][GLOfn - GLOFN_MIN];
+    }
+    else if (SignalType == SIG_GLOL1CA || SignalType == SIG_GLOL1P)
+    {
+        wavelength = GLOL1WAVELENGTH(GLOfn);
+    }
+    else if (SignalType == SIG_GLOL2CA || SignalType == SIG_GLOL2P)
+    {
+        wavelength = GLOL2WAVELENGTH(GLOfn);
+    }
+    else
+    {
+        /* GLOfn is irrelevant for the other signals */
+        wavelength = Wavelength_m[SignalType][-GLOFN_MIN];
     }
 
     return (wavelength);
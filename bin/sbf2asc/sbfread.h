@@ -28,6 +28,7 @@
 #include "sbfdef.h"
 #include "sbfsigtypes.h"
 #include "sbfsvid.h"
+#include "sbfread_alloc.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -108,9 +109,12 @@ extern "C" {
 
 
 /* structure to keep the data from the last reference epoch when
-   decoding Meas3 blocks. */
+   decoding Meas3 blocks.  The per-satellite data is only cleared when
+   a satellite is first met after the reference epoch, as flagged in
+   SatCleared. */
 typedef struct
 {
+    uint64_t          SatCleared[MEAS3_SYS_MAX];
     uint8_t           SigIdx[MEAS3_SYS_MAX][MEAS3_SAT_MAX][MEAS3_SIG_MAX];
     MeasSet_t         MeasSet[MEAS3_SYS_MAX][MEAS3_SAT_MAX][MEAS3_SIG_MAX];
     uint32_t          SlaveSigMask[MEAS3_SYS_MAX][MEAS3_SAT_MAX];
@@ -121,6 +125,63 @@ typedef struct
 } sbfread_Meas3_RefEpoch_t;
 
 
+/* signal tables used when decoding Meas3 blocks: for each
+   constellation, the signal type of each Meas3 signal index, for the
+   SigExcluded value that was last found in the blocks. */
+typedef struct
+{
+    SignalType_t      SigIdx2SignalType[MEAS3_SYS_MAX][MEAS3_SIG_MAX];
+    uint8_t           SigExcluded[MEAS3_SYS_MAX];
+    bool              Valid[MEAS3_SYS_MAX];  /* false until the table of a constellation has been built */
+} sbfread_Meas3_SigTable_t;
+
+
+/* index used while building a MeasEpoch_t to find back the element
+   of channelData[] associated with an 8-bit key (the PRN when
+   decoding Meas3 blocks, the logical channel number when decoding
+   MeasEpoch and MeasExtra blocks) without scanning channelData[].
+   Only the entries listed in Touched[] are non-zero, so that the
+   index can be cleared at the start of each epoch without going
+   through the whole table. */
+typedef struct
+{
+    uint16_t          Pos[256];      /* 1 + position in channelData[], or 0 if not present */
+    uint8_t           Touched[256];  /* keys for which Pos[] has been set */
+    uint32_t          NrTouched;
+} sbfread_ChannelIndex_t;
+
+
+/* selection of the measurements decoded by
+   sbfread_MeasCollectAndDecode(), see sbfread_SetDecodeMask().  The
+   parts of the measurement blocks that are not selected are skipped
+   instead of being decoded. */
+#define SBFREAD_FIELD_DOPPLER     0x01  /* Doppler (Meas3Doppler, MeasEpoch) */
+#define SBFREAD_FIELD_CN0HIRES    0x02  /* C/N0 fractional part (Meas3CN0HiRes, MeasExtra) */
+#define SBFREAD_FIELD_PPINFO      0x04  /* lock count, raw C/N0, APME flag (Meas3PP, MeasExtra) */
+#define SBFREAD_FIELD_MPINFO      0x08  /* multipath, variances, lock time (Meas3MP, MeasExtra) */
+#define SBFREAD_FIELD_FULLRANGE   0x10  /* full-range code and phase (MeasFullRange) */
+#define SBFREAD_FIELD_ALL         0x1f
+
+typedef struct
+{
+    uint32_t          Constellations;  /* bit (1<<MEAS3_SYS_xxx) set for each constellation to decode */
+    uint64_t          SignalTypes;     /* bit (1<<SIG_xxx) set for each signal type to decode */
+    uint32_t          Antennas;        /* bit (1<<AntIdx) set for each antenna to decode */
+    uint32_t          Fields;          /* combination of SBFREAD_FIELD_xxx */
+} sbfread_DecodeMask_t;
+
+/* number of occurrences of the different types of Meas3 sub-blocks */
+typedef struct
+{
+    uint32_t          MasterLong;
+    uint32_t          MasterShort;
+    uint32_t          MasterDelta;
+    uint32_t          SlaveLong;
+    uint32_t          SlaveShort;
+    uint32_t          SlaveDelta;
+} sbfread_Meas3Counters_t;
+
+
 typedef struct
 {
     uint64_t  type;           /* decryption type */
@@ -145,22 +206,58 @@ typedef struct
 #define MEASCOLLECT_SEEN_MEASFULLRANGE       (1<<7)
 #define MEASCOLLECT_NR_OF_MEASBLOCKS         8
 
+/* size in bytes of the heap buffer in which the measurement blocks of
+   one epoch are saved when the buffer holding them is about to be
+   overwritten (see sbfread_DetachMeasBlocks()).  Blocks that do not
+   fit are dropped and counted in SBFData_t::MeasArena_Overflows. */
+#ifndef SBFREAD_MEASARENA_SIZE
+#define SBFREAD_MEASARENA_SIZE               65536
+#endif
+
+/* number of MeasEpoch_t objects allocated at once by
+   sbfread_AllocMeasEpoch() when its pool is empty */
+#ifndef SBFREAD_MEASEPOCHPOOL_CHUNK
+#define SBFREAD_MEASEPOCHPOOL_CHUNK          4
+#endif
+
 typedef struct
 {
     FILE*               F;       /* handle to the file */
     SBFDecrypt_t        decrypt; /* SBF decryption context */
+    int                 CRCErrors; /* number of blocks with a CRC error */
 
     /* the following fields are used to collect and decode the measurement
        blocks */
     sbfread_Meas3_RefEpoch_t RefEpoch[NR_OF_ANTENNAS];
-    Meas3Ranges_1_t     Meas3Ranges[NR_OF_ANTENNAS];
-    Meas3Doppler_1_t    Meas3Doppler[NR_OF_ANTENNAS];
-    Meas3CN0HiRes_1_t   Meas3CN0HiRes[NR_OF_ANTENNAS];
-    Meas3PP_1_t         Meas3PP[NR_OF_ANTENNAS];
-    Meas3MP_1_t         Meas3MP[NR_OF_ANTENNAS];
-    MeasEpoch_2_t       MeasEpoch;
-    MeasExtra_1_t       MeasExtra;
-    MeasFullRange_1_t   MeasFullRange;
+
+    /* the measurement blocks collected for the current epoch, or NULL
+       if not received.  They point into the buffers given to
+       sbfread_MeasCollectAndDecode(), or into MeasArena once such a
+       buffer has to be reused before the end of the epoch. */
+    Meas3Ranges_1_t*    Meas3Ranges[NR_OF_ANTENNAS];
+    Meas3Doppler_1_t*   Meas3Doppler[NR_OF_ANTENNAS];
+    Meas3CN0HiRes_1_t*  Meas3CN0HiRes[NR_OF_ANTENNAS];
+    Meas3PP_1_t*        Meas3PP[NR_OF_ANTENNAS];
+    Meas3MP_1_t*        Meas3MP[NR_OF_ANTENNAS];
+    MeasEpoch_2_t*      MeasEpoch;
+    MeasExtra_1_t*      MeasExtra;
+    MeasFullRange_1_t*  MeasFullRange;
+    sbfread_Arena_t     MeasArena; /* allocated at the first use */
+    uint32_t            MeasArena_Overflows;
+
+    /* decoded epochs handed out by sbfread_AllocMeasEpoch() */
+    sbfread_ObjPool_t   MeasEpochPool;
+    uint32_t            Mallocs; /* other heap allocations */
+
+    sbfread_Meas3_SigTable_t Meas3SigTable;
+    sbfread_ChannelIndex_t ChannelIndex;
+    sbfread_DecodeMask_t DecodeMask;
+    sbfread_Meas3Counters_t Meas3Counters;
+    /* worker threads decoding the antennas in parallel (SBFREAD_THREADS
+       builds only), created at the first multi-antenna epoch */
+    struct sbfread_Meas3Parallel_s* Meas3Parallel;
+    bool                Meas3ParallelUnavailable;
+    uint32_t            MeasDecimation_ms; /* see sbfread_SetMeasDecimation() */
     uint32_t            MeasCollect_CurrentTOW;
     uint32_t            MeasCollect_BlocksSeenAtLastEpoch;
     uint32_t            MeasCollect_BlocksSeenAtThisEpoch;
@@ -173,6 +270,27 @@ void AlignSubBlockSize(void*  SBFBlock,
                        size_t SourceSBSize,
                        size_t TargetSBSize);
 
+/* view on the sub-blocks of an SBF block, see
+   sbfread_SubBlockView_Init() */
+typedef struct
+{
+    const uint8_t*    Base;        /* first sub-block */
+    uint32_t          N;           /* number of sub-blocks */
+    uint32_t          SBSize;      /* size of the sub-blocks in the SBF block */
+    uint32_t          StructSize;  /* size of the sub-block structure */
+} sbfread_SubBlockView_t;
+
+void sbfread_SubBlockView_Init(sbfread_SubBlockView_t* View,
+                               const void*  SBFBlock,
+                               const void*  FirstSubBlock,
+                               uint32_t     N,
+                               uint32_t     SBSize,
+                               size_t       StructSize);
+
+const void* sbfread_SubBlockView_Get(const sbfread_SubBlockView_t* View,
+                                     uint32_t Idx,
+                                     void*    Scratch);
+
 int32_t CheckBlock(SBFData_t* SBFData, uint8_t* Buffer);
 
 int32_t GetNextBlock(SBFData_t* SBFData,
@@ -190,17 +308,17 @@ ssnOff_t GetSBFFilePos(SBFData_t* SBFData);
 
 ssnOff_t GetSBFFileLength(SBFData_t* SBFData);
 
-void InitializeSBFDecoding(char* FileName,
-                           SBFData_t* SBFData);
+int32_t InitializeSBFDecoding(char* FileName,
+                              SBFData_t* SBFData);
 
 void InitializeSBFDecodingWithExistingFile(FILE* file,
         SBFData_t* SBFData);
 
-void CloseSBFFile(SBFData_t* SBFData);
+int32_t CloseSBFFile(SBFData_t* SBFData);
 
 bool IsTimeValid(void* SBFBlock);
 
-int GetCRCErrors();
+int GetCRCErrors(const SBFData_t* SBFData);
 
 #define SBFREAD_MEAS3_ENABLED      0x1
 #define SBFREAD_MEASEPOCH_ENABLED  0x2
@@ -222,7 +340,12 @@ int GetCRCErrors();
      InitializeSBFDecoding()
 
    * SBFBlock: a pointer to the SBFBlock read from the file (see also
-     GetNextBlock() function)
+     GetNextBlock() function).  The measurement blocks are not copied
+     when reading from a file: SBFBlock must not be modified until the
+     end of the epoch, except by GetNextBlock(), which first saves the
+     blocks it is about to overwrite (see sbfread_DetachMeasBlocks()).
+     When the blocks do not come from a file (InitializeSBFDecoding()
+     with a NULL file name), they are always copied.
 
    * MeasEpoch: a pointer to the decoded measurement epoch.  MeasEpoch
      contains a valid measurement epoch only when the function returns
@@ -240,6 +363,74 @@ bool sbfread_MeasCollectAndDecode(
     MeasEpoch_t*                    MeasEpoch,
     uint32_t                        EnabledMeasTypes);
 
+/* sbfread_DetachMeasBlocks() copies the measurement blocks of the
+   current epoch that lie in the Size bytes at Buffer to memory owned by
+   SBFData, so that Buffer can be overwritten before the end of the
+   epoch.  GetNextBlock() calls it before filling its SBFBlock
+   argument; programs filling their block buffer by other means must
+   call it first. */
+void sbfread_DetachMeasBlocks(SBFData_t*  SBFData,
+                              const void* Buffer,
+                              size_t      Size);
+
+/* sbfread_SetDecodeMask() restricts the measurements decoded by
+   sbfread_MeasCollectAndDecode() and sbfread_FlushMeasEpoch() to the
+   constellations, signal types, antennas and fields selected in
+   Mask.  All measurements are decoded if Mask is NULL, which is the
+   default after InitializeSBFDecoding().  Changing the mask while
+   decoding a file discards the current Meas3 reference epochs, so
+   that newly enabled measurements only appear from the next
+   reference epoch. */
+void sbfread_SetDecodeMask(SBFData_t*                  SBFData,
+                           const sbfread_DecodeMask_t* Mask);
+
+/* sbfread_SetMeasDecimation() makes sbfread_MeasCollectAndDecode()
+   and sbfread_FlushMeasEpoch() only return the epochs whose TOW is a
+   multiple of Interval_ms.  The other epochs are not decoded, except
+   for the Meas3 reference epochs, which are still needed to decode
+   the next delta epochs.  This is much faster than decoding all
+   epochs and discarding the unwanted ones afterwards.  Interval_ms
+   0 or 1 (the default) returns all epochs. */
+void sbfread_SetMeasDecimation(SBFData_t* SBFData,
+                               uint32_t   Interval_ms);
+
+/* sbfread_GetMeasBlockAntennas() returns the antennas of which a
+   measurement block (Meas3, MeasEpoch, MeasExtra or MeasFullRange)
+   holds observations, as a mask with the bit (1<<AntIdx) set for each
+   of them, or 0 for the other blocks.  All antenna indices are
+   reported, including those above NR_OF_ANTENNAS, so that a program
+   can check that its epoch dimensions fit the file (see "sbf2asc"
+   built with EPOCH_PROFILES). */
+uint32_t sbfread_GetMeasBlockAntennas(const void* SBFBlock);
+
+/* sbfread_AllocMeasEpoch() returns an uninitialized MeasEpoch_t from
+   a pool owned by SBFData, or NULL if out of memory.  It is meant for
+   applications that keep several decoded epochs in flight (queues
+   between threads, batches,...): the epochs given back with
+   sbfread_FreeMeasEpoch() are recycled, so that no memory is
+   allocated once the pool has grown to the number of epochs in use.
+   sbfread_FreeMeasEpoch() may be called from any thread in
+   SBFREAD_THREADS builds. */
+MeasEpoch_t* sbfread_AllocMeasEpoch(SBFData_t* SBFData);
+
+void sbfread_FreeMeasEpoch(SBFData_t*   SBFData,
+                           MeasEpoch_t* MeasEpoch);
+
+/* sbfread_GetAllocationCount() returns the number of heap allocations
+   made by the decoder since InitializeSBFDecoding().  It allows to
+   check that decoding does not allocate memory in steady state: the
+   count must not change any more once the first epochs have been
+   decoded. */
+uint32_t sbfread_GetAllocationCount(const SBFData_t* SBFData);
+
+/* sbfread_ReleaseMeasDecoding() stops the worker threads used to
+   decode the antennas in parallel, if any, and frees the epochs of
+   sbfread_AllocMeasEpoch(), which must all have been given back.  It is called by
+   CloseSBFFile(), and must be called before re-initializing SBFData
+   when the file was opened with
+   InitializeSBFDecodingWithExistingFile(). */
+void sbfread_ReleaseMeasDecoding(SBFData_t* SBFData);
+
 /*  sbfread_FlushMeasEpoch() forces the measurement decoder to
     process all available data from the current epoch, even if not
     all measurement SBF blocks from that epoch have been received */
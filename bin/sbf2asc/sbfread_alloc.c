@@ -0,0 +1,244 @@
+/*
+ * sbfread_alloc.c: Arenas and object pools used to decode SBF files
+ *                  without heap allocations in steady state.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "sbfread_alloc.h"
+
+#define SBFREAD_ALIGN8(x)  (((x) + 7) & ~(size_t)7)
+
+/* header of each chunk of objects in an object pool */
+typedef union sbfread_ObjChunk_u
+{
+    union sbfread_ObjChunk_u* Next;
+    uint64_t                  Align;
+} sbfread_ObjChunk_t;
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfread_Arena_Init(sbfread_Arena_t* Arena,
+                        void*            Buffer,
+                        size_t           Size)
+{
+    memset(Arena, 0, sizeof(*Arena));
+
+    if (Buffer == NULL)
+    {
+        Buffer = SBFREAD_MALLOC(Size);
+
+        if (Buffer == NULL)
+        {
+            return false;
+        }
+
+        Arena->Owned = true;
+        Arena->Mallocs++;
+    }
+
+    Arena->Data = (uint8_t*)Buffer;
+    Arena->Size = Size;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void* sbfread_Arena_Alloc(sbfread_Arena_t* Arena,
+                          size_t           Bytes)
+{
+    uint8_t* Chunk;
+
+    if (Bytes > Arena->Size - Arena->Used)
+    {
+        return NULL;
+    }
+
+    Chunk = Arena->Data + Arena->Used;
+
+    /* keep the next chunk 8-byte aligned */
+    Arena->Used += SBFREAD_ALIGN8(Bytes);
+
+    if (Arena->Used > Arena->Size)
+    {
+        Arena->Used = Arena->Size;
+    }
+
+    if (Arena->Used > Arena->HighWater)
+    {
+        Arena->HighWater = Arena->Used;
+    }
+
+    return Chunk;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Arena_Reset(sbfread_Arena_t* Arena)
+{
+    Arena->Used = 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Arena_Release(sbfread_Arena_t* Arena)
+{
+    if (Arena->Owned)
+    {
+        SBFREAD_FREE(Arena->Data);
+    }
+
+    Arena->Data  = NULL;
+    Arena->Size  = 0;
+    Arena->Used  = 0;
+    Arena->Owned = false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_ObjPool_Init(sbfread_ObjPool_t* Pool,
+                          size_t             ObjSize,
+                          uint32_t           ObjsPerChunk)
+{
+    memset(Pool, 0, sizeof(*Pool));
+
+    /* free objects hold the link to the next free object */
+    if (ObjSize < sizeof(void*))
+    {
+        ObjSize = sizeof(void*);
+    }
+
+    Pool->ObjSize      = SBFREAD_ALIGN8(ObjSize);
+    Pool->ObjsPerChunk = ObjsPerChunk != 0 ? ObjsPerChunk : 1;
+
+#if SBFREAD_THREADS
+    pthread_mutex_init(&Pool->Mutex, NULL);
+#endif
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfread_ObjPool_Grow(sbfread_ObjPool_t* Pool)
+/* adds a chunk of free objects to the pool */
+{
+    sbfread_ObjChunk_t* Chunk;
+    uint8_t*            Obj;
+    uint32_t            i;
+
+    Chunk = (sbfread_ObjChunk_t*)SBFREAD_MALLOC(sizeof(sbfread_ObjChunk_t) +
+            Pool->ObjsPerChunk * Pool->ObjSize);
+
+    if (Chunk == NULL)
+    {
+        return false;
+    }
+
+    Pool->Mallocs++;
+
+    Chunk->Next = (sbfread_ObjChunk_t*)Pool->Chunks;
+    Pool->Chunks = Chunk;
+
+    Obj = (uint8_t*)(Chunk + 1);
+
+    for (i = 0; i < Pool->ObjsPerChunk; i++, Obj += Pool->ObjSize)
+    {
+        *(void**)Obj   = Pool->FreeList;
+        Pool->FreeList = Obj;
+    }
+
+    Pool->NrOfObjs     += Pool->ObjsPerChunk;
+    Pool->NrOfFreeObjs += Pool->ObjsPerChunk;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void* sbfread_ObjPool_Get(sbfread_ObjPool_t* Pool)
+{
+    void* Obj = NULL;
+
+#if SBFREAD_THREADS
+    pthread_mutex_lock(&Pool->Mutex);
+#endif
+
+    if (Pool->FreeList != NULL || sbfread_ObjPool_Grow(Pool))
+    {
+        Obj = Pool->FreeList;
+        Pool->FreeList = *(void**)Obj;
+        Pool->NrOfFreeObjs--;
+    }
+
+#if SBFREAD_THREADS
+    pthread_mutex_unlock(&Pool->Mutex);
+#endif
+
+    return Obj;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_ObjPool_Put(sbfread_ObjPool_t* Pool,
+                         void*              Obj)
+{
+    if (Obj == NULL)
+    {
+        return;
+    }
+
+#if SBFREAD_THREADS
+    pthread_mutex_lock(&Pool->Mutex);
+#endif
+
+    *(void**)Obj   = Pool->FreeList;
+    Pool->FreeList = Obj;
+    Pool->NrOfFreeObjs++;
+
+#if SBFREAD_THREADS
+    pthread_mutex_unlock(&Pool->Mutex);
+#endif
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_ObjPool_Release(sbfread_ObjPool_t* Pool)
+{
+    sbfread_ObjChunk_t* Chunk = (sbfread_ObjChunk_t*)Pool->Chunks;
+
+    /* already released */
+    if (Pool->ObjSize == 0)
+    {
+        return;
+    }
+
+    while (Chunk != NULL)
+    {
+        sbfread_ObjChunk_t* Next = Chunk->Next;
+
+        SBFREAD_FREE(Chunk);
+        Chunk = Next;
+    }
+
+    Pool->Chunks       = NULL;
+    Pool->FreeList     = NULL;
+    Pool->NrOfObjs     = 0;
+    Pool->NrOfFreeObjs = 0;
+    Pool->ObjSize      = 0;
+
+#if SBFREAD_THREADS
+    pthread_mutex_destroy(&Pool->Mutex);
+#endif
+}
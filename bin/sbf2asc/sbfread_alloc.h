@@ -0,0 +1,118 @@
+/*
+ * sbfread_alloc.h: Declaration of the arenas and object pools used to
+ *                  decode SBF files without heap allocations in steady
+ *                  state.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFREAD_ALLOC_H
+#define SBFREAD_ALLOC_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sbfread_pool.h"
+
+#if SBFREAD_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* All heap allocations of the decoder go through SBFREAD_MALLOC and
+   SBFREAD_FREE, which can be redefined at compile time. */
+#ifndef SBFREAD_MALLOC
+#define SBFREAD_MALLOC(Size)  malloc(Size)
+#endif
+
+#ifndef SBFREAD_FREE
+#define SBFREAD_FREE(Ptr)     free(Ptr)
+#endif
+
+/* An arena hands out 8-byte aligned chunks of a fixed-size buffer.
+   The chunks are not freed individually: the whole arena is reset at
+   once, typically at the end of each epoch or batch. */
+typedef struct
+{
+    uint8_t*          Data;
+    size_t            Size;
+    size_t            Used;
+    size_t            HighWater;  /* largest Used since initialization */
+    bool              Owned;      /* Data was allocated by the arena */
+    uint32_t          Mallocs;    /* number of heap allocations */
+} sbfread_Arena_t;
+
+/* Initialize Arena over the Size bytes at Buffer, which must be
+   8-byte aligned.  If Buffer is NULL, the buffer is allocated on the
+   heap.  Returns false if that allocation fails. */
+bool sbfread_Arena_Init(sbfread_Arena_t* Arena,
+                        void*            Buffer,
+                        size_t           Size);
+
+/* Returns Bytes bytes from the arena, or NULL if the arena is full. */
+void* sbfread_Arena_Alloc(sbfread_Arena_t* Arena,
+                          size_t           Bytes);
+
+/* Forget all the chunks handed out by the arena. */
+void sbfread_Arena_Reset(sbfread_Arena_t* Arena);
+
+/* Free the buffer of the arena if it was allocated by
+   sbfread_Arena_Init(). */
+void sbfread_Arena_Release(sbfread_Arena_t* Arena);
+
+
+/* An object pool recycles objects of a fixed size.  It grows by
+   chunks of ObjsPerChunk objects when it runs out of free objects,
+   and never gives memory back before sbfread_ObjPool_Release(), so
+   that there are no more heap allocations once the pool has reached
+   its working size.  With SBFREAD_THREADS, objects can be taken from
+   and returned to the pool by different threads. */
+typedef struct
+{
+    size_t            ObjSize;      /* rounded up to 8 bytes */
+    uint32_t          ObjsPerChunk;
+    void*             FreeList;
+    void*             Chunks;
+    uint32_t          NrOfObjs;     /* objects allocated so far */
+    uint32_t          NrOfFreeObjs;
+    uint32_t          Mallocs;      /* number of heap allocations */
+#if SBFREAD_THREADS
+    pthread_mutex_t   Mutex;
+#endif
+} sbfread_ObjPool_t;
+
+void sbfread_ObjPool_Init(sbfread_ObjPool_t* Pool,
+                          size_t             ObjSize,
+                          uint32_t           ObjsPerChunk);
+
+/* Returns an uninitialized object, or NULL if the pool cannot grow. */
+void* sbfread_ObjPool_Get(sbfread_ObjPool_t* Pool);
+
+/* Gives Obj, obtained from sbfread_ObjPool_Get(), back to the pool. */
+void sbfread_ObjPool_Put(sbfread_ObjPool_t* Pool,
+                         void*              Obj);
+
+/* Free all the objects of the pool, which must all have been given
+   back.  The pool must be initialized again before it is reused. */
+void sbfread_ObjPool_Release(sbfread_ObjPool_t* Pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
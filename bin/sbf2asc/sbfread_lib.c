@@ -0,0 +1,274 @@
+/*
+ * sbfread_lib.c: C interface of the libsbfread shared library: the
+ *                measurements of an SBF file decoded into columns.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sbfread_lib.h"
+#include "sbfread.h"
+#include "sbfmeasspec.h"
+#include "sbfsvid.h"
+#include "sbftime.h"
+
+struct sbfread_Lib_s
+{
+    SBFData_t         SBFData;
+    sbfmeasspec_t     Spec;
+    uint32_t          Flags;
+    bool              Pending;     /* the rows of MeasEpoch are not
+                                      given yet */
+    uint32_t          NrOfRows;    /* of MeasEpoch */
+    int64_t           Time_ns;     /* of MeasEpoch */
+    sbfread_Lib_Stats_t Stats;
+    MeasEpoch_t       MeasEpoch;
+    uint8_t           SBFBlock[MAX_SBFSIZE];
+};
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfread_Lib_IsSelected(const sbfread_Lib_t* Lib,
+                                   const MeasSet_t*     MeasSet)
+/* returns whether a measurement set of the main antenna is a row, as
+   in the long form of sbfmeasspec_PrintEpoch() */
+{
+    return MeasSet->flags != 0 && MeasSet->signalType < 64 &&
+           Lib->Spec.Group[MeasSet->signalType] != 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+uint32_t sbfread_Lib_GetVersion(void)
+{
+    return SBFREAD_LIB_VERSION;
+}
+
+
+/*---------------------------------------------------------------------------*/
+sbfread_Lib_t* sbfread_Lib_Open(const char* FileName,
+                                const char* Columns,
+                                uint32_t    Interval_ms,
+                                uint32_t    Flags)
+{
+    sbfread_Lib_t*       Lib = (sbfread_Lib_t*)malloc(sizeof(*Lib));
+    sbfread_DecodeMask_t Mask;
+
+    if (Lib == NULL)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    memset(&Lib->Stats, 0, sizeof(Lib->Stats));
+    Lib->Flags   = Flags;
+    Lib->Pending = false;
+
+    /* the rows are the signals: the wide form is not supported */
+    if (!sbfmeasspec_Parse(&Lib->Spec, Columns != NULL ? Columns : "all") ||
+        Lib->Spec.Wide)
+    {
+        free(Lib);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (InitializeSBFDecoding((char*)FileName, &Lib->SBFData) != 0)
+    {
+        int Error = errno;
+
+        free(Lib);
+        errno = Error;
+        return NULL;
+    }
+
+    Lib->Stats.FileLength = (uint64_t)GetSBFFileLength(&Lib->SBFData);
+
+    sbfmeasspec_GetDecodeMask(&Lib->Spec, &Mask);
+    sbfread_SetDecodeMask(&Lib->SBFData, &Mask);
+    sbfread_SetMeasDecimation(&Lib->SBFData, Interval_ms);
+
+    return Lib;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfread_Lib_NextEpoch(sbfread_Lib_t*       Lib,
+                              sbfread_Lib_Epoch_t* Epoch)
+{
+    const MeasEpoch_t* const MeasEpoch = &Lib->MeasEpoch;
+    uint32_t i, SigIdx;
+
+    Lib->Pending = false;
+
+    for (;;)
+    {
+        if (GetNextBlock(&Lib->SBFData, Lib->SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                         START_POS_CURRENT | END_POS_AFTER_BLOCK) != 0)
+        {
+            return 0;
+        }
+
+        Lib->Stats.NrOfBlocks++;
+
+        if (sbfread_MeasCollectAndDecode(&Lib->SBFData, Lib->SBFBlock, &Lib->MeasEpoch,
+                                         SBFREAD_ALLMEAS_ENABLED))
+        {
+            break;
+        }
+    }
+
+    Lib->Stats.NrOfEpochs++;
+    Lib->Pending  = true;
+    Lib->NrOfRows = 0;
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            if (sbfread_Lib_IsSelected(Lib, &MeasEpoch->channelData[i].measSet[0][SigIdx]))
+            {
+                Lib->NrOfRows++;
+            }
+        }
+    }
+
+    if (MeasEpoch->TOW_ms == U32_NOTVALID || MeasEpoch->WNc == U16_NOTVALID)
+    {
+        Lib->Time_ns = -1;
+    }
+    else
+    {
+        Lib->Time_ns = sbftime_GetGPSTime_ns(MeasEpoch->WNc, MeasEpoch->TOW_ms);
+
+        if ((Lib->Flags & SBFREAD_LIB_UTC) != 0)
+        {
+            Lib->Time_ns = sbftime_GetUTCTime_ns(Lib->Time_ns);
+        }
+    }
+
+    if (Epoch != NULL)
+    {
+        memset(Epoch, 0, sizeof(*Epoch));
+        Epoch->Time_ns  = Lib->Time_ns;
+        Epoch->TOW_ms   = MeasEpoch->TOW_ms;
+        Epoch->WNc      = MeasEpoch->WNc;
+        Epoch->NrOfRows = Lib->NrOfRows;
+    }
+
+    return 1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfread_Lib_FillColumns(sbfread_Lib_t* Lib,
+                                uint32_t       MaxRows,
+                                int64_t*       Time_ns,
+                                uint8_t*       SVID,
+                                uint8_t*       SignalType,
+                                double*        Values)
+{
+    const MeasEpoch_t* const MeasEpoch = &Lib->MeasEpoch;
+    uint32_t Row = 0;
+    uint32_t i, SigIdx, Field;
+
+    for (;;)
+    {
+        if (!Lib->Pending && sbfread_Lib_NextEpoch(Lib, NULL) == 0)
+        {
+            break;
+        }
+
+        if (Row + Lib->NrOfRows > MaxRows)
+        {
+            if (Row == 0)
+            {
+                errno = ENOBUFS;
+                return -1;
+            }
+
+            break;
+        }
+
+        for (i = 0; i < MeasEpoch->nbrElements; i++)
+        {
+            const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+
+            for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+            {
+                const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+
+                if (!sbfread_Lib_IsSelected(Lib, MeasSet))
+                {
+                    continue;
+                }
+
+                Time_ns[Row]    = Lib->Time_ns;
+                SVID[Row]       = convertSVIDtoSBF(ChannelData->PRN);
+                SignalType[Row] = MeasSet->signalType;
+
+                for (Field = 0; Field < Lib->Spec.NrOfFields; Field++)
+                {
+                    double Value = sbfmeasspec_GetField(MeasSet, (sbfmeasspec_Field_t)Lib->Spec.Fields[Field]);
+
+                    Values[(size_t)Field * MaxRows + Row] =
+                        (Value == F64_NOTVALID || Value == (double)F32_NOTVALID) ? NAN : Value;
+                }
+
+                Row++;
+            }
+        }
+
+        Lib->Pending = false;
+    }
+
+    Lib->Stats.NrOfRows += Row;
+
+    return (int32_t)Row;
+}
+
+
+/*---------------------------------------------------------------------------*/
+uint32_t sbfread_Lib_GetNrOfValues(const sbfread_Lib_t* Lib)
+{
+    return Lib->Spec.NrOfFields;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Lib_GetStats(sbfread_Lib_t*       Lib,
+                          sbfread_Lib_Stats_t* Stats,
+                          size_t               StatsSize)
+{
+    Lib->Stats.NrOfCRCErrors = (uint64_t)GetCRCErrors(&Lib->SBFData);
+    Lib->Stats.FilePos       = (uint64_t)GetSBFFilePos(&Lib->SBFData);
+
+    memcpy(Stats, &Lib->Stats, StatsSize < sizeof(Lib->Stats) ? StatsSize : sizeof(Lib->Stats));
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbfread_Lib_Close(sbfread_Lib_t* Lib)
+{
+    int32_t Status = CloseSBFFile(&Lib->SBFData);
+    int     Error = errno;
+
+    free(Lib);
+    errno = Error;
+
+    return Status;
+}
@@ -0,0 +1,134 @@
+/*
+ * sbfread_lib.h: C interface of the libsbfread shared library, which
+ *                decodes the measurements of an SBF file into columns,
+ *                for the programs in other languages (Python ctypes or
+ *                cffi,...).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFREAD_LIB_H
+#define SBFREAD_LIB_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Only the functions below are exported by the library.  They only
+   use fixed-size integers, doubles and pointers, and the structures
+   have no implicit padding, so that they can be declared as such in
+   other languages.  SBFREAD_LIB_VERSION is incremented when they
+   change in a way that is not backward compatible. */
+#define SBFREAD_LIB_VERSION  1
+
+#if defined(_WIN32) && defined(SBFREAD_LIB_BUILD)
+#define SBFREAD_LIB_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define SBFREAD_LIB_API __attribute__((visibility("default")))
+#else
+#define SBFREAD_LIB_API
+#endif
+
+/* flags of sbfread_Lib_Open() */
+#define SBFREAD_LIB_UTC  0x1  /* times in UTC ns since Jan 01, 1970
+                                 instead of GPS ns since Jan 06, 1980 */
+
+typedef struct sbfread_Lib_s sbfread_Lib_t;
+
+/* a measurement epoch returned by sbfread_Lib_NextEpoch() */
+typedef struct
+{
+    int64_t           Time_ns;     /* see SBFREAD_LIB_UTC, or -1 if the
+                                      time is not valid */
+    uint32_t          TOW_ms;
+    uint16_t          WNc;
+    uint16_t          Reserved;
+    uint32_t          NrOfRows;    /* selected signals of the epoch */
+    uint32_t          Reserved2;
+} sbfread_Lib_Epoch_t;
+
+/* counters of sbfread_Lib_GetStats() */
+typedef struct
+{
+    uint64_t          NrOfBlocks;     /* valid SBF blocks read */
+    uint64_t          NrOfCRCErrors;  /* blocks with a wrong CRC */
+    uint64_t          NrOfEpochs;     /* measurement epochs decoded */
+    uint64_t          NrOfRows;       /* rows given by
+                                         sbfread_Lib_FillColumns() */
+    uint64_t          FilePos;        /* bytes read from the file */
+    uint64_t          FileLength;     /* bytes */
+} sbfread_Lib_Stats_t;
+
+/* Returns SBFREAD_LIB_VERSION, to check that the library matches the
+   declarations of the caller. */
+SBFREAD_LIB_API uint32_t sbfread_Lib_GetVersion(void);
+
+/* Open the SBF file FileName.  Columns selects the observables and the
+   signals as the long form of the sbf2asc -C option (see
+   sbfmeasspec_Parse()), for instance "cn0/GPSL1CA+GALE1BC", or all
+   the observables of all the signals if NULL; only these are decoded.
+   The epochs whose TOW is not a multiple of Interval_ms are skipped
+   (0 for all the epochs).  Flags is a combination of the
+   SBFREAD_LIB_xx flags.  Returns NULL with errno set on failure, to
+   EINVAL if Columns is not valid. */
+SBFREAD_LIB_API sbfread_Lib_t* sbfread_Lib_Open(const char* FileName,
+                                                const char* Columns,
+                                                uint32_t    Interval_ms,
+                                                uint32_t    Flags);
+
+/* Decode the next measurement epoch, whose rows are then given by
+   sbfread_Lib_FillColumns(), and describe it in Epoch if not NULL.
+   Returns 1, or 0 at the end of the file. */
+SBFREAD_LIB_API int32_t sbfread_Lib_NextEpoch(sbfread_Lib_t*       Lib,
+                                              sbfread_Lib_Epoch_t* Epoch);
+
+/* Fill at most MaxRows rows of the arrays with the selected signals of
+   the main antenna: the rows of the current epoch if they were not
+   given yet, then of the next epochs, as long as all the rows of an
+   epoch fit.  The epoch that does not fit becomes the current one.
+   Each row holds the time (see SBFREAD_LIB_UTC), the SBF SVID, the
+   signal type, and the observables of Columns in Values, by column:
+   the observable i of the row r is Values[i * MaxRows + r], or NaN if
+   it is not available.  Returns the number of rows filled, 0 at the end
+   of the file, or -1 with errno set to ENOBUFS if the rows of an epoch
+   do not fit in MaxRows. */
+SBFREAD_LIB_API int32_t sbfread_Lib_FillColumns(sbfread_Lib_t* Lib,
+                                                uint32_t       MaxRows,
+                                                int64_t*       Time_ns,
+                                                uint8_t*       SVID,
+                                                uint8_t*       SignalType,
+                                                double*        Values);
+
+/* Returns the number of observables in Values (the columns of
+   sbfread_Lib_Open()). */
+SBFREAD_LIB_API uint32_t sbfread_Lib_GetNrOfValues(const sbfread_Lib_t* Lib);
+
+/* Copy the first StatsSize bytes of the counters to Stats, so that
+   the callers built for a previous version, with fewer counters, keep
+   working. */
+SBFREAD_LIB_API void sbfread_Lib_GetStats(sbfread_Lib_t*       Lib,
+                                          sbfread_Lib_Stats_t* Stats,
+                                          size_t               StatsSize);
+
+/* Close the file and free Lib.  Returns 0, or -1 with errno set if the
+   file could not be closed. */
+SBFREAD_LIB_API int32_t sbfread_Lib_Close(sbfread_Lib_t* Lib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
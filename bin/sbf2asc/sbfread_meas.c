@@ -16,8 +16,10 @@
  */
 
 #include <string.h>
+#include <stddef.h>
 
 #include "sbfread.h"
+#include "sbfread_pool.h"
 
 #if SSN_FEATURE_SBF_SCRAMBLING
 # include "sbfdecrypt.h"
@@ -44,43 +46,63 @@ static const double PRBase_m[MEAS3_SYS_MAX]
       };
 
 
-/* a counter of the number of occurrence of the different types of
-   Meas3 sub-blocks. */
-uint32_t Meas3Ranges_Count_MasterLong  = 0;
-uint32_t Meas3Ranges_Count_MasterShort = 0;
-uint32_t Meas3Ranges_Count_MasterDelta = 0;
-uint32_t Meas3Ranges_Count_SlaveLong  = 0;
-uint32_t Meas3Ranges_Count_SlaveShort = 0;
-uint32_t Meas3Ranges_Count_SlaveDelta = 0;
-
-
-/* returns the number of bits set to 1 in the byte */
-static uint32_t bitcnt(uint8_t b)
+/* returns the number of bits set to 1 in v */
+static uint32_t bitcnt(uint64_t v)
 {
-    uint32_t i;
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_popcountll(v);
+#else
     uint32_t n = 0;
 
-    for (i = 0; i < 8; i++)
+    while (v != 0)
     {
-        n += ((b >> i) & 1);
+        v &= v - 1;
+        n++;
     }
 
     return n;
+#endif
 }
 
 /* returns the position of the first bit set to 1 in v (starting at 0
-   for the LSB), or 32 if v is zero. */
-static uint32_t lsbpos(uint32_t v)
+   for the LSB), or 64 if v is zero. */
+static uint32_t lsbpos(uint64_t v)
 {
+#if defined(__GNUC__)
+    return v != 0 ? (uint32_t)__builtin_ctzll(v) : 64;
+#else
     uint32_t i;
 
-    for (i = 0; i < 32; i++)
+    for (i = 0; i < 64; i++)
         if (((v >> i) & 1) != 0)
         {
             return i;
         }
 
-    return 32;
+    return 64;
+#endif
+}
+
+
+/* unaligned loads from the Meas3 sub-blocks (in host byte order, as
+   all other SBF fields).  The memcpy compiles into a single load on
+   the targets that support unaligned accesses. */
+static uint16_t sbfread_LoadU16(const uint8_t* p)
+{
+    uint16_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static uint32_t sbfread_LoadU32(const uint8_t* p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
 }
 
 
@@ -143,38 +165,39 @@ static SignalType_t sbfread_Meas3_SigIdx2SignalType(SignalType_t     Meas3SigIdx
 
 
 /*---------------------------------------------------------------------------*/
-static void sbfread_PrepareSigTable(SignalType_t     Meas3SigIdx2SignalType[MEAS3_SYS_MAX][MEAS3_SIG_MAX],
+static void sbfread_PrepareSigTable(sbfread_Meas3_SigTable_t* SigTable,
                                     Meas3SatSystem_t SatSys,
                                     uint8_t          SigExcluded)
 {
     unsigned int i;
+    uint32_t     Included;
 
-    unsigned int NrZeros = 0;
-    unsigned int PosZeros[MEAS3_SIG_MAX];
-
-    /* note the positions of the zero bits in SigExcluded (extended to
-       MEAS3_SIG_MAX bits).  Only the first 8 signals can be excluded */
-    for (i = 0; i < MEAS3_SIG_MAX; i++)
+    /* the table of that constellation only needs to be rebuilt when
+       SigExcluded changes, which is rare */
+    if (SigTable->Valid[SatSys] && SigTable->SigExcluded[SatSys] == SigExcluded)
     {
-        if (((uint32_t)SigExcluded & (1 << i)) == 0)
-        {
-            PosZeros[NrZeros] = i;
-            NrZeros++;
-        }
+        return;
     }
 
-    /* those signals that correspond to the zero bits must be included */
-    for (i = 0; i < NrZeros; i++)
+    /* the signals that correspond to the zero bits in SigExcluded
+       (extended to MEAS3_SIG_MAX bits) must be included.  Only the
+       first 8 signals can be excluded */
+    Included = ~(uint32_t)SigExcluded & ((1UL << MEAS3_SIG_MAX) - 1);
+
+    for (i = 0; Included != 0; i++)
     {
-        Meas3SigIdx2SignalType[SatSys][i] = Meas3SigIdx2SignalType_Default[SatSys][PosZeros[i]];
+        SigTable->SigIdx2SignalType[SatSys][i] = Meas3SigIdx2SignalType_Default[SatSys][lsbpos(Included)];
+        Included &= Included - 1;
     }
 
     /* remaining signals do not exist */
-    for (i = NrZeros; i < MEAS3_SIG_MAX; i++)
+    for (; i < MEAS3_SIG_MAX; i++)
     {
-        Meas3SigIdx2SignalType[SatSys][i] = SIG_LAST;
+        SigTable->SigIdx2SignalType[SatSys][i] = SIG_LAST;
     }
 
+    SigTable->SigExcluded[SatSys] = SigExcluded;
+    SigTable->Valid[SatSys]       = true;
 }
 
 
@@ -246,7 +269,8 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
                            uint32_t*        MasterSigIdx,
                            uint32_t*        SlaveSigMask,          /* slave signal mask decoded in this function */
                            bool             PRRateAvailable,
-                           int16_t*         PRRate_64mm_s
+                           int16_t*         PRRate_64mm_s,
+                           sbfread_Meas3Counters_t* Counters
 #if SSN_FEATURE_SBF_SCRAMBLING
                            , decrypt_ctx_t*  decryptctx
 #endif
@@ -260,8 +284,8 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
     if ((*buf & 1) == 1)
     {
         /*MasterShort*/
-        uint32_t BF1    = *(uint32_t*)buf;
-        uint32_t PRLSB  = *(uint32_t*)(buf + 4);
+        uint32_t BF1    = sbfread_LoadU32(buf);
+        uint32_t PRLSB  = sbfread_LoadU32(buf + 4);
         uint32_t CmC    = (BF1 >> 1) & 0x3ffff;
         uint32_t PRMSB  = (BF1 >> 19) & 1;
         uint32_t LTI3   = (BF1 >> 20) & 0x7;
@@ -289,7 +313,7 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
 
         if (PRRateAvailable)
         {
-            *PRRate_64mm_s = *(int16_t*)(buf + 8);
+            *PRRate_64mm_s = (int16_t)sbfread_LoadU16(buf + 8);
         }
         else
         {
@@ -299,14 +323,14 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
         *SlaveSigMask = SigList << ((*MasterSigIdx) + 1);
 
         ret = PRRateAvailable ? (uint32_t)10 : (uint32_t)8;
-        Meas3Ranges_Count_MasterShort++;
+        Counters->MasterShort++;
     }
     else if ((*buf & 3) == 0)
     {
         /*MasterLong*/
-        uint32_t BF1    = *(uint32_t*)buf;
-        uint32_t PRLSB  = *(uint32_t*)(buf + 4);
-        uint16_t BF2    = *(uint16_t*)(buf + 8);
+        uint32_t BF1    = sbfread_LoadU32(buf);
+        uint32_t PRLSB  = sbfread_LoadU32(buf + 4);
+        uint16_t BF2    = sbfread_LoadU16(buf + 8);
         uint8_t  BF3    = *(buf + 10);
         uint32_t PRMSB  = (BF1 >> 2) & 0xf;
         uint32_t CmC    = (BF1 >> 6) & 0x3fffff;
@@ -349,7 +373,7 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
 
         if (PRRateAvailable)
         {
-            *PRRate_64mm_s = *(int16_t*)(buf + 10);
+            *PRRate_64mm_s = (int16_t)sbfread_LoadU16(buf + 10);
         }
         else
         {
@@ -360,13 +384,13 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
 
         ret = PRRateAvailable ? (uint32_t)(12 + Cont) : (uint32_t)(10 + Cont);
 
-        Meas3Ranges_Count_MasterLong++;
+        Counters->MasterLong++;
     }
     else if ((*buf & 0xc) == 0xc)
     {
         /*MasterDeltaL (long delta)*/
         uint8_t   BF1   = *buf;
-        uint32_t  BF2   = *(uint32_t*)(buf + 1);
+        uint32_t  BF2   = sbfread_LoadU32(buf + 1);
         uint32_t  PR    = (((uint32_t)(BF1 >> 4) << 13) | (BF2 & 0x1fff));
         uint32_t  CN0   = (BF2 >> 13) & 0x7;
         uint32_t  CmC   = BF2 >> 16;
@@ -390,12 +414,12 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
 
         ret = 5;
 
-        Meas3Ranges_Count_MasterDelta++;
+        Counters->MasterDelta++;
     }
     else
     {
         /*MasterDeltaS (short delta)*/
-        uint32_t  BF1   = *(uint32_t*)buf;
+        uint32_t  BF1   = sbfread_LoadU32(buf);
         uint32_t  PR    = (BF1 >> 4) & 0x3fff;
         uint32_t  CmC   = (BF1 >> 18) & 0x3fff;
         uint32_t  CN0   = (BF1 >> 2) & 0x3;
@@ -419,7 +443,7 @@ sbfread_Meas3_DecodeMaster(const uint8_t* const buf,
 
         ret = 4;
 
-        Meas3Ranges_Count_MasterDelta++;
+        Counters->MasterDelta++;
     }
 
     return ret;
@@ -440,7 +464,8 @@ static uint32_t sbfread_Meas3_DecodeSlave(const uint8_t* const buf,
         const MeasSet_t* const MeasSetMaster,
         uint32_t                       MasterSigIdx,
         const MeasSet_t* const MeasSetMasterRef,
-        const MeasSet_t* const MeasSetSlaveRef)
+        const MeasSet_t* const MeasSetSlaveRef,
+        sbfread_Meas3Counters_t* Counters)
 {
     uint32_t ret;
     double WavelengthMaster_m = sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, MasterSigIdx, GLOfn);
@@ -454,7 +479,7 @@ static uint32_t sbfread_Meas3_DecodeSlave(const uint8_t* const buf,
     if ((*buf & 1) == 1)
     {
         /*SlaveShort*/
-        uint32_t BF1    = *(uint32_t*)buf;
+        uint32_t BF1    = sbfread_LoadU32(buf);
         uint8_t  BF2    = *(buf + 4);
         uint32_t CmCres = (BF1 >> 1) & 0xffff;
         uint32_t PRrel  = BF1 >> 17;
@@ -494,13 +519,13 @@ static uint32_t sbfread_Meas3_DecodeSlave(const uint8_t* const buf,
         }
 
         ret = 5;
-        Meas3Ranges_Count_SlaveShort++;
+        Counters->SlaveShort++;
     }
     else if ((*buf & 3) == 0)
     {
         /*SlaveLong*/
-        uint32_t BF1      = *(uint32_t*)buf;
-        uint16_t PRLSBrel = *(uint16_t*)(buf + 4);
+        uint32_t BF1      = sbfread_LoadU32(buf);
+        uint16_t PRLSBrel = sbfread_LoadU16(buf + 4);
         uint8_t  BF3      = *(buf + 6);
         uint32_t CmC      = (BF1 >> 2) & 0x3fffff;
         uint32_t LTI4     = (BF1 >> 24) & 0xf;
@@ -529,13 +554,13 @@ static uint32_t sbfread_Meas3_DecodeSlave(const uint8_t* const buf,
         }
 
         ret = 7;
-        Meas3Ranges_Count_SlaveLong++;
+        Counters->SlaveLong++;
     }
     else
     {
         /*SlaveDelta*/
-        uint16_t BF1      = *(uint16_t*)buf;
-        uint8_t  dCarrier = *(uint8_t*)(buf + 2);
+        uint16_t BF1      = sbfread_LoadU16(buf);
+        uint8_t  dCarrier = *(buf + 2);
         uint32_t dPR      = (BF1 >> 2) & 0xfff;
         uint32_t CN0      = BF1 >> 14;
 
@@ -549,7 +574,7 @@ static uint32_t sbfread_Meas3_DecodeSlave(const uint8_t* const buf,
         MeasSet->PLLTimer_ms = MeasSetSlaveRef->PLLTimer_ms;
 
         ret = 3;
-        Meas3Ranges_Count_SlaveDelta++;
+        Counters->SlaveDelta++;
     }
 
     return ret;
@@ -803,87 +828,134 @@ static const uint8_t SVIDBase[MEAS3_SYS_MAX]
 
 
 /*---------------------------------------------------------------------------*/
-static MeasChannel_t* sbfread_Meas3_GetMeasChannel(MeasEpoch_t*         MeasEpoch,
-        Meas3SatSystem_t     SatSys,
-        uint32_t             SatIdx)
+static void sbfread_ChannelIndex_Reset(sbfread_ChannelIndex_t* ChannelIndex)
+/* clear all entries of the index, at the start of a new epoch */
 {
     uint32_t i;
 
-    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    for (i = 0; i < ChannelIndex->NrTouched; i++)
     {
-        if (MeasEpoch->channelData[i].PRN == (uint8_t)(SVIDBase[SatSys] + SatIdx))
-        {
-            return &(MeasEpoch->channelData[i]);
-        }
+        ChannelIndex->Pos[ChannelIndex->Touched[i]] = 0;
     }
 
-    if ((int) MeasEpoch->nbrElements < NR_OF_LOGICALCHANNELS)
-    {
-        MeasEpoch->nbrElements++;
-    }
+    ChannelIndex->NrTouched = 0;
+}
 
-    /* the channel number is just a counter */
-    MeasEpoch->channelData[MeasEpoch->nbrElements - 1].channel = MeasEpoch->nbrElements - 1;
 
-    return &(MeasEpoch->channelData[MeasEpoch->nbrElements - 1]);
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfread_ChannelIndex_Find(const sbfread_ChannelIndex_t* ChannelIndex,
+        uint8_t              Key)
+/* returns 1 + the position in channelData[] of the first element
+   added with that key, or 0 if there is no such element */
+{
+    return ChannelIndex->Pos[Key];
 }
 
 
+/*---------------------------------------------------------------------------*/
+static void sbfread_ChannelIndex_Add(sbfread_ChannelIndex_t* ChannelIndex,
+                                     uint8_t              Key,
+                                     uint32_t             Pos)
+/* associate the element at position Pos in channelData[] with Key,
+   unless an element with the same key has already been added */
+{
+    if (ChannelIndex->Pos[Key] == 0)
+    {
+        ChannelIndex->Pos[Key] = (uint16_t)(Pos + 1);
+        ChannelIndex->Touched[ChannelIndex->NrTouched] = Key;
+        ChannelIndex->NrTouched++;
+    }
+}
+
 
 /*---------------------------------------------------------------------------*/
-static uint32_t
-sbfread_Meas3_DecodeConstellation(const uint8_t* buf,
-                                  const Meas3CN0HiRes_1_t* sbfMeas3CN0HiRes,
-                                  uint32_t*      CN0HiResIdx,
-                                  const Meas3Doppler_1_t* sbfMeas3Doppler,
-                                  uint32_t*      DopplerIdx,
-                                  const Meas3PP_1_t* sbfMeas3PP,
-                                  uint32_t*      PP1Idx,
-                                  uint32_t*      PP2Idx,
-                                  const Meas3MP_1_t* sbfMeas3MP,
-                                  uint32_t*      MPIdx,
-                                  uint32_t       AntIdx,
-                                  Meas3SatSystem_t  SatSys,
-                                  MeasEpoch_t*   MeasEpoch,
-                                  sbfread_Meas3_RefEpoch_t* RefEpoch,
-                                  uint32_t       RefInterval_ms,
-                                  bool           RefEpochContainsPRRate
-#if SSN_FEATURE_SBF_SCRAMBLING
-                                  , decrypt_ctx_t* decryptctx
-#endif
-                                 )
+static void sbfread_ChannelIndex_Build(sbfread_ChannelIndex_t* ChannelIndex,
+                                       const MeasEpoch_t*   MeasEpoch)
+/* index all elements of channelData[] by logical channel number */
 {
-    const uint8_t* start = buf;
-    const uint8_t* SatDataBuf;
-    uint32_t NSats = 0;
-    uint32_t SatIdx;
-    uint32_t SigIdx;
-    uint32_t N = 0;
-    uint32_t ii;
-    uint64_t SatMask = 0;
-    uint16_t BDSLongRange = 0;
-    uint32_t Nb;
-    uint32_t SigIdxMasterShort;
-    bool     SigExcludedPresent;
-    uint8_t  SigExcluded;
-    uint32_t SatCnt = 0;
-    uint8_t  GLOFnList[32];
+    uint32_t i;
+
+    sbfread_ChannelIndex_Reset(ChannelIndex);
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        sbfread_ChannelIndex_Add(ChannelIndex, MeasEpoch->channelData[i].channel, i);
+    }
+}
 
-    SignalType_t Meas3SigIdx2SignalType[MEAS3_SYS_MAX][MEAS3_SIG_MAX];
 
-    memset(GLOFnList, 0, sizeof(GLOFnList));
+/*---------------------------------------------------------------------------*/
+static MeasChannel_t* sbfread_GetMeasChannelByPRN(MeasEpoch_t*         MeasEpoch,
+        sbfread_ChannelIndex_t* ChannelIndex,
+        uint8_t              PRN,
+        uint8_t              fnPlus8)
+/* returns the channel of satellite PRN in MeasEpoch, adding it if
+   needed */
+{
+    uint32_t Pos = sbfread_ChannelIndex_Find(ChannelIndex, PRN);
+    MeasChannel_t* MeasChannel;
 
-    /* if first byte of M3SatData is zero, copy the M3SatData from the
-       reference epoch */
-    if (*buf == 0)
+    if (Pos != 0)
     {
-        SatDataBuf = RefEpoch->M3SatDataCopy[SatSys];
+        MeasChannel = &(MeasEpoch->channelData[Pos - 1]);
     }
     else
     {
-        SatDataBuf = buf;
+        if ((int) MeasEpoch->nbrElements < NR_OF_LOGICALCHANNELS)
+        {
+            MeasEpoch->nbrElements++;
+        }
+
+        /* the channel number is just a counter */
+        MeasEpoch->channelData[MeasEpoch->nbrElements - 1].channel = MeasEpoch->nbrElements - 1;
+
+        sbfread_ChannelIndex_Add(ChannelIndex, PRN, MeasEpoch->nbrElements - 1);
+
+        MeasChannel = &(MeasEpoch->channelData[MeasEpoch->nbrElements - 1]);
     }
 
+    MeasChannel->PRN     = PRN;
+    MeasChannel->fnPlus8 = fnPlus8;
+
+    return MeasChannel;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static MeasChannel_t* sbfread_Meas3_GetMeasChannel(MeasEpoch_t*         MeasEpoch,
+        sbfread_ChannelIndex_t* ChannelIndex,
+        Meas3SatSystem_t     SatSys,
+        uint32_t             SatIdx,
+        int                  GLOfn)
+{
+    return sbfread_GetMeasChannelByPRN(MeasEpoch, ChannelIndex,
+                                       (uint8_t)(SVIDBase[SatSys] + SatIdx),
+                                       (uint8_t)(GLOfn + 8));
+}
+
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+sbfread_Meas3_ReadSatData(const uint8_t* SatDataBuf,
+                          Meas3SatSystem_t SatSys,
+                          uint64_t*      SatMask,
+                          uint32_t*      SigIdxMasterShort,
+                          uint8_t        GLOFnList[32],
+                          uint16_t*      BDSLongRange,
+                          uint8_t*       SigExcluded)
+/* reads the M3SatData header of a constellation and returns its size
+   in bytes */
+{
+    uint32_t N = 0;
+    uint32_t Nb;
+    uint32_t ii;
+    bool     SigExcludedPresent;
+
+    *SatMask      = 0;
+    *BDSLongRange = 0;
+    memset(GLOFnList, 0, 32);
+
     /* read BF1 */
     Nb = SatDataBuf[N] & 0x7;
 
@@ -892,21 +964,22 @@ sbfread_Meas3_DecodeConstellation(const uint8_t* buf,
         Nb = 8;
     }
 
-    SigIdxMasterShort = (*(SatDataBuf + N) >> 3) & 0xf;
+    *SigIdxMasterShort = (*(SatDataBuf + N) >> 3) & 0xf;
     SigExcludedPresent = (*(SatDataBuf + N) >> 7) != 0;
     N++;
 
     /* read SatMask */
     for (ii = 0; ii < Nb; ii++)
     {
-        SatMask |= (uint64_t)(*(SatDataBuf + N)) << (ii * 8);
-        NSats += bitcnt(*(SatDataBuf + N));
+        *SatMask |= (uint64_t)(*(SatDataBuf + N)) << (ii * 8);
         N++;
     }
 
     /* read GLOFnList if applicable */
     if (SatSys == MEAS3_SYS_GLO)
     {
+        uint32_t NSats = bitcnt(*SatMask);
+
         memcpy(GLOFnList, SatDataBuf + N, (NSats + 1) / 2);
         N += (NSats + 1) / 2;
     }
@@ -914,415 +987,1064 @@ sbfread_Meas3_DecodeConstellation(const uint8_t* buf,
     /* read BDSLongRange if applicable */
     if (SatSys == MEAS3_SYS_BDS)
     {
-        BDSLongRange = *(uint16_t*)(SatDataBuf + N);
+        *BDSLongRange = sbfread_LoadU16(SatDataBuf + N);
         N += 2;
     }
 
     /* read the SigExcluded field if present */
     if (SigExcludedPresent)
     {
-        SigExcluded = *(SatDataBuf + N);
+        *SigExcluded = *(SatDataBuf + N);
         N++;
     }
     else
     {
-        SigExcluded = 0;
+        *SigExcluded = 0;
     }
 
-    /* go to the first M3Master subblock */
-    if (*buf == 0)
+    return N;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_SkipMeasInfo(const Meas3CN0HiRes_1_t* sbfMeas3CN0HiRes,
+                                       uint32_t*      CN0HiResIdx,
+                                       const Meas3Doppler_1_t* sbfMeas3Doppler,
+                                       uint32_t*      DopplerIdx,
+                                       const Meas3PP_1_t* sbfMeas3PP,
+                                       uint32_t*      PP1Idx,
+                                       uint32_t*      PP2Idx,
+                                       const Meas3MP_1_t* sbfMeas3MP,
+                                       uint32_t*      MPIdx)
+/* moves the indexes in the Meas3CN0HiRes, Meas3Doppler, Meas3PP and
+   Meas3MP blocks past the data of a measurement that is not decoded */
+{
+    MeasSet_t Dummy;
+
+    memset(&Dummy, 0, sizeof(Dummy));
+
+    (void)sbfread_Meas3_GetPRRate_mm_s(sbfMeas3Doppler, DopplerIdx);
+
+    if (sbfMeas3CN0HiRes != NULL)
     {
-        buf += 1;
+        (*CN0HiResIdx)++;
     }
-    else
+
+    sbfread_Meas3_AddPPInfo(&Dummy, sbfMeas3PP, PP1Idx, PP2Idx);
+    sbfread_Meas3_AddMPInfo(&Dummy, sbfMeas3MP, MPIdx);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfread_Meas3_GetSlaveSize(const uint8_t* const buf)
+/* returns the size of the M3Slave sub-block at buf */
+{
+    if ((*buf & 1) == 1)
     {
-        buf += N;
+        return 5; /*SlaveShort*/
     }
-
-    /* if this is a reference epoch, remember this M3SatData */
-    if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
+    else if ((*buf & 3) == 0)
     {
-        memcpy(RefEpoch->M3SatDataCopy[SatSys], start, N);
+        return 7; /*SlaveLong*/
     }
+    else
+    {
+        return 3; /*SlaveDelta*/
+    }
+}
 
-    sbfread_PrepareSigTable(Meas3SigIdx2SignalType, SatSys, SigExcluded);
-
-    /* decoder all sats from this constellation */
-    for (SatIdx = 0; SatIdx < MEAS3_SAT_MAX && SatCnt < NSats; SatIdx++)
-    {
-        if ((SatMask & (1ULL << SatIdx)) != 0)
-        {
-            MeasSet_t          MeasSetMaster;
-            uint32_t           MasterSigIdx;
-            uint32_t           SlaveSigMask = 0;
-            int16_t            PRRate_64mm_s = 0;
-            int                GLOfn = (int)((GLOFnList[SatCnt / 2] >> (4 * (SatCnt % 2))) & 0xf) - 8;
-            float              CN0Master_HiRes_dBHz = 0.0F;
-            int                SlaveCnt = 0;
-            uint32_t           MasterSize;
-            MeasChannel_t*     MeasChannel = sbfread_Meas3_GetMeasChannel(MeasEpoch, SatSys, SatIdx);
-
-            MeasChannel->PRN     = (uint8_t)(SVIDBase[SatSys] + SatIdx);
-            MeasChannel->fnPlus8 = (uint8_t)(GLOfn + 8);
-
-            /* there is always at least a master measurement set available for each satellite.  Decode it now */
-            MasterSize = sbfread_Meas3_DecodeMaster(buf,
-                                                    Meas3SigIdx2SignalType,
-                                                    SatSys,
-                                                    SatIdx,
-                                                    GLOfn,
-                                                    (BDSLongRange & (1 << SatCnt)) != 0 ? 34e6 : PRBase_m[SatSys],
-                                                    SigIdxMasterShort,
-                                                    RefEpoch,
-                                                    MeasEpoch->TOW_ms % RefInterval_ms,
-                                                    &MeasSetMaster,
-                                                    &MasterSigIdx,
-                                                    &SlaveSigMask,
-                                                    RefEpochContainsPRRate,
-                                                    &PRRate_64mm_s
-#if SSN_FEATURE_SBF_SCRAMBLING
-                                                    , decryptctx
-#endif
-                                                   );
-
-            if (MasterSize == 0)
-            {
-                goto EXIT_INVALIDFORMAT;
-            }
 
-            buf += MasterSize;
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_ResetRefEpoch(sbfread_Meas3_RefEpoch_t* RefEpoch)
+/* forgets the data of the previous reference epoch.  The data of each
+   satellite is cleared by sbfread_Meas3_PrepareRefSat() when that
+   satellite is decoded, so that the cost of a reference epoch scales
+   with the number of satellites instead of the size of RefEpoch. */
+{
+    memset(RefEpoch->SatCleared, 0, sizeof(RefEpoch->SatCleared));
+    memset(RefEpoch->M3SatDataCopy, 0, sizeof(RefEpoch->M3SatDataCopy));
+}
 
-            /* keep reference measurement to decode the delta measurements */
-            if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
-            {
-                RefEpoch->SigIdx[SatSys][SatIdx][0]             = (uint8_t)MasterSigIdx;
-                RefEpoch->SlaveSigMask[SatSys][SatIdx]          = SlaveSigMask;
-                RefEpoch->PRRate_64mm_s[SatSys][SatIdx]         = PRRate_64mm_s;
-                RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx] = MeasSetMaster;
-            }
 
-            if (MeasSetMaster.PLLTimer_ms > RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx].PLLTimer_ms)
-            {
-                RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx].PLLTimer_ms = MeasSetMaster.PLLTimer_ms;
-            }
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_PrepareRefSat(sbfread_Meas3_RefEpoch_t* RefEpoch,
+                                        Meas3SatSystem_t SatSys,
+                                        uint32_t         SatIdx)
+/* clears the reference epoch data of a satellite if this was not yet
+   done since the last sbfread_Meas3_ResetRefEpoch() */
+{
+    if ((RefEpoch->SatCleared[SatSys] & (1ULL << SatIdx)) == 0)
+    {
+        memset(RefEpoch->SigIdx[SatSys][SatIdx], 0, sizeof(RefEpoch->SigIdx[SatSys][SatIdx]));
+        memset(RefEpoch->MeasSet[SatSys][SatIdx], 0, sizeof(RefEpoch->MeasSet[SatSys][SatIdx]));
+        RefEpoch->SlaveSigMask[SatSys][SatIdx]  = 0;
+        RefEpoch->PRRate_64mm_s[SatSys][SatIdx] = 0;
 
-            sbfread_Meas3_AddMasterDoppler(&MeasSetMaster, sbfMeas3Doppler,
-                                           sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, MasterSigIdx, GLOfn),
-                                           RefEpoch->PRRate_64mm_s[SatSys][SatIdx],
-                                           DopplerIdx);
+        RefEpoch->SatCleared[SatSys] |= 1ULL << SatIdx;
+    }
+}
 
-            sbfread_Meas3_AddPPInfo(&MeasSetMaster, sbfMeas3PP, PP1Idx, PP2Idx);
-            sbfread_Meas3_AddMPInfo(&MeasSetMaster, sbfMeas3MP, MPIdx);
 
-            if (sbfMeas3CN0HiRes != NULL)
-            {
-                /* remember the HiRes adjustment, but do not apply it yet (as
-                   we need the unadjusted master meas to decode the slave
-                   meas */
-                CN0Master_HiRes_dBHz = (float)((sbfMeas3CN0HiRes->CN0HiRes[*CN0HiResIdx / 2] >> ((*CN0HiResIdx % 2) * 4)) & 0xf) * .0625F - 0.5F;
-                (*CN0HiResIdx)++;
-            }
+/*---------------------------------------------------------------------------*/
+static uint32_t
+sbfread_Meas3_SkipConstellation(const uint8_t* buf,
+                                const Meas3CN0HiRes_1_t* sbfMeas3CN0HiRes,
+                                uint32_t*      CN0HiResIdx,
+                                const Meas3Doppler_1_t* sbfMeas3Doppler,
+                                uint32_t*      DopplerIdx,
+                                const Meas3PP_1_t* sbfMeas3PP,
+                                uint32_t*      PP1Idx,
+                                uint32_t*      PP2Idx,
+                                const Meas3MP_1_t* sbfMeas3MP,
+                                uint32_t*      MPIdx,
+                                Meas3SatSystem_t  SatSys,
+                                uint32_t       TOW_ms,
+                                sbfread_Meas3_RefEpoch_t* RefEpoch,
+                                uint32_t       RefInterval_ms,
+                                bool           RefEpochContainsPRRate)
+/* goes over the data of a constellation that is not selected in the
+   decode mask without decoding the measurements.  Only the sizes of
+   the sub-blocks and the slave signal masks of the reference epoch
+   are extracted.  Returns the size of the constellation data in the
+   Meas3Ranges block, or 0 if the data is invalid. */
+{
+    const uint8_t* start = buf;
+    const uint8_t* SatDataBuf;
+    uint32_t N;
+    uint64_t SatMask;
+    uint64_t SatBits;
+    uint32_t SigIdxMasterShort;
+    uint16_t BDSLongRange;
+    uint8_t  SigExcluded;
+    uint8_t  GLOFnList[32];
 
-            /* decode all slave data */
-            for (SigIdx = 1; SigIdx < MEAS3_SIG_MAX && SlaveSigMask != 0; SigIdx++)
-            {
-                if ((SlaveSigMask & (1 << SigIdx)) != 0)
-                {
-                    MeasSet_t MeasSetSlave;
-
-                    buf += sbfread_Meas3_DecodeSlave(buf,
-                                                     Meas3SigIdx2SignalType,
-                                                     SatSys,
-                                                     SigIdx,
-                                                     GLOfn,
-                                                     &MeasSetSlave,
-                                                     &MeasSetMaster,
-                                                     MasterSigIdx,
-                                                     &(RefEpoch->MeasSet[SatSys][SatIdx][RefEpoch->SigIdx[SatSys][SatIdx][0]]),
-                                                     &(RefEpoch->MeasSet[SatSys][SatIdx][RefEpoch->SigIdx[SatSys][SatIdx][SlaveCnt + 1]]));
-
-                    sbfread_Meas3_AddSlaveDoppler(&MeasSetSlave, &MeasSetMaster, sbfMeas3Doppler,
-                                                  sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, MasterSigIdx, GLOfn),
-                                                  sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, SigIdx, GLOfn),
-                                                  DopplerIdx);
-
-                    sbfread_Meas3_AddPPInfo(&MeasSetSlave, sbfMeas3PP, PP1Idx, PP2Idx);
-                    sbfread_Meas3_AddMPInfo(&MeasSetSlave, sbfMeas3MP, MPIdx);
-
-                    /* keep reference measurement to decode the delta measurements */
-                    if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
-                    {
-                        RefEpoch->SigIdx[SatSys][SatIdx][SlaveCnt + 1] = (uint8_t)SigIdx;
-                        RefEpoch->MeasSet[SatSys][SatIdx][SigIdx]    = MeasSetSlave;
-                    }
+    SatDataBuf = (*buf == 0) ? RefEpoch->M3SatDataCopy[SatSys] : buf;
 
-                    if (MeasSetSlave.PLLTimer_ms > RefEpoch->MeasSet[SatSys][SatIdx][SigIdx].PLLTimer_ms)
-                    {
-                        RefEpoch->MeasSet[SatSys][SatIdx][SigIdx].PLLTimer_ms = MeasSetSlave.PLLTimer_ms;
-                    }
+    N = sbfread_Meas3_ReadSatData(SatDataBuf, SatSys, &SatMask, &SigIdxMasterShort,
+                                  GLOFnList, &BDSLongRange, &SigExcluded);
 
-                    if (sbfMeas3CN0HiRes != NULL)
-                    {
-                        MeasSetSlave.CN0_dBHz += ((sbfMeas3CN0HiRes->CN0HiRes[*CN0HiResIdx / 2] >> ((*CN0HiResIdx % 2) * 4)) & 0xf) * .0625F - 0.5F;
-                        (*CN0HiResIdx)++;
-                    }
+    buf += (*buf == 0) ? 1 : N;
 
-                    if (SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE)
-                    {
-                        MeasChannel->measSet[AntIdx][SigIdx] = MeasSetSlave;
-                    }
+    if (TOW_ms % RefInterval_ms == 0)
+    {
+        memcpy(RefEpoch->M3SatDataCopy[SatSys], start, N);
+    }
 
-                    SlaveCnt++;
+    for (SatBits = SatMask; SatBits != 0; SatBits &= SatBits - 1)
+    {
+        uint32_t SatIdx = lsbpos(SatBits);
+        uint32_t SlaveSigMask;
+        uint32_t SlaveBits;
 
-                    /* delete this bit of the mask */
-                    SlaveSigMask ^= (1 << SigIdx);
-                }
-            }
+        sbfread_Meas3_PrepareRefSat(RefEpoch, SatSys, SatIdx);
 
-            /* now it is time to apply the C/N0 adjustment and to store the master MeasSet*/
-            MeasSetMaster.CN0_dBHz += CN0Master_HiRes_dBHz;
+        if ((*buf & 1) == 1)
+        {
+            /*MasterShort*/
+            SlaveSigMask = ((sbfread_LoadU32(buf) >> 28) & 0xf) << (SigIdxMasterShort + 1);
+            buf += RefEpochContainsPRRate ? 10 : 8;
+        }
+        else if ((*buf & 3) == 0)
+        {
+            /*MasterLong*/
+            uint16_t BF2     = sbfread_LoadU16(buf + 8);
+            uint32_t SigMask = (BF2 >> 6) & 0x1ff;
+            uint32_t Cont    = (BF2 >> 15) & 0x1;
 
-            if (MasterSigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE)
+            if (Cont != 0)
             {
-                MeasChannel->measSet[AntIdx][MasterSigIdx] = MeasSetMaster;
+                SigMask |= (uint32_t)(*(buf + 10) & 0x7f) << 9;
             }
 
-            SatCnt++;
-
-            /* when decoding files containing signals not known yet, the signal
-               type of those unknown signals is set to "SIG_LAST". In that case,
-               it is safer to invalidate the whole measurement set. */
-            for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+            if (SigMask == 0)
             {
-                if (MeasChannel->measSet[AntIdx][SigIdx].signalType >= SIG_LAST)
-                {
-                    MeasChannel->measSet[AntIdx][SigIdx].flags = 0;
-                }
+                return 0;
             }
+
+            SlaveSigMask = SigMask & (SigMask - 1);
+            buf += (RefEpochContainsPRRate ? 12 : 10) + Cont;
+        }
+        else
+        {
+            /*MasterDeltaL or MasterDeltaS*/
+            SlaveSigMask = RefEpoch->SlaveSigMask[SatSys][SatIdx];
+            buf += ((*buf & 0xc) == 0xc) ? 5 : 4;
+        }
+
+        if (TOW_ms % RefInterval_ms == 0)
+        {
+            RefEpoch->SlaveSigMask[SatSys][SatIdx] = SlaveSigMask;
+        }
+
+        sbfread_Meas3_SkipMeasInfo(sbfMeas3CN0HiRes, CN0HiResIdx, sbfMeas3Doppler, DopplerIdx,
+                                   sbfMeas3PP, PP1Idx, PP2Idx, sbfMeas3MP, MPIdx);
+
+        for (SlaveBits = SlaveSigMask & ((1UL << MEAS3_SIG_MAX) - 2); SlaveBits != 0; SlaveBits &= SlaveBits - 1)
+        {
+            buf += sbfread_Meas3_GetSlaveSize(buf);
+
+            sbfread_Meas3_SkipMeasInfo(sbfMeas3CN0HiRes, CN0HiResIdx, sbfMeas3Doppler, DopplerIdx,
+                                       sbfMeas3PP, PP1Idx, PP2Idx, sbfMeas3MP, MPIdx);
         }
     }
 
     return (uint32_t)(buf - start);
-
-EXIT_INVALIDFORMAT:
-    return (uint32_t)0;
 }
 
 
 /*---------------------------------------------------------------------------*/
-static void
-sbfread_Meas3_Decode(
-    const Meas3Ranges_1_t    Meas3Ranges[NR_OF_ANTENNAS],
-    const Meas3Doppler_1_t   Meas3Doppler[NR_OF_ANTENNAS],
-    const Meas3CN0HiRes_1_t  Meas3CN0HiRes[NR_OF_ANTENNAS],
-    const Meas3PP_1_t        Meas3PP[NR_OF_ANTENNAS],
-    const Meas3MP_1_t        Meas3MP[NR_OF_ANTENNAS],
-    sbfread_Meas3_RefEpoch_t RefEpoch[NR_OF_ANTENNAS],
-    MeasEpoch_t*             MeasEpoch
+static uint32_t
+sbfread_Meas3_DecodeConstellation(const uint8_t* buf,
+                                  const Meas3CN0HiRes_1_t* sbfMeas3CN0HiRes,
+                                  uint32_t*      CN0HiResIdx,
+                                  const Meas3Doppler_1_t* sbfMeas3Doppler,
+                                  uint32_t*      DopplerIdx,
+                                  const Meas3PP_1_t* sbfMeas3PP,
+                                  uint32_t*      PP1Idx,
+                                  uint32_t*      PP2Idx,
+                                  const Meas3MP_1_t* sbfMeas3MP,
+                                  uint32_t*      MPIdx,
+                                  uint32_t       AntIdx,
+                                  Meas3SatSystem_t  SatSys,
+                                  MeasEpoch_t*   MeasEpoch,
+                                  sbfread_ChannelIndex_t* ChannelIndex,
+                                  sbfread_Meas3_SigTable_t* SigTable,
+                                  const sbfread_DecodeMask_t* Mask,
+                                  sbfread_Meas3Counters_t* Counters,
+                                  sbfread_Meas3_RefEpoch_t* RefEpoch,
+                                  uint32_t       RefInterval_ms,
+                                  bool           RefEpochContainsPRRate
 #if SSN_FEATURE_SBF_SCRAMBLING
-    , SBFDecrypt_t*           decrypt
+                                  , decrypt_ctx_t* decryptctx
 #endif
-)
+                                 )
 {
-    uint32_t AntIdx;
+    const uint8_t* start = buf;
+    const uint8_t* SatDataBuf;
+    uint32_t SigIdx;
+    uint32_t N;
+    uint64_t SatMask;
+    uint64_t SatBits;
+    uint16_t BDSLongRange;
+    uint32_t SigIdxMasterShort;
+    uint8_t  SigExcluded;
+    uint32_t SatCnt = 0;
+    uint8_t  GLOFnList[32];
 
-    /* First initialize all to 0 */
-    memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+    SignalType_t (*Meas3SigIdx2SignalType)[MEAS3_SIG_MAX] = SigTable->SigIdx2SignalType;
 
-    /* decode the measurements from all antennas */
-    for (AntIdx = 0; (int)AntIdx < NR_OF_ANTENNAS; AntIdx++)
+    /* signal types to store in MeasEpoch */
+    uint64_t SignalTypes = (Mask->Constellations & (1UL << SatSys)) != 0 ? Mask->SignalTypes : 0;
+
+    /* if first byte of M3SatData is zero, copy the M3SatData from the
+       reference epoch */
+    if (*buf == 0)
     {
-        const Meas3Ranges_1_t*   ThisMeas3Ranges   = Meas3Ranges[AntIdx].Header.ID != 0 ? Meas3Ranges + AntIdx : NULL;
-        const Meas3Doppler_1_t*  ThisMeas3Doppler  = Meas3Doppler[AntIdx].Header.ID != 0 ? Meas3Doppler + AntIdx : NULL;
-        const Meas3CN0HiRes_1_t* ThisMeas3CN0HiRes = Meas3CN0HiRes[AntIdx].Header.ID != 0 ? Meas3CN0HiRes + AntIdx : NULL;
-        const Meas3PP_1_t*       ThisMeas3PP       = Meas3PP[AntIdx].Header.ID != 0 ? Meas3PP + AntIdx : NULL;
-        const Meas3MP_1_t*       ThisMeas3MP       = Meas3MP[AntIdx].Header.ID != 0 ? Meas3MP + AntIdx : NULL;
-
-        /* at least the Meas3ranges block must be available, as this is
-           the master meas3 block */
-        if (ThisMeas3Ranges != NULL)
-        {
-            const uint8_t* buf;
-            uint32_t SatSys;
-            uint32_t CN0HiResIdx = 0;
-            uint32_t DopplerIdx = 0;
-            uint32_t PP1Idx = 0;
-            uint32_t PP2Idx = 0;
-            uint32_t MPIdx = 0;
-            uint32_t RefEpochInterval_ms;
+        SatDataBuf = RefEpoch->M3SatDataCopy[SatSys];
+    }
+    else
+    {
+        SatDataBuf = buf;
+    }
 
-#if SSN_FEATURE_SBF_SCRAMBLING
-            decrypt_ctx_t decryptctx;
-            bool          ApplyDescrambling = DecryptMeas3Init(&decryptctx, ThisMeas3Ranges, decrypt);
-#endif
+    N = sbfread_Meas3_ReadSatData(SatDataBuf, SatSys, &SatMask, &SigIdxMasterShort,
+                                  GLOFnList, &BDSLongRange, &SigExcluded);
 
-            /* decode the reference epoch interval */
-            if ((ThisMeas3Ranges->Misc >> 4) == 0)
-            {
-                RefEpochInterval_ms =     1;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 1)
-            {
-                RefEpochInterval_ms =   500;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 2)
-            {
-                RefEpochInterval_ms =  1000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 3)
-            {
-                RefEpochInterval_ms =  2000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 4)
-            {
-                RefEpochInterval_ms =  5000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 5)
-            {
-                RefEpochInterval_ms = 10000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 6)
-            {
-                RefEpochInterval_ms = 15000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 7)
-            {
-                RefEpochInterval_ms = 30000;
-            }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 8)
+    /* go to the first M3Master subblock */
+    if (*buf == 0)
+    {
+        buf += 1;
+    }
+    else
+    {
+        buf += N;
+    }
+
+    /* if this is a reference epoch, remember this M3SatData */
+    if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
+    {
+        memcpy(RefEpoch->M3SatDataCopy[SatSys], start, N);
+    }
+
+    sbfread_PrepareSigTable(SigTable, SatSys, SigExcluded);
+
+    /* decode all sats from this constellation, going through the bits
+       set in SatMask */
+    for (SatBits = SatMask; SatBits != 0; SatBits &= SatBits - 1)
+    {
+        uint32_t           SatIdx = lsbpos(SatBits);
+        MeasSet_t          MeasSetMaster;
+        uint32_t           MasterSigIdx;
+        uint32_t           SlaveSigMask = 0;
+        uint32_t           SlaveBits;
+        int16_t            PRRate_64mm_s = 0;
+        int                GLOfn = (int)((GLOFnList[SatCnt / 2] >> (4 * (SatCnt % 2))) & 0xf) - 8;
+        float              CN0Master_HiRes_dBHz = 0.0F;
+        int                SlaveCnt = 0;
+        uint32_t           MasterSize;
+        MeasChannel_t*     MeasChannel = NULL;
+
+        sbfread_Meas3_PrepareRefSat(RefEpoch, SatSys, SatIdx);
+
+        /* with a signal selection, the satellite only gets a channel
+           in MeasEpoch when one of its signals is stored */
+        if (SignalTypes == ~(uint64_t)0)
+        {
+            MeasChannel = sbfread_Meas3_GetMeasChannel(MeasEpoch, ChannelIndex, SatSys, SatIdx, GLOfn);
+        }
+
+        /* there is always at least a master measurement set available for each satellite.  Decode it now */
+        MasterSize = sbfread_Meas3_DecodeMaster(buf,
+                                                Meas3SigIdx2SignalType,
+                                                SatSys,
+                                                SatIdx,
+                                                GLOfn,
+                                                (BDSLongRange & (1 << SatCnt)) != 0 ? 34e6 : PRBase_m[SatSys],
+                                                SigIdxMasterShort,
+                                                RefEpoch,
+                                                MeasEpoch->TOW_ms % RefInterval_ms,
+                                                &MeasSetMaster,
+                                                &MasterSigIdx,
+                                                &SlaveSigMask,
+                                                RefEpochContainsPRRate,
+                                                &PRRate_64mm_s,
+                                                Counters
+#if SSN_FEATURE_SBF_SCRAMBLING
+                                                , decryptctx
+#endif
+                                               );
+
+        if (MasterSize == 0)
+        {
+            goto EXIT_INVALIDFORMAT;
+        }
+
+        buf += MasterSize;
+
+        /* keep reference measurement to decode the delta measurements */
+        if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
+        {
+            RefEpoch->SigIdx[SatSys][SatIdx][0]             = (uint8_t)MasterSigIdx;
+            RefEpoch->SlaveSigMask[SatSys][SatIdx]          = SlaveSigMask;
+            RefEpoch->PRRate_64mm_s[SatSys][SatIdx]         = PRRate_64mm_s;
+            RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx] = MeasSetMaster;
+        }
+
+        if (MeasSetMaster.PLLTimer_ms > RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx].PLLTimer_ms)
+        {
+            RefEpoch->MeasSet[SatSys][SatIdx][MasterSigIdx].PLLTimer_ms = MeasSetMaster.PLLTimer_ms;
+        }
+
+        sbfread_Meas3_AddMasterDoppler(&MeasSetMaster, sbfMeas3Doppler,
+                                       sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, MasterSigIdx, GLOfn),
+                                       RefEpoch->PRRate_64mm_s[SatSys][SatIdx],
+                                       DopplerIdx);
+
+        sbfread_Meas3_AddPPInfo(&MeasSetMaster, sbfMeas3PP, PP1Idx, PP2Idx);
+        sbfread_Meas3_AddMPInfo(&MeasSetMaster, sbfMeas3MP, MPIdx);
+
+        if (sbfMeas3CN0HiRes != NULL)
+        {
+            /* remember the HiRes adjustment, but do not apply it yet (as
+               we need the unadjusted master meas to decode the slave
+               meas */
+            CN0Master_HiRes_dBHz = (float)((sbfMeas3CN0HiRes->CN0HiRes[*CN0HiResIdx / 2] >> ((*CN0HiResIdx % 2) * 4)) & 0xf) * .0625F - 0.5F;
+            (*CN0HiResIdx)++;
+        }
+
+        /* decode all slave data, going through the bits set in the
+           slave signal mask (signal indexes 1 to MEAS3_SIG_MAX-1) */
+        for (SlaveBits = SlaveSigMask & ((1UL << MEAS3_SIG_MAX) - 2); SlaveBits != 0; SlaveBits &= SlaveBits - 1)
+        {
+            MeasSet_t MeasSetSlave;
+
+            SigIdx = lsbpos(SlaveBits);
+
+            /* signals that are not selected in the decode mask are
+               skipped, as they are never used as reference for the
+               other signals */
+            if ((SignalTypes & (1ULL << sbfread_Meas3_SigIdx2SignalType(Meas3SigIdx2SignalType, SatSys, SigIdx))) == 0)
             {
-                RefEpochInterval_ms = 60000;
+                buf += sbfread_Meas3_GetSlaveSize(buf);
+
+                sbfread_Meas3_SkipMeasInfo(sbfMeas3CN0HiRes, CN0HiResIdx, sbfMeas3Doppler, DopplerIdx,
+                                           sbfMeas3PP, PP1Idx, PP2Idx, sbfMeas3MP, MPIdx);
+                SlaveCnt++;
+                continue;
             }
-            else if ((ThisMeas3Ranges->Misc >> 4) == 9)
+
+            buf += sbfread_Meas3_DecodeSlave(buf,
+                                             Meas3SigIdx2SignalType,
+                                             SatSys,
+                                             SigIdx,
+                                             GLOfn,
+                                             &MeasSetSlave,
+                                             &MeasSetMaster,
+                                             MasterSigIdx,
+                                             &(RefEpoch->MeasSet[SatSys][SatIdx][RefEpoch->SigIdx[SatSys][SatIdx][0]]),
+                                             &(RefEpoch->MeasSet[SatSys][SatIdx][RefEpoch->SigIdx[SatSys][SatIdx][SlaveCnt + 1]]),
+                                             Counters);
+
+            sbfread_Meas3_AddSlaveDoppler(&MeasSetSlave, &MeasSetMaster, sbfMeas3Doppler,
+                                          sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, MasterSigIdx, GLOfn),
+                                          sbfread_Meas3_GetWavelength_m(Meas3SigIdx2SignalType, SatSys, SigIdx, GLOfn),
+                                          DopplerIdx);
+
+            sbfread_Meas3_AddPPInfo(&MeasSetSlave, sbfMeas3PP, PP1Idx, PP2Idx);
+            sbfread_Meas3_AddMPInfo(&MeasSetSlave, sbfMeas3MP, MPIdx);
+
+            /* keep reference measurement to decode the delta measurements */
+            if (MeasEpoch->TOW_ms % RefInterval_ms == 0)
             {
-                RefEpochInterval_ms = 120000;
+                RefEpoch->SigIdx[SatSys][SatIdx][SlaveCnt + 1] = (uint8_t)SigIdx;
+                RefEpoch->MeasSet[SatSys][SatIdx][SigIdx]    = MeasSetSlave;
             }
-            else
+
+            if (MeasSetSlave.PLLTimer_ms > RefEpoch->MeasSet[SatSys][SatIdx][SigIdx].PLLTimer_ms)
             {
-                RefEpochInterval_ms =     1;
+                RefEpoch->MeasSet[SatSys][SatIdx][SigIdx].PLLTimer_ms = MeasSetSlave.PLLTimer_ms;
             }
 
-            if (ThisMeas3Ranges->CumClkJumps >= 128)
+            if (sbfMeas3CN0HiRes != NULL)
             {
-                MeasEpoch->totalClockJump_ms = (int32_t)ThisMeas3Ranges->CumClkJumps - 256;
+                MeasSetSlave.CN0_dBHz += ((sbfMeas3CN0HiRes->CN0HiRes[*CN0HiResIdx / 2] >> ((*CN0HiResIdx % 2) * 4)) & 0xf) * .0625F - 0.5F;
+                (*CN0HiResIdx)++;
             }
-            else
+
+            if (SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE)
             {
-                MeasEpoch->totalClockJump_ms = (int32_t)ThisMeas3Ranges->CumClkJumps;
+                if (MeasChannel == NULL)
+                {
+                    MeasChannel = sbfread_Meas3_GetMeasChannel(MeasEpoch, ChannelIndex, SatSys, SatIdx, GLOfn);
+                }
+
+                MeasChannel->measSet[AntIdx][SigIdx] = MeasSetSlave;
             }
 
-            /* set the time (TOW/WN) */
-            MeasEpoch->TOW_ms = ThisMeas3Ranges->TOW;
-            MeasEpoch->WNc    = ThisMeas3Ranges->WNc;
+            SlaveCnt++;
+        }
 
-            MeasEpoch->rxTOWStatus = RXTOWSTATUS_NOTSET;
+        /* now it is time to apply the C/N0 adjustment and to store the master MeasSet*/
+        MeasSetMaster.CN0_dBHz += CN0Master_HiRes_dBHz;
 
-            if (MeasEpoch->TOW_ms != U32_NOTVALID)
+        if (MasterSigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE &&
+            (SignalTypes & (1ULL << MeasSetMaster.signalType)) != 0)
+        {
+            if (MeasChannel == NULL)
             {
-                MeasEpoch->rxTOWStatus = RXTOWSTATUS_COARSE;
+                MeasChannel = sbfread_Meas3_GetMeasChannel(MeasEpoch, ChannelIndex, SatSys, SatIdx, GLOfn);
             }
 
-            if (MeasEpoch->WNc != U16_NOTVALID)
+            MeasChannel->measSet[AntIdx][MasterSigIdx] = MeasSetMaster;
+        }
+
+        SatCnt++;
+
+        /* when decoding files containing signals not known yet, the signal
+           type of those unknown signals is set to "SIG_LAST". In that case,
+           it is safer to invalidate the whole measurement set. */
+        if (MeasChannel != NULL)
+        {
+            for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
             {
-                MeasEpoch->rxTOWStatus = RXTOWSTATUS_PRECISE;
+                if (MeasChannel->measSet[AntIdx][SigIdx].signalType >= SIG_LAST)
+                {
+                    MeasChannel->measSet[AntIdx][SigIdx].flags = 0;
+                }
             }
+        }
+    }
 
-            MeasEpoch->dopplerVarFactor = DEFAULT_DOPPLER_VARIANCE_FACTOR;
+    return (uint32_t)(buf - start);
 
-            /* Copying bits of common flags; some occupy same positions in
-               SBF and in MeasEpoch_t, others don't */
-            MeasEpoch->commonFlags = 0;
+EXIT_INVALIDFORMAT:
+    return (uint32_t)0;
+}
 
-            /* Bit 0 : multipath mitigation */
-            if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_MULTIPATHMITIGATION) != 0)
-            {
-                MeasEpoch->commonFlags |=  COMMONFLAG_MULTIPATHMITIGATION;
-            }
 
-            /* Bit 1 : code smoothing */
-            if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_ATLEASTONESMOOTHING) != 0)
-            {
-                MeasEpoch->commonFlags |=  COMMONFLAG_ATLEASTONESMOOTHING;
-            }
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfread_Meas3_GetRefInterval_ms(const Meas3Ranges_1_t* sbfMeas3Ranges)
+/* decodes the reference epoch interval from the Misc field */
+{
+    static const uint32_t RefInterval_ms[16] =
+    {
+        1, 500, 1000, 2000, 5000, 10000, 15000, 30000, 60000, 120000,
+        1, 1, 1, 1, 1, 1
+    };
 
-            /* Bit 3 : clock steering */
-            if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_CLOCKSTEERINGACTIVE) != 0)
-            {
-                MeasEpoch->commonFlags |=  COMMONFLAG_CLOCKSTEERINGACTIVE;
-            }
+    return RefInterval_ms[sbfMeas3Ranges->Misc >> 4];
+}
 
-            /* Bit 5 : high-dynamics mode */
-            if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_HIGHDYNAMICSMODE) != 0)
-            {
-                MeasEpoch->commonFlags |=  COMMONFLAG_HIGHDYNAMICSMODE;
-            }
 
-            /* Bit 6 : E6B used */
-            if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_E6BUSED) != 0)
-            {
-                MeasEpoch->commonFlags |=  COMMONFLAG_E6CENCRYPTED;
-            }
+/*---------------------------------------------------------------------------*/
+static bool
+sbfread_Meas3_DecodeAntenna(
+    const Meas3Ranges_1_t*   ThisMeas3Ranges,
+    const Meas3Doppler_1_t*  ThisMeas3Doppler,
+    const Meas3CN0HiRes_1_t* ThisMeas3CN0HiRes,
+    const Meas3PP_1_t*       ThisMeas3PP,
+    const Meas3MP_1_t*       ThisMeas3MP,
+    uint32_t                 AntIdx,
+    sbfread_Meas3_RefEpoch_t* RefEpoch,
+    MeasEpoch_t*             MeasEpoch,
+    sbfread_ChannelIndex_t*  ChannelIndex,
+    sbfread_Meas3_SigTable_t* SigTable,
+    const sbfread_DecodeMask_t* Mask,
+    sbfread_Meas3Counters_t* Counters
+#if SSN_FEATURE_SBF_SCRAMBLING
+    , SBFDecrypt_t*           decrypt
+#endif
+)
+/* decodes the Meas3 blocks of antenna AntIdx into MeasEpoch, using
+   and updating the reference epoch of that antenna.  Returns false if
+   the data is invalid. */
+{
+    const uint8_t* buf;
+    uint32_t SatSys;
+    uint32_t CN0HiResIdx = 0;
+    uint32_t DopplerIdx = 0;
+    uint32_t PP1Idx = 0;
+    uint32_t PP2Idx = 0;
+    uint32_t MPIdx = 0;
+    uint32_t RefEpochInterval_ms;
+
+#if SSN_FEATURE_SBF_SCRAMBLING
+    decrypt_ctx_t decryptctx;
+    bool          ApplyDescrambling = DecryptMeas3Init(&decryptctx, ThisMeas3Ranges, decrypt);
+#endif
+
+    RefEpochInterval_ms = sbfread_Meas3_GetRefInterval_ms(ThisMeas3Ranges);
+
+    if (ThisMeas3Ranges->CumClkJumps >= 128)
+    {
+        MeasEpoch->totalClockJump_ms = (int32_t)ThisMeas3Ranges->CumClkJumps - 256;
+    }
+    else
+    {
+        MeasEpoch->totalClockJump_ms = (int32_t)ThisMeas3Ranges->CumClkJumps;
+    }
+
+    /* set the time (TOW/WN) */
+    MeasEpoch->TOW_ms = ThisMeas3Ranges->TOW;
+    MeasEpoch->WNc    = ThisMeas3Ranges->WNc;
+
+    MeasEpoch->rxTOWStatus = RXTOWSTATUS_NOTSET;
 
-            /* Reserved field is a version indication.  This decoder is
-               compatible with versions < 32. */
-            if (ThisMeas3Ranges->Reserved > 31)
+    if (MeasEpoch->TOW_ms != U32_NOTVALID)
+    {
+        MeasEpoch->rxTOWStatus = RXTOWSTATUS_COARSE;
+    }
+
+    if (MeasEpoch->WNc != U16_NOTVALID)
+    {
+        MeasEpoch->rxTOWStatus = RXTOWSTATUS_PRECISE;
+    }
+
+    MeasEpoch->dopplerVarFactor = DEFAULT_DOPPLER_VARIANCE_FACTOR;
+
+    /* Copying bits of common flags; some occupy same positions in
+       SBF and in MeasEpoch_t, others don't */
+    MeasEpoch->commonFlags = 0;
+
+    /* Bit 0 : multipath mitigation */
+    if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_MULTIPATHMITIGATION) != 0)
+    {
+        MeasEpoch->commonFlags |=  COMMONFLAG_MULTIPATHMITIGATION;
+    }
+
+    /* Bit 1 : code smoothing */
+    if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_ATLEASTONESMOOTHING) != 0)
+    {
+        MeasEpoch->commonFlags |=  COMMONFLAG_ATLEASTONESMOOTHING;
+    }
+
+    /* Bit 3 : clock steering */
+    if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_CLOCKSTEERINGACTIVE) != 0)
+    {
+        MeasEpoch->commonFlags |=  COMMONFLAG_CLOCKSTEERINGACTIVE;
+    }
+
+    /* Bit 5 : high-dynamics mode */
+    if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_HIGHDYNAMICSMODE) != 0)
+    {
+        MeasEpoch->commonFlags |=  COMMONFLAG_HIGHDYNAMICSMODE;
+    }
+
+    /* Bit 6 : E6B used */
+    if ((ThisMeas3Ranges->CommonFlags & SBF_MEASEPOCH_2_COMMONFLAG_E6BUSED) != 0)
+    {
+        MeasEpoch->commonFlags |=  COMMONFLAG_E6CENCRYPTED;
+    }
+
+    /* Reserved field is a version indication.  This decoder is
+       compatible with versions < 32. */
+    if (ThisMeas3Ranges->Reserved > 31)
+    {
+        return false;
+    }
+
+    buf = &(ThisMeas3Ranges->Reserved) + 1;
+
+    /* skip the antennas that are not selected in the decode mask */
+    if ((Mask->Antennas & (1UL << AntIdx)) == 0)
+    {
+        return true;
+    }
+
+    /* if this is a reference epoch, clean up all past reference epoch
+       data for this antenna */
+    if ((MeasEpoch->TOW_ms % RefEpochInterval_ms) == 0)
+    {
+        sbfread_Meas3_ResetRefEpoch(RefEpoch);
+        RefEpoch->TOW_ms = MeasEpoch->TOW_ms;
+    }
+
+    /* only decode the data if this is a reference epoch, or if the
+       matching reference epoch is available */
+    if (((MeasEpoch->TOW_ms % RefEpochInterval_ms) == 0 ||
+         RefEpoch->TOW_ms == (MeasEpoch->TOW_ms / RefEpochInterval_ms)*RefEpochInterval_ms))
+    {
+        /* constellations that are not selected in the decode
+           mask are skipped, and decoding stops after the last
+           selected constellation */
+        uint32_t Selected = ThisMeas3Ranges->Constellations & Mask->Constellations;
+
+#if SSN_FEATURE_SBF_SCRAMBLING
+
+        /* descrambling has to go through all master measurements */
+        if (ApplyDescrambling)
+        {
+            Selected = ThisMeas3Ranges->Constellations;
+        }
+
+#endif
+
+        for (SatSys = MEAS3_SYS_GPS; SatSys < MEAS3_SYS_MAX && (Selected >> SatSys) != 0; SatSys++)
+        {
+            if ((ThisMeas3Ranges->Constellations & (1 << SatSys)) != 0)
             {
-                goto EXIT_INVALIDFORMAT;
+                uint32_t N;
+
+                if ((Selected & (1 << SatSys)) != 0)
+                {
+                    N = sbfread_Meas3_DecodeConstellation(buf,
+                                                          ThisMeas3CN0HiRes, &CN0HiResIdx,
+                                                          ThisMeas3Doppler, &DopplerIdx,
+                                                          ThisMeas3PP, &PP1Idx, &PP2Idx,
+                                                          ThisMeas3MP, &MPIdx,
+                                                          AntIdx, (Meas3SatSystem_t)SatSys, MeasEpoch, ChannelIndex, SigTable, Mask, Counters,
+                                                          RefEpoch,
+                                                          RefEpochInterval_ms,
+                                                          (ThisMeas3Ranges->Misc & 8) != 0 /* PRR availability */
+#if SSN_FEATURE_SBF_SCRAMBLING
+                                                          , ApplyDescrambling ? &decryptctx : NULL
+#endif
+                                                         );
+                }
+                else
+                {
+                    N = sbfread_Meas3_SkipConstellation(buf,
+                                                        ThisMeas3CN0HiRes, &CN0HiResIdx,
+                                                        ThisMeas3Doppler, &DopplerIdx,
+                                                        ThisMeas3PP, &PP1Idx, &PP2Idx,
+                                                        ThisMeas3MP, &MPIdx,
+                                                        (Meas3SatSystem_t)SatSys, MeasEpoch->TOW_ms,
+                                                        RefEpoch,
+                                                        RefEpochInterval_ms,
+                                                        (ThisMeas3Ranges->Misc & 8) != 0);
+                }
+
+                if (N == 0)
+                {
+                    return false;
+                }
+
+                buf += N;
+
             }
+        }
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void
+sbfread_Meas3_Decode(
+    Meas3Ranges_1_t* const   Meas3Ranges[NR_OF_ANTENNAS],
+    Meas3Doppler_1_t* const  Meas3Doppler[NR_OF_ANTENNAS],
+    Meas3CN0HiRes_1_t* const Meas3CN0HiRes[NR_OF_ANTENNAS],
+    Meas3PP_1_t* const       Meas3PP[NR_OF_ANTENNAS],
+    Meas3MP_1_t* const       Meas3MP[NR_OF_ANTENNAS],
+    sbfread_Meas3_RefEpoch_t RefEpoch[NR_OF_ANTENNAS],
+    MeasEpoch_t*             MeasEpoch,
+    sbfread_ChannelIndex_t*  ChannelIndex,
+    sbfread_Meas3_SigTable_t* SigTable,
+    const sbfread_DecodeMask_t* Mask,
+    sbfread_Meas3Counters_t* Counters
+#if SSN_FEATURE_SBF_SCRAMBLING
+    , SBFDecrypt_t*           decrypt
+#endif
+)
+{
+    uint32_t AntIdx;
+    bool     Valid = true;
+
+    /* First initialize all to 0 */
+    memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+    sbfread_ChannelIndex_Reset(ChannelIndex);
+
+    /* decode the measurements from all antennas.  At least the
+       Meas3Ranges block must be available, as this is the master
+       meas3 block.  The antennas following an invalid one are still
+       decoded, to update their reference epoch as the parallel
+       decoding does. */
+    for (AntIdx = 0; (int)AntIdx < NR_OF_ANTENNAS; AntIdx++)
+    {
+        if (Meas3Ranges[AntIdx] != NULL &&
+            !sbfread_Meas3_DecodeAntenna(Meas3Ranges[AntIdx],
+                                         Meas3Doppler[AntIdx],
+                                         Meas3CN0HiRes[AntIdx],
+                                         Meas3PP[AntIdx],
+                                         Meas3MP[AntIdx],
+                                         AntIdx,
+                                         &(RefEpoch[AntIdx]),
+                                         MeasEpoch,
+                                         ChannelIndex,
+                                         SigTable,
+                                         Mask,
+                                         Counters
+#if SSN_FEATURE_SBF_SCRAMBLING
+                                         , decrypt
+#endif
+                                        ))
+        {
+            Valid = false;
+        }
+    }
+
+    if (!Valid)
+    {
+        /* something wrong, discard all data */
+        memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+    }
+}
+
 
-            buf = &(ThisMeas3Ranges->Reserved) + 1;
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_UpdateRefEpochs(SBFData_t*   SBFData,
+        MeasEpoch_t* MeasEpoch)
+/* called instead of decoding an epoch skipped by the decimation: only
+   the antennas for which this is a reference epoch are decoded, to
+   keep the reference data needed by the next delta epochs.  MeasEpoch
+   is only used as scratch buffer. */
+{
+    uint32_t AntIdx;
+    bool     Cleared = false;
+
+    for (AntIdx = 0; AntIdx < NR_OF_ANTENNAS; AntIdx++)
+    {
+        const Meas3Ranges_1_t* ThisMeas3Ranges = SBFData->Meas3Ranges[AntIdx];
 
-            /* if this is a reference epoch, clean up all past reference epoch
-               data for this antenna */
-            if ((MeasEpoch->TOW_ms % RefEpochInterval_ms) == 0)
+        if (ThisMeas3Ranges != NULL &&
+            ThisMeas3Ranges->TOW % sbfread_Meas3_GetRefInterval_ms(ThisMeas3Ranges) == 0)
+        {
+            if (!Cleared)
             {
-                memset(&(RefEpoch[AntIdx]), 0, sizeof(sbfread_Meas3_RefEpoch_t));
-                RefEpoch[AntIdx].TOW_ms = MeasEpoch->TOW_ms;
+                memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+                sbfread_ChannelIndex_Reset(&(SBFData->ChannelIndex));
+                Cleared = true;
             }
 
-            /* only decode the data if this is a reference epoch, or if the
-               matching reference epoch is available */
-            if (((MeasEpoch->TOW_ms % RefEpochInterval_ms) == 0 ||
-                 RefEpoch[AntIdx].TOW_ms == (MeasEpoch->TOW_ms / RefEpochInterval_ms)*RefEpochInterval_ms))
-            {
-                for (SatSys = MEAS3_SYS_GPS; SatSys < MEAS3_SYS_MAX; SatSys++)
-                {
-                    if ((ThisMeas3Ranges->Constellations & (1 << SatSys)) != 0)
-                    {
-                        uint32_t N;
-                        N = sbfread_Meas3_DecodeConstellation(buf,
-                                                              ThisMeas3CN0HiRes, &CN0HiResIdx,
-                                                              ThisMeas3Doppler, &DopplerIdx,
-                                                              ThisMeas3PP, &PP1Idx, &PP2Idx,
-                                                              ThisMeas3MP, &MPIdx,
-                                                              AntIdx, (Meas3SatSystem_t)SatSys, MeasEpoch,
-                                                              &(RefEpoch[AntIdx]),
-                                                              RefEpochInterval_ms,
-                                                              (ThisMeas3Ranges->Misc & 8) != 0 /* PRR availability */
+            (void)sbfread_Meas3_DecodeAntenna(ThisMeas3Ranges,
+                                              SBFData->Meas3Doppler[AntIdx],
+                                              SBFData->Meas3CN0HiRes[AntIdx],
+                                              SBFData->Meas3PP[AntIdx],
+                                              SBFData->Meas3MP[AntIdx],
+                                              AntIdx,
+                                              &(SBFData->RefEpoch[AntIdx]),
+                                              MeasEpoch,
+                                              &(SBFData->ChannelIndex),
+                                              &(SBFData->Meas3SigTable),
+                                              &(SBFData->DecodeMask),
+                                              &(SBFData->Meas3Counters)
 #if SSN_FEATURE_SBF_SCRAMBLING
-                                                              , ApplyDescrambling ? &decryptctx : NULL
+                                              , &(SBFData->decrypt)
 #endif
-                                                             );
+                                             );
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+/*--- PARALLEL DECODING OF THE ANTENNAS -------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+/* With SBFREAD_THREADS, the Meas3 blocks of the different antennas of
+   an epoch are decoded concurrently: antenna 0 by the calling thread,
+   directly into the output epoch, and each other antenna by its own
+   worker thread into a private epoch.  The private epochs are then
+   merged in antenna order, which gives the same channel order as
+   decoding the antennas one after the other. */
+#if SBFREAD_THREADS && NR_OF_ANTENNAS > 1 && !SSN_FEATURE_SBF_SCRAMBLING
+
+/* output of the worker decoding one antenna */
+typedef struct
+{
+    MeasEpoch_t              Epoch;
+    sbfread_ChannelIndex_t   ChannelIndex;
+    sbfread_Meas3_SigTable_t SigTable;
+    sbfread_Meas3Counters_t  Counters;
+    bool                     Active;  /* antenna present in this epoch */
+    bool                     Valid;   /* false if the data was invalid */
+} sbfread_Meas3AntennaOutput_t;
+
+struct sbfread_Meas3Parallel_s
+{
+    sbfread_Pool_t*              Pool;
+    SBFData_t*                   SBFData;  /* blocks and reference epochs */
+    sbfread_Meas3AntennaOutput_t Output[NR_OF_ANTENNAS - 1];
+};
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_ParallelJob(void* Arg, uint32_t WorkerIdx)
+/* decodes antenna WorkerIdx+1 into its private epoch */
+{
+    struct sbfread_Meas3Parallel_s* Parallel = (struct sbfread_Meas3Parallel_s*)Arg;
+    SBFData_t*                      SBFData  = Parallel->SBFData;
+    sbfread_Meas3AntennaOutput_t*   Output   = &(Parallel->Output[WorkerIdx]);
+    uint32_t                        AntIdx   = WorkerIdx + 1;
+
+    if (!Output->Active)
+    {
+        return;
+    }
+
+    /* only the channels used at the previous epoch need to be cleared */
+    memset(Output->Epoch.channelData, 0, Output->Epoch.nbrElements * sizeof(MeasChannel_t));
+    memset(&(Output->Epoch), 0, offsetof(MeasEpoch_t, channelData));
+    memset(&(Output->Counters), 0, sizeof(Output->Counters));
+    sbfread_ChannelIndex_Reset(&(Output->ChannelIndex));
+
+    Output->Valid = sbfread_Meas3_DecodeAntenna(SBFData->Meas3Ranges[AntIdx],
+                    SBFData->Meas3Doppler[AntIdx],
+                    SBFData->Meas3CN0HiRes[AntIdx],
+                    SBFData->Meas3PP[AntIdx],
+                    SBFData->Meas3MP[AntIdx],
+                    AntIdx,
+                    &(SBFData->RefEpoch[AntIdx]),
+                    &(Output->Epoch),
+                    &(Output->ChannelIndex),
+                    &(Output->SigTable),
+                    &(SBFData->DecodeMask),
+                    &(Output->Counters));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_MergeAntenna(MeasEpoch_t*            MeasEpoch,
+                                       sbfread_ChannelIndex_t* ChannelIndex,
+                                       const MeasEpoch_t*      AntennaEpoch,
+                                       uint32_t                AntIdx)
+/* adds the measurements of antenna AntIdx from AntennaEpoch into
+   MeasEpoch */
+{
+    uint32_t i;
+
+    /* as when decoding the antennas one after the other, the epoch
+       header comes from the last antenna */
+    MeasEpoch->TOW_ms            = AntennaEpoch->TOW_ms;
+    MeasEpoch->WNc               = AntennaEpoch->WNc;
+    MeasEpoch->rxTOWStatus       = AntennaEpoch->rxTOWStatus;
+    MeasEpoch->totalClockJump_ms = AntennaEpoch->totalClockJump_ms;
+    MeasEpoch->dopplerVarFactor  = AntennaEpoch->dopplerVarFactor;
+    MeasEpoch->commonFlags       = AntennaEpoch->commonFlags;
+
+    for (i = 0; i < AntennaEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* Src = &(AntennaEpoch->channelData[i]);
+        MeasChannel_t*       Dst = sbfread_GetMeasChannelByPRN(MeasEpoch, ChannelIndex, Src->PRN, Src->fnPlus8);
+
+        memcpy(Dst->measSet[AntIdx], Src->measSet[AntIdx], sizeof(Dst->measSet[AntIdx]));
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfread_Meas3_DecodeParallel(SBFData_t*   SBFData,
+        MeasEpoch_t* MeasEpoch)
+/* decodes the Meas3 blocks of the epoch with one thread per antenna.
+   Returns false, without decoding anything, if there are not several
+   antennas to decode or if no worker threads are available.  As in
+   the sequential decoding, the antennas following an invalid one
+   still update their reference epoch. */
+{
+    struct sbfread_Meas3Parallel_s* Parallel = SBFData->Meas3Parallel;
+    uint32_t AntIdx;
+    uint32_t NrOfAntennas = 0;
+    bool     Valid = true;
+
+    for (AntIdx = 0; AntIdx < NR_OF_ANTENNAS; AntIdx++)
+    {
+        if (SBFData->Meas3Ranges[AntIdx] != NULL &&
+            (SBFData->DecodeMask.Antennas & (1UL << AntIdx)) != 0)
+        {
+            NrOfAntennas++;
+        }
+    }
+
+    if (NrOfAntennas < 2 || SBFData->Meas3ParallelUnavailable)
+    {
+        return false;
+    }
+
+    if (Parallel == NULL)
+    {
+        Parallel = (struct sbfread_Meas3Parallel_s*)SBFREAD_MALLOC(sizeof(*Parallel));
+        SBFData->Mallocs++;
+
+        if (Parallel != NULL)
+        {
+            memset(Parallel, 0, sizeof(*Parallel));
+            Parallel->Pool = sbfread_Pool_Create(NR_OF_ANTENNAS - 1);
+        }
+
+        if (Parallel == NULL || Parallel->Pool == NULL)
+        {
+            SBFREAD_FREE(Parallel);
+            SBFData->Meas3ParallelUnavailable = true;
+            return false;
+        }
+
+        SBFData->Meas3Parallel = Parallel;
+    }
+
+    Parallel->SBFData = SBFData;
+
+    for (AntIdx = 1; AntIdx < NR_OF_ANTENNAS; AntIdx++)
+    {
+        Parallel->Output[AntIdx - 1].Active = (SBFData->Meas3Ranges[AntIdx] != NULL);
+    }
+
+    memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+    sbfread_ChannelIndex_Reset(&(SBFData->ChannelIndex));
+
+    sbfread_Pool_Start(Parallel->Pool, sbfread_Meas3_ParallelJob, Parallel);
+
+    if (SBFData->Meas3Ranges[0] != NULL)
+    {
+        Valid = sbfread_Meas3_DecodeAntenna(SBFData->Meas3Ranges[0],
+                                            SBFData->Meas3Doppler[0],
+                                            SBFData->Meas3CN0HiRes[0],
+                                            SBFData->Meas3PP[0],
+                                            SBFData->Meas3MP[0],
+                                            0,
+                                            &(SBFData->RefEpoch[0]),
+                                            MeasEpoch,
+                                            &(SBFData->ChannelIndex),
+                                            &(SBFData->Meas3SigTable),
+                                            &(SBFData->DecodeMask),
+                                            &(SBFData->Meas3Counters));
+    }
+
+    sbfread_Pool_Wait(Parallel->Pool);
+
+    for (AntIdx = 1; AntIdx < NR_OF_ANTENNAS && Valid; AntIdx++)
+    {
+        sbfread_Meas3AntennaOutput_t* Output = &(Parallel->Output[AntIdx - 1]);
+
+        if (Output->Active)
+        {
+            SBFData->Meas3Counters.MasterLong  += Output->Counters.MasterLong;
+            SBFData->Meas3Counters.MasterShort += Output->Counters.MasterShort;
+            SBFData->Meas3Counters.MasterDelta += Output->Counters.MasterDelta;
+            SBFData->Meas3Counters.SlaveLong   += Output->Counters.SlaveLong;
+            SBFData->Meas3Counters.SlaveShort  += Output->Counters.SlaveShort;
+            SBFData->Meas3Counters.SlaveDelta  += Output->Counters.SlaveDelta;
+
+            Valid = Output->Valid;
+
+            if (Valid)
+            {
+                sbfread_Meas3_MergeAntenna(MeasEpoch, &(SBFData->ChannelIndex), &(Output->Epoch), AntIdx);
+            }
+        }
+    }
+
+    if (!Valid)
+    {
+        /* something wrong, discard all data */
+        memset(MeasEpoch, 0, sizeof(*MeasEpoch));
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_ReleaseParallel(SBFData_t* SBFData)
+{
+    if (SBFData->Meas3Parallel != NULL)
+    {
+        sbfread_Pool_Destroy(SBFData->Meas3Parallel->Pool);
+        SBFREAD_FREE(SBFData->Meas3Parallel);
+        SBFData->Meas3Parallel = NULL;
+    }
+}
+
+#else
+
+/*---------------------------------------------------------------------------*/
+static bool sbfread_Meas3_DecodeParallel(SBFData_t*   SBFData,
+        MeasEpoch_t* MeasEpoch)
+{
+    (void)SBFData;
+    (void)MeasEpoch;
+
+    return false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_Meas3_ReleaseParallel(SBFData_t* SBFData)
+{
+    (void)SBFData;
+}
+
+#endif /* SBFREAD_THREADS */
+
+
+/*---------------------------------------------------------------------------*/
+MeasEpoch_t* sbfread_AllocMeasEpoch(SBFData_t* SBFData)
+{
+    return (MeasEpoch_t*)sbfread_ObjPool_Get(&(SBFData->MeasEpochPool));
+}
 
-                        if (N == 0)
-                        {
-                            goto EXIT_INVALIDFORMAT;
-                        }
 
-                        buf += N;
+/*---------------------------------------------------------------------------*/
+void sbfread_FreeMeasEpoch(SBFData_t*   SBFData,
+                           MeasEpoch_t* MeasEpoch)
+{
+    sbfread_ObjPool_Put(&(SBFData->MeasEpochPool), MeasEpoch);
+}
 
-                    }
-                }
-            }
-        }
-    }
 
-    return;
+/*---------------------------------------------------------------------------*/
+uint32_t sbfread_GetAllocationCount(const SBFData_t* SBFData)
+{
+    return SBFData->Mallocs + SBFData->MeasArena.Mallocs + SBFData->MeasEpochPool.Mallocs;
+}
 
-EXIT_INVALIDFORMAT:
-    /* something wrong, discard all data */
-    memset(MeasEpoch, 0, sizeof(*MeasEpoch));
 
+/*---------------------------------------------------------------------------*/
+void sbfread_ReleaseMeasDecoding(SBFData_t* SBFData)
+{
+    sbfread_Meas3_ReleaseParallel(SBFData);
+    sbfread_ObjPool_Release(&(SBFData->MeasEpochPool));
+    sbfread_Arena_Release(&(SBFData->MeasArena));
 }
 
 
@@ -1358,14 +2080,20 @@ static int32_t sbfread_ExtendSignBit(uint32_t x, uint32_t N)
 }
 
 
-static double  PR_Type1;
-static double  Doppler_Type1;
-static uint8_t Type2Cnt;
-static double  Wavelength1;
+/* the values of a type-1 sub-block which are needed to decode its
+   type-2 sub-blocks */
+typedef struct
+{
+    double  PR;          /* pseudorange in the type-1 sub-block */
+    double  Doppler;     /* Doppler in the type-1 sub-block */
+    double  Wavelength;  /* carrier wavelength of the type-1 signal */
+    uint8_t Type2Cnt;    /* number of type-2 sub-blocks decoded so far */
+} sbfread_Type1Obs_t;
 
 /*---------------------------------------------------------------------------*/
 static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
                             MeasEpochChannelType1_t* Type1SubBlock,
+                            sbfread_Type1Obs_t*      Type1Obs,
                             SignalType_t*            SignalType,
                             uint32_t*                AntIdx,
                             double*    PR,
@@ -1384,6 +2112,9 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
  *        MeasEpoch. The data will be extracted from this type-1
  *        sub-block.
  *
+ *  *Type1Obs:  filled with the type-1 values needed by
+ *        GetNextObsFromType2().
+ *
  *  *SignalType:the signal type of the type-1 sub-block
  *
  *  *AntIdx:    the antenna index (starting from 0 for the main antenna)
@@ -1423,7 +2154,7 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
     }
 
     /* compute the carrier wavelength */
-    Wavelength1 = GetWavelength_m(*SignalType, (int)(Type1SubBlock->ObsInfo >> 3) - 8);
+    Type1Obs->Wavelength = GetWavelength_m(*SignalType, (int)(Type1SubBlock->ObsInfo >> 3) - 8);
 
     /* pseudorange */
     if (((Type1SubBlock->Misc & 0xf) == 0) && (Type1SubBlock->CodeLSB == 0))
@@ -1435,7 +2166,7 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
         *PR = (Type1SubBlock->Misc & 0xf) * 4294967.296 + Type1SubBlock->CodeLSB * 0.001;
     }
 
-    PR_Type1 = *PR;
+    Type1Obs->PR = *PR;
 
     /* Doppler */
     if (Type1SubBlock->Doppler == (int32_t)0x80000000)
@@ -1447,7 +2178,7 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
         *Doppler    = Type1SubBlock->Doppler * 0.0001;
     }
 
-    Doppler_Type1 = *Doppler;
+    Type1Obs->Doppler = *Doppler;
 
     /* carrier phase */
     if ((Type1SubBlock->CarrierLSB == 0)  &&
@@ -1457,7 +2188,7 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
     }
     else
     {
-        *Carrier = *PR / Wavelength1
+        *Carrier = *PR / Type1Obs->Wavelength
                    + (Type1SubBlock->CarrierMSB * 65536 + Type1SubBlock->CarrierLSB) / 1000.0;
     }
 
@@ -1492,13 +2223,14 @@ static void GetObsFromType1(MeasEpoch_2_t*           MeasEpoch,
     *HCF = ((SBF_ID_TO_NUMBER(MeasEpoch->Header.ID) == sbfnr_MeasEpoch_2) &&
             ((Type1SubBlock->ObsInfo & 4) != 0));
 
-    Type2Cnt = 0;
+    Type1Obs->Type2Cnt = 0;
 }
 
 
 /*---------------------------------------------------------------------------*/
 static void GetNextObsFromType2(MeasEpoch_2_t*           MeasEpoch,
                                 MeasEpochChannelType1_t* Type1SubBlock,
+                                sbfread_Type1Obs_t*      Type1Obs,
                                 SignalType_t*            SignalType,
                                 uint32_t*                AntIdx,
                                 double*    PR,
@@ -1518,6 +2250,9 @@ static void GetNextObsFromType2(MeasEpoch_2_t*           MeasEpoch,
  *        MeasEpoch. The data will be extracted from one of the type-2
  *        sub-blocks depending on this type-1 sub-block.
  *
+ *  *Type1Obs:  the values set by GetObsFromType1() for the same
+ *        type-1 sub-block.
+ *
  *  *SignalType:the signal type of the type-1 sub-block
  *
  *  *AntIdx:    the antenna index (starting from 0 for the main antenna)
@@ -1537,19 +2272,19 @@ static void GetNextObsFromType2(MeasEpoch_2_t*           MeasEpoch,
  */
 {
     /* if there are still type-2 sub-blocks to read, proceed*/
-    if (Type2Cnt < Type1SubBlock->N_Type2)
+    if (Type1Obs->Type2Cnt < Type1SubBlock->N_Type2)
     {
         MeasEpochChannelType2_t* Type2SubBlock
             = (MeasEpochChannelType2_t*)
               ((uint8_t*)Type1SubBlock
-               + MeasEpoch->SB1Size + Type2Cnt * MeasEpoch->SB2Size);
+               + MeasEpoch->SB1Size + Type1Obs->Type2Cnt * MeasEpoch->SB2Size);
         double Wavelength2;
         int32_t CodeOffsetMSB
             = sbfread_ExtendSignBit(Type2SubBlock->OffsetsMSB, 3);
         int32_t  DopplerOffsetMSB
             = sbfread_ExtendSignBit(Type2SubBlock->OffsetsMSB >> 3, 5);
 
-        Type2Cnt++;
+        Type1Obs->Type2Cnt++;
 
         *AntIdx = Type2SubBlock->Type >> 5;
 
@@ -1572,7 +2307,7 @@ static void GetNextObsFromType2(MeasEpoch_2_t*           MeasEpoch,
         }
         else
         {
-            *PR = PR_Type1 + (CodeOffsetMSB * 65536 + Type2SubBlock->CodeOffsetLSB) * 1e-3;
+            *PR = Type1Obs->PR + (CodeOffsetMSB * 65536 + Type2SubBlock->CodeOffsetLSB) * 1e-3;
         }
 
         /* carrier phase */
@@ -1596,7 +2331,7 @@ static void GetNextObsFromType2(MeasEpoch_2_t*           MeasEpoch,
         else
         {
             *Doppler =
-                Doppler_Type1 * Wavelength1 / Wavelength2
+                Type1Obs->Doppler * Type1Obs->Wavelength / Wavelength2
                 + (DopplerOffsetMSB * 65536 + Type2SubBlock->DopplerOffsetLSB) * 0.0001;
         }
 
@@ -1768,16 +2503,92 @@ static bool sbfread_AddMeasSet(MeasChannel_t* trackChan,
 
 
 /*---------------------------------------------------------------------------*/
-void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
-                              MeasEpoch_t*         trackMeasEpoch)
+static uint32_t sbfread_GetConstellationBit(uint32_t PRN)
+/* returns the bit of the constellation of a satellite in the
+   Constellations field of sbfread_DecodeMask_t (bit MEAS3_SYS_MAX
+   for the satellites not covered by Meas3, like L-band beams) */
+{
+    uint32_t SatSys;
+
+    if (agIsGPS(PRN))
+    {
+        SatSys = MEAS3_SYS_GPS;
+    }
+    else if (agIsGLONASS(PRN))
+    {
+        SatSys = MEAS3_SYS_GLO;
+    }
+    else if (agIsGAL(PRN))
+    {
+        SatSys = MEAS3_SYS_GAL;
+    }
+    else if (agIsCOMPASS(PRN))
+    {
+        SatSys = MEAS3_SYS_BDS;
+    }
+    else if (agIsRA(PRN))
+    {
+        SatSys = MEAS3_SYS_SBAS;
+    }
+    else if (agIsQZSS(PRN))
+    {
+        SatSys = MEAS3_SYS_QZS;
+    }
+    else if (agIsIRNSS(PRN))
+    {
+        SatSys = MEAS3_SYS_IRN;
+    }
+    else
+    {
+        SatSys = MEAS3_SYS_MAX;
+    }
+
+    return 1UL << SatSys;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfread_IsMeasSetSelected(const sbfread_DecodeMask_t* Mask,
+                                      SignalType_t SignalType,
+                                      uint32_t     AntIdx)
+/* returns true if the signal type and antenna are selected in Mask */
+{
+    return ((Mask->SignalTypes & (1ULL << SignalType)) != 0 &&
+            AntIdx < 32 && (Mask->Antennas & (1UL << AntIdx)) != 0);
+}
+
+
+/* decode mask used when no mask is given: everything is decoded */
+static const sbfread_DecodeMask_t sbfread_DecodeMask_All =
+{
+    0xffffffffUL, 0xffffffffffffffffULL, 0xffffffffUL, SBFREAD_FIELD_ALL
+};
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfread_MeasEpoch_DecodeIndexed(MeasEpoch_2_t*       sbfMeasEpoch,
+        MeasEpoch_t*         trackMeasEpoch,
+        sbfread_ChannelIndex_t* ChannelIndex,
+        const sbfread_DecodeMask_t* Mask)
+/* decodes a MeasEpoch_2_t or GenMeasEpoch_1_t (SBF Block) into
+   trackMeasEpoch.  If ChannelIndex is not NULL, it is filled with the
+   position of each element of channelData[] indexed by logical
+   channel number, for use by the MeasExtra and MeasFullRange
+   decoders.  Only the measurements selected in Mask are decoded. */
 {
     uint32_t         chNR = 0;
     MeasEpochChannelType1_t* Type1SubBlock;
     int              Type1Counter;
+    sbfread_Type1Obs_t Type1Obs;
 
     /* Initialize all to 0 */
     memset(trackMeasEpoch, 0, sizeof(*trackMeasEpoch));
 
+    if (ChannelIndex != NULL)
+    {
+        sbfread_ChannelIndex_Reset(ChannelIndex);
+    }
+
     /* as of revision 1 of that block, the exact total clock jump is
        available from the block (8LSB only). */
     if (SBF_ID_TO_REV(sbfMeasEpoch->Header.ID) >= 1)
@@ -1864,9 +2675,10 @@ void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
 
         trackChan->PRN     = convertSVIDfromSBF(GetMeasEpochSVID(Type1SubBlock));
 
-        if (trackChan->PRN == 0)
+        if (trackChan->PRN == 0 ||
+            (Mask->Constellations & sbfread_GetConstellationBit(trackChan->PRN)) == 0)
         {
-            /* skip, if SVID is not recognized */
+            /* skip, if SVID is not recognized or not selected */
             Type1SubBlock = GetNextType1SubBlock(sbfMeasEpoch, Type1SubBlock, &Type1Counter);
             continue;
         }
@@ -1908,24 +2720,39 @@ void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
             continue;
         }
 
-        GetObsFromType1(sbfMeasEpoch, Type1SubBlock,
+        GetObsFromType1(sbfMeasEpoch, Type1SubBlock, &Type1Obs,
                         &SignalType, &AntIdx, &PR_m, &Carrier_cycles, &Doppler_Hz, &CN0_dBHz, &LockTime_s, &HCF);
 
-        AtLeastOneMeas |= sbfread_AddMeasSet(trackChan, SignalType, AntIdx,
-                                             PR_m, Carrier_cycles, Doppler_Hz, CN0_dBHz, LockTime_s, HCF);
+        if (sbfread_IsMeasSetSelected(Mask, SignalType, AntIdx))
+        {
+            AtLeastOneMeas |= sbfread_AddMeasSet(trackChan, SignalType, AntIdx,
+                                                 PR_m, Carrier_cycles,
+                                                 (Mask->Fields & SBFREAD_FIELD_DOPPLER) != 0 ? Doppler_Hz : F64_NOTVALID,
+                                                 CN0_dBHz, LockTime_s, HCF);
+        }
 
         for (i = 0; i < (int)Type1SubBlock->N_Type2; i++)
         {
-            GetNextObsFromType2(sbfMeasEpoch, Type1SubBlock,
+            GetNextObsFromType2(sbfMeasEpoch, Type1SubBlock, &Type1Obs,
                                 &SignalType, &AntIdx, &PR_m, &Carrier_cycles, &Doppler_Hz, &CN0_dBHz, &LockTime_s, &HCF);
 
-            AtLeastOneMeas |= sbfread_AddMeasSet(trackChan, SignalType, AntIdx,
-                                                 PR_m, Carrier_cycles, Doppler_Hz, CN0_dBHz, LockTime_s, HCF);
+            if (sbfread_IsMeasSetSelected(Mask, SignalType, AntIdx))
+            {
+                AtLeastOneMeas |= sbfread_AddMeasSet(trackChan, SignalType, AntIdx,
+                                                     PR_m, Carrier_cycles,
+                                                     (Mask->Fields & SBFREAD_FIELD_DOPPLER) != 0 ? Doppler_Hz : F64_NOTVALID,
+                                                     CN0_dBHz, LockTime_s, HCF);
+            }
         }
 
 
         if (AtLeastOneMeas)
         {
+            if (ChannelIndex != NULL)
+            {
+                sbfread_ChannelIndex_Add(ChannelIndex, trackChan->channel, chNR);
+            }
+
             chNR++;
         }
 
@@ -1936,6 +2763,14 @@ void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
 }
 
 
+/*---------------------------------------------------------------------------*/
+void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
+                              MeasEpoch_t*         trackMeasEpoch)
+{
+    sbfread_MeasEpoch_DecodeIndexed(sbfMeasEpoch, trackMeasEpoch, NULL, &sbfread_DecodeMask_All);
+}
+
+
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -1944,35 +2779,42 @@ void sbfread_MeasEpoch_Decode(MeasEpoch_2_t*       sbfMeasEpoch,
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
-/*! decodes a MeasExtra_1_t (SBF Block) into an existing MeasEpoch_t
+/*! decodes a MeasExtra_1_t (SBF Block) into an existing MeasEpoch_t,
+    ChannelIndex giving the position of each element of channelData[]
+    indexed by logical channel number.
  */
-void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
-                              MeasEpoch_t*     measEpoch)
+static void sbfread_MeasExtra_DecodeIndexed(MeasExtra_1_t*   sbfMeasExtra,
+        MeasEpoch_t*     measEpoch,
+        const sbfread_ChannelIndex_t* ChannelIndex)
 {
-    MeasExtra_1_t  sbfMeasExtra_Aligned;
-    uint32_t nrSB = ((sbfMeasExtra->Header.Length / sbfMeasExtra->SBSize - sbfMeasExtra->N) / 256) * 256 + sbfMeasExtra->N;
+    sbfread_SubBlockView_t SubBlocks;
+    MeasExtraChannel_1_t   Scratch;
+    uint32_t nrSB = 0;
 
-    /* align the sub-block size to what we expect */
-    memcpy(&sbfMeasExtra_Aligned, sbfMeasExtra, sbfMeasExtra->Header.Length);
-    AlignSubBlockSize(&sbfMeasExtra_Aligned, (unsigned)nrSB,
-                      sbfMeasExtra->SBSize, sizeof(MeasExtraChannel_1_t));
+    if (sbfMeasExtra->SBSize != 0)
+    {
+        nrSB = ((sbfMeasExtra->Header.Length / sbfMeasExtra->SBSize - sbfMeasExtra->N) / 256) * 256 + sbfMeasExtra->N;
+    }
 
+    /* read the sub-blocks in place, whatever their size */
+    sbfread_SubBlockView_Init(&SubBlocks, sbfMeasExtra, sbfMeasExtra->MeasExtraChannel,
+                              nrSB, sbfMeasExtra->SBSize, sizeof(MeasExtraChannel_1_t));
 
-    if (sbfMeasExtra_Aligned.DopplerVarFactor != 0.0)
+    if (sbfMeasExtra->DopplerVarFactor != 0.0)
     {
-        measEpoch->dopplerVarFactor = sbfMeasExtra_Aligned.DopplerVarFactor;
+        measEpoch->dopplerVarFactor = sbfMeasExtra->DopplerVarFactor;
     }
 
     /* loop over all MeasExtra channels */
-    for (uint32_t i = 0; i < nrSB; i++)
+    for (uint32_t i = 0; i < SubBlocks.N; i++)
     {
-        MeasExtraChannel_1_t* extraChan = &(sbfMeasExtra_Aligned.MeasExtraChannel[i]);
+        const MeasExtraChannel_1_t* extraChan = sbfread_SubBlockView_Get(&SubBlocks, i, &Scratch);
         MeasChannel_t*        measChan  = measEpoch->channelData;
 
         int      antNR = (int)((extraChan->Type >> 5) & 0x7);
         uint8_t  sigID;
         int      j     = 0;
-        int      chIdx = 0;
+        uint32_t chPos = 0;
         bool     chFound = false;
 
         sigID = (uint8_t)(extraChan->Type & 0x1F);
@@ -1984,20 +2826,15 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
 
         /* find corresponding channel, do not process the signal if it is
            being tracked on an antenna that is not supported in this platform */
-        if (antNR < NR_OF_ANTENNAS)
+        if (antNR < NR_OF_ANTENNAS && extraChan->RXChannel != 0)
         {
-            do
-            {
-                measChan = &(measEpoch->channelData[chIdx]);
-
-                if (measChan->channel == (extraChan->RXChannel - 1))
-                {
-                    chFound = true;
-                }
+            chPos = sbfread_ChannelIndex_Find(ChannelIndex, (uint8_t)(extraChan->RXChannel - 1));
 
-                chIdx++;
+            if (chPos != 0)
+            {
+                measChan = &(measEpoch->channelData[chPos - 1]);
+                chFound  = true;
             }
-            while ((!chFound) && (chIdx < (int)(measEpoch->nbrElements)));
         }
 
         if (chFound)
@@ -2005,7 +2842,8 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
             /* find corresponding signal location*/
             do
             {
-                if (measChan->measSet[antNR][j].signalType == sigID)
+                if (measChan->measSet[antNR][j].signalType == sigID &&
+                    (measChan->measSet[antNR][j].flags & MEASFLAG_VALIDITY) != 0)
                 {
                     MeasSet_t* meas = &(measChan->measSet[antNR][j]);
 
@@ -2044,7 +2882,7 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
 
                     meas->SmoothingCorr_mm = extraChan->SmoothingCorr;
 
-                    if (SBF_ID_TO_REV(sbfMeasExtra_Aligned.Header.ID) >= 1)
+                    if (SBF_ID_TO_REV(sbfMeasExtra->Header.ID) >= 1)
                     {
                         meas->lockCount = extraChan->CumLossCont;
                     }
@@ -2055,7 +2893,7 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
 
                     /* extract the carrier multipath and the APMEINSYNC bit if this is
                        the revision 2 of the block */
-                    if (SBF_ID_TO_REV(sbfMeasExtra_Aligned.Header.ID) >= 2)
+                    if (SBF_ID_TO_REV(sbfMeasExtra->Header.ID) >= 2)
                     {
                         if ((extraChan->Info & 1) != 0)
                         {
@@ -2069,7 +2907,7 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
                         meas->CarrierMP_1_512c      = (int8_t)0;
                     }
 
-                    if (SBF_ID_TO_REV(sbfMeasExtra_Aligned.Header.ID) >= 3)
+                    if (SBF_ID_TO_REV(sbfMeasExtra->Header.ID) >= 3)
                     {
                         meas->CN0_dBHz += (extraChan->Misc & 0x7) * 0.03125f;
                     }
@@ -2086,6 +2924,19 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
     }
 }
 
+
+/*---------------------------------------------------------------------------*/
+void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
+                              MeasEpoch_t*     measEpoch)
+{
+    sbfread_ChannelIndex_t ChannelIndex;
+
+    memset(&ChannelIndex, 0, sizeof(ChannelIndex));
+    sbfread_ChannelIndex_Build(&ChannelIndex, measEpoch);
+
+    sbfread_MeasExtra_DecodeIndexed(sbfMeasExtra, measEpoch, &ChannelIndex);
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 /*--- FUNCTIONS TO DECODE MEASFULLRANGE SBF BLOCKS --------------------------*/
@@ -2097,57 +2948,48 @@ void sbfread_MeasExtra_Decode(MeasExtra_1_t*   sbfMeasExtra,
     MeasEpoch_t
  */
 static void sbfread_MeasFullRange_Decode(MeasFullRange_1_t*  sbfMeasFullRange,
-        MeasEpoch_t*        trackMeasEpoch)
+        MeasEpoch_t*        trackMeasEpoch,
+        const sbfread_ChannelIndex_t* ChannelIndex)
 {
     /* Local declarations */
     uint32_t  n;
-    uint32_t nrSB = ((sbfMeasFullRange->Header.Length / sbfMeasFullRange->SBLength - sbfMeasFullRange->N) / 256) * 256 + sbfMeasFullRange->N;
-    MeasFullRange_1_t  sbfMeasFullRange_Aligned;
+    uint32_t  nrSB = 0;
+    sbfread_SubBlockView_t SubBlocks;
+    MeasFullRangeSub_1_t   Scratch;
 
-    /* align the sub-block size to what we expect */
-    memcpy(&sbfMeasFullRange_Aligned, sbfMeasFullRange, sbfMeasFullRange->Header.Length);
-    AlignSubBlockSize(&sbfMeasFullRange_Aligned, (unsigned)nrSB,
-                      sbfMeasFullRange->SBLength, sizeof(MeasFullRangeSub_1_t));
-
-    /* Body */
-#ifdef SWAP_DOUBLE_NEEDED
-
-    for (n = 0; in < nrSB; n++)
+    if (sbfMeasFullRange->SBLength != 0)
     {
-        swapDouble(&(sbfMeasFullRange_Aligned.measFullRangeSub[n].CodeObs));
+        nrSB = ((sbfMeasFullRange->Header.Length / sbfMeasFullRange->SBLength - sbfMeasFullRange->N) / 256) * 256 + sbfMeasFullRange->N;
     }
 
-#endif
+    /* read the sub-blocks in place, whatever their size */
+    sbfread_SubBlockView_Init(&SubBlocks, sbfMeasFullRange, sbfMeasFullRange->MeasFullRangeSub,
+                              nrSB, sbfMeasFullRange->SBLength, sizeof(MeasFullRangeSub_1_t));
 
     /* loop over all subblocks */
-    for (n = 0; n < nrSB; n++)
+    for (n = 0; n < SubBlocks.N; n++)
     {
-        MeasFullRangeSub_1_t* fullRangeSub = &(sbfMeasFullRange_Aligned.MeasFullRangeSub[n]);
+        const MeasFullRangeSub_1_t* fullRangeSub = sbfread_SubBlockView_Get(&SubBlocks, n, &Scratch);
         MeasChannel_t*        measChan     = trackMeasEpoch->channelData;
 
         int      antNR   = (int)((fullRangeSub->FreqNrAnt >> 5) & 0x7);
         uint8_t  fnPlus8 = fullRangeSub->FreqNrAnt & 0x1F;
         uint8_t  sigID   = fullRangeSub->Type;
         int      j       = 0;
-        int      chIdx   = 0;
+        uint32_t chPos   = 0;
         bool     chFound = false;
 
         /* find corresponding tracker channel, do not process the signal if it is
            being tracked on an antenna that not supported in this platform */
-        if (antNR < NR_OF_ANTENNAS)
+        if (antNR < NR_OF_ANTENNAS && fullRangeSub->RxChannel != 0)
         {
-            do
-            {
-                measChan = &(trackMeasEpoch->channelData[chIdx]);
-
-                if (measChan->channel == (fullRangeSub->RxChannel - 1))
-                {
-                    chFound = true;
-                }
+            chPos = sbfread_ChannelIndex_Find(ChannelIndex, (uint8_t)(fullRangeSub->RxChannel - 1));
 
-                chIdx++;
+            if (chPos != 0)
+            {
+                measChan = &(trackMeasEpoch->channelData[chPos - 1]);
+                chFound  = true;
             }
-            while ((!chFound) && (chIdx < (int)(trackMeasEpoch->nbrElements)));
         }
 
         if (chFound)
@@ -2155,16 +2997,20 @@ static void sbfread_MeasFullRange_Decode(MeasFullRange_1_t*  sbfMeasFullRange,
             /* find corresponding signal location */
             do
             {
-                if (measChan->measSet[antNR][j].signalType == sigID)
+                if (measChan->measSet[antNR][j].signalType == sigID &&
+                    (measChan->measSet[antNR][j].flags & MEASFLAG_VALIDITY) != 0)
                 {
                     MeasSet_t* meas   = &(measChan->measSet[antNR][j]);
                     double waveLength = GetWavelength_m((SignalType_t)sigID, (int)fnPlus8 - 8);
 
                     meas->PR_m     = fullRangeSub->CodeObs;
+#ifdef SWAP_DOUBLE_NEEDED
+                    swapDouble(&(meas->PR_m));
+#endif
                     meas->L_cycles = (fullRangeSub->CarrierMinCode + meas->PR_m) / waveLength;
 
                     /* C/N0 encoded in block from rev1 */
-                    if (SBF_ID_TO_REV(sbfMeasFullRange_Aligned.Header.ID) > 0)
+                    if (SBF_ID_TO_REV(sbfMeasFullRange->Header.ID) > 0)
                     {
                         meas->CN0_dBHz = (float)fullRangeSub->CN0 / 100.0F;
                     }
@@ -2195,70 +3041,192 @@ static bool sbfread_ProcessEpoch(SBFData_t*           SBFData,
 {
     int      i;
     bool     MeasReady = false;
+    bool     Decimated = (SBFData->MeasDecimation_ms > 1 &&
+                          SBFData->MeasCollect_CurrentTOW % SBFData->MeasDecimation_ms != 0);
 
-    if ((EnabledMeasTypes & SBFREAD_MEAS3_ENABLED) != 0 && SBFData->Meas3Ranges[0].Header.ID != 0 &&
+    if ((EnabledMeasTypes & SBFREAD_MEAS3_ENABLED) != 0 && SBFData->Meas3Ranges[0] != NULL &&
         ((SBFData->MeasCollect_CurrentTOW != SBFData->TOWAtLastMeasEpoch)
          || (SBFData->MeasCollect_CurrentTOW == U32_NOTVALID)
         ))
     {
-        sbfread_Meas3_Decode(SBFData->Meas3Ranges,
-                             SBFData->Meas3Doppler,
-                             SBFData->Meas3CN0HiRes,
-                             SBFData->Meas3PP,
-                             SBFData->Meas3MP,
-                             SBFData->RefEpoch,
-                             MeasEpoch
+        if (Decimated)
+        {
+            sbfread_Meas3_UpdateRefEpochs(SBFData, MeasEpoch);
+        }
+        else if (!sbfread_Meas3_DecodeParallel(SBFData, MeasEpoch))
+        {
+            sbfread_Meas3_Decode(SBFData->Meas3Ranges,
+                                 SBFData->Meas3Doppler,
+                                 SBFData->Meas3CN0HiRes,
+                                 SBFData->Meas3PP,
+                                 SBFData->Meas3MP,
+                                 SBFData->RefEpoch,
+                                 MeasEpoch,
+                                 &(SBFData->ChannelIndex),
+                                 &(SBFData->Meas3SigTable),
+                                 &(SBFData->DecodeMask),
+                                 &(SBFData->Meas3Counters)
 #if SSN_FEATURE_SBF_SCRAMBLING
-                             , &(SBFData->decrypt)
+                                 , &(SBFData->decrypt)
 #endif
-                            );
+                                );
+        }
 
         SBFData->TOWAtLastMeasEpoch = SBFData->MeasCollect_CurrentTOW;
 
-        MeasReady = true;
+        MeasReady = !Decimated;
     }
-    else if ((EnabledMeasTypes & SBFREAD_MEASEPOCH_ENABLED) != 0 && SBFData->MeasEpoch.Header.ID != 0 &&
+    else if ((EnabledMeasTypes & SBFREAD_MEASEPOCH_ENABLED) != 0 && SBFData->MeasEpoch != NULL &&
              ((SBFData->MeasCollect_CurrentTOW != SBFData->TOWAtLastMeasEpoch)
               || (SBFData->MeasCollect_CurrentTOW == U32_NOTVALID)
              ))
     {
-        sbfread_MeasEpoch_Decode(&(SBFData->MeasEpoch), MeasEpoch);
-
-        // include MeasExtra if available
-        if (SBFData->MeasExtra.Header.ID != 0)
+        if (!Decimated)
         {
-            sbfread_MeasExtra_Decode(&(SBFData->MeasExtra), MeasEpoch);
-        }
+            sbfread_MeasEpoch_DecodeIndexed(SBFData->MeasEpoch, MeasEpoch, &(SBFData->ChannelIndex), &(SBFData->DecodeMask));
 
-        // include MeasFullRange if available
-        if (SBFData->MeasFullRange.Header.ID != 0)
-        {
-            sbfread_MeasFullRange_Decode(&(SBFData->MeasFullRange), MeasEpoch);
+            // include MeasExtra if available
+            if (SBFData->MeasExtra != NULL)
+            {
+                sbfread_MeasExtra_DecodeIndexed(SBFData->MeasExtra, MeasEpoch, &(SBFData->ChannelIndex));
+            }
+
+            // include MeasFullRange if available
+            if (SBFData->MeasFullRange != NULL)
+            {
+                sbfread_MeasFullRange_Decode(SBFData->MeasFullRange, MeasEpoch, &(SBFData->ChannelIndex));
+            }
         }
 
         SBFData->TOWAtLastMeasEpoch = SBFData->MeasCollect_CurrentTOW;
 
-        MeasReady = true;
+        MeasReady = !Decimated;
     }
 
     /* forget all collected blocks to start a new epoch */
     for (i = 0; i < NR_OF_ANTENNAS; i++)
     {
-        SBFData->Meas3Ranges[i].Header.ID   = 0;
-        SBFData->Meas3Doppler[i].Header.ID  = 0;
-        SBFData->Meas3CN0HiRes[i].Header.ID = 0;
-        SBFData->Meas3PP[i].Header.ID       = 0;
-        SBFData->Meas3MP[i].Header.ID       = 0;
+        SBFData->Meas3Ranges[i]   = NULL;
+        SBFData->Meas3Doppler[i]  = NULL;
+        SBFData->Meas3CN0HiRes[i] = NULL;
+        SBFData->Meas3PP[i]       = NULL;
+        SBFData->Meas3MP[i]       = NULL;
     }
 
-    SBFData->MeasEpoch.Header.ID        = 0;
-    SBFData->MeasExtra.Header.ID        = 0;
-    SBFData->MeasFullRange.Header.ID    = 0;
+    SBFData->MeasEpoch        = NULL;
+    SBFData->MeasExtra        = NULL;
+    SBFData->MeasFullRange    = NULL;
+    sbfread_Arena_Reset(&(SBFData->MeasArena));
 
     return MeasReady;
 }
 
 
+/*---------------------------------------------------------------------------*/
+static void* sbfread_CopyMeasBlock(SBFData_t*  SBFData,
+                                   const void* SBFBlock)
+/* returns a copy of a measurement block in the arena of the current
+   epoch, or NULL if the arena is full */
+{
+    uint32_t Length = ((const HeaderAndTimeBlock_t*)SBFBlock)->Header.Length;
+    void*    Dest;
+
+    /* the arena is only needed by the programs that reuse their block
+       buffer before the end of the epoch */
+    if (SBFData->MeasArena.Data == NULL &&
+        !sbfread_Arena_Init(&(SBFData->MeasArena), NULL, SBFREAD_MEASARENA_SIZE))
+    {
+        SBFData->MeasArena_Overflows++;
+        return NULL;
+    }
+
+    Dest = sbfread_Arena_Alloc(&(SBFData->MeasArena), Length);
+
+    if (Dest == NULL)
+    {
+        SBFData->MeasArena_Overflows++;
+        return NULL;
+    }
+
+    memcpy(Dest, SBFBlock, Length);
+
+    return Dest;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void* sbfread_StoreMeasBlock(SBFData_t* SBFData,
+                                    void*      Current,
+                                    void*      SBFBlock)
+/* returns the measurement block to keep for the current epoch.  When
+   reading a file, that is SBFBlock itself, which GetNextBlock() saves
+   before overwriting it.  Otherwise the block is copied, since there
+   is no telling when its buffer is reused.  Current is the block of
+   the same type already collected in this epoch (or NULL), which is
+   kept if the copy does not fit. */
+{
+    void* Copy;
+
+    if (SBFData->F != NULL)
+    {
+        return SBFBlock;
+    }
+
+    Copy = sbfread_CopyMeasBlock(SBFData, SBFBlock);
+
+    return Copy != NULL ? Copy : Current;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void* sbfread_DetachMeasBlock(SBFData_t* SBFData,
+                                     void*      Block,
+                                     uintptr_t  BufferStart,
+                                     uintptr_t  BufferEnd)
+/* returns Block, or a copy of it if it overlaps the buffer from
+   BufferStart to BufferEnd */
+{
+    uintptr_t BlockStart = (uintptr_t)Block;
+
+    if (Block != NULL && BlockStart < BufferEnd &&
+        BlockStart + ((const HeaderAndTimeBlock_t*)Block)->Header.Length > BufferStart)
+    {
+        return sbfread_CopyMeasBlock(SBFData, Block);
+    }
+
+    return Block;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_DetachMeasBlocks(SBFData_t*  SBFData,
+                              const void* Buffer,
+                              size_t      Size)
+{
+    uintptr_t Start = (uintptr_t)Buffer;
+    uintptr_t End   = Start + Size;
+    int       i;
+
+    if (SBFData->MeasCollect_BlocksSeenAtThisEpoch == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < NR_OF_ANTENNAS; i++)
+    {
+        SBFData->Meas3Ranges[i]   = sbfread_DetachMeasBlock(SBFData, SBFData->Meas3Ranges[i], Start, End);
+        SBFData->Meas3Doppler[i]  = sbfread_DetachMeasBlock(SBFData, SBFData->Meas3Doppler[i], Start, End);
+        SBFData->Meas3CN0HiRes[i] = sbfread_DetachMeasBlock(SBFData, SBFData->Meas3CN0HiRes[i], Start, End);
+        SBFData->Meas3PP[i]       = sbfread_DetachMeasBlock(SBFData, SBFData->Meas3PP[i], Start, End);
+        SBFData->Meas3MP[i]       = sbfread_DetachMeasBlock(SBFData, SBFData->Meas3MP[i], Start, End);
+    }
+
+    SBFData->MeasEpoch     = sbfread_DetachMeasBlock(SBFData, SBFData->MeasEpoch, Start, End);
+    SBFData->MeasExtra     = sbfread_DetachMeasBlock(SBFData, SBFData->MeasExtra, Start, End);
+    SBFData->MeasFullRange = sbfread_DetachMeasBlock(SBFData, SBFData->MeasFullRange, Start, End);
+}
+
+
 /*---------------------------------------------------------------------------*/
 static bool sbfread_IsMeasBlock(const void* const SBFBlock)
 {
@@ -2276,6 +3244,136 @@ static bool sbfread_IsMeasBlock(const void* const SBFBlock)
 }
 
 
+/*---------------------------------------------------------------------------*/
+static bool sbfread_IsBlockSelected(const sbfread_DecodeMask_t* Mask,
+                                    uint32_t Field,
+                                    uint32_t AntIdx)
+/* returns true if a block providing the given SBFREAD_FIELD_xxx for
+   antenna AntIdx needs to be collected */
+{
+    return ((Mask->Fields & Field) != 0 && (Mask->Antennas & (1UL << AntIdx)) != 0);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_SetDecodeMask(SBFData_t*                  SBFData,
+                           const sbfread_DecodeMask_t* Mask)
+{
+    int i;
+
+    if (Mask == NULL)
+    {
+        Mask = &sbfread_DecodeMask_All;
+    }
+
+    SBFData->DecodeMask = *Mask;
+
+    /* the reference epochs only contain the measurements that were
+       selected when they were decoded */
+    for (i = 0; i < NR_OF_ANTENNAS; i++)
+    {
+        SBFData->RefEpoch[i].TOW_ms = U32_NOTVALID;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_SetMeasDecimation(SBFData_t* SBFData,
+                               uint32_t   Interval_ms)
+{
+    SBFData->MeasDecimation_ms = Interval_ms;
+}
+
+
+/*---------------------------------------------------------------------------*/
+uint32_t sbfread_GetMeasBlockAntennas(const void* SBFBlock)
+{
+    const uint32_t BlockNumber = SBF_ID_TO_NUMBER(((const HeaderAndTimeBlock_t*)SBFBlock)->Header.ID);
+    uint32_t Antennas = 0;
+    uint32_t i, n;
+
+    switch (BlockNumber)
+    {
+    case sbfnr_Meas3Ranges_1:
+    case sbfnr_Meas3Doppler_1:
+    case sbfnr_Meas3CN0HiRes_1:
+    case sbfnr_Meas3PP_1:
+    case sbfnr_Meas3MP_1:
+        Antennas = 1U << sbfread_Meas3_GetAntennaIdx((const uint8_t*)SBFBlock);
+        break;
+
+    case sbfnr_MeasEpoch_2:
+    case sbfnr_GenMeasEpoch_1:
+    {
+        const MeasEpoch_2_t* const sbfMeasEpoch = (const MeasEpoch_2_t*)SBFBlock;
+        int Type1Counter;
+        MeasEpochChannelType1_t* Type1SubBlock = GetFirstType1SubBlock(sbfMeasEpoch, &Type1Counter);
+
+        while (Type1SubBlock)
+        {
+            const uint8_t* Type2SubBlock = (const uint8_t*)Type1SubBlock + sbfMeasEpoch->SB1Size;
+
+            Antennas |= 1U << (Type1SubBlock->Type >> 5);
+
+            for (i = 0; i < Type1SubBlock->N_Type2; i++, Type2SubBlock += sbfMeasEpoch->SB2Size)
+            {
+                Antennas |= 1U << (((const MeasEpochChannelType2_t*)Type2SubBlock)->Type >> 5);
+            }
+
+            Type1SubBlock = GetNextType1SubBlock(sbfMeasEpoch, Type1SubBlock, &Type1Counter);
+        }
+
+        break;
+    }
+
+    case sbfnr_MeasExtra_1:
+    {
+        const MeasExtra_1_t* const sbfMeasExtra = (const MeasExtra_1_t*)SBFBlock;
+        sbfread_SubBlockView_t SubBlocks;
+        MeasExtraChannel_1_t   Scratch;
+
+        n = (sbfMeasExtra->SBSize != 0) ? ((sbfMeasExtra->Header.Length / sbfMeasExtra->SBSize - sbfMeasExtra->N) / 256) * 256 + sbfMeasExtra->N : 0;
+        sbfread_SubBlockView_Init(&SubBlocks, sbfMeasExtra, sbfMeasExtra->MeasExtraChannel,
+                                  n, sbfMeasExtra->SBSize, sizeof(MeasExtraChannel_1_t));
+
+        for (i = 0; i < SubBlocks.N; i++)
+        {
+            const MeasExtraChannel_1_t* extraChan = sbfread_SubBlockView_Get(&SubBlocks, i, &Scratch);
+
+            Antennas |= 1U << ((extraChan->Type >> 5) & 0x7);
+        }
+
+        break;
+    }
+
+    case sbfnr_MeasFullRange_1:
+    {
+        const MeasFullRange_1_t* const sbfMeasFullRange = (const MeasFullRange_1_t*)SBFBlock;
+        sbfread_SubBlockView_t SubBlocks;
+        MeasFullRangeSub_1_t   Scratch;
+
+        n = (sbfMeasFullRange->SBLength != 0) ? ((sbfMeasFullRange->Header.Length / sbfMeasFullRange->SBLength - sbfMeasFullRange->N) / 256) * 256 + sbfMeasFullRange->N : 0;
+        sbfread_SubBlockView_Init(&SubBlocks, sbfMeasFullRange, sbfMeasFullRange->MeasFullRangeSub,
+                                  n, sbfMeasFullRange->SBLength, sizeof(MeasFullRangeSub_1_t));
+
+        for (i = 0; i < SubBlocks.N; i++)
+        {
+            const MeasFullRangeSub_1_t* fullRangeSub = sbfread_SubBlockView_Get(&SubBlocks, i, &Scratch);
+
+            Antennas |= 1U << ((fullRangeSub->FreqNrAnt >> 5) & 0x7);
+        }
+
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return Antennas;
+}
+
+
 /*---------------------------------------------------------------------------*/
 bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
                                   void*                SBFBlock,
@@ -2318,7 +3416,7 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
 
         if ((int)AntIdx < NR_OF_ANTENNAS)
         {
-            memcpy(SBFData->Meas3Ranges + AntIdx, SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+            SBFData->Meas3Ranges[AntIdx] = sbfread_StoreMeasBlock(SBFData, SBFData->Meas3Ranges[AntIdx], SBFBlock);
             SBFData->MeasCollect_BlocksSeenAtThisEpoch |= (MEASCOLLECT_SEEN_MEAS3RANGES << (AntIdx * MEASCOLLECT_NR_OF_MEASBLOCKS));
         }
 
@@ -2327,9 +3425,10 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
     case sbfnr_Meas3Doppler_1:
         AntIdx = sbfread_Meas3_GetAntennaIdx((uint8_t*)SBFBlock);
 
-        if ((int)AntIdx < NR_OF_ANTENNAS)
+        if ((int)AntIdx < NR_OF_ANTENNAS &&
+            sbfread_IsBlockSelected(&(SBFData->DecodeMask), SBFREAD_FIELD_DOPPLER, AntIdx))
         {
-            memcpy(SBFData->Meas3Doppler + AntIdx, SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+            SBFData->Meas3Doppler[AntIdx] = sbfread_StoreMeasBlock(SBFData, SBFData->Meas3Doppler[AntIdx], SBFBlock);
             SBFData->MeasCollect_BlocksSeenAtThisEpoch |= (MEASCOLLECT_SEEN_MEAS3DOPPLER << (AntIdx * MEASCOLLECT_NR_OF_MEASBLOCKS));
         }
 
@@ -2338,9 +3437,10 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
     case sbfnr_Meas3CN0HiRes_1:
         AntIdx = sbfread_Meas3_GetAntennaIdx((uint8_t*)SBFBlock);
 
-        if ((int)AntIdx < NR_OF_ANTENNAS)
+        if ((int)AntIdx < NR_OF_ANTENNAS &&
+            sbfread_IsBlockSelected(&(SBFData->DecodeMask), SBFREAD_FIELD_CN0HIRES, AntIdx))
         {
-            memcpy(SBFData->Meas3CN0HiRes + AntIdx, SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+            SBFData->Meas3CN0HiRes[AntIdx] = sbfread_StoreMeasBlock(SBFData, SBFData->Meas3CN0HiRes[AntIdx], SBFBlock);
             SBFData->MeasCollect_BlocksSeenAtThisEpoch |= (MEASCOLLECT_SEEN_MEAS3CN0HIRES << (AntIdx * MEASCOLLECT_NR_OF_MEASBLOCKS));
         }
 
@@ -2349,9 +3449,10 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
     case sbfnr_Meas3PP_1:
         AntIdx = sbfread_Meas3_GetAntennaIdx((uint8_t*)SBFBlock);
 
-        if ((int)AntIdx < NR_OF_ANTENNAS)
+        if ((int)AntIdx < NR_OF_ANTENNAS &&
+            sbfread_IsBlockSelected(&(SBFData->DecodeMask), SBFREAD_FIELD_PPINFO, AntIdx))
         {
-            memcpy(SBFData->Meas3PP + AntIdx, SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+            SBFData->Meas3PP[AntIdx] = sbfread_StoreMeasBlock(SBFData, SBFData->Meas3PP[AntIdx], SBFBlock);
             SBFData->MeasCollect_BlocksSeenAtThisEpoch |= (MEASCOLLECT_SEEN_MEAS3PP << (AntIdx * MEASCOLLECT_NR_OF_MEASBLOCKS));
         }
 
@@ -2360,9 +3461,10 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
     case sbfnr_Meas3MP_1:
         AntIdx = sbfread_Meas3_GetAntennaIdx((uint8_t*)SBFBlock);
 
-        if ((int)AntIdx < NR_OF_ANTENNAS)
+        if ((int)AntIdx < NR_OF_ANTENNAS &&
+            sbfread_IsBlockSelected(&(SBFData->DecodeMask), SBFREAD_FIELD_MPINFO, AntIdx))
         {
-            memcpy(SBFData->Meas3MP + AntIdx, SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+            SBFData->Meas3MP[AntIdx] = sbfread_StoreMeasBlock(SBFData, SBFData->Meas3MP[AntIdx], SBFBlock);
             SBFData->MeasCollect_BlocksSeenAtThisEpoch |= (MEASCOLLECT_SEEN_MEAS3MP << (AntIdx * MEASCOLLECT_NR_OF_MEASBLOCKS));
         }
 
@@ -2370,17 +3472,27 @@ bool sbfread_MeasCollectAndDecode(SBFData_t*           SBFData,
 
     case sbfnr_MeasEpoch_2:
     case sbfnr_GenMeasEpoch_1:
-        memcpy(&(SBFData->MeasEpoch), SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+        SBFData->MeasEpoch = sbfread_StoreMeasBlock(SBFData, SBFData->MeasEpoch, SBFBlock);
         SBFData->MeasCollect_BlocksSeenAtThisEpoch |= MEASCOLLECT_SEEN_MEASEPOCH;
         break;
 
     case sbfnr_MeasExtra_1:
-        memcpy(&(SBFData->MeasExtra), SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+        /* MeasExtra also holds the C/N0 fractional part and the APME
+           flag of the MeasEpoch measurements */
+        if ((SBFData->DecodeMask.Fields & (SBFREAD_FIELD_MPINFO | SBFREAD_FIELD_CN0HIRES | SBFREAD_FIELD_PPINFO)) != 0)
+        {
+            SBFData->MeasExtra = sbfread_StoreMeasBlock(SBFData, SBFData->MeasExtra, SBFBlock);
+        }
+
         SBFData->MeasCollect_BlocksSeenAtThisEpoch |= MEASCOLLECT_SEEN_MEASEXTRA;
         break;
 
     case sbfnr_MeasFullRange_1:
-        memcpy(&(SBFData->MeasFullRange), SBFBlock, ((HeaderAndTimeBlock_t*)SBFBlock)->Header.Length);
+        if ((SBFData->DecodeMask.Fields & SBFREAD_FIELD_FULLRANGE) != 0)
+        {
+            SBFData->MeasFullRange = sbfread_StoreMeasBlock(SBFData, SBFData->MeasFullRange, SBFBlock);
+        }
+
         SBFData->MeasCollect_BlocksSeenAtThisEpoch |= MEASCOLLECT_SEEN_MEASFULLRANGE;
         break;
     }
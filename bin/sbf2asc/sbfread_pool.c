@@ -0,0 +1,242 @@
+/*
+ * sbfread_pool.c: A small pool of persistent worker threads used to
+ *                 run decoding jobs in parallel.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "sbfread_pool.h"
+
+#if SBFREAD_THREADS
+
+#include <pthread.h>
+
+typedef struct
+{
+    sbfread_Pool_t*   Pool;
+    uint32_t          WorkerIdx;
+} sbfread_PoolWorker_t;
+
+struct sbfread_Pool_s
+{
+    pthread_mutex_t   Mutex;
+    pthread_cond_t    StartCond;    /* signalled when a job is started */
+    pthread_cond_t    DoneCond;     /* signalled when all workers are done */
+    pthread_t*        Threads;
+    sbfread_PoolWorker_t* Workers;
+    uint32_t          NrOfThreads;  /* number of threads actually running */
+    uint32_t          Generation;   /* incremented for each new job */
+    uint32_t          Pending;      /* workers still busy with the job */
+    bool              Stop;
+    sbfread_PoolJob_t Job;
+    void*             Arg;
+};
+
+
+/*---------------------------------------------------------------------------*/
+static void* sbfread_Pool_WorkerMain(void* Arg)
+{
+    sbfread_PoolWorker_t* Worker = (sbfread_PoolWorker_t*)Arg;
+    sbfread_Pool_t*       Pool   = Worker->Pool;
+    /* the pool starts at generation 0: a job started before this
+       thread gets the mutex must not be missed */
+    uint32_t              Generation = 0;
+
+    pthread_mutex_lock(&Pool->Mutex);
+
+    for (;;)
+    {
+        sbfread_PoolJob_t Job;
+        void*             JobArg;
+
+        while (Pool->Generation == Generation && !Pool->Stop)
+        {
+            pthread_cond_wait(&Pool->StartCond, &Pool->Mutex);
+        }
+
+        if (Pool->Stop)
+        {
+            break;
+        }
+
+        Generation = Pool->Generation;
+        Job        = Pool->Job;
+        JobArg     = Pool->Arg;
+        pthread_mutex_unlock(&Pool->Mutex);
+
+        Job(JobArg, Worker->WorkerIdx);
+
+        pthread_mutex_lock(&Pool->Mutex);
+
+        if (--Pool->Pending == 0)
+        {
+            pthread_cond_signal(&Pool->DoneCond);
+        }
+    }
+
+    pthread_mutex_unlock(&Pool->Mutex);
+
+    return NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+sbfread_Pool_t* sbfread_Pool_Create(uint32_t NrOfWorkers)
+{
+    sbfread_Pool_t* Pool;
+    uint32_t        i;
+
+    if (NrOfWorkers == 0)
+    {
+        return NULL;
+    }
+
+    Pool = (sbfread_Pool_t*)calloc(1, sizeof(*Pool));
+
+    if (Pool == NULL)
+    {
+        return NULL;
+    }
+
+    Pool->Threads = (pthread_t*)calloc(NrOfWorkers, sizeof(pthread_t));
+    Pool->Workers = (sbfread_PoolWorker_t*)calloc(NrOfWorkers, sizeof(sbfread_PoolWorker_t));
+
+    if (Pool->Threads == NULL || Pool->Workers == NULL)
+    {
+        free(Pool->Threads);
+        free(Pool->Workers);
+        free(Pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&Pool->Mutex, NULL);
+    pthread_cond_init(&Pool->StartCond, NULL);
+    pthread_cond_init(&Pool->DoneCond, NULL);
+
+    for (i = 0; i < NrOfWorkers; i++)
+    {
+        Pool->Workers[i].Pool      = Pool;
+        Pool->Workers[i].WorkerIdx = i;
+
+        if (pthread_create(&Pool->Threads[i], NULL, sbfread_Pool_WorkerMain, &Pool->Workers[i]) != 0)
+        {
+            sbfread_Pool_Destroy(Pool);
+            return NULL;
+        }
+
+        Pool->NrOfThreads++;
+    }
+
+    return Pool;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Start(sbfread_Pool_t*   Pool,
+                        sbfread_PoolJob_t Job,
+                        void*             Arg)
+{
+    pthread_mutex_lock(&Pool->Mutex);
+
+    Pool->Job     = Job;
+    Pool->Arg     = Arg;
+    Pool->Pending = Pool->NrOfThreads;
+    Pool->Generation++;
+
+    pthread_cond_broadcast(&Pool->StartCond);
+    pthread_mutex_unlock(&Pool->Mutex);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Wait(sbfread_Pool_t* Pool)
+{
+    pthread_mutex_lock(&Pool->Mutex);
+
+    while (Pool->Pending != 0)
+    {
+        pthread_cond_wait(&Pool->DoneCond, &Pool->Mutex);
+    }
+
+    pthread_mutex_unlock(&Pool->Mutex);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Destroy(sbfread_Pool_t* Pool)
+{
+    uint32_t i;
+
+    if (Pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&Pool->Mutex);
+    Pool->Stop = true;
+    pthread_cond_broadcast(&Pool->StartCond);
+    pthread_mutex_unlock(&Pool->Mutex);
+
+    for (i = 0; i < Pool->NrOfThreads; i++)
+    {
+        pthread_join(Pool->Threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&Pool->DoneCond);
+    pthread_cond_destroy(&Pool->StartCond);
+    pthread_mutex_destroy(&Pool->Mutex);
+
+    free(Pool->Workers);
+    free(Pool->Threads);
+    free(Pool);
+}
+
+#else  /* SBFREAD_THREADS */
+
+/*---------------------------------------------------------------------------*/
+sbfread_Pool_t* sbfread_Pool_Create(uint32_t NrOfWorkers)
+{
+    (void)NrOfWorkers;
+
+    return NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Start(sbfread_Pool_t*   Pool,
+                        sbfread_PoolJob_t Job,
+                        void*             Arg)
+{
+    (void)Pool;
+    (void)Job;
+    (void)Arg;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Wait(sbfread_Pool_t* Pool)
+{
+    (void)Pool;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfread_Pool_Destroy(sbfread_Pool_t* Pool)
+{
+    (void)Pool;
+}
+
+#endif /* SBFREAD_THREADS */
@@ -0,0 +1,62 @@
+/*
+ * sbfread_pool.h: Declaration of a small pool of persistent worker
+ *                 threads used to run decoding jobs in parallel.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFREAD_POOL_H
+#define SBFREAD_POOL_H 1
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The worker threads are only available when building with
+   SBFREAD_THREADS set to 1 (POSIX threads).  Otherwise
+   sbfread_Pool_Create() always returns NULL and the callers fall back
+   to sequential decoding. */
+#ifndef SBFREAD_THREADS
+#define SBFREAD_THREADS 0
+#endif
+
+typedef struct sbfread_Pool_s sbfread_Pool_t;
+
+/* a job run by each worker; WorkerIdx goes from 0 to NrOfWorkers-1 */
+typedef void (*sbfread_PoolJob_t)(void* Arg, uint32_t WorkerIdx);
+
+/* Start NrOfWorkers threads.  Returns NULL if the threads cannot be
+   created or if threads are not supported in this build. */
+sbfread_Pool_t* sbfread_Pool_Create(uint32_t NrOfWorkers);
+
+/* Have every worker call Job(Arg, WorkerIdx), and return immediately
+   so that the caller can do its own share of the work.  Must be
+   followed by sbfread_Pool_Wait() before the next call. */
+void sbfread_Pool_Start(sbfread_Pool_t*   Pool,
+                        sbfread_PoolJob_t Job,
+                        void*             Arg);
+
+/* Wait until all workers have finished the job given to
+   sbfread_Pool_Start(). */
+void sbfread_Pool_Wait(sbfread_Pool_t* Pool);
+
+/* Stop the worker threads and free the pool.  Pool may be NULL. */
+void sbfread_Pool_Destroy(sbfread_Pool_t* Pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,814 @@
+/*
+ * sbfrinex.c: RINEX 3.x/4.x observation file writer.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "sbfrinex.h"
+#include "sbfread.h"
+#include "sbfsvid.h"
+
+/* the constellations, in the order of the header */
+static const char SystemLetters[] = "GRECJIS";
+
+#define SBFRINEX_NR_OF_SYSTEMS  7
+
+/* signals of a constellation, and observables of each signal: code,
+   phase, Doppler and C/N0 */
+#define SBFRINEX_MAX_SIGNALS  16
+#define SBFRINEX_NR_OF_OBS     4
+
+static const char ObsLetters[SBFRINEX_NR_OF_OBS] = {'C', 'L', 'D', 'S'};
+
+/* RINEX band and attribute of each signal type, or "" if it has no
+   RINEX observation code */
+static const char SignalCodes[64][3] =
+{
+    /*  0- 7: GPSL1CA, GPSL1P, GPSL2P, GPSL2C, GPSL5, GPSL1C, QZSL1CA, QZSL2C */
+    "1C", "1W", "2W", "2L", "5Q", "1L", "1C", "2L",
+    /*  8-15: GLOL1CA, GLOL1P, GLOL2P, GLOL2CA, GLOL3, BDSB1C, BDSB2a, IRNL5 */
+    "1C", "1P", "2P", "2C", "3Q", "1P", "5P", "5A",
+    /* 16-23: -, GALE1BC, -, GALE6BC, GALE5a, GALE5b, GALE5, MSS */
+    "",   "1C", "",   "6C", "5Q", "7Q", "8Q", "",
+    /* 24-31: SBSL1CA, SBSL5, QZSL5, QZSL6, BDSB1I, BDSB2I, BDSB3, - */
+    "1C", "5I", "5Q", "6L", "2I", "7I", "6I", "",
+    /* 32-39: QZSL1C, QZSL1S, BDSB2b, -, IRNS1, IRNL1, QZSL1CB, QZSL5S */
+    "1L", "1Z", "7D", "",   "9A", "1P", "1E", "5P"
+    /* 40-63: not defined */
+};
+
+/* spaces written for the missing observations */
+static const char Spaces[] = "                                                                ";
+
+#define SBFRINEX_OBS_WIDTH  16   /* F14.3 and the LLI and SSI digits */
+
+/* the signals of a constellation, in the order of the columns */
+typedef struct
+{
+    uint32_t NrOfSignals;
+    uint8_t  SignalTypes[SBFRINEX_MAX_SIGNALS];
+} sbfrinex_System_t;
+
+/* the tracking state of a signal at the last epoch where it was
+   written, to detect the losses of lock */
+typedef struct
+{
+    uint32_t Epoch;         /* 1 + index of the epoch, 0 if never seen */
+    uint32_t PLLTimer_ms;
+    uint8_t  LockCount;
+} sbfrinex_Lock_t;
+
+struct sbfrinex_Obs_s
+{
+    sbfout_Stream_t*  Out;
+    uint32_t          Version;
+    char              Program[21];
+
+    FILE*             Spill;         /* the epochs, until the header is
+                                        written */
+    sbfout_Stream_t   Body;
+
+    sbfrinex_System_t Systems[SBFRINEX_NR_OF_SYSTEMS];
+    int8_t            Column[SBFRINEX_NR_OF_SYSTEMS][64];
+                                     /* column of each signal type in
+                                        each constellation, or -1 */
+    int8_t            GLOFreq[33];   /* frequency number + 8 of each
+                                        GLONASS slot, 0 if unknown */
+
+    uint32_t          NrOfEpochs;
+    int64_t           FirstEpoch_ms;
+    int64_t           LastEpoch_ms;
+    int64_t           Interval_ms;   /* shortest interval, or 0 */
+
+    /* header records from the ReceiverSetup and PVTCartesian blocks */
+    char              MarkerName[61];
+    char              MarkerNumber[21];
+    char              Observer[21];
+    char              Agency[41];
+    char              RxSerialNbr[21];
+    char              RxName[21];
+    char              RxVersion[21];
+    char              AntSerialNbr[21];
+    char              AntType[21];
+    double            Delta[3];      /* H, E, N */
+    bool              HavePosition;
+    double            Position[3];
+
+    int               Error;         /* errno of the first error, or 0 */
+
+    sbfrinex_Lock_t   Lock[256][64];  /* by SBF SVID and signal type */
+};
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_GetCalendar(int64_t              Time_ms,
+                          sbfrinex_Calendar_t* Calendar)
+{
+    /* days since 1 March 0000, from which the civil date follows
+       with 400-year eras (see H. Hinnant, "chrono-Compatible Low-Level
+       Date Algorithms") */
+    int64_t Days   = Time_ms / 86400000 + 3657 + 719468;
+    int64_t Ms     = Time_ms % 86400000;
+    int64_t Era    = Days / 146097;
+    int64_t DayOfEra  = Days - Era * 146097;
+    int64_t YearOfEra = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+    int64_t DayOfYear = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+    int64_t MonthIdx  = (5 * DayOfYear + 2) / 153;
+
+    Calendar->Day   = (int)(DayOfYear - (153 * MonthIdx + 2) / 5 + 1);
+    Calendar->Month = (int)(MonthIdx < 10 ? MonthIdx + 3 : MonthIdx - 9);
+    Calendar->Year  = (int)(YearOfEra + Era * 400 + (Calendar->Month <= 2 ? 1 : 0));
+    Calendar->Hour  = (int)(Ms / 3600000);
+    Calendar->Min   = (int)(Ms / 60000 % 60);
+    Calendar->Sec   = (double)(Ms % 60000) / 1000.0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_CopyText(char*       Dest,
+                              size_t      DestSize,
+                              const char* Text,
+                              size_t      TextLen)
+/* copies a text field of an SBF block, which is not always
+   null-terminated, without the trailing spaces */
+{
+    size_t Len = 0;
+
+    while (Len < TextLen && Len < DestSize - 1 && Text[Len] != '\0')
+    {
+        Dest[Len] = (Text[Len] >= ' ' && Text[Len] <= '~') ? Text[Len] : ' ';
+        Len++;
+    }
+
+    while (Len > 0 && Dest[Len - 1] == ' ')
+    {
+        Len--;
+    }
+
+    Dest[Len] = '\0';
+}
+
+
+/*---------------------------------------------------------------------------*/
+sbfrinex_Obs_t* sbfrinex_CreateObs(sbfout_Stream_t* Out,
+                                   uint32_t         Version,
+                                   const char*      Program)
+{
+    sbfrinex_Obs_t* Obs = (sbfrinex_Obs_t*)calloc(1, sizeof(*Obs));
+
+    if (Obs == NULL)
+    {
+        return NULL;
+    }
+
+    Obs->Out     = Out;
+    Obs->Version = Version;
+    sbfrinex_CopyText(Obs->Program, sizeof(Obs->Program), Program, strlen(Program));
+    memset(Obs->Column, -1, sizeof(Obs->Column));
+
+    Obs->Spill = tmpfile();
+
+    if (Obs->Spill == NULL || !sbfout_Open(&Obs->Body, Obs->Spill))
+    {
+        int Error = errno;
+
+        if (Obs->Spill != NULL)
+        {
+            (void)fclose(Obs->Spill);
+        }
+
+        free(Obs);
+        errno = Error;
+        return NULL;
+    }
+
+    return Obs;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int sbfrinex_GetSystem(uint8_t SVID)
+/* index of the constellation of a satellite in SystemLetters, or -1 for
+   the satellites without RINEX name */
+{
+    const char* Name = getSatelliteNameFromSBF(SVID);
+    const char* Letter;
+
+    if (Name[0] == '\0' || Name[1] < '0' || Name[1] > '9')
+    {
+        return -1;
+    }
+
+    Letter = strchr(SystemLetters, Name[0]);
+
+    return Letter != NULL ? (int)(Letter - SystemLetters) : -1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfrinex_AddColumn(sbfrinex_Obs_t* Obs,
+                               uint32_t        System,
+                               uint8_t         Type)
+/* gives a column to a signal type seen for the first time in a
+   constellation: that of the signal with the same RINEX code, if any,
+   or a new one.  Returns false if there is no room left. */
+{
+    sbfrinex_System_t* Sys = &Obs->Systems[System];
+    uint32_t           Col;
+
+    for (Col = 0; Col < Sys->NrOfSignals; Col++)
+    {
+        if (strcmp(SignalCodes[Sys->SignalTypes[Col]], SignalCodes[Type]) == 0)
+        {
+            Obs->Column[System][Type] = (int8_t)Col;
+            return true;
+        }
+    }
+
+    if (Sys->NrOfSignals == SBFRINEX_MAX_SIGNALS)
+    {
+        return false;
+    }
+
+    Obs->Column[System][Type] = (int8_t)Sys->NrOfSignals;
+    Sys->SignalTypes[Sys->NrOfSignals++] = Type;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutSpaces(sbfout_Stream_t* Out,
+                               uint32_t         Len)
+{
+    while (Len > 0)
+    {
+        uint32_t N = Len < sizeof(Spaces) - 1 ? Len : (uint32_t)sizeof(Spaces) - 1;
+
+        sbfout_Write(Out, Spaces, N);
+        Len -= N;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfrinex_IsObs(double Value)
+/* true if Value fits in the F14.3 field of an observation, which also
+   discards F64_NOTVALID and F32_NOTVALID */
+{
+    return Value > -1e9 && Value < 1e10;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfrinex_HasObs(const MeasSet_t* MeasSet)
+/* true if at least one observable of the signal can be written */
+{
+    return sbfrinex_IsObs(MeasSet->PR_m) || sbfrinex_IsObs(MeasSet->L_cycles) ||
+           sbfrinex_IsObs(MeasSet->doppler_Hz) || sbfrinex_IsObs(MeasSet->CN0_dBHz);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutObs(sbfout_Stream_t* Out,
+                            uint32_t*        Pending,
+                            double           Value,
+                            uint32_t         LLI,
+                            uint32_t         SSI)
+/* writes an observation as F14.3,I1,I1, or adds it to the spaces to
+   write before the next one if it is not available: the rows end after
+   their last observation */
+{
+    char Flags[2];
+
+    if (!sbfrinex_IsObs(Value))
+    {
+        *Pending += SBFRINEX_OBS_WIDTH;
+        return;
+    }
+
+    sbfrinex_PutSpaces(Out, *Pending);
+    *Pending = 0;
+
+    Flags[0] = LLI != 0 ? (char)('0' + LLI) : ' ';
+    Flags[1] = SSI != 0 ? (char)('0' + SSI) : ' ';
+
+    sbfout_PutFixed(Out, Value, 14, 3);
+    sbfout_Write(Out, Flags, sizeof(Flags));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfrinex_GetSSI(float CN0_dBHz)
+/* signal strength indicator: 1 below 12 dB-Hz, then one step each 6
+   dB-Hz up to 9 from 54 dB-Hz, or 0 if unknown */
+{
+    if (CN0_dBHz == F32_NOTVALID || !(CN0_dBHz > 0.0F))
+    {
+        return 0;
+    }
+
+    if (CN0_dBHz < 12.0F)
+    {
+        return 1;
+    }
+
+    return CN0_dBHz >= 54.0F ? 9 : 2 + (uint32_t)((CN0_dBHz - 12.0F) / 6.0F);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutSignal(sbfrinex_Obs_t*  Obs,
+                               uint32_t*        Pending,
+                               uint8_t          SVID,
+                               const MeasSet_t* MeasSet)
+/* writes the observables of a signal and updates its tracking state */
+{
+    sbfrinex_Lock_t* Lock = &Obs->Lock[SVID][MeasSet->signalType];
+    uint32_t         SSI  = sbfrinex_GetSSI(MeasSet->CN0_dBHz);
+    uint32_t         LLI  = 0;
+
+    /* the lock is lost if the signal was not tracked at the previous
+       epoch, or if its lock count or PLL lock time went back; nothing
+       is known at the first epoch */
+    if (Obs->NrOfEpochs > 1 &&
+        (Lock->Epoch != Obs->NrOfEpochs - 1 ||
+         Lock->LockCount != MeasSet->lockCount ||
+         MeasSet->PLLTimer_ms < Lock->PLLTimer_ms))
+    {
+        LLI |= 1;
+    }
+
+    if ((MeasSet->flags & MEASFLAG_HALFCYCLEAMBIGUITY) != 0)
+    {
+        LLI |= 2;
+    }
+
+    Lock->Epoch       = Obs->NrOfEpochs;
+    Lock->PLLTimer_ms = MeasSet->PLLTimer_ms;
+    Lock->LockCount   = MeasSet->lockCount;
+
+    sbfrinex_PutObs(&Obs->Body, Pending, MeasSet->PR_m, 0, SSI);
+    sbfrinex_PutObs(&Obs->Body, Pending, MeasSet->L_cycles, LLI, SSI);
+    sbfrinex_PutObs(&Obs->Body, Pending, MeasSet->doppler_Hz, 0, SSI);
+    sbfrinex_PutObs(&Obs->Body, Pending, MeasSet->CN0_dBHz, 0, 0);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_AddEpoch(void*              Context,
+                       const MeasEpoch_t* MeasEpoch)
+{
+    sbfrinex_Obs_t*     Obs = (sbfrinex_Obs_t*)Context;
+    sbfout_Stream_t*    Out = &Obs->Body;
+    int8_t              SystemOf[NR_OF_LOGICALCHANNELS];
+    uint32_t            NrOfSats = 0;
+    sbfrinex_Calendar_t Calendar;
+    int64_t             Time_ms;
+    uint32_t            i, SigIdx;
+
+    if (MeasEpoch->TOW_ms == U32_NOTVALID || MeasEpoch->WNc == U16_NOTVALID)
+    {
+        return;
+    }
+
+    Time_ms = (int64_t)MeasEpoch->WNc * 604800000LL + MeasEpoch->TOW_ms;
+
+    /* the satellites with at least one signal with a RINEX code and an
+       observable to write, and the columns of the signals seen for the
+       first time */
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        uint8_t                    SVID   = convertSVIDtoSBF(ChannelData->PRN);
+        int                        System = sbfrinex_GetSystem(SVID);
+
+        SystemOf[i] = -1;
+
+        if (System < 0)
+        {
+            continue;
+        }
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+            uint8_t                Type    = MeasSet->signalType;
+
+            if (MeasSet->flags == 0 || Type >= 64 || SignalCodes[Type][0] == '\0')
+            {
+                continue;
+            }
+
+            if (Obs->Column[System][Type] < 0 && !sbfrinex_AddColumn(Obs, (uint32_t)System, Type))
+            {
+                continue;
+            }
+
+            /* no row for the satellites without any observable to
+               write */
+            if (sbfrinex_HasObs(MeasSet))
+            {
+                SystemOf[i] = (int8_t)System;
+            }
+        }
+
+        if (SystemOf[i] >= 0)
+        {
+            NrOfSats++;
+
+            if (SystemLetters[System] == 'R' && ChannelData->fnPlus8 != 0)
+            {
+                Obs->GLOFreq[atoi(getSatelliteNameFromSBF(SVID) + 1) % 33] = (int8_t)ChannelData->fnPlus8;
+            }
+        }
+    }
+
+    if (NrOfSats == 0)
+    {
+        return;
+    }
+
+    if (Obs->NrOfEpochs == 0)
+    {
+        Obs->FirstEpoch_ms = Time_ms;
+    }
+    else if (Time_ms > Obs->LastEpoch_ms &&
+             (Obs->Interval_ms == 0 || Time_ms - Obs->LastEpoch_ms < Obs->Interval_ms))
+    {
+        Obs->Interval_ms = Time_ms - Obs->LastEpoch_ms;
+    }
+
+    Obs->LastEpoch_ms = Time_ms;
+    Obs->NrOfEpochs++;
+
+    /* epoch record: time, epoch flag (0: OK) and number of satellites */
+    sbfrinex_GetCalendar(Time_ms, &Calendar);
+    sbfout_Printf(Out, "> %04d %02d %02d %02d %02d",
+                  Calendar.Year, Calendar.Month, Calendar.Day, Calendar.Hour, Calendar.Min);
+    sbfout_PutFixed(Out, Calendar.Sec, 11, 7);
+    sbfout_Write(Out, "  0", 3);
+    sbfout_PutInt(Out, NrOfSats, 3);
+    sbfout_Write(Out, "\n", 1);
+
+    /* a row per satellite, with the observables of each signal in the
+       column of the signal */
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        const MeasSet_t*           Columns[SBFRINEX_MAX_SIGNALS] = {NULL};
+        uint8_t                    SVID = convertSVIDtoSBF(ChannelData->PRN);
+        uint32_t                   NrOfColumns = 0;
+        uint32_t                   Pending = 0;
+        uint32_t                   Col;
+
+        if (SystemOf[i] < 0)
+        {
+            continue;
+        }
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+            uint8_t                Type    = MeasSet->signalType;
+
+            if (MeasSet->flags == 0 || Type >= 64 || Obs->Column[SystemOf[i]][Type] < 0)
+            {
+                continue;
+            }
+
+            Col = (uint32_t)Obs->Column[SystemOf[i]][Type];
+
+            if (Columns[Col] == NULL)
+            {
+                Columns[Col] = MeasSet;
+
+                if (Col >= NrOfColumns)
+                {
+                    NrOfColumns = Col + 1;
+                }
+            }
+        }
+
+        sbfout_Write(Out, getSatelliteNameFromSBF(SVID), 3);
+
+        for (Col = 0; Col < NrOfColumns; Col++)
+        {
+            if (Columns[Col] == NULL)
+            {
+                Pending += SBFRINEX_NR_OF_OBS * SBFRINEX_OBS_WIDTH;
+            }
+            else
+            {
+                sbfrinex_PutSignal(Obs, &Pending, SVID, Columns[Col]);
+            }
+        }
+
+        sbfout_Write(Out, "\n", 1);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_AddReceiverSetup(void*       Context,
+                               const void* SBFBlock)
+{
+    sbfrinex_Obs_t*            Obs   = (sbfrinex_Obs_t*)Context;
+    const ReceiverSetup_1_0_t* Setup = (const ReceiverSetup_1_0_t*)SBFBlock;
+
+    /* the fields of revision 0 are at the same place in all the
+       revisions */
+    sbfrinex_CopyText(Obs->MarkerName, sizeof(Obs->MarkerName), Setup->MarkerName, sizeof(Setup->MarkerName));
+    sbfrinex_CopyText(Obs->MarkerNumber, sizeof(Obs->MarkerNumber), Setup->MarkerNumber, sizeof(Setup->MarkerNumber));
+    sbfrinex_CopyText(Obs->Observer, sizeof(Obs->Observer), Setup->Observer, sizeof(Setup->Observer));
+    sbfrinex_CopyText(Obs->Agency, sizeof(Obs->Agency), Setup->Agency, sizeof(Setup->Agency));
+    sbfrinex_CopyText(Obs->RxSerialNbr, sizeof(Obs->RxSerialNbr), Setup->RxSerialNbr, sizeof(Setup->RxSerialNbr));
+    sbfrinex_CopyText(Obs->RxName, sizeof(Obs->RxName), Setup->RxName, sizeof(Setup->RxName));
+    sbfrinex_CopyText(Obs->RxVersion, sizeof(Obs->RxVersion), Setup->RxVersion, sizeof(Setup->RxVersion));
+    sbfrinex_CopyText(Obs->AntSerialNbr, sizeof(Obs->AntSerialNbr), Setup->AntSerialNbr, sizeof(Setup->AntSerialNbr));
+    sbfrinex_CopyText(Obs->AntType, sizeof(Obs->AntType), Setup->AntType, sizeof(Setup->AntType));
+
+    Obs->Delta[0]  = Setup->deltaH;
+    Obs->Delta[1]  = Setup->deltaE;
+    Obs->Delta[2]  = Setup->deltaN;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_AddPVTCartesian(void*       Context,
+                              const void* SBFBlock)
+{
+    sbfrinex_Obs_t*           Obs = (sbfrinex_Obs_t*)Context;
+    const PVTCartesian_2_0_t* PVT = (const PVTCartesian_2_0_t*)SBFBlock;
+
+    if (!Obs->HavePosition && PVT->Error == 0 && PVT->X != F64_NOTVALID)
+    {
+        Obs->Position[0]  = PVT->X;
+        Obs->Position[1]  = PVT->Y;
+        Obs->Position[2]  = PVT->Z;
+        Obs->HavePosition = true;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_PutRecord(sbfout_Stream_t* Out,
+                        const char*      Text,
+                        const char*      Label)
+{
+    sbfout_Printf(Out, "%-60.60s%s\n", Text, Label);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_PutProgramRecord(sbfout_Stream_t* Out,
+                               const char*      Program)
+{
+    char       Text[64];
+    char       Date[32];
+    time_t     Now = time(NULL);
+    struct tm* UTC = gmtime(&Now);
+
+    if (UTC == NULL || strftime(Date, sizeof(Date), "%Y%m%d %H%M%S UTC", UTC) == 0)
+    {
+        Date[0] = '\0';
+    }
+
+    (void)snprintf(Text, sizeof(Text), "%-20.20s%-20.20s%.20s", Program, "", Date);
+    sbfrinex_PutRecord(Out, Text, "PGM / RUN BY / DATE");
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_TimeRecord(sbfout_Stream_t* Out,
+                                int64_t          Time_ms,
+                                const char*      Label)
+{
+    sbfrinex_Calendar_t Calendar;
+    char                Text[61];
+
+    sbfrinex_GetCalendar(Time_ms, &Calendar);
+    (void)snprintf(Text, sizeof(Text), "%6d%6d%6d%6d%6d%13.7f     GPS",
+                   Calendar.Year, Calendar.Month, Calendar.Day,
+                   Calendar.Hour, Calendar.Min, Calendar.Sec);
+    sbfrinex_PutRecord(Out, Text, Label);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_WriteHeader(sbfrinex_Obs_t* Obs)
+{
+    sbfout_Stream_t* Out = Obs->Out;
+    char             Text[128];
+    uint32_t         NrOfSystems = 0;
+    char             System = 'M';
+    uint32_t         s, i, n;
+
+    for (s = 0; s < SBFRINEX_NR_OF_SYSTEMS; s++)
+    {
+        if (Obs->Systems[s].NrOfSignals > 0)
+        {
+            NrOfSystems++;
+            System = SystemLetters[s];
+        }
+    }
+
+    if (NrOfSystems != 1)
+    {
+        System = 'M';
+    }
+
+    (void)snprintf(Text, sizeof(Text), "%9.2f%11s%-20s%c", Obs->Version >= 4 ? 4.00 : 3.04, "",
+                   "OBSERVATION DATA", System);
+    sbfrinex_PutRecord(Out, Text, "RINEX VERSION / TYPE");
+
+    sbfrinex_PutProgramRecord(Out, Obs->Program);
+
+    sbfrinex_PutRecord(Out, Obs->MarkerName[0] != '\0' ? Obs->MarkerName : "UNKNOWN", "MARKER NAME");
+
+    if (Obs->MarkerNumber[0] != '\0')
+    {
+        sbfrinex_PutRecord(Out, Obs->MarkerNumber, "MARKER NUMBER");
+    }
+
+    (void)snprintf(Text, sizeof(Text), "%-20.20s%-40.40s", Obs->Observer, Obs->Agency);
+    sbfrinex_PutRecord(Out, Text, "OBSERVER / AGENCY");
+
+    (void)snprintf(Text, sizeof(Text), "%-20.20s%-20.20s%-20.20s",
+                   Obs->RxSerialNbr, Obs->RxName, Obs->RxVersion);
+    sbfrinex_PutRecord(Out, Text, "REC # / TYPE / VERS");
+
+    (void)snprintf(Text, sizeof(Text), "%-20.20s%-20.20s", Obs->AntSerialNbr, Obs->AntType);
+    sbfrinex_PutRecord(Out, Text, "ANT # / TYPE");
+
+    (void)snprintf(Text, sizeof(Text), "%14.4f%14.4f%14.4f",
+                   Obs->Position[0], Obs->Position[1], Obs->Position[2]);
+    sbfrinex_PutRecord(Out, Text, "APPROX POSITION XYZ");
+
+    (void)snprintf(Text, sizeof(Text), "%14.4f%14.4f%14.4f",
+                   Obs->Delta[0], Obs->Delta[1], Obs->Delta[2]);
+    sbfrinex_PutRecord(Out, Text, "ANTENNA: DELTA H/E/N");
+
+    /* the observation types of each constellation, 13 per record */
+    for (s = 0; s < SBFRINEX_NR_OF_SYSTEMS; s++)
+    {
+        const sbfrinex_System_t* Sys = &Obs->Systems[s];
+        uint32_t                 NrOfObs = Sys->NrOfSignals * SBFRINEX_NR_OF_OBS;
+        size_t                   Len = 0;
+
+        if (NrOfObs == 0)
+        {
+            continue;
+        }
+
+        for (n = 0; n < NrOfObs; n++)
+        {
+            const char* Code = SignalCodes[Sys->SignalTypes[n / SBFRINEX_NR_OF_OBS]];
+
+            if (n % 13 == 0)
+            {
+                if (n > 0)
+                {
+                    sbfrinex_PutRecord(Out, Text, "SYS / # / OBS TYPES");
+                }
+
+                Len = (size_t)(n == 0 ? snprintf(Text, sizeof(Text), "%c  %3u", SystemLetters[s], NrOfObs)
+                                      : snprintf(Text, sizeof(Text), "      "));
+            }
+
+            Len += (size_t)snprintf(Text + Len, sizeof(Text) - Len, " %c%s",
+                                    ObsLetters[n % SBFRINEX_NR_OF_OBS], Code);
+        }
+
+        sbfrinex_PutRecord(Out, Text, "SYS / # / OBS TYPES");
+    }
+
+    (void)snprintf(Text, sizeof(Text), "%-20s", "DBHZ");
+    sbfrinex_PutRecord(Out, Text, "SIGNAL STRENGTH UNIT");
+
+    if (Obs->Interval_ms > 0)
+    {
+        (void)snprintf(Text, sizeof(Text), "%10.3f", (double)Obs->Interval_ms / 1000.0);
+        sbfrinex_PutRecord(Out, Text, "INTERVAL");
+    }
+
+    if (Obs->NrOfEpochs > 0)
+    {
+        sbfrinex_TimeRecord(Out, Obs->FirstEpoch_ms, "TIME OF FIRST OBS");
+        sbfrinex_TimeRecord(Out, Obs->LastEpoch_ms, "TIME OF LAST OBS");
+    }
+
+    /* the phase shifts applied to the observations are not known */
+    if (Obs->Version < 4)
+    {
+        for (s = 0; s < SBFRINEX_NR_OF_SYSTEMS; s++)
+        {
+            if (Obs->Systems[s].NrOfSignals > 0)
+            {
+                (void)snprintf(Text, sizeof(Text), "%c", SystemLetters[s]);
+                sbfrinex_PutRecord(Out, Text, "SYS / PHASE SHIFT");
+            }
+        }
+    }
+
+    /* the frequency numbers of the GLONASS slots, 8 per record */
+    for (i = 1, n = 0; i < 33; i++)
+    {
+        n += Obs->GLOFreq[i] != 0 ? 1 : 0;
+    }
+
+    if (n > 0)
+    {
+        uint32_t Count = 0;
+        size_t   Len = (size_t)snprintf(Text, sizeof(Text), "%3u ", n);
+
+        for (i = 1; i < 33; i++)
+        {
+            if (Obs->GLOFreq[i] == 0)
+            {
+                continue;
+            }
+
+            if (Count > 0 && Count % 8 == 0)
+            {
+                sbfrinex_PutRecord(Out, Text, "GLONASS SLOT / FRQ #");
+                Len = (size_t)snprintf(Text, sizeof(Text), "    ");
+            }
+
+            Len += (size_t)snprintf(Text + Len, sizeof(Text) - Len, "R%02u %2d ",
+                                    i, Obs->GLOFreq[i] - 8);
+            Count++;
+        }
+
+        sbfrinex_PutRecord(Out, Text, "GLONASS SLOT / FRQ #");
+    }
+
+    /* the GLONASS code-phase biases are not known */
+    if (Obs->Systems[1].NrOfSignals > 0)
+    {
+        sbfrinex_PutRecord(Out, " C1C          C1P          C2C          C2P", "GLONASS COD/PHS/BIS");
+    }
+
+    sbfrinex_PutRecord(Out, "", "END OF HEADER");
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfrinex_CloseObs(sbfrinex_Obs_t* Obs)
+{
+    char Data[16384];
+    int  Error;
+
+    if (sbfout_Close(&Obs->Body) != 0)
+    {
+        Obs->Error = errno;
+    }
+
+    sbfrinex_WriteHeader(Obs);
+
+    /* the epochs follow the header */
+    if (Obs->Error == 0 && fseek(Obs->Spill, 0, SEEK_SET) != 0)
+    {
+        Obs->Error = errno != 0 ? errno : EIO;
+    }
+
+    while (Obs->Error == 0)
+    {
+        size_t Len = fread(Data, 1, sizeof(Data), Obs->Spill);
+
+        sbfout_Write(Obs->Out, Data, Len);
+
+        if (Len < sizeof(Data))
+        {
+            if (ferror(Obs->Spill))
+            {
+                Obs->Error = errno != 0 ? errno : EIO;
+            }
+
+            break;
+        }
+    }
+
+    (void)fclose(Obs->Spill);
+
+    Error = Obs->Error;
+    free(Obs);
+
+    return Error;
+}
@@ -0,0 +1,99 @@
+/*
+ * sbfrinex.h: Declaration of the RINEX 3.x/4.x observation file writer.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFRINEX_H
+#define SBFRINEX_H 1
+
+#include <stdint.h>
+
+#include "measepoch.h"
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sbfrinex_Obs_s sbfrinex_Obs_t;
+
+/* calendar date and time of day */
+typedef struct
+{
+    int    Year;
+    int    Month;
+    int    Day;
+    int    Hour;
+    int    Min;
+    double Sec;
+} sbfrinex_Calendar_t;
+
+/* Convert a GPS time, in ms since the GPS epoch (6 January 1980), to a
+   calendar date in GPS time. */
+void sbfrinex_GetCalendar(int64_t              Time_ms,
+                          sbfrinex_Calendar_t* Calendar);
+
+/* Write a header record: Text in the 60 columns of data, and Label. */
+void sbfrinex_PutRecord(sbfout_Stream_t* Out,
+                        const char*      Text,
+                        const char*      Label);
+
+/* Write the PGM / RUN BY / DATE header record, with the current date. */
+void sbfrinex_PutProgramRecord(sbfout_Stream_t* Out,
+                               const char*      Program);
+
+/* Start a RINEX observation file of version Version (3 for RINEX 3.04,
+   4 for RINEX 4.00), written to Out by sbfrinex_CloseObs().  Program
+   is written in the PGM / RUN BY / DATE header record.
+
+   The header lists the observation types found in the epochs: as they
+   are only known at the end, the epochs are formatted to a temporary
+   file, and copied to Out after the header.  The observation types of
+   each constellation are in the order in which they are found, so
+   that the rows of the first epochs only have to be shorter.
+
+   Returns NULL if the temporary file or the memory cannot be
+   allocated (errno is set). */
+sbfrinex_Obs_t* sbfrinex_CreateObs(sbfout_Stream_t* Out,
+                                   uint32_t         Version,
+                                   const char*      Program);
+
+/* Write the code (C), phase (L), Doppler (D) and C/N0 (S) observables
+   of the main antenna of an epoch, with the signature of an epoch
+   handler of sbfconsumer (Context is the sbfrinex_Obs_t).  The loss
+   of lock indicator is set when the lock count or the PLL lock time
+   of a signal shows a cycle slip since the previous epoch, and for
+   the half-cycle ambiguities; the signal strength indicator is derived
+   from the C/N0. */
+void sbfrinex_AddEpoch(void*              Context,
+                       const MeasEpoch_t* MeasEpoch);
+
+/* Block handlers, for the marker, receiver and antenna records of the
+   header (ReceiverSetup) and for the approximate position of the
+   marker (the first valid PVTCartesian, revision 2). */
+void sbfrinex_AddReceiverSetup(void*       Context,
+                               const void* SBFBlock);
+
+void sbfrinex_AddPVTCartesian(void*       Context,
+                              const void* SBFBlock);
+
+/* Write the header and the epochs to Out, and free Obs.  Returns 0 on
+   success, or the errno of the first error. */
+int sbfrinex_CloseObs(sbfrinex_Obs_t* Obs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1145 @@
+/*
+ * sbfrinexnav.c: RINEX 3.x/4.x navigation file writer.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sbfrinexnav.h"
+#include "sbfrinex.h"
+#include "sbfread.h"
+#include "sbfsvid.h"
+#include "sbftime.h"
+
+#define SECONDS_PER_WEEK  604800
+
+/* BeiDou time is 14 s behind GPS time, with the weeks counted from
+   GPS week 1356 */
+#define BDT_WEEK0        1356
+#define BDT_OFFSET_s     ((int64_t)BDT_WEEK0 * SECONDS_PER_WEEK + 14)
+
+/* the semi-circles of the SBF orbits, in radians (value of pi of the
+   GPS ICD) */
+#define SBFRINEX_PI  3.1415926535898
+
+/* the constellations, in the order of the records at the same time */
+static const char SystemLetters[] = "GRECJ";
+
+const uint16_t sbfrinex_NavBlockNumbers[SBFRINEX_NR_OF_NAVBLOCKS] =
+{
+    sbfnr_GPSNav_1, sbfnr_GALNav_1, sbfnr_GLONav_1, sbfnr_BDSNav_1, sbfnr_QZSNav_1,
+    sbfnr_GPSIon_1, sbfnr_GPSUtc_1, sbfnr_GALIon_1, sbfnr_GALUtc_1, sbfnr_GALGstGps_1,
+    sbfnr_GLOTime_1, sbfnr_BDSIon_1, sbfnr_BDSUtc_1
+};
+
+/* index of each block in sbfrinex_NavBlockNumbers: the ephemerides
+   come first */
+#define NAV_GPSNAV     0
+#define NAV_GALNAV     1
+#define NAV_GLONAV     2
+#define NAV_BDSNAV     3
+#define NAV_QZSNAV     4
+#define NAV_GPSION     5
+#define NAV_GPSUTC     6
+#define NAV_GALION     7
+#define NAV_GALUTC     8
+#define NAV_GALGSTGPS  9
+#define NAV_GLOTIME   10
+#define NAV_BDSION    11
+#define NAV_BDSUTC    12
+
+/* shortest length of each block (revision 0) */
+static const uint16_t NavBlockLengths[SBFRINEX_NR_OF_NAVBLOCKS] =
+{
+    sizeof(GPSNav_1_t), sizeof(GALNav_1_t), sizeof(GLONav_1_0_t), sizeof(BDSNav_1_t),
+    sizeof(QZSNav_1_t), sizeof(GPSIon_1_t), sizeof(GPSUtc_1_t), sizeof(GALIon_1_t),
+    sizeof(GALUtc_1_t), sizeof(GALGstGps_1_t), sizeof(GLOTime_1_t), sizeof(BDSIon_1_t),
+    sizeof(BDSUtc_1_t)
+};
+
+/* accuracy in meters of the URA index of GPS, QZSS and BeiDou */
+static const double URAs_m[16] =
+{
+    2.4, 3.4, 4.85, 6.85, 9.65, 13.65, 24.0, 48.0,
+    96.0, 192.0, 384.0, 768.0, 1536.0, 3072.0, 6144.0, 6144.0
+};
+
+/* the blocks kept, copied whole */
+typedef union
+{
+    TimeHeader_t  Head;
+    GPSNav_1_t    GPSNav;
+    GALNav_1_t    GALNav;
+    GLONav_1_0_t  GLONav;
+    BDSNav_1_t    BDSNav;
+    QZSNav_1_t    QZSNav;
+    GPSIon_1_t    GPSIon;
+    GPSUtc_1_t    GPSUtc;
+    GALIon_1_t    GALIon;
+    GALUtc_1_t    GALUtc;
+    GALGstGps_1_t GALGstGps;
+    GLOTime_1_t   GLOTime;
+    BDSIon_1_t    BDSIon;
+    BDSUtc_1_t    BDSUtc;
+} sbfrinex_NavBlock_t;
+
+typedef struct
+{
+    int64_t             Time_ms;  /* GPS time of the record: time of
+                                     clock of the ephemerides, time of
+                                     transmission of the others */
+    uint32_t            Seq;      /* order of arrival */
+    uint8_t             Kind;     /* NAV_GPSNAV, ... */
+    uint8_t             System;   /* index in SystemLetters */
+    uint8_t             SVID;
+    sbfrinex_NavBlock_t Block;
+} sbfrinex_NavRecord_t;
+
+struct sbfrinex_Nav_s
+{
+    sbfout_Stream_t*      Out;
+    uint32_t              Version;
+    char                  Program[21];
+
+    sbfrinex_NavRecord_t* Records;
+    uint32_t              NrOfRecords;
+    uint32_t              MaxNrOfRecords;
+
+    uint64_t*             Keys;       /* hash set of the keys of the
+                                         records, 0 in the free slots */
+    uint32_t              KeyBits;    /* 2^KeyBits slots */
+
+    int                   Error;      /* errno of the first error, or 0 */
+};
+
+
+/*---------------------------------------------------------------------------*/
+sbfrinex_Nav_t* sbfrinex_CreateNav(sbfout_Stream_t* Out,
+                                   uint32_t         Version,
+                                   const char*      Program)
+{
+    sbfrinex_Nav_t* Nav = (sbfrinex_Nav_t*)calloc(1, sizeof(*Nav));
+
+    if (Nav != NULL)
+    {
+        Nav->Out     = Out;
+        Nav->Version = Version;
+        (void)snprintf(Nav->Program, sizeof(Nav->Program), "%s", Program);
+    }
+
+    return Nav;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfrinex_GetSlot(uint64_t Key,
+                                 uint32_t KeyBits)
+/* first slot of a key (Fibonacci hashing) */
+{
+    return (uint32_t)((Key * 0x9E3779B97F4A7C15ULL) >> (64 - KeyBits));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfrinex_GrowKeys(sbfrinex_Nav_t* Nav)
+/* doubles the number of slots of the hash set */
+{
+    uint32_t  KeyBits = Nav->KeyBits == 0 ? 10 : Nav->KeyBits + 1;
+    uint32_t  Mask    = (1U << KeyBits) - 1;
+    uint64_t* Keys    = (uint64_t*)calloc((size_t)Mask + 1, sizeof(*Keys));
+    uint32_t  i;
+
+    if (Keys == NULL)
+    {
+        return false;
+    }
+
+    for (i = 0; Nav->KeyBits > 0 && i < (1U << Nav->KeyBits); i++)
+    {
+        if (Nav->Keys[i] != 0)
+        {
+            uint32_t Slot = sbfrinex_GetSlot(Nav->Keys[i], KeyBits);
+
+            while (Keys[Slot] != 0)
+            {
+                Slot = (Slot + 1) & Mask;
+            }
+
+            Keys[Slot] = Nav->Keys[i];
+        }
+    }
+
+    free(Nav->Keys);
+    Nav->Keys    = Keys;
+    Nav->KeyBits = KeyBits;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfrinex_InsertKey(sbfrinex_Nav_t* Nav,
+                               uint64_t        Key)
+/* adds the key of a record to the hash set.  Returns false if it was
+   already there. */
+{
+    uint32_t Mask;
+    uint32_t Slot;
+
+    /* linear probing, with the set at most half full */
+    if (2 * (Nav->NrOfRecords + 1) > (Nav->KeyBits > 0 ? 1U << Nav->KeyBits : 0) &&
+        !sbfrinex_GrowKeys(Nav))
+    {
+        Nav->Error = ENOMEM;
+        return false;
+    }
+
+    Mask = (1U << Nav->KeyBits) - 1;
+    Slot = sbfrinex_GetSlot(Key, Nav->KeyBits);
+
+    while (Nav->Keys[Slot] != 0)
+    {
+        if (Nav->Keys[Slot] == Key)
+        {
+            return false;
+        }
+
+        Slot = (Slot + 1) & Mask;
+    }
+
+    Nav->Keys[Slot] = Key;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint64_t sbfrinex_GetEphKey(uint8_t  SVID,
+                                   uint32_t IOD,
+                                   int64_t  Toe_s)
+/* key of an ephemeris: satellite, issue of data and reference time */
+{
+    return ((uint64_t)SVID << 48) | ((uint64_t)(IOD & 0xffff) << 32) | (uint64_t)(uint32_t)Toe_s;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint64_t sbfrinex_GetParamKey(uint32_t       Kind,
+                                     const uint8_t* Params,
+                                     size_t         Len)
+/* key of ionosphere or UTC parameters: FNV-1a hash of their values,
+   with bit 56 set to never be the key of an ephemeris */
+{
+    uint64_t Hash = 0xcbf29ce484222325ULL ^ Kind;
+    size_t   i;
+
+    for (i = 0; i < Len; i++)
+    {
+        Hash = (Hash ^ Params[i]) * 0x100000001b3ULL;
+    }
+
+    return (1ULL << 56) | (Hash & ((1ULL << 56) - 1));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int64_t sbfrinex_GetNearTime(int64_t  Ref_s,
+                                    uint32_t SecondsOfWeek)
+/* the time at SecondsOfWeek in the week closest to Ref_s: the weeks
+   of the reference times of the ephemerides are not always those of
+   the block (or modulo 1024) */
+{
+    int64_t Time_s = Ref_s - Ref_s % SECONDS_PER_WEEK + SecondsOfWeek;
+
+    if (Time_s - Ref_s > SECONDS_PER_WEEK / 2)
+    {
+        Time_s -= SECONDS_PER_WEEK;
+    }
+    else if (Ref_s - Time_s > SECONDS_PER_WEEK / 2)
+    {
+        Time_s += SECONDS_PER_WEEK;
+    }
+
+    return Time_s;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int sbfrinex_GetNavSystem(uint8_t SVID)
+/* index of the constellation of a satellite in SystemLetters, or -1 */
+{
+    const char* Name = getSatelliteNameFromSBF(SVID);
+    const char* Letter;
+
+    if (Name[0] == '\0' || Name[1] < '0' || Name[1] > '9')
+    {
+        return -1;
+    }
+
+    Letter = strchr(SystemLetters, Name[0]);
+
+    return Letter != NULL ? (int)(Letter - SystemLetters) : -1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfrinex_AddNavBlock(void*       Context,
+                          const void* SBFBlock)
+{
+    sbfrinex_Nav_t*            Nav   = (sbfrinex_Nav_t*)Context;
+    const sbfrinex_NavBlock_t* Block = (const sbfrinex_NavBlock_t*)SBFBlock;
+    uint16_t                   BlockNumber = SBF_ID_TO_NUMBER(Block->Head.Header.ID);
+    size_t                     Length = Block->Head.Header.Length;
+    sbfrinex_NavRecord_t*      Record;
+    uint32_t                   Kind;
+    int64_t                    Ref_s;
+    int64_t                    Time_s;
+    uint64_t                   Key;
+    uint8_t                    SVID;
+    int                        System;
+
+    for (Kind = 0; Kind < SBFRINEX_NR_OF_NAVBLOCKS; Kind++)
+    {
+        if (sbfrinex_NavBlockNumbers[Kind] == BlockNumber)
+        {
+            break;
+        }
+    }
+
+    if (Kind == SBFRINEX_NR_OF_NAVBLOCKS || Length < NavBlockLengths[Kind] ||
+        Block->Head.TOW == U32_NOTVALID || Block->Head.WNc == U16_NOTVALID)
+    {
+        return;
+    }
+
+    Ref_s = (int64_t)Block->Head.WNc * SECONDS_PER_WEEK + Block->Head.TOW / 1000;
+
+    switch (Kind)
+    {
+    case NAV_GPSNAV:
+        SVID   = Block->GPSNav.Eph.PRN;
+        Key    = sbfrinex_GetEphKey(SVID, Block->GPSNav.Eph.IODE2,
+                                    sbfrinex_GetNearTime(Ref_s, Block->GPSNav.Eph.t_oe));
+        Time_s = sbfrinex_GetNearTime(Ref_s, Block->GPSNav.Eph.t_oc);
+        break;
+
+    case NAV_QZSNAV:
+        SVID   = Block->QZSNav.Eph.PRN;
+        Key    = sbfrinex_GetEphKey(SVID, Block->QZSNav.Eph.IODE2,
+                                    sbfrinex_GetNearTime(Ref_s, Block->QZSNav.Eph.t_oe));
+        Time_s = sbfrinex_GetNearTime(Ref_s, Block->QZSNav.Eph.t_oc);
+        break;
+
+    case NAV_GALNAV:
+        /* the I/NAV and F/NAV ephemerides are different records */
+        SVID   = Block->GALNav.Eph.SVID;
+        Key    = sbfrinex_GetEphKey(SVID, Block->GALNav.Eph.IODnav | ((uint32_t)Block->GALNav.Eph.Source << 10),
+                                    sbfrinex_GetNearTime(Ref_s, Block->GALNav.Eph.t_oe));
+        Time_s = sbfrinex_GetNearTime(Ref_s, Block->GALNav.Eph.t_oc);
+        break;
+
+    case NAV_GLONAV:
+        SVID   = Block->GLONav.Eph.SVID;
+        Time_s = sbfrinex_GetNearTime(Ref_s, Block->GLONav.Eph.t_oe);
+        Key    = sbfrinex_GetEphKey(SVID, 0, Time_s);
+        break;
+
+    case NAV_BDSNAV:
+        /* in BeiDou time */
+        SVID   = Block->BDSNav.Eph.PRN;
+        Key    = sbfrinex_GetEphKey(SVID, Block->BDSNav.Eph.IODE,
+                                    sbfrinex_GetNearTime(Ref_s - BDT_OFFSET_s, Block->BDSNav.Eph.t_oe));
+        Time_s = sbfrinex_GetNearTime(Ref_s - BDT_OFFSET_s, Block->BDSNav.Eph.t_oc) + BDT_OFFSET_s;
+        break;
+
+    default:
+        /* the satellite is at the same place in all the ionosphere and
+           UTC blocks, and is not part of their values */
+        SVID   = Block->GPSIon.Ion.PRN;
+        Key    = sbfrinex_GetParamKey(Kind, (const uint8_t*)SBFBlock + sizeof(TimeHeader_t) + 2,
+                                      NavBlockLengths[Kind] - sizeof(TimeHeader_t) - 2);
+        Time_s = Ref_s;
+        break;
+    }
+
+    System = sbfrinex_GetNavSystem(SVID);
+
+    if (System < 0)
+    {
+        return;
+    }
+
+    if (Nav->NrOfRecords == Nav->MaxNrOfRecords)
+    {
+        uint32_t              MaxNrOfRecords = Nav->MaxNrOfRecords == 0 ? 1024 : 2 * Nav->MaxNrOfRecords;
+        sbfrinex_NavRecord_t* Records = (sbfrinex_NavRecord_t*)realloc(Nav->Records,
+                                                                       MaxNrOfRecords * sizeof(*Records));
+
+        if (Records == NULL)
+        {
+            Nav->Error = ENOMEM;
+            return;
+        }
+
+        Nav->Records        = Records;
+        Nav->MaxNrOfRecords = MaxNrOfRecords;
+    }
+
+    if (!sbfrinex_InsertKey(Nav, Key))
+    {
+        return;
+    }
+
+    Record = &Nav->Records[Nav->NrOfRecords];
+
+    Record->Time_ms = Time_s * 1000;
+    Record->Seq     = Nav->NrOfRecords;
+    Record->Kind    = (uint8_t)Kind;
+    Record->System  = (uint8_t)System;
+    Record->SVID    = SVID;
+
+    memset(&Record->Block, 0, sizeof(Record->Block));
+    memcpy(&Record->Block, SBFBlock, Length < sizeof(Record->Block) ? Length : sizeof(Record->Block));
+
+    Nav->NrOfRecords++;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int sbfrinex_CompareRecords(const void* A,
+                                   const void* B)
+/* by time, then constellation and satellite, then order of arrival */
+{
+    const sbfrinex_NavRecord_t* RecA = (const sbfrinex_NavRecord_t*)A;
+    const sbfrinex_NavRecord_t* RecB = (const sbfrinex_NavRecord_t*)B;
+
+    if (RecA->Time_ms != RecB->Time_ms)
+    {
+        return RecA->Time_ms < RecB->Time_ms ? -1 : 1;
+    }
+
+    if (RecA->System != RecB->System)
+    {
+        return RecA->System < RecB->System ? -1 : 1;
+    }
+
+    if (RecA->SVID != RecB->SVID)
+    {
+        return RecA->SVID < RecB->SVID ? -1 : 1;
+    }
+
+    return RecA->Seq < RecB->Seq ? -1 : (RecA->Seq > RecB->Seq ? 1 : 0);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutNavValues(sbfout_Stream_t* Out,
+                                  const double*    Values,
+                                  uint32_t         NrOfValues)
+/* writes values in the D19.12 format (with an E), blank if not valid
+   (F64_NOTVALID or F32_NOTVALID), and ends the line after the last
+   valid one */
+{
+    uint32_t i;
+
+    while (NrOfValues > 0 && Values[NrOfValues - 1] == F64_NOTVALID)
+    {
+        NrOfValues--;
+    }
+
+    for (i = 0; i < NrOfValues; i++)
+    {
+        if (Values[i] == F64_NOTVALID)
+        {
+            sbfout_Write(Out, "                   ", 19);
+        }
+        else
+        {
+            sbfout_Printf(Out, "%19.12E", Values[i]);
+        }
+    }
+
+    sbfout_Write(Out, "\n", 1);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutNavEpoch(sbfout_Stream_t* Out,
+                                 int64_t          Time_s,
+                                 const double*    Values)
+/* writes an epoch in the time scale of the record, and the three
+   values that follow it */
+{
+    sbfrinex_Calendar_t Calendar;
+
+    sbfrinex_GetCalendar(Time_s * 1000, &Calendar);
+    sbfout_Printf(Out, " %04d %02d %02d %02d %02d %02d",
+                  Calendar.Year, Calendar.Month, Calendar.Day,
+                  Calendar.Hour, Calendar.Min, (int)Calendar.Sec);
+    sbfrinex_PutNavValues(Out, Values, 3);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutNavOrbits(sbfout_Stream_t* Out,
+                                  const double     Orbits[][4],
+                                  uint32_t         NrOfLines)
+/* writes the BROADCAST ORBIT lines of an ephemeris */
+{
+    uint32_t i;
+
+    for (i = 0; i < NrOfLines; i++)
+    {
+        sbfout_Write(Out, "    ", 4);
+        sbfrinex_PutNavValues(Out, Orbits[i], 4);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutNavName(sbfrinex_Nav_t*             Nav,
+                                const char*                 Type,
+                                const sbfrinex_NavRecord_t* Record,
+                                const char*                 Message)
+/* writes the record type line of RINEX 4 ("> EPH G01 LNAV"), then the
+   satellite that starts the first line */
+{
+    const char* Name = getSatelliteNameFromSBF(Record->SVID);
+
+    if (Nav->Version >= 4)
+    {
+        sbfout_Printf(Nav->Out, "> %s %.3s %s\n", Type, Name, Message);
+    }
+
+    /* the ION and STO records start with their epoch */
+    sbfout_Write(Nav->Out, strcmp(Type, "EPH") == 0 ? Name : "   ", 3);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double sbfrinex_GetValid(float Value)
+/* the float fields that can be not valid, with the same marker as the
+   double ones */
+{
+    return Value == F32_NOTVALID ? F64_NOTVALID : (double)Value;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double sbfrinex_GetFitInterval(const gpEph_1_t* Eph)
+/* curve fit interval in hours, from the fit interval flag and the
+   IODC (IS-GPS-200, table 20-XII) */
+{
+    if (Eph->FitIntFlg == 0)
+    {
+        return 4.0;
+    }
+
+    if (Eph->IODC >= 240 && Eph->IODC <= 247)
+    {
+        return 8.0;
+    }
+
+    if ((Eph->IODC >= 248 && Eph->IODC <= 255) || Eph->IODC == 496)
+    {
+        return 14.0;
+    }
+
+    if ((Eph->IODC >= 497 && Eph->IODC <= 503) || Eph->IODC >= 1021)
+    {
+        return 26.0;
+    }
+
+    return 6.0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutGPSEph(sbfrinex_Nav_t*             Nav,
+                               const sbfrinex_NavRecord_t* Record)
+{
+    /* the QZSS ephemeris has the layout of the GPS one */
+    const gpEph_1_t* Eph   = Record->Kind == NAV_QZSNAV ? (const gpEph_1_t*)&Record->Block.QZSNav.Eph
+                                                        : &Record->Block.GPSNav.Eph;
+    int64_t          Ref_s = (int64_t)Eph->WNc * SECONDS_PER_WEEK;
+    int64_t          Toe_s = sbfrinex_GetNearTime(Ref_s + Eph->TOW / 1000, Eph->t_oe);
+    int64_t          Week  = Toe_s / SECONDS_PER_WEEK;
+    double           Clock[3] = {Eph->a_f0, Eph->a_f1, Eph->a_f2};
+    double           Orbits[7][4] =
+    {
+        {Eph->IODE2, Eph->C_rs, Eph->DEL_N * SBFRINEX_PI, Eph->M_0 * SBFRINEX_PI},
+        {Eph->C_uc, Eph->e, Eph->C_us, Eph->SQRT_A},
+        {Eph->t_oe, Eph->C_ic, Eph->OMEGA_0 * SBFRINEX_PI, Eph->C_is},
+        {Eph->i_0 * SBFRINEX_PI, Eph->C_rc, Eph->omega * SBFRINEX_PI, Eph->OMEGADOT * SBFRINEX_PI},
+        {Eph->IDOT * SBFRINEX_PI, Eph->CAorPonL2, (double)Week, Eph->L2DataFlag},
+        {URAs_m[Eph->URA & 15], Eph->health, sbfrinex_GetValid(Eph->T_gd), Eph->IODC},
+        {(double)(Ref_s - Week * SECONDS_PER_WEEK) + Eph->TOW / 1000.0,
+         Record->Kind == NAV_QZSNAV ? Eph->FitIntFlg : sbfrinex_GetFitInterval(Eph),
+         F64_NOTVALID, F64_NOTVALID}
+    };
+
+    sbfrinex_PutNavName(Nav, "EPH", Record, "LNAV");
+    sbfrinex_PutNavEpoch(Nav->Out, Record->Time_ms / 1000, Clock);
+    sbfrinex_PutNavOrbits(Nav->Out, Orbits, 7);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double sbfrinex_GetSISA(uint8_t SISA)
+/* signal in space accuracy in meters, or -1 if not available (Galileo
+   OS SIS ICD, 5.1.11) */
+{
+    if (SISA < 50)
+    {
+        return SISA / 100.0;
+    }
+
+    if (SISA < 75)
+    {
+        return (50 + 2 * (SISA - 50)) / 100.0;
+    }
+
+    if (SISA < 100)
+    {
+        return (100 + 4 * (SISA - 75)) / 100.0;
+    }
+
+    if (SISA < 126)
+    {
+        return (200 + 16 * (SISA - 100)) / 100.0;
+    }
+
+    return -1.0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutGALEph(sbfrinex_Nav_t*             Nav,
+                               const sbfrinex_NavRecord_t* Record)
+{
+    const gaEph_1_t* Eph   = &Record->Block.GALNav.Eph;
+    bool             FNAV  = Eph->Source == 16;
+    int64_t          Ref_s = (int64_t)Eph->WNc * SECONDS_PER_WEEK;
+    int64_t          Toe_s = sbfrinex_GetNearTime(Ref_s + Eph->TOW / 1000, Eph->t_oe);
+    int64_t          Week  = Toe_s / SECONDS_PER_WEEK;
+    uint32_t         SBFHealth = Eph->Health_OSSOL;
+    uint32_t         Health = 0;
+    double           Clock[3] = {Eph->a_f0, Eph->a_f1, Eph->a_f2};
+
+    /* the SBF health has, for E1-B (bits 0-3), E5b (bits 4-7) and
+       E5a (bits 8-11), a validity bit, HS and DVS; RINEX has DVS and
+       HS of E1-B (bits 0-2), E5a (bits 3-5) and E5b (bits 6-8) */
+    if ((SBFHealth & 0x001) != 0)
+    {
+        Health |= ((SBFHealth >> 3) & 1) | (((SBFHealth >> 1) & 3) << 1);
+    }
+
+    if ((SBFHealth & 0x100) != 0)
+    {
+        Health |= (((SBFHealth >> 11) & 1) << 3) | (((SBFHealth >> 9) & 3) << 4);
+    }
+
+    if ((SBFHealth & 0x010) != 0)
+    {
+        Health |= (((SBFHealth >> 7) & 1) << 6) | (((SBFHealth >> 5) & 3) << 7);
+    }
+
+    {
+        double Orbits[7][4] =
+        {
+            {Eph->IODnav, Eph->C_rs, Eph->DEL_N * SBFRINEX_PI, Eph->M_0 * SBFRINEX_PI},
+            {Eph->C_uc, Eph->e, Eph->C_us, Eph->SQRT_A},
+            {Eph->t_oe, Eph->C_ic, Eph->OMEGA_0 * SBFRINEX_PI, Eph->C_is},
+            {Eph->i_0 * SBFRINEX_PI, Eph->C_rc, Eph->omega * SBFRINEX_PI, Eph->OMEGADOT * SBFRINEX_PI},
+            /* data sources: E5a F/NAV, or E1-B and E5b I/NAV, with the
+               clock of the same pair of signals */
+            {Eph->IDOT * SBFRINEX_PI, FNAV ? 258.0 : 517.0, (double)Week, F64_NOTVALID},
+            {sbfrinex_GetSISA(FNAV ? Eph->SISA_L1E5a : Eph->SISA_L1E5b), Health,
+             sbfrinex_GetValid(Eph->BGD_L1E5a), sbfrinex_GetValid(Eph->BGD_L1E5b)},
+            {(double)(Ref_s - Week * SECONDS_PER_WEEK) + Eph->TOW / 1000.0,
+             F64_NOTVALID, F64_NOTVALID, F64_NOTVALID}
+        };
+
+        sbfrinex_PutNavName(Nav, "EPH", Record, FNAV ? "FNAV" : "INAV");
+        sbfrinex_PutNavEpoch(Nav->Out, Record->Time_ms / 1000, Clock);
+        sbfrinex_PutNavOrbits(Nav->Out, Orbits, 7);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutBDSEph(sbfrinex_Nav_t*             Nav,
+                               const sbfrinex_NavRecord_t* Record)
+{
+    const cmpEph_1_t* Eph   = &Record->Block.BDSNav.Eph;
+    int               PRN   = atoi(getSatelliteNameFromSBF(Record->SVID) + 1);
+    int64_t           Ref_s = (int64_t)Eph->WNc * SECONDS_PER_WEEK + Eph->TOW / 1000 - BDT_OFFSET_s;
+    int64_t           Toe_s = sbfrinex_GetNearTime(Ref_s, Eph->t_oe);
+    int64_t           Week  = Toe_s / SECONDS_PER_WEEK;
+    double            Clock[3] = {Eph->a_f0, Eph->a_f1, Eph->a_f2};
+    double            Orbits[7][4] =
+    {
+        {Eph->IODE, Eph->C_rs, Eph->DEL_N * SBFRINEX_PI, Eph->M_0 * SBFRINEX_PI},
+        {Eph->C_uc, Eph->e, Eph->C_us, Eph->SQRT_A},
+        {Eph->t_oe, Eph->C_ic, Eph->OMEGA_0 * SBFRINEX_PI, Eph->C_is},
+        {Eph->i_0 * SBFRINEX_PI, Eph->C_rc, Eph->omega * SBFRINEX_PI, Eph->OMEGADOT * SBFRINEX_PI},
+        {Eph->IDOT * SBFRINEX_PI, F64_NOTVALID, (double)Week, F64_NOTVALID},
+        {URAs_m[Eph->URA & 15], Eph->SatH1, sbfrinex_GetValid(Eph->T_GD1), sbfrinex_GetValid(Eph->T_GD2)},
+        {(double)(Ref_s - Week * SECONDS_PER_WEEK) + (Eph->TOW % 1000) / 1000.0, Eph->IODC,
+         F64_NOTVALID, F64_NOTVALID}
+    };
+
+    /* the GEO satellites broadcast the D2 message, the others D1; the
+       epochs are in BeiDou time */
+    sbfrinex_PutNavName(Nav, "EPH", Record, PRN <= 5 || PRN >= 59 ? "D2" : "D1");
+    sbfrinex_PutNavEpoch(Nav->Out, Record->Time_ms / 1000 - 14, Clock);
+    sbfrinex_PutNavOrbits(Nav->Out, Orbits, 7);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutGLOEph(sbfrinex_Nav_t*             Nav,
+                               const sbfrinex_NavRecord_t* Record,
+                               int                         LeapSeconds)
+{
+    const glEph_1_0_t* Eph    = &Record->Block.GLONav.Eph;
+    int64_t            Toc_s  = Record->Time_ms / 1000 - LeapSeconds;
+    int64_t            Sent_s = (int64_t)Eph->WNc * SECONDS_PER_WEEK + Eph->TOW / 1000 - LeapSeconds;
+    bool               GLOM   = Eph->M == 1;
+
+    /* the epochs are in UTC, the message frame time in seconds of the
+       UTC week of the epoch */
+    double Clock[3] =
+    {
+        -(double)Eph->tau, Eph->gamma,
+        (double)(Sent_s - (Toc_s - Toc_s % SECONDS_PER_WEEK))
+    };
+    double Orbits[4][4] =
+    {
+        {Eph->x, Eph->dx, Eph->ddx, (Eph->B >> 2) & 1},
+        {Eph->y, Eph->dy, Eph->ddy, (double)Eph->FreqNr - 8.0},
+        {Eph->z, Eph->dz, Eph->ddz, Eph->E},
+        /* RINEX 4 only: status flags, L1/L2 group delay difference,
+           URAI and health flags; only the GLONASS-M ones are known */
+        {F64_NOTVALID, GLOM ? sbfrinex_GetValid(Eph->dtau) : F64_NOTVALID,
+         GLOM ? (double)Eph->F_T : F64_NOTVALID, F64_NOTVALID}
+    };
+
+    sbfrinex_PutNavName(Nav, "EPH", Record, "FDMA");
+    sbfrinex_PutNavEpoch(Nav->Out, Toc_s, Clock);
+    sbfrinex_PutNavOrbits(Nav->Out, Orbits, Nav->Version >= 4 ? 4 : 3);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int64_t sbfrinex_GetFullWeek(int64_t  RefWeek,
+                                    uint32_t Week,
+                                    uint32_t Modulo)
+/* the week closest to RefWeek of a week number modulo Modulo */
+{
+    int64_t Diff = ((int64_t)Week - RefWeek) % Modulo;
+
+    if (Diff < 0)
+    {
+        Diff += Modulo;
+    }
+
+    return Diff >= Modulo / 2 ? RefWeek + Diff - Modulo : RefWeek + Diff;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* The ionosphere and UTC parameters: with RINEX 3, a header record of
+   each type, with RINEX 4, an ION or STO record. */
+
+static void sbfrinex_PutIonoRecord(sbfrinex_Nav_t*             Nav,
+                                   const sbfrinex_NavRecord_t* Record,
+                                   const char*                 Type,
+                                   const double*               Values)
+/* Klobuchar (4 alpha and 4 beta) or NeQuick-G (3 a_i and the storm
+   flags) parameters */
+{
+    char Text[64];
+
+    if (Nav->Version < 4)
+    {
+        bool GAL = strcmp(Type, "GAL") == 0;
+
+        (void)snprintf(Text, sizeof(Text), "%-4s %12.4E%12.4E%12.4E%12.4E",
+                       GAL ? "GAL" : strcmp(Type, "BDS") == 0 ? "BDSA" : "GPSA",
+                       Values[0], Values[1], Values[2], GAL ? 0.0 : Values[3]);
+        sbfrinex_PutRecord(Nav->Out, Text, "IONOSPHERIC CORR");
+
+        if (!GAL)
+        {
+            (void)snprintf(Text, sizeof(Text), "%-4s %12.4E%12.4E%12.4E%12.4E",
+                           strcmp(Type, "BDS") == 0 ? "BDSB" : "GPSB",
+                           Values[4], Values[5], Values[6], Values[7]);
+            sbfrinex_PutRecord(Nav->Out, Text, "IONOSPHERIC CORR");
+        }
+    }
+    else if (strcmp(Type, "GAL") == 0)
+    {
+        double Flags = Values[3];
+
+        sbfrinex_PutNavName(Nav, "ION", Record, "IFNV");
+        sbfrinex_PutNavEpoch(Nav->Out, Record->Time_ms / 1000, Values);
+        sbfout_Write(Nav->Out, "    ", 4);
+        sbfrinex_PutNavValues(Nav->Out, &Flags, 1);
+    }
+    else
+    {
+        bool BDS = strcmp(Type, "BDS") == 0;
+
+        sbfrinex_PutNavName(Nav, "ION", Record, BDS ? "D1D2" : "LNAV");
+        sbfrinex_PutNavEpoch(Nav->Out, Record->Time_ms / 1000 - (BDS ? 14 : 0), Values);
+        sbfout_Write(Nav->Out, "    ", 4);
+        sbfrinex_PutNavValues(Nav->Out, Values + 3, 4);
+        sbfout_Write(Nav->Out, "    ", 4);
+        sbfrinex_PutNavValues(Nav->Out, Values + 7, 1);
+    }
+}
+
+
+static void sbfrinex_PutTimeRecord(sbfrinex_Nav_t*             Nav,
+                                   const sbfrinex_NavRecord_t* Record,
+                                   const char*                 Type,
+                                   int64_t                     Epoch_s,
+                                   double                      A0,
+                                   double                      A1)
+/* time system correction A0 + A1 (t - Epoch), with Epoch_s in the
+   time scale of the constellation, or 0 for the GLONASS ones, which
+   have no reference time */
+{
+    static const struct
+    {
+        char Type[5];
+        char Message[5];
+        char UTC[10];
+    } STOs[] =
+    {
+        {"GPUT", "LNAV", "UTC(USNO)"},
+        {"GAUT", "IFNV", "UTCGAL"},
+        {"GAGP", "IFNV", ""},
+        {"GLUT", "FDMA", "UTC(SU)"},
+        {"GLGP", "FDMA", ""},
+        {"BDUT", "D1D2", "UTC(NTSC)"}
+    };
+    bool     BDS = strcmp(Type, "BDUT") == 0;
+    int64_t  Sent_s = (int64_t)Record->Block.Head.WNc * SECONDS_PER_WEEK +
+                      Record->Block.Head.TOW / 1000 - (BDS ? 14 : 0);
+    char     Text[64];
+    uint32_t i;
+
+    if (A0 == F64_NOTVALID || A1 == F64_NOTVALID)
+    {
+        return;
+    }
+
+    if (Nav->Version < 4)
+    {
+        (void)snprintf(Text, sizeof(Text), "%-4s %17.10E%16.9E %6d %4d", Type, A0, A1,
+                       (int)(Epoch_s % SECONDS_PER_WEEK),
+                       Epoch_s == 0 ? 0 : (int)(Epoch_s / SECONDS_PER_WEEK) - (BDS ? BDT_WEEK0 : 0));
+        sbfrinex_PutRecord(Nav->Out, Text, "TIME SYSTEM CORR");
+    }
+    else
+    {
+        sbfrinex_Calendar_t Calendar;
+        double              Values[4];
+
+        for (i = 0; i < sizeof(STOs) / sizeof(STOs[0]) - 1 && strcmp(STOs[i].Type, Type) != 0; i++)
+        {
+        }
+
+        /* the epoch is the reference time, or the transmission time */
+        if (Epoch_s == 0)
+        {
+            Epoch_s = Sent_s;
+        }
+
+        Values[0] = (double)(Sent_s - (Epoch_s - Epoch_s % SECONDS_PER_WEEK));
+        Values[1] = A0;
+        Values[2] = A1;
+        Values[3] = 0.0;
+
+        sbfrinex_GetCalendar(Epoch_s * 1000, &Calendar);
+        sbfrinex_PutNavName(Nav, "STO", Record, STOs[i].Message);
+        sbfout_Printf(Nav->Out, " %04d %02d %02d %02d %02d %02d %-18s%-18s%s\n",
+                      Calendar.Year, Calendar.Month, Calendar.Day,
+                      Calendar.Hour, Calendar.Min, (int)Calendar.Sec,
+                      Type, "", STOs[i].UTC);
+        sbfout_Write(Nav->Out, "    ", 4);
+        sbfrinex_PutNavValues(Nav->Out, Values, 4);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutParams(sbfrinex_Nav_t*             Nav,
+                               const sbfrinex_NavRecord_t* Record)
+/* writes the ionosphere or UTC parameters of a record */
+{
+    const sbfrinex_NavBlock_t* Block = &Record->Block;
+    int64_t                    Week  = Block->Head.WNc;
+
+    switch (Record->Kind)
+    {
+    case NAV_GPSION:
+    case NAV_BDSION:
+    {
+        /* same layout */
+        const gpIon_1_t* Ion = &Block->GPSIon.Ion;
+        double           Values[8] =
+        {
+            Ion->alpha_0, Ion->alpha_1, Ion->alpha_2, Ion->alpha_3,
+            Ion->beta_0, Ion->beta_1, Ion->beta_2, Ion->beta_3
+        };
+
+        sbfrinex_PutIonoRecord(Nav, Record, Record->Kind == NAV_BDSION ? "BDS" : "GPS", Values);
+        break;
+    }
+
+    case NAV_GALION:
+    {
+        const gaIon_1_t* Ion = &Block->GALIon.Ion;
+        double           Values[4] = {Ion->a_i0, Ion->a_i1, Ion->a_i2, Ion->StormFlags};
+
+        sbfrinex_PutIonoRecord(Nav, Record, "GAL", Values);
+        break;
+    }
+
+    case NAV_GPSUTC:
+    {
+        const gpUtc_1_t* Utc = &Block->GPSUtc.Utc;
+
+        sbfrinex_PutTimeRecord(Nav, Record, "GPUT",
+                               sbfrinex_GetFullWeek(Week, Utc->WN_t, 256) * SECONDS_PER_WEEK + Utc->t_ot,
+                               Utc->A_0, Utc->A_1);
+        break;
+    }
+
+    case NAV_GALUTC:
+    {
+        const gaUtc_1_t* Utc = &Block->GALUtc.Utc;
+
+        sbfrinex_PutTimeRecord(Nav, Record, "GAUT",
+                               sbfrinex_GetFullWeek(Week, Utc->WN_ot, 256) * SECONDS_PER_WEEK + Utc->t_ot,
+                               Utc->A_0, Utc->A_1);
+        break;
+    }
+
+    case NAV_GALGSTGPS:
+    {
+        const gaGstGps_1_t* GstGps = &Block->GALGstGps.GstGps;
+
+        sbfrinex_PutTimeRecord(Nav, Record, "GAGP",
+                               sbfrinex_GetFullWeek(Week, GstGps->WN_oG, 64) * SECONDS_PER_WEEK + GstGps->t_oG,
+                               sbfrinex_GetValid(GstGps->A_0G), sbfrinex_GetValid(GstGps->A_1G));
+        break;
+    }
+
+    case NAV_GLOTIME:
+    {
+        const glTime_1_t* Time = &Block->GLOTime.GLOTime;
+
+        sbfrinex_PutTimeRecord(Nav, Record, "GLUT", 0, Time->tau_c, 0.0);
+        sbfrinex_PutTimeRecord(Nav, Record, "GLGP", 0, sbfrinex_GetValid(Time->tau_GPS), 0.0);
+        break;
+    }
+
+    case NAV_BDSUTC:
+    {
+        /* the BeiDou UTC parameters apply from the start of the week */
+        const cmpUtc_1_t* Utc = &Block->BDSUtc.Utc;
+        int64_t           BDTWeek = (Week * SECONDS_PER_WEEK + Block->Head.TOW / 1000 - BDT_OFFSET_s) /
+                                    SECONDS_PER_WEEK;
+
+        sbfrinex_PutTimeRecord(Nav, Record, "BDUT", (BDTWeek + BDT_WEEK0) * SECONDS_PER_WEEK,
+                               Utc->A_0, Utc->A_1);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfrinex_PutLeapSeconds(sbfrinex_Nav_t*             Nav,
+                                    const sbfrinex_NavRecord_t* GPSUtc,
+                                    const sbfrinex_NavRecord_t* BDSUtc)
+/* the LEAP SECONDS header record, from the GPS UTC parameters, or the
+   BeiDou ones */
+{
+    char Text[64];
+
+    if (GPSUtc != NULL)
+    {
+        const gpUtc_1_t* Utc  = &GPSUtc->Block.GPSUtc.Utc;
+        int64_t          WN_t = sbfrinex_GetFullWeek(GPSUtc->Block.Head.WNc, Utc->WN_t, 256);
+
+        (void)snprintf(Text, sizeof(Text), "%6d%6d%6d%6d", Utc->DEL_t_LS, Utc->DEL_t_LSF,
+                       (int)sbfrinex_GetFullWeek(WN_t, Utc->WN_LSF, 256), Utc->DN);
+    }
+    else if (BDSUtc != NULL)
+    {
+        const cmpUtc_1_t* Utc = &BDSUtc->Block.BDSUtc.Utc;
+        int64_t           Week = (int64_t)BDSUtc->Block.Head.WNc - BDT_WEEK0;
+
+        (void)snprintf(Text, sizeof(Text), "%6d%6d%6d%6dBDS", Utc->DEL_t_LS, Utc->DEL_t_LSF,
+                       (int)sbfrinex_GetFullWeek(Week, Utc->WN_LSF, 256), Utc->DN);
+    }
+    else
+    {
+        return;
+    }
+
+    sbfrinex_PutRecord(Nav->Out, Text, "LEAP SECONDS");
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfrinex_CloseNav(sbfrinex_Nav_t* Nav)
+{
+    static const char* const SystemNames[] =
+    {
+        "G: GPS", "R: GLONASS", "E: GALILEO", "C: BDS", "J: QZSS"
+    };
+    const sbfrinex_NavRecord_t* Last[SBFRINEX_NR_OF_NAVBLOCKS] = {NULL};
+    sbfout_Stream_t*            Out = Nav->Out;
+    uint32_t                    Systems = 0;
+    int                         LeapSeconds = 0;
+    const char*                 System = "M: MIXED";
+    char                        Text[64];
+    uint32_t                    i;
+    int                         Error;
+
+    if (Nav->NrOfRecords > 0)
+    {
+        qsort(Nav->Records, Nav->NrOfRecords, sizeof(*Nav->Records), sbfrinex_CompareRecords);
+    }
+
+    /* the last parameters of each type, and the constellations of the
+       ephemerides */
+    for (i = 0; i < Nav->NrOfRecords; i++)
+    {
+        const sbfrinex_NavRecord_t* Record = &Nav->Records[i];
+
+        Last[Record->Kind] = Record;
+
+        if (Record->Kind < NAV_GPSION)
+        {
+            Systems |= 1U << Record->System;
+        }
+    }
+
+    /* GPS-UTC, for the GLONASS times: from the leap seconds table when
+       no UTC block gives it */
+    if (Last[NAV_GPSUTC] != NULL)
+    {
+        LeapSeconds = Last[NAV_GPSUTC]->Block.GPSUtc.Utc.DEL_t_LS;
+    }
+    else if (Last[NAV_GALUTC] != NULL)
+    {
+        LeapSeconds = Last[NAV_GALUTC]->Block.GALUtc.Utc.DEL_t_LS;
+    }
+    else if (Last[NAV_BDSUTC] != NULL)
+    {
+        LeapSeconds = Last[NAV_BDSUTC]->Block.BDSUtc.Utc.DEL_t_LS + 14;
+    }
+    else if (Nav->NrOfRecords > 0)
+    {
+        LeapSeconds = sbftime_GetLeapSeconds(Nav->Records[0].Time_ms * 1000000);
+    }
+
+    for (i = 0; i < sizeof(SystemNames) / sizeof(SystemNames[0]); i++)
+    {
+        if (Systems == 1U << i)
+        {
+            System = SystemNames[i];
+        }
+    }
+
+    (void)snprintf(Text, sizeof(Text), "%9.2f%11s%-20s%-20s", Nav->Version >= 4 ? 4.00 : 3.04, "",
+                   "N: GNSS NAV DATA", System);
+    sbfrinex_PutRecord(Out, Text, "RINEX VERSION / TYPE");
+    sbfrinex_PutProgramRecord(Out, Nav->Program);
+
+    if (Nav->Version < 4)
+    {
+        for (i = NAV_GPSION; i < SBFRINEX_NR_OF_NAVBLOCKS; i++)
+        {
+            if (Last[i] != NULL && (i == NAV_GPSION || i == NAV_GALION || i == NAV_BDSION))
+            {
+                sbfrinex_PutParams(Nav, Last[i]);
+            }
+        }
+
+        for (i = NAV_GPSION; i < SBFRINEX_NR_OF_NAVBLOCKS; i++)
+        {
+            if (Last[i] != NULL && i != NAV_GPSION && i != NAV_GALION && i != NAV_BDSION)
+            {
+                sbfrinex_PutParams(Nav, Last[i]);
+            }
+        }
+    }
+
+    sbfrinex_PutLeapSeconds(Nav, Last[NAV_GPSUTC], Last[NAV_BDSUTC]);
+    sbfrinex_PutRecord(Out, "", "END OF HEADER");
+
+    for (i = 0; i < Nav->NrOfRecords; i++)
+    {
+        const sbfrinex_NavRecord_t* Record = &Nav->Records[i];
+
+        switch (Record->Kind)
+        {
+        case NAV_GPSNAV:
+        case NAV_QZSNAV:
+            sbfrinex_PutGPSEph(Nav, Record);
+            break;
+
+        case NAV_GALNAV:
+            sbfrinex_PutGALEph(Nav, Record);
+            break;
+
+        case NAV_GLONAV:
+            sbfrinex_PutGLOEph(Nav, Record, LeapSeconds);
+            break;
+
+        case NAV_BDSNAV:
+            sbfrinex_PutBDSEph(Nav, Record);
+            break;
+
+        default:
+            if (Nav->Version >= 4)
+            {
+                sbfrinex_PutParams(Nav, Record);
+            }
+            break;
+        }
+    }
+
+    Error = Nav->Error;
+
+    free(Nav->Records);
+    free(Nav->Keys);
+    free(Nav);
+
+    return Error;
+}
@@ -0,0 +1,66 @@
+/*
+ * sbfrinexnav.h: Declaration of the RINEX 3.x/4.x navigation file
+ *                writer.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFRINEXNAV_H
+#define SBFRINEXNAV_H 1
+
+#include <stdint.h>
+
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sbfrinex_Nav_s sbfrinex_Nav_t;
+
+/* The SBF blocks of the navigation file, to be given to
+   sbfrinex_AddNavBlock(): the GPS, Galileo, GLONASS, BeiDou and QZSS
+   ephemerides, and the ionosphere and UTC parameters. */
+#define SBFRINEX_NR_OF_NAVBLOCKS  13
+
+extern const uint16_t sbfrinex_NavBlockNumbers[SBFRINEX_NR_OF_NAVBLOCKS];
+
+/* Start a RINEX navigation file of version Version (3 for RINEX 3.04,
+   4 for RINEX 4.00), written to Out by sbfrinex_CloseNav().  Program
+   is written in the PGM / RUN BY / DATE header record.  Returns NULL
+   on allocation failure. */
+sbfrinex_Nav_t* sbfrinex_CreateNav(sbfout_Stream_t* Out,
+                                   uint32_t         Version,
+                                   const char*      Program);
+
+/* Add a navigation block, with the signature of a block handler of
+   sbfconsumer (Context is the sbfrinex_Nav_t).  The same ephemeris is
+   broadcast over and over: an ephemeris is only kept the first time
+   its satellite, issue of data and reference time are seen, and the
+   ionosphere and UTC parameters the first time their values are
+   seen. */
+void sbfrinex_AddNavBlock(void*       Context,
+                          const void* SBFBlock);
+
+/* Write the header and the records, in the order of their time, to
+   Out, and free Nav.  With RINEX 3, the last ionosphere and UTC
+   parameters of each constellation go to the header; with RINEX 4,
+   they are ION and STO records.  Returns 0 on success, or the errno
+   of the first error. */
+int sbfrinex_CloseNav(sbfrinex_Nav_t* Nav);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
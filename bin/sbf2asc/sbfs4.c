@@ -0,0 +1,139 @@
+/*
+ * sbfs4.c: Computation of the S4 amplitude scintillation index from the
+ *          C/N0 of the measurement epochs.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sbfs4.h"
+#include "sbfsvid.h"
+
+
+/*---------------------------------------------------------------------------*/
+void sbfs4_Init(sbfs4_t*             S4,
+                sbfout_Stream_t*     Out,
+                const sbfmeasspec_t* Spec)
+{
+    S4->Out    = Out;
+    S4->Spec   = Spec;
+    S4->Minute = -1;
+    memset(S4->Sat, 0, sizeof(S4->Sat));
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfs4_WriteMinute(sbfs4_t* S4)
+/* writes the S4 index of the satellites of the current minute and
+   resets their statistics */
+{
+    char     Time[SBFTIME_TEXT_SIZE];
+    uint32_t SVID;
+
+    if (S4->Spec->TimeFormat == SBFTIME_GPS)
+    {
+        (void)snprintf(Time, sizeof(Time), "%12.2f", (double)S4->Minute * 60.0);
+    }
+    else
+    {
+        (void)sbftime_Print(Time, S4->Spec->TimeFormat, S4->Minute * 60000000000LL, 2);
+    }
+
+    for (SVID = 0; SVID < 256; SVID++)
+    {
+        sbfs4_Sat_t* Sat = &S4->Sat[SVID];
+
+        /* the standard deviation is that of a sample (N-1) */
+        if (Sat->N >= 2 && Sat->Mean > 0.0)
+        {
+            sbfout_Printf(S4->Out, "%3u %s %10.6f %6u\n",
+                          SVID,
+                          Time,
+                          sqrt(Sat->M2 / (double)(Sat->N - 1)) / Sat->Mean,
+                          (unsigned int)Sat->N);
+        }
+
+        Sat->N    = 0;
+        Sat->Mean = 0.0;
+        Sat->M2   = 0.0;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfs4_AddEpoch(sbfs4_t*           S4,
+                    const MeasEpoch_t* MeasEpoch)
+{
+    int64_t  Minute;
+    uint32_t i, SigIdx;
+
+    if (MeasEpoch->TOW_ms == U32_NOTVALID || MeasEpoch->WNc == U16_NOTVALID)
+    {
+        return;
+    }
+
+    Minute = ((int64_t)MeasEpoch->WNc * (86400LL * 7LL * 1000LL)
+              + MeasEpoch->TOW_ms) / 60000;
+
+    if (Minute != S4->Minute)
+    {
+        if (S4->Minute >= 0)
+        {
+            sbfs4_WriteMinute(S4);
+        }
+
+        S4->Minute = Minute;
+    }
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+
+        for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+        {
+            const MeasSet_t* const MeasSet = &(ChannelData->measSet[0][SigIdx]);
+
+            if (MeasSet->flags != 0 && MeasSet->signalType < 64 &&
+                S4->Spec->Group[MeasSet->signalType] == 1)
+            {
+                /* only the first signal of the group is used, even if
+                   its C/N0 is not available */
+                if (MeasSet->CN0_dBHz != F32_NOTVALID)
+                {
+                    sbfs4_Sat_t* Sat = &S4->Sat[convertSVIDtoSBF(ChannelData->PRN)];
+                    double       SNR = pow(10.0, MeasSet->CN0_dBHz / 10.0);
+                    double       Delta = SNR - Sat->Mean;
+
+                    Sat->N++;
+                    Sat->Mean += Delta / (double)Sat->N;
+                    Sat->M2   += Delta * (SNR - Sat->Mean);
+                }
+
+                break;
+            }
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfs4_Close(sbfs4_t* S4)
+{
+    if (S4->Minute >= 0)
+    {
+        sbfs4_WriteMinute(S4);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * sbfs4.h: Declaration of the computation of the S4 amplitude
+ *          scintillation index from the C/N0 of the measurement epochs.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFS4_H
+#define SBFS4_H 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "measepoch.h"
+#include "sbfmeasspec.h"
+#include "sbfout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* statistics of the linear signal-to-noise ratio of a satellite over
+   the current minute (Welford's algorithm) */
+typedef struct
+{
+    uint32_t          N;
+    double            Mean;
+    double            M2;          /* sum of the squared deviations */
+} sbfs4_Sat_t;
+
+typedef struct
+{
+    sbfout_Stream_t*  Out;
+    const sbfmeasspec_t* Spec;     /* signals used, see sbfs4_Init() */
+    int64_t           Minute;      /* current minute since Jan 06, 1980,
+                                      or -1 before the first epoch */
+    sbfs4_Sat_t       Sat[256];    /* indexed by SBF SVID */
+} sbfs4_t;
+
+/* Start computing the S4 index, written to Out.  For each satellite,
+   the C/N0 of the first signal of the first group of Spec (as in the
+   wide form of sbfmeasspec_PrintEpoch()) is used.  Spec must remain
+   valid until sbfs4_Close(). */
+void sbfs4_Init(sbfs4_t*             S4,
+                sbfout_Stream_t*     Out,
+                const sbfmeasspec_t* Spec);
+
+/* Add the C/N0 of an epoch.  When the epoch starts a new minute, a row
+   is written for each satellite observed at least twice during the
+   previous minute, with the SBF SVID, the start of the minute (GPS
+   seconds, or the TimeFormat of Spec), the S4 index and the number of samples.  S4 is the
+   standard deviation of the linear signal-to-noise ratio 10^(C/N0/10)
+   divided by its mean. */
+void sbfs4_AddEpoch(sbfs4_t*           S4,
+                    const MeasEpoch_t* MeasEpoch);
+
+/* Write the rows of the last minute. */
+void sbfs4_Close(sbfs4_t* S4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
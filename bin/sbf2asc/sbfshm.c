@@ -0,0 +1,381 @@
+/*
+ * sbfshm.c: Ring of decoded measurement epochs in POSIX shared memory,
+ *           written by one process without any lock, and read by any
+ *           number of processes.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "sbfshm.h"
+#include "sbfsvid.h"
+#include "sbftime.h"
+#include "ssntypes.h"
+#include "sbfdef.h"
+
+#if SBFSHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* the measurement sets of the largest epoch */
+#define MAX_NR_OF_MEAS  (uint32_t)(sizeof(((sbfshm_Epoch_t*)0)->Meas) / sizeof(sbfshm_Meas_t))
+
+/* the slots are aligned on cache lines */
+#define SLOT_SIZE  (((uint32_t)sizeof(sbfshm_Epoch_t) + 63u) & ~63u)
+
+#if SBFSHM
+
+/* The Version of the slots and the Head are accessed atomically, the
+   rest of the slots with plain copies: a reader detects that it has
+   read a slot while it was being written from its Version (seqlock).
+   The fences order the plain copies with the Versions. */
+#define LOAD_ACQUIRE(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define LOAD_RELAXED(p)     __atomic_load_n(p, __ATOMIC_RELAXED)
+#define STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define STORE_RELAXED(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+
+
+/*---------------------------------------------------------------------------*/
+static sbfshm_Slot_t* sbfshm_GetSlot(const sbfshm_t* Shm,
+                                     uint64_t        EpochNr)
+/* returns the slot of the epoch EpochNr */
+{
+    return (sbfshm_Slot_t*)(Shm->Slots + (size_t)(EpochNr & (Shm->Header->NrOfSlots - 1))
+                                         * Shm->Header->SlotSize);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool sbfshm_Map(sbfshm_t* Shm,
+                       int       Protection)
+/* maps Shm->Size bytes of Shm->Fd, and closes Shm->Fd on failure */
+{
+    void* Map = mmap(NULL, Shm->Size, Protection, MAP_SHARED, Shm->Fd, 0);
+
+    if (Map == MAP_FAILED)
+    {
+        int Error = errno;
+
+        (void)close(Shm->Fd);
+        errno = Error;
+        return false;
+    }
+
+    Shm->Header = (sbfshm_Header_t*)Map;
+    Shm->Slots  = (uint8_t*)Map + sizeof(sbfshm_Header_t);
+    Shm->Next   = 0;
+    Shm->Lost   = 0;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfshm_Create(sbfshm_t*   Shm,
+                   const char* Name)
+{
+    /* the object is created anew, so that the readers of a previous
+       one keep their own */
+    (void)shm_unlink(Name);
+
+    Shm->Fd = shm_open(Name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if (Shm->Fd < 0)
+    {
+        return false;
+    }
+
+    /* the pages are only allocated when written, up to the number of
+       measurement sets actually in the epochs */
+    Shm->Writer = true;
+    Shm->Size   = sizeof(sbfshm_Header_t) + (size_t)SBFSHM_NR_OF_SLOTS * SLOT_SIZE;
+
+    if (ftruncate(Shm->Fd, (off_t)Shm->Size) != 0)
+    {
+        int Error = errno;
+
+        (void)close(Shm->Fd);
+        (void)shm_unlink(Name);
+        errno = Error;
+        return false;
+    }
+
+    if (!sbfshm_Map(Shm, PROT_READ | PROT_WRITE))
+    {
+        (void)shm_unlink(Name);
+        return false;
+    }
+
+    Shm->Header->Version     = SBFSHM_VERSION;
+    Shm->Header->NrOfSlots   = SBFSHM_NR_OF_SLOTS;
+    Shm->Header->SlotSize    = SLOT_SIZE;
+    Shm->Header->MaxNrOfMeas = MAX_NR_OF_MEAS;
+    Shm->Header->Closed      = 0;
+    Shm->Header->Head        = 0;
+
+    /* the readers check the magic number last */
+    STORE_RELEASE(&Shm->Header->Magic, SBFSHM_MAGIC);
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfshm_AddEpoch(void*              Context,
+                     const MeasEpoch_t* MeasEpoch)
+{
+    sbfshm_t*      Shm  = (sbfshm_t*)Context;
+    uint64_t       N    = Shm->Next;
+    sbfshm_Slot_t* Slot = sbfshm_GetSlot(Shm, N);
+    sbfshm_Meas_t* Meas = (sbfshm_Meas_t*)(Slot + 1);
+    uint32_t       NrOfMeas = 0;
+    uint32_t       i, Ant, SigIdx;
+
+    /* tell the readers that the slot is being written before writing
+       it */
+    STORE_RELAXED(&Slot->Version, 2 * N + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+        uint8_t                    SVID = convertSVIDtoSBF(ChannelData->PRN);
+
+        for (Ant = 0; Ant < NR_OF_ANTENNAS; Ant++)
+        {
+            for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+            {
+                const MeasSet_t* const MeasSet = &(ChannelData->measSet[Ant][SigIdx]);
+
+                if (MeasSet->flags == 0)
+                {
+                    continue;
+                }
+
+                Meas[NrOfMeas].PR_m        = MeasSet->PR_m;
+                Meas[NrOfMeas].L_cycles    = MeasSet->L_cycles;
+                Meas[NrOfMeas].Doppler_Hz  = MeasSet->doppler_Hz;
+                Meas[NrOfMeas].CN0_dBHz    = MeasSet->CN0_dBHz;
+                Meas[NrOfMeas].LockTime_ms = MeasSet->PLLTimer_ms;
+                Meas[NrOfMeas].SVID        = SVID;
+                Meas[NrOfMeas].SignalType  = MeasSet->signalType;
+                Meas[NrOfMeas].Antenna     = (uint8_t)Ant;
+                Meas[NrOfMeas].Flags       = MeasSet->flags;
+                NrOfMeas++;
+            }
+        }
+    }
+
+    Slot->Time_ns     = (MeasEpoch->TOW_ms == U32_NOTVALID || MeasEpoch->WNc == U16_NOTVALID) ?
+                        -1 : sbftime_GetGPSTime_ns(MeasEpoch->WNc, MeasEpoch->TOW_ms);
+    Slot->TOW_ms      = MeasEpoch->TOW_ms;
+    Slot->WNc         = MeasEpoch->WNc;
+    Slot->CommonFlags = MeasEpoch->commonFlags;
+    Slot->Reserved    = 0;
+    Slot->NrOfMeas    = NrOfMeas;
+    Slot->Reserved2   = 0;
+
+    STORE_RELEASE(&Slot->Version, 2 * N + 2);
+    STORE_RELEASE(&Shm->Header->Head, N + 1);
+
+    Shm->Next = N + 1;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfshm_Close(sbfshm_t* Shm)
+{
+    if (Shm->Writer)
+    {
+        STORE_RELEASE(&Shm->Header->Closed, 1u);
+    }
+
+    (void)munmap(Shm->Header, Shm->Size);
+    (void)close(Shm->Fd);
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfshm_Open(sbfshm_t*   Shm,
+                 const char* Name)
+{
+    struct stat Stat;
+    uint64_t    Head;
+
+    Shm->Fd = shm_open(Name, O_RDONLY, 0);
+
+    if (Shm->Fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat(Shm->Fd, &Stat) != 0)
+    {
+        int Error = errno;
+
+        (void)close(Shm->Fd);
+        errno = Error;
+        return false;
+    }
+
+    if ((size_t)Stat.st_size < sizeof(sbfshm_Header_t))
+    {
+        (void)close(Shm->Fd);
+        errno = EPROTO;
+        return false;
+    }
+
+    Shm->Writer = false;
+    Shm->Size   = (size_t)Stat.st_size;
+
+    if (!sbfshm_Map(Shm, PROT_READ))
+    {
+        return false;
+    }
+
+    if (LOAD_ACQUIRE(&Shm->Header->Magic) != SBFSHM_MAGIC ||
+        Shm->Header->Version != SBFSHM_VERSION ||
+        Shm->Header->NrOfSlots == 0 ||
+        (Shm->Header->NrOfSlots & (Shm->Header->NrOfSlots - 1)) != 0 ||
+        Shm->Header->MaxNrOfMeas > MAX_NR_OF_MEAS ||
+        Shm->Header->SlotSize < sizeof(sbfshm_Slot_t) + Shm->Header->MaxNrOfMeas * sizeof(sbfshm_Meas_t) ||
+        Shm->Size < sizeof(sbfshm_Header_t) + (size_t)Shm->Header->NrOfSlots * Shm->Header->SlotSize)
+    {
+        (void)munmap(Shm->Header, Shm->Size);
+        (void)close(Shm->Fd);
+        errno = EPROTO;
+        return false;
+    }
+
+    /* the oldest epoch which is not being overwritten */
+    Head = LOAD_ACQUIRE(&Shm->Header->Head);
+    Shm->Next = (Head >= Shm->Header->NrOfSlots) ? Head - Shm->Header->NrOfSlots + 1 : 0;
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfshm_Read(sbfshm_t*       Shm,
+                sbfshm_Epoch_t* Epoch)
+{
+    uint64_t             N = Shm->Next;
+    uint64_t             Version = 2 * N + 2;
+    const sbfshm_Slot_t* Slot;
+    uint32_t             NrOfMeas;
+    uint64_t             Head;
+
+    /* the Closed flag is read before the Head, so that the last epochs
+       are not missed */
+    uint32_t             Closed = LOAD_ACQUIRE(&Shm->Header->Closed);
+
+    Head = LOAD_ACQUIRE(&Shm->Header->Head);
+
+    if (N >= Head)
+    {
+        return Closed ? SBFSHM_READ_CLOSED : SBFSHM_READ_EMPTY;
+    }
+
+    if (Head - N < Shm->Header->NrOfSlots)
+    {
+        Slot = sbfshm_GetSlot(Shm, N);
+
+        if (LOAD_ACQUIRE(&Slot->Version) == Version)
+        {
+            memcpy(&Epoch->Epoch, Slot, sizeof(*Slot));
+            NrOfMeas = Epoch->Epoch.NrOfMeas;
+
+            if (NrOfMeas <= Shm->Header->MaxNrOfMeas)
+            {
+                memcpy(Epoch->Meas, Slot + 1, NrOfMeas * sizeof(sbfshm_Meas_t));
+            }
+
+            /* the copy is only valid if the slot has not been reused
+               meanwhile */
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (LOAD_RELAXED(&Slot->Version) == Version &&
+                NrOfMeas <= Shm->Header->MaxNrOfMeas)
+            {
+                Shm->Next = N + 1;
+                return SBFSHM_READ_OK;
+            }
+        }
+
+        Head = LOAD_ACQUIRE(&Shm->Header->Head);
+    }
+
+    /* the epoch N has been overwritten: skip to the oldest epoch which
+       is not being overwritten.  The new Version of the slot may be
+       seen before the Head that goes with it, hence at least N + 1. */
+    Shm->Next  = (Head - N >= Shm->Header->NrOfSlots) ? Head - Shm->Header->NrOfSlots + 1 : N + 1;
+    Shm->Lost += Shm->Next - N;
+
+    return SBFSHM_READ_OVERRUN;
+}
+
+#else /* SBFSHM */
+
+/*---------------------------------------------------------------------------*/
+bool sbfshm_Create(sbfshm_t*   Shm,
+                   const char* Name)
+{
+    (void)Shm;
+    (void)Name;
+    errno = ENOSYS;
+    return false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfshm_AddEpoch(void*              Context,
+                     const MeasEpoch_t* MeasEpoch)
+{
+    (void)Context;
+    (void)MeasEpoch;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void sbfshm_Close(sbfshm_t* Shm)
+{
+    (void)Shm;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbfshm_Open(sbfshm_t*   Shm,
+                 const char* Name)
+{
+    (void)Shm;
+    (void)Name;
+    errno = ENOSYS;
+    return false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbfshm_Read(sbfshm_t*       Shm,
+                sbfshm_Epoch_t* Epoch)
+{
+    (void)Shm;
+    (void)Epoch;
+    return SBFSHM_READ_CLOSED;
+}
+
+#endif /* SBFSHM */
@@ -0,0 +1,168 @@
+/*
+ * sbfshm.h: Declaration of the ring of decoded measurement epochs in
+ *           POSIX shared memory, for the local processes reading a live
+ *           stream.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFSHM_H
+#define SBFSHM_H 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "measepoch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The shared memory is only available when building with SBFSHM set
+   to 1 (POSIX shm_open() and mmap()).  Otherwise sbfshm_Create() and
+   sbfshm_Open() always fail with ENOSYS. */
+#ifndef SBFSHM
+#define SBFSHM 0
+#endif
+
+/* number of epochs in the ring (a power of 2): the readers can be that
+   many epochs late before losing some */
+#ifndef SBFSHM_NR_OF_SLOTS
+#define SBFSHM_NR_OF_SLOTS  256
+#endif
+
+/* the slot of an epoch is its number & (NrOfSlots - 1) */
+#if SBFSHM && !defined(__cplusplus)
+_Static_assert(SBFSHM_NR_OF_SLOTS > 0 && (SBFSHM_NR_OF_SLOTS & (SBFSHM_NR_OF_SLOTS - 1)) == 0,
+               "SBFSHM_NR_OF_SLOTS must be a power of 2");
+#endif
+
+#define SBFSHM_MAGIC    0x52464253u   /* "SBFR" */
+#define SBFSHM_VERSION  1
+
+/* Layout of the shared memory object, in the byte order of the host:
+
+     sbfshm_Header_t, then NrOfSlots slots of SlotSize bytes, each made
+     of an sbfshm_Slot_t followed by MaxNrOfMeas sbfshm_Meas_t, of
+     which the first Epoch.NrOfMeas are used.
+
+   The epoch N (counting from 0) is in the slot N % NrOfSlots.  The
+   writer sets the Version of the slot to 2*N+1 before writing the
+   epoch N, and to 2*N+2 once it is written, then sets Head to N+1.  A
+   reader of the epoch N copies it and checks that the Version was
+   2*N+2 both before and after the copy: otherwise the writer has
+   reused the slot, and the epoch is lost.  The writer never waits for
+   the readers. */
+typedef struct
+{
+    uint32_t          Magic;        /* SBFSHM_MAGIC */
+    uint32_t          Version;      /* SBFSHM_VERSION */
+    uint32_t          NrOfSlots;
+    uint32_t          SlotSize;     /* bytes, a multiple of 64 */
+    uint32_t          MaxNrOfMeas;  /* per epoch */
+    uint32_t          Closed;       /* 1 when the writer is done */
+    uint64_t          Head;         /* number of epochs written */
+    uint8_t           Reserved[32]; /* up to 64 bytes */
+} sbfshm_Header_t;
+
+/* the observables of one signal of a satellite, as in MeasSet_t */
+typedef struct
+{
+    double            PR_m;         /* F64_NOTVALID if unknown */
+    double            L_cycles;     /* F64_NOTVALID if unknown */
+    float             Doppler_Hz;   /* F32_NOTVALID if unknown */
+    float             CN0_dBHz;     /* F32_NOTVALID if unknown */
+    uint32_t          LockTime_ms;
+    uint8_t           SVID;         /* SBF SVID */
+    uint8_t           SignalType;
+    uint8_t           Antenna;      /* 0 for the main antenna */
+    uint8_t           Flags;        /* MEASFLAG_xx */
+} sbfshm_Meas_t;
+
+/* a measurement epoch, with the valid measurement sets */
+typedef struct
+{
+    uint64_t          Version;      /* see above */
+    int64_t           Time_ns;      /* GPS ns since Jan 06, 1980, or -1
+                                       if the time is not valid */
+    uint32_t          TOW_ms;
+    uint16_t          WNc;
+    uint8_t           CommonFlags;  /* COMMONFLAG_xx */
+    uint8_t           Reserved;
+    uint32_t          NrOfMeas;
+    uint32_t          Reserved2;
+} sbfshm_Slot_t;
+
+/* an epoch read by sbfshm_Read() */
+typedef struct
+{
+    sbfshm_Slot_t     Epoch;
+    sbfshm_Meas_t     Meas[NR_OF_LOGICALCHANNELS * NR_OF_ANTENNAS *
+                           MAX_NR_OF_SIGNALS_PER_SATELLITE];
+} sbfshm_Epoch_t;
+
+typedef struct
+{
+    int               Fd;
+    bool              Writer;       /* created by sbfshm_Create() */
+    size_t            Size;
+    sbfshm_Header_t*  Header;       /* the mapped object */
+    uint8_t*          Slots;
+    uint64_t          Next;         /* epoch written next (writer), or
+                                       read next (reader) */
+    uint64_t          Lost;         /* epochs overwritten before being
+                                       read (reader) */
+} sbfshm_t;
+
+/* Create the shared memory object Name (such as "/sbf2asc"), replacing
+   any existing one, and map it for writing.  The object is left after
+   sbfshm_Close(), for the readers, until removed with shm_unlink() (or
+   from /dev/shm on Linux).  Returns false with errno set on failure. */
+bool sbfshm_Create(sbfshm_t*   Shm,
+                   const char* Name);
+
+/* Publish the valid measurement sets of an epoch, with the signature
+   of an epoch handler of sbfconsumer (Context is the sbfshm_t). */
+void sbfshm_AddEpoch(void*              Context,
+                     const MeasEpoch_t* MeasEpoch);
+
+/* Unmap and close the object.  After sbfshm_Create(), the readers are
+   first told that there are no more epochs (SBFSHM_READ_CLOSED). */
+void sbfshm_Close(sbfshm_t* Shm);
+
+/* results of sbfshm_Read() */
+#define SBFSHM_READ_OK       0  /* the next epoch was read */
+#define SBFSHM_READ_EMPTY    1  /* no new epoch yet */
+#define SBFSHM_READ_CLOSED   2  /* no new epoch, and the writer is done */
+#define SBFSHM_READ_OVERRUN  3  /* epochs were lost, see Lost */
+
+/* Map the shared memory object Name, created by sbfshm_Create(), for
+   reading from its oldest epoch.  Returns false with errno set on
+   failure, or with EPROTO if Name is not a ring of this version or
+   has larger epochs than sbfshm_Epoch_t (see measepochconfig.h). */
+bool sbfshm_Open(sbfshm_t*   Shm,
+                 const char* Name);
+
+/* Copy the next epoch to Epoch, without any lock: the writer is never
+   held back.  If the reader is so late that its next epoch has been
+   overwritten, it skips to the oldest epoch in the ring, adds the
+   number of skipped epochs to Shm->Lost and returns
+   SBFSHM_READ_OVERRUN; the next call reads again. */
+int sbfshm_Read(sbfshm_t*       Shm,
+                sbfshm_Epoch_t* Epoch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -59,175 +59,205 @@
 
 #define SBFSVID_INVALID  (255)
 
+/* internal SVID (see sviddef.h) for each SBF SVID, 0 if the SBF SVID
+   is not defined */
+static const uint8_t SBFtoInternalSVID[256] =
+{
+    /*   0    : invalid */
+      0,
+    /*   1- 37: GPS */
+      1,   2,   3,   4,   5,   6,   7,   8,   9,  10,
+     11,  12,  13,  14,  15,  16,  17,  18,  19,  20,
+     21,  22,  23,  24,  25,  26,  27,  28,  29,  30,
+     31,  32,  33,  34,  35,  36,  37,
+    /*  38- 61: GLONASS */
+     38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+     58,  59,  60,  61,
+    /*  62    : GLONASS, unknown slot */
+     68,
+    /*  63- 70: GLONASS */
+     62,  63,  64,  65,  66,  67,  68,  69,
+    /*  71-106: Galileo */
+     71,  72,  73,  74,  75,  76,  77,  78,  79,  80,
+     81,  82,  83,  84,  85,  86,  87,  88,  89,  90,
+     91,  92,  93,  94,  95,  96,  97,  98,  99, 100,
+    101, 102, 103, 104, 105, 106,
+    /* 107-117: L-band */
+    107, 108, 109, 110, 111, 112, 113, 114, 115, 116,
+    117,
+    /* 118-119: L-band, unknown */
+    118, 119,
+    /* 120-140: SBAS */
+    120, 121, 122, 123, 124, 125, 126, 127, 128, 129,
+    130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
+    140,
+    /* 141-180: BeiDou */
+    161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
+    171, 172, 173, 174, 175, 176, 177, 178, 179, 180,
+    181, 182, 183, 184, 185, 186, 187, 188, 189, 190,
+    191, 192, 193, 194, 195, 196, 197, 198, 199, 200,
+    /* 181-190: QZSS */
+    224, 225, 226, 227, 228, 229, 230, 231, 232, 233,
+    /* 191-197: NavIC/IRNSS */
+    234, 235, 236, 237, 238, 239, 240,
+    /* 198-215: SBAS */
+    141, 142, 143, 144, 145, 146, 147, 148, 149, 150,
+    151, 152, 153, 154, 155, 156, 157, 158,
+    /* 216-222: NavIC/IRNSS */
+    241, 242, 243, 244, 245, 246, 247,
+    /* 223-245: BeiDou */
+    201, 202, 203, 204, 205, 206, 207, 208, 209, 210,
+    211, 212, 213, 214, 215, 216, 217, 218, 219, 220,
+    221, 222, 223,
+    /* 246-255: invalid */
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0
+};
+
+/* SBF SVID for each internal SVID (see sviddef.h), SBFSVID_INVALID if
+   the internal SVID is not defined */
+static const uint8_t InternalToSBFSVID[256] =
+{
+    /*   0    : invalid */
+    255,
+    /*   1- 37: GPS */
+      1,   2,   3,   4,   5,   6,   7,   8,   9,  10,
+     11,  12,  13,  14,  15,  16,  17,  18,  19,  20,
+     21,  22,  23,  24,  25,  26,  27,  28,  29,  30,
+     31,  32,  33,  34,  35,  36,  37,
+    /*  38- 67: GLONASS */
+     38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+     58,  59,  60,  61,  63,  64,  65,  66,  67,  68,
+    /*  68    : GLONASS, unknown slot */
+     62,
+    /*  69- 70: invalid */
+    255, 255,
+    /*  71-106: Galileo */
+     71,  72,  73,  74,  75,  76,  77,  78,  79,  80,
+     81,  82,  83,  84,  85,  86,  87,  88,  89,  90,
+     91,  92,  93,  94,  95,  96,  97,  98,  99, 100,
+    101, 102, 103, 104, 105, 106,
+    /* 107-117: L-band */
+    107, 108, 109, 110, 111, 112, 113, 114, 115, 116,
+    117,
+    /* 118-119: L-band, unknown */
+    118, 119,
+    /* 120-158: SBAS */
+    120, 121, 122, 123, 124, 125, 126, 127, 128, 129,
+    130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
+    140, 198, 199, 200, 201, 202, 203, 204, 205, 206,
+    207, 208, 209, 210, 211, 212, 213, 214, 215,
+    /* 159-160: invalid */
+    255, 255,
+    /* 161-223: BeiDou */
+    141, 142, 143, 144, 145, 146, 147, 148, 149, 150,
+    151, 152, 153, 154, 155, 156, 157, 158, 159, 160,
+    161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
+    171, 172, 173, 174, 175, 176, 177, 178, 179, 180,
+    223, 224, 225, 226, 227, 228, 229, 230, 231, 232,
+    233, 234, 235, 236, 237, 238, 239, 240, 241, 242,
+    243, 244, 245,
+    /* 224-233: QZSS */
+    181, 182, 183, 184, 185, 186, 187, 188, 189, 190,
+    /* 234-247: NavIC/IRNSS */
+    191, 192, 193, 194, 195, 196, 197, 216, 217, 218,
+    219, 220, 221, 222,
+    /* 248-255: invalid */
+    255, 255, 255, 255, 255, 255, 255, 255
+};
+
+/* RINEX-style satellite name for each SBF SVID */
+const char SBFSVIDName[256][4] =
+{
+    /*   0    : invalid */
+    "",
+    /*   1- 37: GPS */
+    "G01", "G02", "G03", "G04", "G05", "G06", "G07", "G08", "G09", "G10",
+    "G11", "G12", "G13", "G14", "G15", "G16", "G17", "G18", "G19", "G20",
+    "G21", "G22", "G23", "G24", "G25", "G26", "G27", "G28", "G29", "G30",
+    "G31", "G32", "G33", "G34", "G35", "G36", "G37",
+    /*  38- 61: GLONASS */
+    "R01", "R02", "R03", "R04", "R05", "R06", "R07", "R08", "R09", "R10",
+    "R11", "R12", "R13", "R14", "R15", "R16", "R17", "R18", "R19", "R20",
+    "R21", "R22", "R23", "R24",
+    /*  62    : GLONASS, unknown slot */
+    "NA",
+    /*  63- 68: GLONASS */
+    "R25", "R26", "R27", "R28", "R29", "R30",
+    /*  69- 70: invalid */
+    "",    "",
+    /*  71-106: Galileo */
+    "E01", "E02", "E03", "E04", "E05", "E06", "E07", "E08", "E09", "E10",
+    "E11", "E12", "E13", "E14", "E15", "E16", "E17", "E18", "E19", "E20",
+    "E21", "E22", "E23", "E24", "E25", "E26", "E27", "E28", "E29", "E30",
+    "E31", "E32", "E33", "E34", "E35", "E36",
+    /* 107-119: L-band */
+    "NA",  "NA",  "NA",  "NA",  "NA",  "NA",  "NA",  "NA",  "NA",  "NA",
+    "NA",  "NA",  "NA",
+    /* 120-140: SBAS */
+    "S20", "S21", "S22", "S23", "S24", "S25", "S26", "S27", "S28", "S29",
+    "S30", "S31", "S32", "S33", "S34", "S35", "S36", "S37", "S38", "S39",
+    "S40",
+    /* 141-180: BeiDou */
+    "C01", "C02", "C03", "C04", "C05", "C06", "C07", "C08", "C09", "C10",
+    "C11", "C12", "C13", "C14", "C15", "C16", "C17", "C18", "C19", "C20",
+    "C21", "C22", "C23", "C24", "C25", "C26", "C27", "C28", "C29", "C30",
+    "C31", "C32", "C33", "C34", "C35", "C36", "C37", "C38", "C39", "C40",
+    /* 181-190: QZSS */
+    "J01", "J02", "J03", "J04", "J05", "J06", "J07", "J08", "J09", "J10",
+    /* 191-197: NavIC/IRNSS */
+    "I01", "I02", "I03", "I04", "I05", "I06", "I07",
+    /* 198-215: SBAS */
+    "S41", "S42", "S43", "S44", "S45", "S46", "S47", "S48", "S49", "S50",
+    "S51", "S52", "S53", "S54", "S55", "S56", "S57", "S58",
+    /* 216-222: NavIC/IRNSS */
+    "I08", "I09", "I10", "I11", "I12", "I13", "I14",
+    /* 223-245: BeiDou */
+    "C41", "C42", "C43", "C44", "C45", "C46", "C47", "C48", "C49", "C50",
+    "C51", "C52", "C53", "C54", "C55", "C56", "C57", "C58", "C59", "C60",
+    "C61", "C62", "C63",
+    /* 246-255: invalid */
+    "",    "",    "",    "",    "",    "",    "",    "",    "",    ""
+};
+
+
+/* name of each signal type */
+const char SBFSignalName[64][8] =
+{
+    /*  0- 7 */
+    "GPSL1CA", "GPSL1P",  "GPSL2P",  "GPSL2C",  "GPSL5",   "GPSL1C",  "QZSL1CA", "QZSL2C",
+    /*  8-15 */
+    "GLOL1CA", "GLOL1P",  "GLOL2P",  "GLOL2CA", "GLOL3",   "BDSB1C",  "BDSB2a",  "IRNL5",
+    /* 16-23 */
+    "",        "GALE1BC", "",        "GALE6BC", "GALE5a",  "GALE5b",  "GALE5",   "MSS",
+    /* 24-31 */
+    "SBSL1CA", "SBSL5",   "QZSL5",   "QZSL6",   "BDSB1I",  "BDSB2I",  "BDSB3",   "",
+    /* 32-39 */
+    "QZSL1C",  "QZSL1S",  "BDSB2b",  "",        "IRNS1",   "IRNL1",   "QZSL1CB", "QZSL5S"
+    /* 40-63: not defined */
+};
+
+
 uint32_t convertSVIDfromSBF(uint32_t sbfSVID)
 {
-    uint32_t internalSBF = 0;
-
-    // GPS
-    if (sbfSVID >= SBFSVID_GPS_MIN && sbfSVID <= SBFSVID_GPS_MAX)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (gpMINPRN - SBFSVID_GPS_MIN));
-    }
-
-    // GLO
-    if (sbfSVID >= SBFSVID_GLO_MIN1 && sbfSVID <= SBFSVID_GLO_MAX1)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (glMINPRN - SBFSVID_GLO_MIN1));
-    }
-
-    if (sbfSVID == SBFSVID_GLO_UNK)
-    {
-        internalSBF = (uint32_t)glPRNUNKWN;
-    }
-
-    if (sbfSVID >= SBFSVID_GLO_MIN2 && sbfSVID <= SBFSVID_GLO_MAX2)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (glMINPRN - SBFSVID_GLO_MIN1 - SBFSVID_GLO_GAP1));
-    }
-
-    // GAL
-    if (sbfSVID >= SBFSVID_GAL_MIN && sbfSVID <= SBFSVID_GAL_MAX)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (galMINPRN - SBFSVID_GAL_MIN));
-    }
-
-    // LBAND
-    if (sbfSVID >= SBFSVID_LBR_MIN && sbfSVID <= SBFSVID_LBR_MAX)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (lbMINPRN - SBFSVID_LBR_MIN));
-    }
-
-    if (sbfSVID == SBFSVID_LBR_UNK1)
-    {
-        internalSBF = (uint32_t)lbPRNUNKWN1;
-    }
-
-    if (sbfSVID == SBFSVID_LBR_UNK2)
-    {
-        internalSBF = (uint32_t)lbPRNUNKWN2;
-    }
-
-    // SBAS
-    if (sbfSVID >= SBFSVID_RA_MIN1 && sbfSVID <= SBFSVID_RA_MAX1)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (raMINPRN - SBFSVID_RA_MIN1));
-    }
-
-    if (sbfSVID >= SBFSVID_RA_MIN2 && sbfSVID <= SBFSVID_RA_MAX2)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (raMINPRN - SBFSVID_RA_MIN1 - SBFSVID_RA_GAP1));
-    }
-
-    // BDS
-    if (sbfSVID >= SBFSVID_BDS_MIN1 && sbfSVID <= SBFSVID_BDS_MAX1)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (cmpMINPRN - SBFSVID_BDS_MIN1));
-    }
-
-    if (sbfSVID >= SBFSVID_BDS_MIN2 && sbfSVID <= SBFSVID_BDS_MAX2)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (cmpMINPRN - SBFSVID_BDS_MIN1 - SBFSVID_BDS_GAP1));
-    }
-
-    // QZSS
-    if (sbfSVID >= SBFSVID_QZSS_MIN && sbfSVID <= SBFSVID_QZSS_MAX)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (qzMINPRN - SBFSVID_QZSS_MIN));
-    }
-
-    // IRNSS
-    if (sbfSVID >= SBFSVID_IRNS_MIN1 && sbfSVID <= SBFSVID_IRNS_MAX1)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (irMINPRN - SBFSVID_IRNS_MIN1));
-    }
-
-    if (sbfSVID >= SBFSVID_IRNS_MIN2 && sbfSVID <= SBFSVID_IRNS_MAX2)
-    {
-        internalSBF = (uint32_t)(sbfSVID + (irMINPRN - SBFSVID_IRNS_MIN1 - SBFSVID_IRNS_GAP1));
-    }
-
-    return internalSBF;
+    return sbfSVID < 256 ? (uint32_t)SBFtoInternalSVID[sbfSVID] : 0;
 }
 
 
 uint8_t convertSVIDtoSBF(uint32_t internalSVID)
 {
-    uint8_t sbfSVID = SBFSVID_INVALID;
-
-    if (agIsGPS(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - gpMINPRN + SBFSVID_GPS_MIN);
-    }
-    else if (agIsGLONASS(internalSVID))
-    {
-        if (internalSVID == glPRNUNKWN)
-        {
-            sbfSVID = (uint8_t)SBFSVID_GLO_UNK;
-        }
-        else
-        {
-            sbfSVID = (uint8_t)(internalSVID - glMINPRN + SBFSVID_GLO_MIN1);
-
-            /* this is for the GLONASS slots > 24 */
-            if (internalSVID > glMINPRN + SBFSVID_GLO_MAX1 - SBFSVID_GLO_MIN1)
-            {
-                sbfSVID += SBFSVID_GLO_GAP1;
-            }
-        }
-    }
-    else if (agIsGAL(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - galMINPRN + SBFSVID_GAL_MIN);
-    }
-    else if (agIsLBR(internalSVID))
-    {
-        if (internalSVID == lbPRNUNKWN1)
-        {
-            sbfSVID = (uint8_t)SBFSVID_LBR_UNK1;
-        }
-        else if (internalSVID == lbPRNUNKWN2)
-        {
-            sbfSVID = (uint8_t)SBFSVID_LBR_UNK2;
-        }
-        else
-        {
-            sbfSVID = (uint8_t)(internalSVID - lbMINPRN + SBFSVID_LBR_MIN);
-        }
-    }
-    else if (agIsRA(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - raMINPRN + SBFSVID_RA_MIN1);
-
-        /* this is the second part of the SBAS PRNS, remapped in SBF in the 198-215 range */
-        if (internalSVID > raMINPRN + SBFSVID_RA_MAX1 - SBFSVID_RA_MIN1)
-        {
-            sbfSVID += SBFSVID_RA_GAP1;
-        }
-    }
-    else if (agIsCOMPASS(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - cmpMINPRN + SBFSVID_BDS_MIN1);
-
-        /* this is the second part of the BDS PRNS (from C41), remapped in SBF in the 223-245 range */
-        if (internalSVID > cmpMINPRN + SBFSVID_BDS_MAX1 - SBFSVID_BDS_MIN1)
-        {
-            sbfSVID += SBFSVID_BDS_GAP1;
-        }
-    }
-    else if (agIsQZSS(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - qzMINPRN + SBFSVID_QZSS_MIN);
-    }
-    else if (agIsIRNSS(internalSVID))
-    {
-        sbfSVID = (uint8_t)(internalSVID - irMINPRN + SBFSVID_IRNS_MIN1);
-
-        /* this is the second part of the IRNSS PRNS, remapped in SBF in the 216-222 range */
-        if (internalSVID > irMINPRN + SBFSVID_IRNS_MAX1 - SBFSVID_IRNS_MIN1)
-        {
-            sbfSVID += SBFSVID_IRNS_GAP1;
-        }
-    }
-
-    return sbfSVID;
+    return internalSVID < 256 ? InternalToSBFSVID[internalSVID] : (uint8_t)SBFSVID_INVALID;
+}
+
+
+const char* getSatelliteNameFromSBF(uint32_t sbfSVID)
+{
+    return sbfSVID < 256 ? SBFSVIDName[sbfSVID] : "";
+}
+
+
+const char* getSignalName(uint32_t SignalType)
+{
+    return SignalType < 64 ? SBFSignalName[SignalType] : "";
 }
@@ -32,6 +32,27 @@ uint32_t convertSVIDfromSBF(uint32_t sbfSVID);
  */
 uint8_t convertSVIDtoSBF(uint32_t internalSVID);
 
+/*! RINEX-style satellite name ("G01", "R24", "E05", "S20", "C41",
+    "J01", "I14", ...) for each SBF SVID.  The name is "NA" for the
+    GLONASS satellites with unknown slot number and for L-band beams,
+    and an empty string for undefined SVIDs.
+ */
+extern const char SBFSVIDName[256][4];
+
+/*! Return the satellite name of an SBF SVID (see SBFSVIDName[])
+ */
+const char* getSatelliteNameFromSBF(uint32_t sbfSVID);
+
+/*! Name of each signal type (SignalType_t without the "SIG_" prefix,
+    such as "GPSL1CA" or "GALE5a"), or an empty string for the reserved
+    signal types.
+ */
+extern const char SBFSignalName[64][8];
+
+/*! Return the name of a signal type (see SBFSignalName[])
+ */
+const char* getSignalName(uint32_t SignalType);
+
 #ifdef __cplusplus
 }
 #endif
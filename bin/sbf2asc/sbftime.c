@@ -0,0 +1,219 @@
+/*
+ * sbftime.c: Conversions of the SBF time stamps to integer GPS and UTC
+ *            nanoseconds and to ISO 8601 text.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sbftime.h"
+
+#define NS_PER_SECOND  1000000000LL
+
+/* Leap seconds table: from the GPS second Start (since Jan 06, 1980),
+   GPS-UTC is Leap seconds.  The GPS second Start is the inserted UTC
+   second 23:59:60 of the day before the date in the comment.  To be
+   extended when the IERS announces a new leap second. */
+static const struct
+{
+    int64_t  Start_s;
+    int32_t  Leap;
+} LeapSeconds[] =
+{
+    {  46828800,  1},   /* 1981-07-01 */
+    {  78364801,  2},   /* 1982-07-01 */
+    { 109900802,  3},   /* 1983-07-01 */
+    { 173059203,  4},   /* 1985-07-01 */
+    { 252028804,  5},   /* 1988-01-01 */
+    { 315187205,  6},   /* 1990-01-01 */
+    { 346723206,  7},   /* 1991-01-01 */
+    { 393984007,  8},   /* 1992-07-01 */
+    { 425520008,  9},   /* 1993-07-01 */
+    { 457056009, 10},   /* 1994-07-01 */
+    { 504489610, 11},   /* 1996-01-01 */
+    { 551750411, 12},   /* 1997-07-01 */
+    { 599184012, 13},   /* 1999-01-01 */
+    { 820108813, 14},   /* 2006-01-01 */
+    { 914803214, 15},   /* 2009-01-01 */
+    {1025136015, 16},   /* 2012-07-01 */
+    {1119744016, 17},   /* 2015-07-01 */
+    {1167264017, 18}    /* 2017-01-01 */
+};
+
+#define NR_OF_LEAPSECONDS  (sizeof(LeapSeconds) / sizeof(LeapSeconds[0]))
+
+
+/*---------------------------------------------------------------------------*/
+int64_t sbftime_GetGPSTime_ns(uint32_t WNc,
+                              uint32_t TOW_ms)
+{
+    return ((int64_t)WNc * 604800000LL + (int64_t)TOW_ms) * 1000000LL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int32_t sbftime_GetLeap(int64_t GPSTime_ns,
+                               bool*   InLeapSecond)
+/* returns GPS-UTC at GPSTime_ns, and whether GPSTime_ns is in an
+   inserted leap second */
+{
+    int64_t  Time_s = GPSTime_ns / NS_PER_SECOND;
+    uint32_t i;
+
+    for (i = NR_OF_LEAPSECONDS; i > 0; i--)
+    {
+        if (Time_s >= LeapSeconds[i - 1].Start_s)
+        {
+            *InLeapSecond = (Time_s == LeapSeconds[i - 1].Start_s);
+            return LeapSeconds[i - 1].Leap;
+        }
+    }
+
+    *InLeapSecond = false;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int32_t sbftime_GetLeapSeconds(int64_t GPSTime_ns)
+{
+    bool InLeapSecond;
+
+    return sbftime_GetLeap(GPSTime_ns, &InLeapSecond);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int64_t sbftime_GetUTCTime_ns(int64_t GPSTime_ns)
+{
+    bool InLeapSecond;
+
+    return GPSTime_ns + (SBFTIME_GPS_EPOCH_UNIX_s
+                         - sbftime_GetLeap(GPSTime_ns, &InLeapSecond)) * NS_PER_SECOND;
+}
+
+
+/*---------------------------------------------------------------------------*/
+bool sbftime_ParseFormat(const char*       Text,
+                         sbftime_Format_t* Format)
+{
+    static const char* const Names[] = {"gps", "gpsns", "utcns", "iso"};
+    uint32_t i;
+
+    for (i = 0; i < sizeof(Names) / sizeof(Names[0]); i++)
+    {
+        if (strcmp(Text, Names[i]) == 0)
+        {
+            *Format = (sbftime_Format_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static int sbftime_PrintFraction(char*    Text,
+                                 int64_t  Fraction_ns,
+                                 uint32_t Decimals)
+/* writes "." and the first Decimals digits of Fraction_ns, or nothing
+   without decimals */
+{
+    uint32_t i;
+
+    if (Decimals == 0)
+    {
+        return 0;
+    }
+
+    for (i = Decimals; i < 9; i++)
+    {
+        Fraction_ns /= 10;
+    }
+
+    return sprintf(Text, ".%0*lld", (int)Decimals, (long long)Fraction_ns);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int sbftime_Print(char*            Text,
+                  sbftime_Format_t Format,
+                  int64_t          GPSTime_ns,
+                  uint32_t         Decimals)
+{
+    int64_t Rounding = NS_PER_SECOND / 2;
+    int64_t UTCTime_s, Days, Era, DayOfEra, YearOfEra, DayOfYear, Month;
+    bool    InLeapSecond;
+    int32_t Leap;
+    int     Len;
+    uint32_t i;
+
+    if (Decimals > 9)
+    {
+        Decimals = 9;
+    }
+
+    /* round to the last decimal written */
+    for (i = 0; i < Decimals; i++)
+    {
+        Rounding /= 10;
+    }
+
+    switch (Format)
+    {
+    case SBFTIME_GPSNS:
+        return sprintf(Text, "%lld", (long long)GPSTime_ns);
+
+    case SBFTIME_UTCNS:
+        return sprintf(Text, "%lld", (long long)sbftime_GetUTCTime_ns(GPSTime_ns));
+
+    case SBFTIME_GPS:
+        GPSTime_ns += Rounding;
+        Len = sprintf(Text, "%lld", (long long)(GPSTime_ns / NS_PER_SECOND));
+        return Len + sbftime_PrintFraction(Text + Len, GPSTime_ns % NS_PER_SECOND, Decimals);
+
+    default:
+        break;
+    }
+
+    GPSTime_ns += Rounding;
+    Leap      = sbftime_GetLeap(GPSTime_ns, &InLeapSecond);
+    UTCTime_s = GPSTime_ns / NS_PER_SECOND + SBFTIME_GPS_EPOCH_UNIX_s - Leap;
+
+    /* civil date of the day since Jan 01, 1970 (H. Hinnant's
+       civil_from_days(), in eras of 400 years starting on March 1st) */
+    Days      = UTCTime_s / 86400 + 719468;
+    Era       = Days / 146097;
+    DayOfEra  = Days - Era * 146097;
+    YearOfEra = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+    DayOfYear = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+    Month     = (5 * DayOfYear + 2) / 153;
+
+    /* the inserted leap second follows 23:59:59, which the UTC time
+       repeats */
+    Len = sprintf(Text, "%04d-%02d-%02dT%02d:%02d:%02d",
+                  (int)(YearOfEra + Era * 400 + (Month >= 10 ? 1 : 0)),
+                  (int)(Month < 10 ? Month + 3 : Month - 9),
+                  (int)(DayOfYear - (153 * Month + 2) / 5 + 1),
+                  (int)(UTCTime_s % 86400 / 3600),
+                  (int)(UTCTime_s % 3600 / 60),
+                  InLeapSecond ? 60 : (int)(UTCTime_s % 60));
+    Len += sbftime_PrintFraction(Text + Len, GPSTime_ns % NS_PER_SECOND, Decimals);
+    Text[Len++] = 'Z';
+    Text[Len]   = '\0';
+
+    return Len;
+}
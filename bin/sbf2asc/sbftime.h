@@ -0,0 +1,78 @@
+/*
+ * sbftime.h: Declaration of the conversions of the SBF time stamps to
+ *            integer GPS and UTC nanoseconds and to ISO 8601 text.
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SBFTIME_H
+#define SBFTIME_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* formats of the time column of the text outputs */
+typedef enum
+{
+    SBFTIME_GPS,      /* GPS seconds since Jan 06, 1980 (with the
+                         decimals of each output) */
+    SBFTIME_GPSNS,    /* GPS nanoseconds since Jan 06, 1980 */
+    SBFTIME_UTCNS,    /* UTC nanoseconds since Jan 01, 1970 (Unix time,
+                         the inserted leap seconds repeat the previous
+                         second) */
+    SBFTIME_ISO       /* UTC as yyyy-mm-ddThh:mm:ss.sssZ */
+} sbftime_Format_t;
+
+/* size of the text written by sbftime_Print() */
+#define SBFTIME_TEXT_SIZE  40
+
+/* GPS epoch (Jan 06, 1980) in Unix time */
+#define SBFTIME_GPS_EPOCH_UNIX_s  315964800LL
+
+/* GPS time in ns since the GPS epoch of a week number and time of
+   week in ms, computed in integers. */
+int64_t sbftime_GetGPSTime_ns(uint32_t WNc,
+                              uint32_t TOW_ms);
+
+/* GPS-UTC leap seconds at a GPS time, from the leap seconds table
+   (18 since January 2017).  The newest entries are checked first, so
+   that the lookup of recent times is a single comparison. */
+int32_t sbftime_GetLeapSeconds(int64_t GPSTime_ns);
+
+/* UTC time in ns since Jan 01, 1970 of a GPS time. */
+int64_t sbftime_GetUTCTime_ns(int64_t GPSTime_ns);
+
+/* Parse the name of a time format: gps, gpsns, utcns or iso.  Returns
+   false if Text is not one of them. */
+bool sbftime_ParseFormat(const char*       Text,
+                         sbftime_Format_t* Format);
+
+/* Write a GPS time to Text (at least SBFTIME_TEXT_SIZE chars) in
+   Format, with Decimals decimals of a second for SBFTIME_GPS and
+   SBFTIME_ISO.  The inserted leap seconds are written as second 60 in
+   the ISO format.  Returns the length of the text. */
+int sbftime_Print(char*            Text,
+                  sbftime_Format_t Format,
+                  int64_t          GPSTime_ns,
+                  uint32_t         Decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * bench_decode.c: Time the decoding of the measurement epochs of an SBF
+ *                 file (see the "bench" target of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Only the functions of the decoder that exist since the first version
+   of sbfread.h are used, so that the same program can time an older
+   version of the decoder (BENCH_BASE in the Makefile).
+
+   usage: bench_decode file.sbf [Repetitions]
+
+   The file is decoded Repetitions times (default 10, at most
+   BENCH_MAX_RUNS) and the fastest and the median runs are printed,
+   with the number of epochs and of satellites decoded as a check that
+   both versions decoded the same.  Differences of a few percent need
+   more runs: the median of 10 runs still varies by about 5%. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_MAX_RUNS 1000
+
+#include "sbfread.h"
+
+static SBFData_t   SBFData;
+static MeasEpoch_t MeasEpoch;
+static uint8_t     SBFBlock[MAX_SBFSIZE];
+static double      Time_s[BENCH_MAX_RUNS];
+
+static int CompareTimes(const void* a, const void* b)
+{
+    const double ta = *(const double*)a;
+    const double tb = *(const double*)b;
+
+    return (ta > tb) - (ta < tb);
+}
+
+int main(int argc, char* argv[])
+{
+    int      NrOfRuns = (argc > 2) ? atoi(argv[2]) : 10;
+    uint64_t NrOfEpochs = 0, NrOfSats = 0;
+    int      Run;
+    FILE*    F;
+
+    if (argc < 2 || NrOfRuns < 1 || NrOfRuns > BENCH_MAX_RUNS)
+    {
+        fprintf(stderr, "usage: bench_decode file.sbf [Repetitions]\n");
+        return EXIT_FAILURE;
+    }
+
+    /* the first versions of InitializeSBFDecoding() exit on failure */
+    if ((F = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    fclose(F);
+
+    for (Run = 0; Run < NrOfRuns; Run++)
+    {
+        struct timespec Start, End;
+
+        InitializeSBFDecoding(argv[1], &SBFData);
+
+        NrOfEpochs = 0;
+        NrOfSats   = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &Start);
+
+        while (GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                            START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
+        {
+            if (sbfread_MeasCollectAndDecode(&SBFData, SBFBlock, &MeasEpoch,
+                                             SBFREAD_ALLMEAS_ENABLED))
+            {
+                NrOfEpochs++;
+                NrOfSats += MeasEpoch.nbrElements;
+            }
+        }
+
+        if (sbfread_FlushMeasEpoch(&SBFData, &MeasEpoch, SBFREAD_ALLMEAS_ENABLED))
+        {
+            NrOfEpochs++;
+            NrOfSats += MeasEpoch.nbrElements;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &End);
+        CloseSBFFile(&SBFData);
+
+        Time_s[Run] = (double)(End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) * 1e-9;
+    }
+
+    qsort(Time_s, (size_t)NrOfRuns, sizeof(Time_s[0]), CompareTimes);
+
+    printf("%s: best %.1f ms, median %.1f ms of %d runs, %llu epochs, %llu satellites, %.0f ns per satellite\n",
+           argv[1], Time_s[0] * 1e3, Time_s[NrOfRuns / 2] * 1e3, NrOfRuns,
+           (unsigned long long)NrOfEpochs, (unsigned long long)NrOfSats,
+           NrOfSats ? Time_s[0] * 1e9 / (double)NrOfSats : 0.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/*
+ * check_alloc.c: Check that the decoder makes no heap allocation in
+ *                steady state (see the "check" target of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Each file is decoded twice: from the file, where the measurement
+   blocks are referenced in place, and as a stream of blocks
+   (InitializeSBFDecodingWithExistingFile() without a file), where they
+   are copied into the arena.  The epochs are taken from
+   sbfread_AllocMeasEpoch() and given back CHECK_IN_FLIGHT epochs later,
+   as by an application with a queue.  After the first CHECK_WARMUP
+   epochs, which cover a Meas3 reference epoch and the start of the
+   worker threads, the allocation count must not change any more up to
+   the end of the file.
+
+   Two counts are checked: sbfread_GetAllocationCount(), and, when
+   built with CHECK_WRAP_MALLOC and the GNU linker option
+   --wrap=malloc,--wrap=calloc,--wrap=realloc, all the calls to these
+   functions from the decoder, including those that would bypass
+   SBFREAD_MALLOC.
+
+   usage: check_alloc file.sbf...  (exits with 1 on a failure) */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sbfread.h"
+
+#define CHECK_WARMUP     20
+#define CHECK_IN_FLIGHT  4
+
+static uint32_t NrOfMallocs;
+
+#ifdef CHECK_WRAP_MALLOC
+void* __real_malloc(size_t Size);
+void* __real_calloc(size_t Count, size_t Size);
+void* __real_realloc(void* Ptr, size_t Size);
+
+void* __wrap_malloc(size_t Size)
+{
+    __atomic_fetch_add(&NrOfMallocs, 1, __ATOMIC_RELAXED);
+    return __real_malloc(Size);
+}
+
+void* __wrap_calloc(size_t Count, size_t Size)
+{
+    __atomic_fetch_add(&NrOfMallocs, 1, __ATOMIC_RELAXED);
+    return __real_calloc(Count, Size);
+}
+
+void* __wrap_realloc(void* Ptr, size_t Size)
+{
+    __atomic_fetch_add(&NrOfMallocs, 1, __ATOMIC_RELAXED);
+    return __real_realloc(Ptr, Size);
+}
+#endif
+
+static SBFData_t SBFData, StreamData;
+static uint8_t   SBFBlock[MAX_SBFSIZE];
+
+
+/*---------------------------------------------------------------------------*/
+static bool check_File(const char* FileName,
+                       bool        Stream)
+{
+    SBFData_t* const Decoder = Stream ? &StreamData : &SBFData;
+    MeasEpoch_t* InFlight[CHECK_IN_FLIGHT] = { NULL };
+    MeasEpoch_t* MeasEpoch;
+    uint32_t     NrOfEpochs = 0;
+    uint32_t     WarmCount = 0, WarmMallocs = 0;
+    bool         Success;
+    uint32_t     i;
+
+    if (InitializeSBFDecoding((char*)FileName, &SBFData) != 0)
+    {
+        perror(FileName);
+        return false;
+    }
+
+    if (Stream)
+    {
+        InitializeSBFDecodingWithExistingFile(NULL, &StreamData);
+    }
+
+    MeasEpoch = sbfread_AllocMeasEpoch(Decoder);
+
+    while (MeasEpoch != NULL &&
+           GetNextBlock(&SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                        START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
+    {
+        if (sbfread_MeasCollectAndDecode(Decoder, SBFBlock, MeasEpoch, SBFREAD_ALLMEAS_ENABLED))
+        {
+            const uint32_t Slot = NrOfEpochs % CHECK_IN_FLIGHT;
+
+            if (InFlight[Slot] != NULL)
+            {
+                sbfread_FreeMeasEpoch(Decoder, InFlight[Slot]);
+            }
+
+            InFlight[Slot] = MeasEpoch;
+            MeasEpoch = sbfread_AllocMeasEpoch(Decoder);
+
+            if (++NrOfEpochs == CHECK_WARMUP)
+            {
+                WarmCount   = sbfread_GetAllocationCount(Decoder);
+                WarmMallocs = __atomic_load_n(&NrOfMallocs, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    Success = (MeasEpoch != NULL && NrOfEpochs > CHECK_WARMUP &&
+               sbfread_GetAllocationCount(Decoder) == WarmCount &&
+               __atomic_load_n(&NrOfMallocs, __ATOMIC_RELAXED) == WarmMallocs);
+
+    printf("%s (%s): %u epochs, allocations after %u epochs %u, at the end %u",
+           FileName, Stream ? "stream" : "file", NrOfEpochs, CHECK_WARMUP,
+           WarmCount, sbfread_GetAllocationCount(Decoder));
+#ifdef CHECK_WRAP_MALLOC
+    printf(" (all calls %u, %u)", WarmMallocs, __atomic_load_n(&NrOfMallocs, __ATOMIC_RELAXED));
+#endif
+    printf(": %s\n", Success ? "ok" : "FAILED");
+
+    for (i = 0; i < CHECK_IN_FLIGHT; i++)
+    {
+        if (InFlight[i] != NULL)
+        {
+            sbfread_FreeMeasEpoch(Decoder, InFlight[i]);
+        }
+    }
+
+    if (MeasEpoch != NULL)
+    {
+        sbfread_FreeMeasEpoch(Decoder, MeasEpoch);
+    }
+
+    if (Stream)
+    {
+        sbfread_ReleaseMeasDecoding(&StreamData);
+    }
+
+    CloseSBFFile(&SBFData);
+
+    return Success;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    int Errors = 0;
+    int i;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: check_alloc file.sbf...\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 1; i < argc; i++)
+    {
+        Errors += check_File(argv[i], false) ? 0 : 1;
+        Errors += check_File(argv[i], true) ? 0 : 1;
+    }
+
+    printf("check_alloc: %d files, %d failures\n", argc - 1, Errors);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,250 @@
+/*
+ * check_printf.c: Check that sbfout_Printf(), sbfout_PutFixed() and
+ *                 sbfout_PutInt() write the same text as snprintf()
+ *                 (see the "check" target of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Every format is written to a memory stream with sbfout and compared
+   with the output of snprintf() for the same arguments:
+
+     - "%W.Pf", "%-W.Pf" and "%f" of the values in Values[], of their
+       negatives and of pseudo-random values from 1e-12 to 1e22, for
+       the widths 0..80 and the precisions 0..20, which cover both the
+       fields formatted by sbfout and those left to the C library;
+     - rounding ties (0.125, 2.5, ...) and the values next to them;
+     - the text after a conversion, which must still be written when
+       the field is wider than sbfout formats itself;
+     - the integer and string conversions with the same widths.
+
+   A field larger than the output buffer is also written to a file
+   stream and read back.
+
+   usage: check_printf  (prints the mismatches, exits with 1 if any) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "sbfout.h"
+
+#define CHECK_MAX_WIDTH      80
+#define CHECK_MAX_PRECISION  20
+#define CHECK_NR_OF_RANDOM   200
+
+static const double Values[] =
+{
+    0.0, 1.0, 0.5, 1.5, 2.5, 0.125, 0.375, 1.005, 0.045, 9.995, 99.5,
+    123.456, 1e-7, 5e-7, 0.999999, 0.9999995, 1e15 + 0.5, 4503599627370495.5,
+    4503599627370496.0, 9007199254740993.0, 1e21, 1e22, 1.7976931348623157e308,
+    4.9406564584124654e-324, 2.2250738585072014e-308, 20200101.123456789
+};
+
+static sbfout_Stream_t Out;
+static char            Expected[1024];
+static uint32_t        NrOfChecks;
+static uint32_t        Errors;
+static uint64_t        Random = 0x853c49e6748fea9bULL;
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Compare(const char* What)
+/* compares the contents of the memory stream with Expected */
+{
+    size_t Len = strlen(Expected);
+
+    if (Out.Used != Len || memcmp(Out.Data, Expected, Len) != 0)
+    {
+        printf("%s: \"%.*s\" instead of \"%s\"\n", What, (int)Out.Used, Out.Data, Expected);
+        Errors++;
+    }
+
+    Out.Used = 0;
+    NrOfChecks++;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double check_Random(void)
+/* returns a value from 1e-12 to 1e22, with about as many values for
+   every power of 10 */
+{
+    Random = Random * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    return pow(10.0, (double)(Random >> 11) / 9007199254740992.0 * 34.0 - 12.0);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Fixed(double Value)
+{
+    char What[64];
+    int  Width;
+    int  Precision;
+
+    (void)snprintf(Expected, sizeof(Expected), "%f", Value);
+    sbfout_Printf(&Out, "%f", Value);
+    check_Compare("%f");
+
+    for (Width = 0; Width <= CHECK_MAX_WIDTH; Width++)
+    {
+        for (Precision = 0; Precision <= CHECK_MAX_PRECISION; Precision++)
+        {
+            (void)snprintf(What, sizeof(What), "%%%d.%df of %.17g", Width, Precision, Value);
+            (void)snprintf(Expected, sizeof(Expected), "%*.*f|", Width, Precision, Value);
+            sbfout_Printf(&Out, "%*.*f|", Width, Precision, Value);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "%%-%d.%df of %.17g", Width, Precision, Value);
+            (void)snprintf(Expected, sizeof(Expected), "%-*.*f|", Width, Precision, Value);
+            sbfout_Printf(&Out, "%-*.*f|", Width, Precision, Value);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "sbfout_PutFixed(%d, %d) of %.17g", Width, Precision, Value);
+            (void)snprintf(Expected, sizeof(Expected), "%*.*f", Width, Precision, Value);
+            sbfout_PutFixed(&Out, Value, Width, Precision);
+            check_Compare(What);
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Literal(void)
+/* the widths and precisions written in the format string, and the text
+   after the wide fields */
+{
+    (void)snprintf(Expected, sizeof(Expected), "a%70.3fb%-66.2fc%.70fd%5de", 1.25, -3.5, 0.1, 42);
+    sbfout_Printf(&Out, "a%70.3fb%-66.2fc%.70fd%5de", 1.25, -3.5, 0.1, 42);
+    check_Compare("%70.3f, %-66.2f and %.70f followed by text");
+
+    (void)snprintf(Expected, sizeof(Expected), "%12.4f %-9.1f %8.0f|", 2.00005, 0.05, 0.5);
+    sbfout_Printf(&Out, "%12.4f %-9.1f %8.0f|", 2.00005, 0.05, 0.5);
+    check_Compare("%12.4f %-9.1f %8.0f");
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Integers(void)
+{
+    static const long long Ints[] = { 0, 7, -7, 123456789, -2147483648LL, 9223372036854775807LL };
+    char   What[64];
+    int    Width;
+    size_t i;
+
+    for (i = 0; i < sizeof(Ints) / sizeof(Ints[0]); i++)
+    {
+        for (Width = 0; Width <= CHECK_MAX_WIDTH; Width++)
+        {
+            (void)snprintf(What, sizeof(What), "%%%dlld of %lld", Width, Ints[i]);
+            (void)snprintf(Expected, sizeof(Expected), "%*lld|", Width, Ints[i]);
+            sbfout_Printf(&Out, "%*lld|", Width, Ints[i]);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "%%0%dlld of %lld", Width, Ints[i]);
+            (void)snprintf(Expected, sizeof(Expected), "%0*lld|", Width, Ints[i]);
+            sbfout_Printf(&Out, "%0*lld|", Width, Ints[i]);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "%%-%dllx of %lld", Width, Ints[i]);
+            (void)snprintf(Expected, sizeof(Expected), "%-*llx|", Width, (unsigned long long)Ints[i]);
+            sbfout_Printf(&Out, "%-*llx|", Width, (unsigned long long)Ints[i]);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "sbfout_PutInt(%d) of %lld", Width, Ints[i]);
+            (void)snprintf(Expected, sizeof(Expected), "%*lld", Width, Ints[i]);
+            sbfout_PutInt(&Out, Ints[i], Width);
+            check_Compare(What);
+
+            (void)snprintf(What, sizeof(What), "%%%ds and %%-%ds", Width, Width);
+            (void)snprintf(Expected, sizeof(Expected), "%*s|%-*s|", Width, "G01", Width, "E36");
+            sbfout_Printf(&Out, "%*s|%-*s|", Width, "G01", Width, "E36");
+            check_Compare(What);
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_FileStream(void)
+/* a field larger than the output buffer */
+{
+    sbfout_Stream_t File;
+    const int       Width = 3 * SBFOUT_BUFFER_SIZE / 2;
+    FILE*           F = tmpfile();
+    char*           Text = (char*)malloc((size_t)Width + 16);
+    size_t          Len;
+
+    if (F == NULL || Text == NULL || !sbfout_Open(&File, F))
+    {
+        printf("check_printf: cannot open a temporary file\n");
+        Errors++;
+        return;
+    }
+
+    sbfout_Printf(&File, "<%*.3f>", Width, 1.5);
+    (void)sbfout_Close(&File);
+
+    rewind(F);
+    Len = fread(Text, 1, (size_t)Width + 16, F);
+
+    if (Len != (size_t)Width + 2 || Text[0] != '<' || Text[Width - 5] != ' ' ||
+        memcmp(Text + Width - 4, "1.500>", 6) != 0)
+    {
+        printf("check_printf: %%%d.3f written as %zu bytes to a file\n", Width, Len);
+        Errors++;
+    }
+
+    NrOfChecks++;
+    free(Text);
+    (void)fclose(F);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(void)
+{
+    size_t i;
+
+    if (!sbfout_OpenMemory(&Out))
+    {
+        printf("check_printf: cannot allocate the buffer\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < sizeof(Values) / sizeof(Values[0]); i++)
+    {
+        check_Fixed(Values[i]);
+        check_Fixed(-Values[i]);
+        check_Fixed(nextafter(Values[i], 0.0));
+        check_Fixed(nextafter(Values[i], INFINITY));
+    }
+
+    for (i = 0; i < CHECK_NR_OF_RANDOM; i++)
+    {
+        check_Fixed(check_Random());
+    }
+
+    check_Literal();
+    check_Integers();
+    check_FileStream();
+
+    (void)sbfout_Close(&Out);
+
+    printf("check_printf: %u checks, %u mismatches\n", NrOfChecks, Errors);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
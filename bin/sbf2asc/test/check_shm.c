@@ -0,0 +1,326 @@
+/*
+ * check_shm.c: Check the readers of the shared memory ring of sbfshm
+ *              (see the "check" target of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Built with SBFSHM=1 and a small ring (SBFSHM_NR_OF_SLOTS), so that
+   the writer laps the readers quickly.  The epoch N written by the
+   checks has TOW_ms = N and 1 + N % 50 measurement sets, the set i
+   having PR_m = N + i: a reader can tell from any copy whether it is
+   one consistent epoch.
+
+     1. in order: the epochs written are read back, then the reader
+        gets SBFSHM_READ_EMPTY, and SBFSHM_READ_CLOSED once the writer
+        is closed;
+     2. overrun: a reader that is several rounds late gets
+        SBFSHM_READ_OVERRUN, counts the lost epochs in Lost, and goes
+        on with the oldest epoch of the ring;
+     3. retry: the slot of the next epoch of a reader is being
+        rewritten (odd Version, as left by the writer in the middle of
+        sbfshm_AddEpoch()), possibly before the reader sees the new
+        Head, so the reader must not return its content but skip to
+        the next epoch;
+     4. concurrent: a writer thread publishes epochs without any pause
+        while a reader thread reads them.  Every epoch read must be
+        consistent, the epoch numbers must increase, and the epochs
+        read plus Lost must be all the epochs written.  The number of
+        overruns is printed: it shows that the retry path ran.
+
+   usage: check_shm  (exits with 1 on a failure) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "sbfshm.h"
+#include "sviddef.h"
+
+#define CHECK_NR_OF_EPOCHS  200000  /* of the concurrent check */
+
+static char           ShmName[64];
+static MeasEpoch_t    MeasEpoch;
+static sbfshm_Epoch_t Epoch;
+static int            Errors;
+
+#define CHECK(Cond) \
+    do { if (!(Cond)) { printf("check_shm:%d: %s failed\n", __LINE__, #Cond); Errors++; } } while (0)
+
+
+/*---------------------------------------------------------------------------*/
+static void check_AddEpoch(sbfshm_t* Writer,
+                           uint32_t  N)
+/* publish the epoch N */
+{
+    uint32_t NrOfMeas = 1 + N % 50;
+    uint32_t i;
+
+    MeasEpoch.TOW_ms      = N;
+    MeasEpoch.WNc         = 2300;
+    MeasEpoch.commonFlags = 0;
+    MeasEpoch.nbrElements = (int)NrOfMeas;
+
+    for (i = 0; i < NrOfMeas; i++)
+    {
+        MeasChannel_t* const ChannelData = &(MeasEpoch.channelData[i]);
+
+        ChannelData->PRN = gpMINPRN + i % 32;
+        ChannelData->measSet[0][0].flags      = MEASFLAG_VALIDITY;
+        ChannelData->measSet[0][0].signalType = 0;
+        ChannelData->measSet[0][0].PR_m       = (double)N + i;
+    }
+
+    sbfshm_AddEpoch(Writer, &MeasEpoch);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool check_IsConsistent(const sbfshm_Epoch_t* Epoch)
+/* returns whether Epoch is one epoch of check_AddEpoch() */
+{
+    uint32_t N = Epoch->Epoch.TOW_ms;
+    uint32_t i;
+
+    if (Epoch->Epoch.NrOfMeas != 1 + N % 50)
+    {
+        return false;
+    }
+
+    for (i = 0; i < Epoch->Epoch.NrOfMeas; i++)
+    {
+        if (Epoch->Meas[i].PR_m != (double)N + i)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_InOrder(void)
+{
+    sbfshm_t Writer, Reader;
+    uint32_t N;
+
+    CHECK(sbfshm_Create(&Writer, ShmName));
+
+    for (N = 0; N < SBFSHM_NR_OF_SLOTS - 1; N++)
+    {
+        check_AddEpoch(&Writer, N);
+    }
+
+    CHECK(sbfshm_Open(&Reader, ShmName));
+
+    for (N = 0; N < SBFSHM_NR_OF_SLOTS - 1; N++)
+    {
+        CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OK);
+        CHECK(Epoch.Epoch.TOW_ms == N && check_IsConsistent(&Epoch));
+    }
+
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_EMPTY);
+    sbfshm_Close(&Writer);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_CLOSED);
+    CHECK(Reader.Lost == 0);
+    sbfshm_Close(&Reader);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Overrun(void)
+{
+    const uint32_t NrOfEpochs = 3 * SBFSHM_NR_OF_SLOTS + 5;
+    sbfshm_t Writer, Reader;
+    uint32_t N;
+
+    CHECK(sbfshm_Create(&Writer, ShmName));
+    CHECK(sbfshm_Open(&Reader, ShmName));
+
+    for (N = 0; N < NrOfEpochs; N++)
+    {
+        check_AddEpoch(&Writer, N);
+    }
+
+    /* only the last NrOfSlots - 1 epochs are kept */
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OVERRUN);
+    CHECK(Reader.Lost == NrOfEpochs - (SBFSHM_NR_OF_SLOTS - 1));
+
+    for (N = NrOfEpochs - (SBFSHM_NR_OF_SLOTS - 1); N < NrOfEpochs; N++)
+    {
+        CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OK);
+        CHECK(Epoch.Epoch.TOW_ms == N && check_IsConsistent(&Epoch));
+    }
+
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_EMPTY);
+    sbfshm_Close(&Reader);
+    sbfshm_Close(&Writer);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static sbfshm_Slot_t* check_StartRewrite(sbfshm_t* Writer,
+                                         uint64_t  N)
+/* leave the slot of the epoch N as sbfshm_AddEpoch() does while it
+   writes the epoch N + NrOfSlots over it, half written */
+{
+    sbfshm_Slot_t* Slot = (sbfshm_Slot_t*)(Writer->Slots + (size_t)(N % SBFSHM_NR_OF_SLOTS) *
+                                           Writer->Header->SlotSize);
+
+    __atomic_store_n(&Slot->Version, 2 * (N + SBFSHM_NR_OF_SLOTS) + 1, __ATOMIC_RELEASE);
+    Slot->TOW_ms   = (uint32_t)(N + SBFSHM_NR_OF_SLOTS);
+    Slot->NrOfMeas = 0;
+
+    return Slot;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Retry(void)
+{
+    sbfshm_t Writer, Reader;
+    uint32_t N;
+
+    CHECK(sbfshm_Create(&Writer, ShmName));
+
+    for (N = 0; N < SBFSHM_NR_OF_SLOTS; N++)
+    {
+        check_AddEpoch(&Writer, N);
+    }
+
+    /* the next epoch of the reader is the oldest one, 1 */
+    CHECK(sbfshm_Open(&Reader, ShmName));
+    CHECK(Reader.Next == 1);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OK);
+    CHECK(Epoch.Epoch.TOW_ms == 1 && check_IsConsistent(&Epoch));
+
+    /* the slot of the epoch 2 is being rewritten, and the reader sees
+       its new Version before the new Head: the Version check fails
+       while the Head still says that the epoch 2 is in the ring.  The
+       reader must not return the torn epoch, nor go back, but skip to
+       the epoch 3 */
+    check_StartRewrite(&Writer, 2);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OVERRUN);
+    CHECK(Reader.Lost == 1 && Reader.Next == 3);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OK);
+    CHECK(Epoch.Epoch.TOW_ms == 3 && check_IsConsistent(&Epoch));
+
+    /* the writer has lapped the reader and is rewriting the slot of its
+       next epoch, 4: the reader skips to the oldest epoch which is not
+       being overwritten */
+    for (N = SBFSHM_NR_OF_SLOTS; N < SBFSHM_NR_OF_SLOTS + 4; N++)
+    {
+        check_AddEpoch(&Writer, N);
+    }
+
+    check_StartRewrite(&Writer, 4);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OVERRUN);
+    CHECK(Reader.Lost == 2 && Reader.Next == 5);
+    CHECK(sbfshm_Read(&Reader, &Epoch) == SBFSHM_READ_OK);
+    CHECK(Epoch.Epoch.TOW_ms == 5 && check_IsConsistent(&Epoch));
+
+    sbfshm_Close(&Reader);
+    sbfshm_Close(&Writer);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void* check_WriterThread(void* Arg)
+{
+    sbfshm_t* Writer = (sbfshm_t*)Arg;
+    uint32_t  N;
+
+    for (N = 0; N < CHECK_NR_OF_EPOCHS; N++)
+    {
+        check_AddEpoch(Writer, N);
+    }
+
+    sbfshm_Close(Writer);
+
+    return NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Concurrent(void)
+{
+    static sbfshm_t Writer;
+    sbfshm_t  Reader;
+    pthread_t Thread;
+    uint64_t  NrOfRead = 0, NrOfOverruns = 0, NrOfTorn = 0;
+    int64_t   Last = -1;
+    bool      InOrder = true;
+    int       Result;
+
+    CHECK(sbfshm_Create(&Writer, ShmName));
+    CHECK(sbfshm_Open(&Reader, ShmName));
+    CHECK(pthread_create(&Thread, NULL, check_WriterThread, &Writer) == 0);
+
+    while ((Result = sbfshm_Read(&Reader, &Epoch)) != SBFSHM_READ_CLOSED)
+    {
+        if (Result == SBFSHM_READ_OK)
+        {
+            if (!check_IsConsistent(&Epoch))
+            {
+                NrOfTorn++;
+            }
+
+            if ((int64_t)Epoch.Epoch.TOW_ms <= Last)
+            {
+                InOrder = false;
+            }
+
+            Last = Epoch.Epoch.TOW_ms;
+            NrOfRead++;
+        }
+        else if (Result == SBFSHM_READ_OVERRUN)
+        {
+            NrOfOverruns++;
+        }
+    }
+
+    pthread_join(Thread, NULL);
+
+    CHECK(NrOfTorn == 0);
+    CHECK(InOrder);
+    CHECK(Last == CHECK_NR_OF_EPOCHS - 1);
+    CHECK(NrOfRead + Reader.Lost == CHECK_NR_OF_EPOCHS);
+
+    printf("check_shm: concurrent: %u epochs written, %llu read, %llu lost in %llu overruns, %llu torn\n",
+           CHECK_NR_OF_EPOCHS, (unsigned long long)NrOfRead, (unsigned long long)Reader.Lost,
+           (unsigned long long)NrOfOverruns, (unsigned long long)NrOfTorn);
+
+    sbfshm_Close(&Reader);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(void)
+{
+    snprintf(ShmName, sizeof(ShmName), "/sbf2asc_check_shm_%ld", (long)getpid());
+
+    check_InOrder();
+    check_Overrun();
+    check_Retry();
+    check_Concurrent();
+
+    (void)shm_unlink(ShmName);
+
+    printf("check_shm: ring of %d slots, %d failures\n", SBFSHM_NR_OF_SLOTS, Errors);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,481 @@
+/*
+ * check_tables.c: Check that the lookup tables of the SVID conversions,
+ *                 of the satellite names and of the carrier wavelengths
+ *                 give the same results as the functions they replaced
+ *                 (see the "check" target of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The Old...() functions below are the branching versions of
+   convertSVIDfromSBF(), convertSVIDtoSBF() and GetWavelength_m(), as
+   they were before the tables, and OldSatelliteName() is the naming
+   of svid_to_satellite() in data.py.  Every input is run through both
+   the tables and the old function:
+
+     - every SBF and internal SVID in 0..69999 and the top of the
+       uint32_t range;
+     - every signal type in -3..299 with every GLONASS frequency number
+       in -100..99 (the wavelengths must be equal bit for bit);
+     - every SBF SVID for the satellite names.
+
+   usage: check_tables  (prints the mismatches, exits with 1 if any) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sbfread.h"
+#include "sbfsvid.h"
+#include "sviddef.h"
+
+#define SBFSVID_GPS_MIN  (  1)
+#define SBFSVID_GPS_MAX  ( 37)
+
+#define SBFSVID_GLO_MIN1 ( 38)
+#define SBFSVID_GLO_MAX1 ( 61)
+#define SBFSVID_GLO_UNK  ( 62)
+#define SBFSVID_GLO_MIN2 ( 63)
+#define SBFSVID_GLO_MAX2 ( 70)
+#define SBFSVID_GLO_GAP1 (SBFSVID_GLO_MIN2-SBFSVID_GLO_MAX1-1)
+
+#define SBFSVID_GAL_MIN  ( 71)
+#define SBFSVID_GAL_MAX  (106)
+
+#define SBFSVID_LBR_MIN  (107)
+#define SBFSVID_LBR_MAX  (117)
+#define SBFSVID_LBR_UNK1 (119)
+#define SBFSVID_LBR_UNK2 (118)
+
+#define SBFSVID_RA_MIN1  (120)
+#define SBFSVID_RA_MAX1  (140)
+#define SBFSVID_RA_MIN2  (198)
+#define SBFSVID_RA_MAX2  (215)
+#define SBFSVID_RA_GAP1  (SBFSVID_RA_MIN2-SBFSVID_RA_MAX1-1)
+
+#define SBFSVID_BDS_MIN1 (141)
+#define SBFSVID_BDS_MAX1 (180)
+#define SBFSVID_BDS_MIN2 (223)
+#define SBFSVID_BDS_MAX2 (245)
+#define SBFSVID_BDS_GAP1 (SBFSVID_BDS_MIN2-SBFSVID_BDS_MAX1-1)
+
+#define SBFSVID_QZSS_MIN (181)
+#define SBFSVID_QZSS_MAX (190)
+
+#define SBFSVID_IRNS_MIN1 (191)
+#define SBFSVID_IRNS_MAX1 (197)
+#define SBFSVID_IRNS_MIN2 (216)
+#define SBFSVID_IRNS_MAX2 (222)
+#define SBFSVID_IRNS_GAP1  (SBFSVID_IRNS_MIN2-SBFSVID_IRNS_MAX1-1)
+
+#define SBFSVID_INVALID  (255)
+
+/*---------------------------------------------------------------------------*/
+static uint32_t OldSVIDfromSBF(uint32_t sbfSVID)
+{
+    uint32_t internalSBF = 0;
+
+    // GPS
+    if (sbfSVID >= SBFSVID_GPS_MIN && sbfSVID <= SBFSVID_GPS_MAX)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (gpMINPRN - SBFSVID_GPS_MIN));
+    }
+
+    // GLO
+    if (sbfSVID >= SBFSVID_GLO_MIN1 && sbfSVID <= SBFSVID_GLO_MAX1)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (glMINPRN - SBFSVID_GLO_MIN1));
+    }
+
+    if (sbfSVID == SBFSVID_GLO_UNK)
+    {
+        internalSBF = (uint32_t)glPRNUNKWN;
+    }
+
+    if (sbfSVID >= SBFSVID_GLO_MIN2 && sbfSVID <= SBFSVID_GLO_MAX2)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (glMINPRN - SBFSVID_GLO_MIN1 - SBFSVID_GLO_GAP1));
+    }
+
+    // GAL
+    if (sbfSVID >= SBFSVID_GAL_MIN && sbfSVID <= SBFSVID_GAL_MAX)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (galMINPRN - SBFSVID_GAL_MIN));
+    }
+
+    // LBAND
+    if (sbfSVID >= SBFSVID_LBR_MIN && sbfSVID <= SBFSVID_LBR_MAX)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (lbMINPRN - SBFSVID_LBR_MIN));
+    }
+
+    if (sbfSVID == SBFSVID_LBR_UNK1)
+    {
+        internalSBF = (uint32_t)lbPRNUNKWN1;
+    }
+
+    if (sbfSVID == SBFSVID_LBR_UNK2)
+    {
+        internalSBF = (uint32_t)lbPRNUNKWN2;
+    }
+
+    // SBAS
+    if (sbfSVID >= SBFSVID_RA_MIN1 && sbfSVID <= SBFSVID_RA_MAX1)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (raMINPRN - SBFSVID_RA_MIN1));
+    }
+
+    if (sbfSVID >= SBFSVID_RA_MIN2 && sbfSVID <= SBFSVID_RA_MAX2)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (raMINPRN - SBFSVID_RA_MIN1 - SBFSVID_RA_GAP1));
+    }
+
+    // BDS
+    if (sbfSVID >= SBFSVID_BDS_MIN1 && sbfSVID <= SBFSVID_BDS_MAX1)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (cmpMINPRN - SBFSVID_BDS_MIN1));
+    }
+
+    if (sbfSVID >= SBFSVID_BDS_MIN2 && sbfSVID <= SBFSVID_BDS_MAX2)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (cmpMINPRN - SBFSVID_BDS_MIN1 - SBFSVID_BDS_GAP1));
+    }
+
+    // QZSS
+    if (sbfSVID >= SBFSVID_QZSS_MIN && sbfSVID <= SBFSVID_QZSS_MAX)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (qzMINPRN - SBFSVID_QZSS_MIN));
+    }
+
+    // IRNSS
+    if (sbfSVID >= SBFSVID_IRNS_MIN1 && sbfSVID <= SBFSVID_IRNS_MAX1)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (irMINPRN - SBFSVID_IRNS_MIN1));
+    }
+
+    if (sbfSVID >= SBFSVID_IRNS_MIN2 && sbfSVID <= SBFSVID_IRNS_MAX2)
+    {
+        internalSBF = (uint32_t)(sbfSVID + (irMINPRN - SBFSVID_IRNS_MIN1 - SBFSVID_IRNS_GAP1));
+    }
+
+    return internalSBF;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint8_t OldSVIDtoSBF(uint32_t internalSVID)
+{
+    uint8_t sbfSVID = SBFSVID_INVALID;
+
+    if (agIsGPS(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - gpMINPRN + SBFSVID_GPS_MIN);
+    }
+    else if (agIsGLONASS(internalSVID))
+    {
+        if (internalSVID == glPRNUNKWN)
+        {
+            sbfSVID = (uint8_t)SBFSVID_GLO_UNK;
+        }
+        else
+        {
+            sbfSVID = (uint8_t)(internalSVID - glMINPRN + SBFSVID_GLO_MIN1);
+
+            /* this is for the GLONASS slots > 24 */
+            if (internalSVID > glMINPRN + SBFSVID_GLO_MAX1 - SBFSVID_GLO_MIN1)
+            {
+                sbfSVID += SBFSVID_GLO_GAP1;
+            }
+        }
+    }
+    else if (agIsGAL(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - galMINPRN + SBFSVID_GAL_MIN);
+    }
+    else if (agIsLBR(internalSVID))
+    {
+        if (internalSVID == lbPRNUNKWN1)
+        {
+            sbfSVID = (uint8_t)SBFSVID_LBR_UNK1;
+        }
+        else if (internalSVID == lbPRNUNKWN2)
+        {
+            sbfSVID = (uint8_t)SBFSVID_LBR_UNK2;
+        }
+        else
+        {
+            sbfSVID = (uint8_t)(internalSVID - lbMINPRN + SBFSVID_LBR_MIN);
+        }
+    }
+    else if (agIsRA(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - raMINPRN + SBFSVID_RA_MIN1);
+
+        /* this is the second part of the SBAS PRNS, remapped in SBF in the 198-215 range */
+        if (internalSVID > raMINPRN + SBFSVID_RA_MAX1 - SBFSVID_RA_MIN1)
+        {
+            sbfSVID += SBFSVID_RA_GAP1;
+        }
+    }
+    else if (agIsCOMPASS(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - cmpMINPRN + SBFSVID_BDS_MIN1);
+
+        /* this is the second part of the BDS PRNS (from C41), remapped in SBF in the 223-245 range */
+        if (internalSVID > cmpMINPRN + SBFSVID_BDS_MAX1 - SBFSVID_BDS_MIN1)
+        {
+            sbfSVID += SBFSVID_BDS_GAP1;
+        }
+    }
+    else if (agIsQZSS(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - qzMINPRN + SBFSVID_QZSS_MIN);
+    }
+    else if (agIsIRNSS(internalSVID))
+    {
+        sbfSVID = (uint8_t)(internalSVID - irMINPRN + SBFSVID_IRNS_MIN1);
+
+        /* this is the second part of the IRNSS PRNS, remapped in SBF in the 216-222 range */
+        if (internalSVID > irMINPRN + SBFSVID_IRNS_MAX1 - SBFSVID_IRNS_MIN1)
+        {
+            sbfSVID += SBFSVID_IRNS_GAP1;
+        }
+    }
+
+    return sbfSVID;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static double OldWavelength_m(SignalType_t SignalType, int GLOfn)
+/* returns the carrier wavelength corresponding to a given Type field
+ * in a MeasEpoch sub-block.
+ *
+ * Arguments:
+ *   Type: the Type field as provided in the type-1 or type-2 sub-blocks.
+ *
+ *   GLOfn: GLONASS frequency number (from -7 to 12).  This argument
+ *          is ignored for non-GLONASS signals.
+ *
+ */
+{
+    double wavelength;
+
+    switch (SignalType)
+    {
+    case SIG_GPSL1CA:
+    case SIG_GPSL1P:
+    case SIG_GPSL1C:
+    case SIG_GALE1BC:
+    case SIG_SBSL1CA:
+    case SIG_QZSL1CA:
+    case SIG_QZSL1CB:
+    case SIG_QZSL1C:
+    case SIG_QZSL1S:
+    case SIG_BDSB1C:
+    case SIG_IRNL1:
+        wavelength = L1WAVELENGTH;
+        break;
+
+    case SIG_GPSL2P:
+    case SIG_GPSL2C:
+    case SIG_QZSL2C:
+        wavelength = L2WAVELENGTH;
+        break;
+
+    case SIG_GALE5:
+        wavelength = E5WAVELENGTH;
+        break;
+
+    case SIG_GALE5a:
+    case SIG_RES16_:
+        wavelength = E5aWAVELENGTH;
+        break;
+
+    case SIG_GALE5b:
+    case SIG_BDSB2I:
+    case SIG_BDSB2b:
+        wavelength = E5bWAVELENGTH;
+        break;
+
+    case SIG_GALE6BC:
+    case SIG_QZSL6:
+        wavelength = E6WAVELENGTH;
+        break;
+
+    case SIG_GPSL5:
+    case SIG_SBSL5:
+    case SIG_QZSL5:
+    case SIG_QZSL5S:
+    case SIG_IRNL5:
+    case SIG_BDSB2a:
+        wavelength = L5WAVELENGTH;
+        break;
+
+    case SIG_BDSB1I:
+        wavelength = E2WAVELENGTH;
+        break;
+
+    case SIG_BDSB3:
+        wavelength = B3WAVELENGTH;
+        break;
+
+    case SIG_GLOL1CA:
+    case SIG_GLOL1P:
+        wavelength = c84 / (L1GLOFREQ + GLOfn * 562500);
+        break;
+
+    case SIG_GLOL2CA:
+    case SIG_GLOL2P:
+        wavelength = c84 / (L2GLOFREQ + GLOfn * 437500);
+        break;
+
+    case SIG_GLOL3:
+        wavelength = L3WAVELENGTH;
+        break;
+
+    case SIG_IRNS1:
+        wavelength = S1WAVELENGTH;
+        break;
+
+    default:
+        wavelength = L1WAVELENGTH;
+        break;
+    }
+
+    return (wavelength);
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void OldSatelliteName(uint32_t sbfSVID, char Name[4])
+{
+    static const struct
+    {
+        uint32_t Min, Max;
+        char     System;
+        uint32_t Offset;
+    } Ranges[] =
+    {
+        {   1,  37, 'G',   0 },
+        {  38,  61, 'R',  37 },
+        {  63,  68, 'R',  38 },
+        {  71, 106, 'E',  70 },
+        { 120, 140, 'S', 100 },
+        { 141, 180, 'C', 140 },
+        { 181, 190, 'J', 180 },  /* J08-J10 are not in data.py */
+        { 191, 197, 'I', 190 },
+        { 198, 215, 'S', 157 },
+        { 216, 222, 'I', 208 },
+        { 223, 245, 'C', 182 }
+    };
+    uint32_t i;
+
+    Name[0] = '\0';
+
+    if (sbfSVID == 62 || (sbfSVID >= 107 && sbfSVID <= 119))
+    {
+        strcpy(Name, "NA");
+    }
+
+    for (i = 0; i < sizeof(Ranges) / sizeof(Ranges[0]); i++)
+    {
+        if (sbfSVID >= Ranges[i].Min && sbfSVID <= Ranges[i].Max)
+        {
+            snprintf(Name, 4, "%c%02u", Ranges[i].System, sbfSVID - Ranges[i].Offset);
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t CheckSVID(uint32_t SVID)
+{
+    uint32_t Errors = 0;
+
+    if (convertSVIDfromSBF(SVID) != OldSVIDfromSBF(SVID))
+    {
+        printf("convertSVIDfromSBF(%u): %u instead of %u\n",
+               SVID, convertSVIDfromSBF(SVID), OldSVIDfromSBF(SVID));
+        Errors++;
+    }
+
+    if (convertSVIDtoSBF(SVID) != OldSVIDtoSBF(SVID))
+    {
+        printf("convertSVIDtoSBF(%u): %u instead of %u\n",
+               SVID, convertSVIDtoSBF(SVID), OldSVIDtoSBF(SVID));
+        Errors++;
+    }
+
+    return Errors;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(void)
+{
+    uint32_t Errors = 0;
+    uint32_t NrOfChecks = 0;
+    uint32_t SVID;
+    int      SignalType, GLOfn;
+
+    for (SVID = 0; SVID < 70000; SVID++)
+    {
+        Errors += CheckSVID(SVID);
+        NrOfChecks += 2;
+    }
+
+    for (SVID = 0xffffffffU - 70000; SVID != 0; SVID++)
+    {
+        Errors += CheckSVID(SVID);
+        NrOfChecks += 2;
+    }
+
+    for (SignalType = -3; SignalType < 300; SignalType++)
+    {
+        for (GLOfn = -100; GLOfn < 100; GLOfn++)
+        {
+            double New = GetWavelength_m((SignalType_t)SignalType, GLOfn);
+            double Old = OldWavelength_m((SignalType_t)SignalType, GLOfn);
+
+            if (memcmp(&New, &Old, sizeof(New)) != 0)
+            {
+                printf("GetWavelength_m(%d, %d): %.17g instead of %.17g\n",
+                       SignalType, GLOfn, New, Old);
+                Errors++;
+            }
+
+            NrOfChecks++;
+        }
+    }
+
+    for (SVID = 0; SVID < 300; SVID++)
+    {
+        char Name[4];
+
+        OldSatelliteName(SVID, Name);
+
+        if (strcmp(getSatelliteNameFromSBF(SVID), Name) != 0)
+        {
+            printf("getSatelliteNameFromSBF(%u): \"%s\" instead of \"%s\"\n",
+                   SVID, getSatelliteNameFromSBF(SVID), Name);
+            Errors++;
+        }
+
+        NrOfChecks++;
+    }
+
+    printf("check_tables: %u checks, %u mismatches\n", NrOfChecks, Errors);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
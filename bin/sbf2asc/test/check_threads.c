@@ -0,0 +1,282 @@
+/*
+ * check_threads.c: Check that several decoders can run at once, each on
+ *                  its own thread and file (see the "check" and
+ *                  "tsan-check" targets of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Each file is first decoded alone, and a checksum of its decoded
+   epochs is kept.  Then Threads threads are started at once, the
+   thread i decoding the file i % NrOfFiles Rounds times with its own
+   SBFData_t, and each run must give the checksum of the file.  Built
+   with -fsanitize=thread ("make tsan-check"), ThreadSanitizer also
+   reports any data shared between the decoders, and, with
+   SBFREAD_THREADS, between the threads decoding the antennas of an
+   epoch.
+
+   usage: check_threads [-t Threads] [-r Rounds] file.sbf...
+          (default 8 threads and 2 rounds, exits with 1 on a mismatch) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "sbfread.h"
+
+#define CHECK_MAX_THREADS  64
+
+typedef struct
+{
+    const char*       FileName;
+    uint32_t          NrOfRounds;
+    uint64_t          Checksum;    /* of the last round */
+    uint64_t          NrOfEpochs;  /* of the last round */
+    uint32_t          NrOfMismatches; /* rounds whose checksum differs
+                                         from the first one */
+    bool              Failed;      /* out of memory */
+} check_Thread_t;
+
+
+/*---------------------------------------------------------------------------*/
+static uint64_t check_Hash(uint64_t Hash, const void* Data, size_t Length)
+/* FNV-1a */
+{
+    const uint8_t* p = (const uint8_t*)Data;
+    size_t i;
+
+    for (i = 0; i < Length; i++)
+    {
+        Hash = (Hash ^ p[i]) * 0x100000001b3ULL;
+    }
+
+    return Hash;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint64_t check_HashEpoch(uint64_t Hash, const MeasEpoch_t* MeasEpoch)
+/* hash the fields of the epoch one by one, leaving out the padding */
+{
+    uint32_t i, Ant, SigIdx;
+
+    Hash = check_Hash(Hash, &MeasEpoch->TOW_ms, sizeof(MeasEpoch->TOW_ms));
+    Hash = check_Hash(Hash, &MeasEpoch->WNc, sizeof(MeasEpoch->WNc));
+    Hash = check_Hash(Hash, &MeasEpoch->nbrElements, sizeof(MeasEpoch->nbrElements));
+
+    for (i = 0; i < MeasEpoch->nbrElements; i++)
+    {
+        const MeasChannel_t* const ChannelData = &(MeasEpoch->channelData[i]);
+
+        Hash = check_Hash(Hash, &ChannelData->PRN, sizeof(ChannelData->PRN));
+
+        for (Ant = 0; Ant < NR_OF_ANTENNAS; Ant++)
+        {
+            for (SigIdx = 0; SigIdx < MAX_NR_OF_SIGNALS_PER_SATELLITE; SigIdx++)
+            {
+                const MeasSet_t* const MeasSet = &(ChannelData->measSet[Ant][SigIdx]);
+
+                if (MeasSet->flags == 0)
+                {
+                    continue;
+                }
+
+                Hash = check_Hash(Hash, &MeasSet->flags, sizeof(MeasSet->flags));
+                Hash = check_Hash(Hash, &MeasSet->signalType, sizeof(MeasSet->signalType));
+                Hash = check_Hash(Hash, &MeasSet->PR_m, sizeof(MeasSet->PR_m));
+                Hash = check_Hash(Hash, &MeasSet->L_cycles, sizeof(MeasSet->L_cycles));
+                Hash = check_Hash(Hash, &MeasSet->doppler_Hz, sizeof(MeasSet->doppler_Hz));
+                Hash = check_Hash(Hash, &MeasSet->CN0_dBHz, sizeof(MeasSet->CN0_dBHz));
+                Hash = check_Hash(Hash, &MeasSet->PLLTimer_ms, sizeof(MeasSet->PLLTimer_ms));
+            }
+        }
+    }
+
+    return Hash;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static bool check_Decode(const char* FileName,
+                         uint64_t*   Checksum,
+                         uint64_t*   NrOfEpochs)
+/* decode a file with its own decoder and buffers */
+{
+    SBFData_t*   SBFData   = (SBFData_t*)calloc(1, sizeof(SBFData_t));
+    MeasEpoch_t* MeasEpoch = (MeasEpoch_t*)calloc(1, sizeof(MeasEpoch_t));
+    uint8_t*     SBFBlock  = (uint8_t*)malloc(MAX_SBFSIZE);
+    bool         Success   = false;
+
+    *Checksum   = 0xcbf29ce484222325ULL;
+    *NrOfEpochs = 0;
+
+    if (SBFData != NULL && MeasEpoch != NULL && SBFBlock != NULL &&
+        InitializeSBFDecoding((char*)FileName, SBFData) == 0)
+    {
+        while (GetNextBlock(SBFData, SBFBlock, BLOCKNUMBER_ALL, BLOCKNUMBER_ALL,
+                            START_POS_CURRENT | END_POS_AFTER_BLOCK) == 0)
+        {
+            if (sbfread_MeasCollectAndDecode(SBFData, SBFBlock, MeasEpoch,
+                                             SBFREAD_ALLMEAS_ENABLED))
+            {
+                *Checksum = check_HashEpoch(*Checksum, MeasEpoch);
+                (*NrOfEpochs)++;
+            }
+        }
+
+        if (sbfread_FlushMeasEpoch(SBFData, MeasEpoch, SBFREAD_ALLMEAS_ENABLED))
+        {
+            *Checksum = check_HashEpoch(*Checksum, MeasEpoch);
+            (*NrOfEpochs)++;
+        }
+
+        CloseSBFFile(SBFData);
+        Success = true;
+    }
+
+    free(SBFBlock);
+    free(MeasEpoch);
+    free(SBFData);
+
+    return Success;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void* check_Thread(void* Arg)
+{
+    check_Thread_t* Thread = (check_Thread_t*)Arg;
+    uint64_t FirstChecksum = 0;
+    uint32_t Round;
+
+    for (Round = 0; Round < Thread->NrOfRounds; Round++)
+    {
+        if (!check_Decode(Thread->FileName, &Thread->Checksum, &Thread->NrOfEpochs))
+        {
+            Thread->Failed = true;
+            break;
+        }
+
+        if (Round == 0)
+        {
+            FirstChecksum = Thread->Checksum;
+        }
+        else if (Thread->Checksum != FirstChecksum)
+        {
+            Thread->NrOfMismatches++;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    static check_Thread_t Threads[CHECK_MAX_THREADS];
+    static pthread_t      ThreadIds[CHECK_MAX_THREADS];
+    uint64_t* Checksums;
+    uint64_t* NrOfEpochs;
+    int       NrOfThreads = 8;
+    int       NrOfRounds  = 2;
+    int       NrOfFiles, FirstFile = 1;
+    int       Errors = 0;
+    int       i;
+
+    while (FirstFile + 1 < argc && argv[FirstFile][0] == '-')
+    {
+        if (strcmp(argv[FirstFile], "-t") == 0)
+        {
+            NrOfThreads = atoi(argv[FirstFile + 1]);
+        }
+        else if (strcmp(argv[FirstFile], "-r") == 0)
+        {
+            NrOfRounds = atoi(argv[FirstFile + 1]);
+        }
+        else
+        {
+            break;
+        }
+
+        FirstFile += 2;
+    }
+
+    NrOfFiles = argc - FirstFile;
+
+    if (NrOfFiles < 1 || NrOfThreads < 1 || NrOfThreads > CHECK_MAX_THREADS || NrOfRounds < 1)
+    {
+        fprintf(stderr, "usage: check_threads [-t Threads (1-%d)] [-r Rounds] file.sbf...\n",
+                CHECK_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    Checksums  = (uint64_t*)calloc((size_t)NrOfFiles, sizeof(uint64_t));
+    NrOfEpochs = (uint64_t*)calloc((size_t)NrOfFiles, sizeof(uint64_t));
+
+    if (Checksums == NULL || NrOfEpochs == NULL)
+    {
+        perror("check_threads");
+        return EXIT_FAILURE;
+    }
+
+    /* the reference checksums, one decoder at a time */
+    for (i = 0; i < NrOfFiles; i++)
+    {
+        if (!check_Decode(argv[FirstFile + i], &Checksums[i], &NrOfEpochs[i]))
+        {
+            perror(argv[FirstFile + i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < NrOfThreads; i++)
+    {
+        Threads[i].FileName   = argv[FirstFile + i % NrOfFiles];
+        Threads[i].NrOfRounds = (uint32_t)NrOfRounds;
+
+        if (pthread_create(&ThreadIds[i], NULL, check_Thread, &Threads[i]) != 0)
+        {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < NrOfThreads; i++)
+    {
+        pthread_join(ThreadIds[i], NULL);
+    }
+
+    for (i = 0; i < NrOfThreads; i++)
+    {
+        const check_Thread_t* const Thread = &Threads[i];
+        const int File = i % NrOfFiles;
+
+        if (Thread->Failed || Thread->NrOfMismatches != 0 ||
+            Thread->Checksum != Checksums[File] || Thread->NrOfEpochs != NrOfEpochs[File])
+        {
+            printf("thread %d, %s: %s\n", i, Thread->FileName,
+                   Thread->Failed ? "decoding failed" : "the decoded epochs differ");
+            Errors++;
+        }
+    }
+
+    printf("check_threads: %d threads x %d rounds on %d files, %d mismatches\n",
+           NrOfThreads, NrOfRounds, NrOfFiles, Errors);
+
+    free(NrOfEpochs);
+    free(Checksums);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+/*
+ * check_time.c: Check the conversions of the GPS time to UTC and to ISO
+ *               8601 text of sbftime.c (see the "check" target of the
+ *               Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The times of Times[] are around the first leap second (inserted at
+   the end of 1981-06-30) and the last one (at the end of 2016-12-31),
+   with the second 23:59:60 written in the ISO format and the UTC time
+   in ns repeating 23:59:59, and the time of a known "sbf2asc -Z iso"
+   output.  The ISO text is also checked against the date of gmtime()
+   outside the leap seconds, every 6 hours from 1980 to 2040.
+
+   usage: check_time  (prints the mismatches, exits with 1 if any) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sbftime.h"
+
+#define NS_PER_SECOND  1000000000LL
+
+static const struct
+{
+    int64_t     GPSTime_ns;
+    int32_t     Leap;
+    uint32_t    Decimals;
+    const char* ISO;
+    int64_t     UTCTime_s;    /* Unix time of the UTC second */
+} Times[] =
+{
+    {  46828799LL * NS_PER_SECOND,              0, 0, "1981-06-30T23:59:59Z",      362793599},
+    {  46828800LL * NS_PER_SECOND,              1, 0, "1981-06-30T23:59:60Z",      362793599},
+    {  46828800LL * NS_PER_SECOND + 500000000,  1, 3, "1981-06-30T23:59:60.500Z",  362793599},
+    {  46828801LL * NS_PER_SECOND,              1, 0, "1981-07-01T00:00:00Z",      362793600},
+    {  46828799LL * NS_PER_SECOND + 996000000,  0, 2, "1981-06-30T23:59:60.00Z",   362793599},
+    {1167264016LL * NS_PER_SECOND,             17, 0, "2016-12-31T23:59:59Z",     1483228799},
+    {1167264017LL * NS_PER_SECOND,             18, 0, "2016-12-31T23:59:60Z",     1483228799},
+    {1167264017LL * NS_PER_SECOND + 999000000, 18, 3, "2016-12-31T23:59:60.999Z", 1483228799},
+    {1167264018LL * NS_PER_SECOND,             18, 0, "2017-01-01T00:00:00Z",     1483228800},
+    {1391385600LL * NS_PER_SECOND,             18, 2, "2024-02-07T23:59:42.00Z",  1707350382}
+};
+
+static uint32_t NrOfChecks;
+static uint32_t Errors;
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Text(const char* What,
+                       const char* Text,
+                       const char* Expected)
+{
+    if (strcmp(Text, Expected) != 0)
+    {
+        printf("%s: \"%s\" instead of \"%s\"\n", What, Text, Expected);
+        Errors++;
+    }
+
+    NrOfChecks++;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Times(void)
+{
+    char     Text[SBFTIME_TEXT_SIZE];
+    char     Expected[SBFTIME_TEXT_SIZE];
+    char     What[64];
+    uint32_t i;
+
+    for (i = 0; i < sizeof(Times) / sizeof(Times[0]); i++)
+    {
+        int64_t GPSTime_ns = Times[i].GPSTime_ns;
+
+        (void)snprintf(What, sizeof(What), "GPS time %lld ns", (long long)GPSTime_ns);
+
+        (void)sbftime_Print(Text, SBFTIME_ISO, GPSTime_ns, Times[i].Decimals);
+        check_Text(What, Text, Times[i].ISO);
+
+        (void)snprintf(Text, sizeof(Text), "%d", (int)sbftime_GetLeapSeconds(GPSTime_ns));
+        (void)snprintf(Expected, sizeof(Expected), "%d", (int)Times[i].Leap);
+        check_Text(What, Text, Expected);
+
+        (void)sbftime_Print(Text, SBFTIME_UTCNS, GPSTime_ns, 0);
+        (void)snprintf(Expected, sizeof(Expected), "%lld",
+                       (long long)(Times[i].UTCTime_s * NS_PER_SECOND + GPSTime_ns % NS_PER_SECOND));
+        check_Text(What, Text, Expected);
+    }
+
+    /* WNc 2300 (2024-02-04) at TOW 4 days */
+    (void)snprintf(Text, sizeof(Text), "%lld", (long long)sbftime_GetGPSTime_ns(2300, 345600000));
+    check_Text("sbftime_GetGPSTime_ns(2300, 345600000)", Text, "1391385600000000000");
+
+    (void)sbftime_Print(Text, SBFTIME_GPS, 1391385600LL * NS_PER_SECOND + 123456789, 3);
+    check_Text("GPS seconds with 3 decimals", Text, "1391385600.123");
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void check_Dates(void)
+/* the civil dates of the ISO text against gmtime() */
+{
+    char    Text[SBFTIME_TEXT_SIZE];
+    char    Expected[SBFTIME_TEXT_SIZE];
+    char    What[64];
+    int64_t GPSTime_s;
+
+    for (GPSTime_s = 0; GPSTime_s < 60LL * 365 * 86400; GPSTime_s += 6 * 3600 + 1)
+    {
+        int64_t    GPSTime_ns = GPSTime_s * NS_PER_SECOND;
+        time_t     UTCTime_s  = (time_t)(sbftime_GetUTCTime_ns(GPSTime_ns) / NS_PER_SECOND);
+        struct tm* Date       = gmtime(&UTCTime_s);
+
+        (void)sbftime_Print(Text, SBFTIME_ISO, GPSTime_ns, 0);
+
+        if (Date == NULL || strcmp(Text + 17, "60Z") == 0)
+        {
+            continue;
+        }
+
+        (void)strftime(Expected, sizeof(Expected), "%Y-%m-%dT%H:%M:%SZ", Date);
+        (void)snprintf(What, sizeof(What), "GPS time %lld s", (long long)GPSTime_s);
+        check_Text(What, Text, Expected);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(void)
+{
+    check_Times();
+    check_Dates();
+
+    printf("check_time: %u checks, %u mismatches\n", NrOfChecks, Errors);
+
+    return Errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,849 @@
+/*
+ * sbfgen.c: Generator of synthetic SBF measurement files, for the
+ *           checks and benchmarks of the decoder (see the "check" and
+ *           "bench" targets of the Makefile).
+ *
+ * Septentrio grants permission to use, copy, modify, and/or distribute
+ * this software for any purpose with or without fee.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND SEPTENTRIO DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL
+ * SEPTENTRIO BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* The blocks are well-formed (sync, CRC, sub-block layout, reference
+   and delta epochs of Meas3), but the observables are random bits: the
+   files exercise every path of the decoder, not realistic values.  The
+   same options and seed always give the same file.
+
+   usage: sbfgen [-3|-E] [-e Epochs] [-n Satellites] [-a Antennas]
+                 [-f mixed|short|long|delta] [-s Seed] file.sbf
+
+     -3  Meas3 blocks (Meas3Ranges, Meas3Doppler, Meas3CN0HiRes,
+         Meas3PP, Meas3MP), the default
+     -E  MeasEpoch, MeasExtra and MeasFullRange blocks
+     -e  number of epochs at 10 Hz (default 1000)
+     -n  number of satellites per epoch and per antenna, spread over
+         all constellations (default 40, at most 100)
+     -a  number of antennas (default 1)
+     -f  format of the Meas3 master and slave sub-blocks: the "short",
+         "long" or "delta" formats only (the reference epochs still use
+         the long format with "delta"), or all of them (default)
+     -s  seed of the random generator (default 1)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../crc.h"
+
+#define SBFGEN_MAX_BLOCK   65536
+#define SBFGEN_NR_OF_SYS   7
+#define SBFGEN_MAX_SATS    100
+#define SBFGEN_MAX_ANT     3
+#define SBFGEN_TOW0_MS     345600000
+#define SBFGEN_WNC         2300
+#define SBFGEN_STEP_MS     100
+#define SBFGEN_REFCODE     2        /* reference epoch every 1000 ms */
+#define SBFGEN_REFINT_MS   1000
+
+typedef enum
+{
+    FORMAT_MIXED,
+    FORMAT_SHORT,
+    FORMAT_LONG,
+    FORMAT_DELTA
+} sbfgen_Format_t;
+
+/* number of satellites that can be coded for each Meas3 constellation
+   (GPS, GLONASS, Galileo, BeiDou, SBAS, QZSS, NavIC) so that their
+   SVIDs are valid */
+static const uint32_t SatCap[SBFGEN_NR_OF_SYS] = { 32, 24, 36, 63, 39, 10, 14 };
+
+typedef struct
+{
+    bool              Valid;
+    uint8_t           SatData[32];
+    uint32_t          SatDataLength;
+    uint32_t          NrOfSats;
+    uint32_t          SlaveMask[64];
+} sbfgen_RefSys_t;
+
+typedef struct
+{
+    uint64_t          Rand;
+    FILE*             F;
+    uint32_t          NrOfSats;
+    uint32_t          NrOfAnt;
+    sbfgen_Format_t   Format;
+    bool              PRRate;
+    sbfgen_RefSys_t   Ref[SBFGEN_MAX_ANT][SBFGEN_NR_OF_SYS];
+    uint8_t           Body[SBFGEN_MAX_BLOCK];
+    uint32_t          Length;
+} sbfgen_t;
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfgen_Rand(sbfgen_t* Gen)
+/* xorshift64* */
+{
+    Gen->Rand ^= Gen->Rand >> 12;
+    Gen->Rand ^= Gen->Rand << 25;
+    Gen->Rand ^= Gen->Rand >> 27;
+
+    return (uint32_t)((Gen->Rand * 2685821657736338717ULL) >> 32);
+}
+
+static uint32_t sbfgen_RandInt(sbfgen_t* Gen, uint32_t Min, uint32_t Max)
+{
+    return Min + sbfgen_Rand(Gen) % (Max - Min + 1);
+}
+
+static bool sbfgen_Chance(sbfgen_t* Gen, uint32_t Percent)
+{
+    return sbfgen_Rand(Gen) % 100 < Percent;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_Put(sbfgen_t* Gen, const void* Data, uint32_t Length)
+{
+    memcpy(Gen->Body + Gen->Length, Data, Length);
+    Gen->Length += Length;
+}
+
+static void sbfgen_PutU8(sbfgen_t* Gen, uint32_t Value)
+{
+    Gen->Body[Gen->Length++] = (uint8_t)Value;
+}
+
+static void sbfgen_PutU16(sbfgen_t* Gen, uint32_t Value)
+{
+    sbfgen_PutU8(Gen, Value);
+    sbfgen_PutU8(Gen, Value >> 8);
+}
+
+static void sbfgen_PutU32(sbfgen_t* Gen, uint32_t Value)
+{
+    sbfgen_PutU16(Gen, Value);
+    sbfgen_PutU16(Gen, Value >> 16);
+}
+
+static void sbfgen_PutRandom(sbfgen_t* Gen, uint32_t Length)
+{
+    uint32_t i;
+
+    for (i = 0; i < Length; i++)
+    {
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen));
+    }
+}
+
+static void sbfgen_PutZeros(sbfgen_t* Gen, uint32_t Length)
+{
+    memset(Gen->Body + Gen->Length, 0, Length);
+    Gen->Length += Length;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_StartBlock(sbfgen_t* Gen, uint32_t TOW_ms)
+/* the header is written by sbfgen_EndBlock() */
+{
+    Gen->Length = 8;
+    sbfgen_PutU32(Gen, TOW_ms);
+    sbfgen_PutU16(Gen, SBFGEN_WNC);
+}
+
+static void sbfgen_EndBlock(sbfgen_t* Gen, uint32_t Number, uint32_t Rev)
+{
+    uint32_t Length = (Gen->Length + 3) & ~3U;
+    uint16_t CRC;
+
+    memset(Gen->Body + Gen->Length, 0, Length - Gen->Length);
+
+    Gen->Body[0] = '$';
+    Gen->Body[1] = '@';
+    Gen->Body[4] = (uint8_t)Number;
+    Gen->Body[5] = (uint8_t)((Number >> 8) | (Rev << 5));
+    Gen->Body[6] = (uint8_t)Length;
+    Gen->Body[7] = (uint8_t)(Length >> 8);
+
+    CRC = CRC_compute16CCITT(Gen->Body + 4, Length - 4);
+    Gen->Body[2] = (uint8_t)CRC;
+    Gen->Body[3] = (uint8_t)(CRC >> 8);
+
+    if (fwrite(Gen->Body, 1, Length, Gen->F) != Length)
+    {
+        perror("sbfgen");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_PickSatellites(sbfgen_t* Gen,
+                                  uint64_t  SatMask[SBFGEN_NR_OF_SYS])
+/* draw NrOfSats distinct satellites, spread over the constellations */
+{
+    uint32_t NrOfSats[SBFGEN_NR_OF_SYS] = { 0 };
+    uint32_t Total = 0;
+    uint32_t Sys;
+
+    while (Total < Gen->NrOfSats)
+    {
+        for (Sys = 0; Sys < SBFGEN_NR_OF_SYS && Total < Gen->NrOfSats; Sys++)
+        {
+            if (NrOfSats[Sys] < SatCap[Sys])
+            {
+                NrOfSats[Sys]++;
+                Total++;
+            }
+        }
+    }
+
+    for (Sys = 0; Sys < SBFGEN_NR_OF_SYS; Sys++)
+    {
+        uint32_t n = 0;
+
+        SatMask[Sys] = 0;
+
+        while (n < NrOfSats[Sys])
+        {
+            uint64_t Bit = 1ULL << sbfgen_RandInt(Gen, 0, SatCap[Sys] - 1);
+
+            if ((SatMask[Sys] & Bit) == 0)
+            {
+                SatMask[Sys] |= Bit;
+                n++;
+            }
+        }
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfgen_PutSatData(sbfgen_t*        Gen,
+                                  uint32_t         Sys,
+                                  uint64_t         SatMask,
+                                  sbfgen_RefSys_t* Ref)
+/* write the satellite mask of a constellation and keep it as the
+   reference.  Returns the index of the master signal in the
+   MasterShort sub-blocks. */
+{
+    uint32_t Start = Gen->Length;
+    uint32_t NrOfSats = (uint32_t)__builtin_popcountll(SatMask);
+    uint32_t Bytes = (64 - (uint32_t)__builtin_clzll(SatMask) + 7) / 8;
+    uint32_t MasterShortSigIdx = sbfgen_RandInt(Gen, 0, 5);
+    bool     SigExcluded = sbfgen_Chance(Gen, 30);
+    uint32_t i;
+
+    if (Bytes == 7)
+    {
+        Bytes = 8;
+    }
+
+    sbfgen_PutU8(Gen, (Bytes == 8 ? 7 : Bytes) | (MasterShortSigIdx << 3) | (SigExcluded ? 0x80 : 0));
+
+    for (i = 0; i < Bytes; i++)
+    {
+        sbfgen_PutU8(Gen, (uint32_t)(SatMask >> (8 * i)));
+    }
+
+    if (Sys == 1)
+    {
+        /* GLONASS frequency numbers */
+        for (i = 0; i < (NrOfSats + 1) / 2; i++)
+        {
+            sbfgen_PutU8(Gen, sbfgen_RandInt(Gen, 1, 14) | (sbfgen_RandInt(Gen, 1, 14) << 4));
+        }
+    }
+
+    if (Sys == 3)
+    {
+        /* BeiDou long range flags */
+        sbfgen_PutU16(Gen, sbfgen_Rand(Gen));
+    }
+
+    if (SigExcluded)
+    {
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen) & sbfgen_Rand(Gen));
+    }
+
+    Ref->Valid         = true;
+    Ref->NrOfSats      = NrOfSats;
+    Ref->SatDataLength = Gen->Length - Start;
+    memcpy(Ref->SatData, Gen->Body + Start, Ref->SatDataLength);
+
+    return MasterShortSigIdx;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfgen_PutMaster(sbfgen_t* Gen,
+                                 bool      Fresh,
+                                 uint32_t  MasterShortSigIdx,
+                                 uint32_t  RefSlaveMask)
+/* write a master sub-block: MasterShort or MasterLong if Fresh (no
+   reference for the satellite), MasterDeltaL or MasterDeltaS
+   otherwise.  Returns the mask of the slave signals that follow. */
+{
+    bool Short;
+
+    if (!Fresh)
+    {
+        if (Gen->Format == FORMAT_DELTA ||
+            (Gen->Format == FORMAT_MIXED && !sbfgen_Chance(Gen, 10)))
+        {
+            if (sbfgen_Chance(Gen, 50))
+            {
+                /* MasterDeltaL */
+                sbfgen_PutU8(Gen, ((sbfgen_Rand(Gen) & 0xf) << 4) | 0xe);
+                sbfgen_PutRandom(Gen, 4);
+            }
+            else
+            {
+                /* MasterDeltaS */
+                static const uint32_t Tag[3] = { 0x2, 0x6, 0xa };
+
+                sbfgen_PutU32(Gen, (sbfgen_Rand(Gen) & ~0xfU) | Tag[sbfgen_RandInt(Gen, 0, 2)]);
+            }
+
+            return RefSlaveMask;
+        }
+    }
+
+    Short = (Gen->Format == FORMAT_SHORT ||
+             (Gen->Format == FORMAT_MIXED && sbfgen_Chance(Gen, 50)));
+
+    if (Short)
+    {
+        uint32_t BF1 = sbfgen_Rand(Gen) | 1;
+
+        sbfgen_PutU32(Gen, BF1);
+        sbfgen_PutU32(Gen, sbfgen_Rand(Gen));
+
+        if (Gen->PRRate)
+        {
+            sbfgen_PutRandom(Gen, 2);
+        }
+
+        return ((BF1 >> 28) & 0xf) << (MasterShortSigIdx + 1);
+    }
+    else
+    {
+        uint32_t SigMask = 0;
+        uint32_t Cont = sbfgen_Chance(Gen, 20) ? 1 : 0;
+        uint32_t BF3 = sbfgen_Rand(Gen) & 0xff;
+        uint32_t Full;
+
+        while (SigMask == 0)
+        {
+            SigMask = sbfgen_Rand(Gen) & sbfgen_Rand(Gen) & 0x1ff;
+        }
+
+        sbfgen_PutU32(Gen, sbfgen_Rand(Gen) & ~3U);
+        sbfgen_PutU32(Gen, sbfgen_Rand(Gen));
+        sbfgen_PutU16(Gen, (sbfgen_Rand(Gen) & 0x3f) | (SigMask << 6) | (Cont << 15));
+
+        if (Cont)
+        {
+            sbfgen_PutU8(Gen, BF3);
+        }
+
+        if (Gen->PRRate)
+        {
+            sbfgen_PutRandom(Gen, 2);
+        }
+
+        Full = SigMask | (Cont ? (BF3 & 0x7f) << 9 : 0);
+
+        /* the master is the first signal */
+        return Full & (Full - 1);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_PutSlave(sbfgen_t* Gen,
+                            bool      Fresh)
+/* write a slave sub-block: SlaveShort or SlaveLong if Fresh,
+   otherwise any format */
+{
+    sbfgen_Format_t Format = Gen->Format;
+
+    if (Format == FORMAT_MIXED || (Format == FORMAT_DELTA && Fresh))
+    {
+        uint32_t r = sbfgen_RandInt(Gen, 0, 99);
+
+        Format = (r < 40) ? FORMAT_SHORT : (r < 70 || Fresh) ? FORMAT_LONG : FORMAT_DELTA;
+    }
+
+    switch (Format)
+    {
+    case FORMAT_SHORT:
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen) | 1);
+        sbfgen_PutRandom(Gen, 4);
+        break;
+
+    case FORMAT_LONG:
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen) & ~3U);
+        sbfgen_PutRandom(Gen, 6);
+        break;
+
+    default:
+        sbfgen_PutU8(Gen, (sbfgen_Rand(Gen) & ~3U) | 2);
+        sbfgen_PutRandom(Gen, 2);
+        break;
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_Meas3Epoch(sbfgen_t* Gen,
+                              uint32_t  TOW_ms)
+/* write the Meas3 blocks of all antennas for an epoch */
+{
+    bool     RefEpoch = (TOW_ms % SBFGEN_REFINT_MS == 0);
+    uint64_t SatMask[SBFGEN_NR_OF_SYS];
+    uint32_t Ant, Sys;
+
+    if (RefEpoch)
+    {
+        Gen->PRRate = sbfgen_Chance(Gen, 50);
+    }
+
+    for (Ant = 0; Ant < Gen->NrOfAnt; Ant++)
+    {
+        uint32_t NrOfMeas = 0;
+        uint32_t n, i;
+
+        sbfgen_PickSatellites(Gen, SatMask);
+
+        sbfgen_StartBlock(Gen, TOW_ms);
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen) & 0x6b);      /* CommonFlags */
+        sbfgen_PutU8(Gen, sbfgen_Rand(Gen));             /* CumClkJumps */
+        sbfgen_PutU16(Gen, (1U << SBFGEN_NR_OF_SYS) - 1); /* Constellations */
+        sbfgen_PutU8(Gen, Ant | (Gen->PRRate ? 8 : 0) | (SBFGEN_REFCODE << 4));
+        sbfgen_PutU8(Gen, 0);
+
+        for (Sys = 0; Sys < SBFGEN_NR_OF_SYS; Sys++)
+        {
+            sbfgen_RefSys_t* Ref = &(Gen->Ref[Ant][Sys]);
+            bool     Fresh = (RefEpoch || !Ref->Valid);
+            uint32_t MasterShortSigIdx = 0;
+            uint32_t Sat;
+
+            if (Fresh)
+            {
+                MasterShortSigIdx = sbfgen_PutSatData(Gen, Sys, SatMask[Sys], Ref);
+            }
+            else if (sbfgen_Chance(Gen, 50))
+            {
+                /* same satellites as in the reference epoch */
+                sbfgen_PutU8(Gen, 0);
+                MasterShortSigIdx = (Ref->SatData[0] >> 3) & 0x7;
+            }
+            else
+            {
+                sbfgen_Put(Gen, Ref->SatData, Ref->SatDataLength);
+                MasterShortSigIdx = (Ref->SatData[0] >> 3) & 0x7;
+            }
+
+            for (Sat = 0; Sat < Ref->NrOfSats; Sat++)
+            {
+                uint32_t SlaveMask = sbfgen_PutMaster(Gen, Fresh, MasterShortSigIdx, Ref->SlaveMask[Sat]);
+                uint32_t Slaves = (uint32_t)__builtin_popcount(SlaveMask & 0xfffe);
+
+                if (Fresh)
+                {
+                    Ref->SlaveMask[Sat] = SlaveMask;
+                }
+
+                NrOfMeas += 1 + Slaves;
+
+                for (i = 0; i < Slaves; i++)
+                {
+                    sbfgen_PutSlave(Gen, Fresh);
+                }
+            }
+        }
+
+        sbfgen_EndBlock(Gen, 4109, 0);
+
+        /* Meas3Doppler: 1 to 4 bytes per measurement */
+        sbfgen_StartBlock(Gen, TOW_ms);
+        sbfgen_PutU16(Gen, Ant);
+
+        for (n = 0; n < NrOfMeas; n++)
+        {
+            uint32_t Bytes = sbfgen_RandInt(Gen, 1, 4);
+            uint32_t v = sbfgen_Rand(Gen);
+
+            switch (Bytes)
+            {
+            case 1:
+                sbfgen_PutU8(Gen, v & ~2U);
+                break;
+
+            case 2:
+                sbfgen_PutU16(Gen, (v & ~6U) | 2);
+                break;
+
+            case 3:
+                sbfgen_PutU16(Gen, (v & ~0xeU) | 6);
+                sbfgen_PutU8(Gen, v >> 16);
+                break;
+
+            default:
+                sbfgen_PutU32(Gen, v | 0xe);
+                break;
+            }
+        }
+
+        sbfgen_PutZeros(Gen, 8);
+        sbfgen_EndBlock(Gen, 4111, 0);
+
+        /* Meas3CN0HiRes: 4 bits per measurement */
+        sbfgen_StartBlock(Gen, TOW_ms);
+        sbfgen_PutU16(Gen, Ant);
+        sbfgen_PutRandom(Gen, (NrOfMeas + 1) / 2 + 2);
+        sbfgen_EndBlock(Gen, 4110, 0);
+
+        /* Meas3PP: first and second part */
+        {
+            uint32_t Start2 = (((NrOfMeas * 5 + 7) / 8 + 2 + 3) / 4) * 4;
+            bool     Part2  = sbfgen_Chance(Gen, 70);
+
+            sbfgen_StartBlock(Gen, TOW_ms);
+            sbfgen_PutU16(Gen, Ant | (Part2 ? (Start2 / 4) << 8 : 0));
+            sbfgen_PutRandom(Gen, Start2);
+
+            if (Part2)
+            {
+                sbfgen_PutU8(Gen, (sbfgen_Rand(Gen) & 0xf) << 4);
+                sbfgen_PutRandom(Gen, 1 + (NrOfMeas * 6 + 7) / 8 + 4);
+            }
+
+            sbfgen_PutZeros(Gen, 4);
+            sbfgen_EndBlock(Gen, 4112, 0);
+        }
+
+        /* Meas3MP: 21 bits per measurement */
+        sbfgen_StartBlock(Gen, TOW_ms);
+        sbfgen_PutU16(Gen, Ant);
+        sbfgen_PutRandom(Gen, (NrOfMeas * 21 + 7) / 8 + 4);
+        sbfgen_EndBlock(Gen, 4113, 0);
+    }
+}
+
+
+/*---------------------------------------------------------------------------*/
+static uint32_t sbfgen_PickSignals(sbfgen_t* Gen,
+                                   uint32_t  SVID,
+                                   uint8_t   Signals[4])
+/* draw 1 to 4 distinct signal types of a satellite */
+{
+    static const uint8_t GPS[] = { 0, 1, 2, 3, 4, 5 };
+    static const uint8_t GLO[] = { 8, 9, 10, 11, 12 };
+    static const uint8_t GAL[] = { 17, 19, 20, 21, 22 };
+    static const uint8_t SBS[] = { 24, 25 };
+    static const uint8_t BDS[] = { 28, 29, 30, 13, 14, 34 };
+    static const uint8_t QZS[] = { 6, 7, 26, 27, 32, 33 };
+    static const uint8_t IRN[] = { 15, 37 };
+    const uint8_t* List;
+    uint32_t Size, Count, n = 0;
+
+#define SBFGEN_LIST(l) (List = (l), Size = sizeof(l))
+    if (SVID <= 37)       SBFGEN_LIST(GPS);
+    else if (SVID <= 70)  SBFGEN_LIST(GLO);
+    else if (SVID <= 106) SBFGEN_LIST(GAL);
+    else if (SVID <= 140) SBFGEN_LIST(SBS);
+    else if (SVID <= 180 || SVID >= 223) SBFGEN_LIST(BDS);
+    else if (SVID <= 190) SBFGEN_LIST(QZS);
+    else                  SBFGEN_LIST(IRN);
+#undef SBFGEN_LIST
+
+    Count = sbfgen_RandInt(Gen, 1, Size < 4 ? Size : 4);
+
+    while (n < Count)
+    {
+        uint8_t  Sig = List[sbfgen_RandInt(Gen, 0, Size - 1)];
+        uint32_t i;
+
+        for (i = 0; i < n && Signals[i] != Sig; i++)
+        {
+        }
+
+        if (i == n)
+        {
+            Signals[n++] = Sig;
+        }
+    }
+
+    return Count;
+}
+
+
+/*---------------------------------------------------------------------------*/
+static void sbfgen_MeasEpochEpoch(sbfgen_t* Gen,
+                                  uint32_t  TOW_ms)
+/* write the MeasEpoch, MeasExtra and MeasFullRange blocks of an epoch */
+{
+    static const uint8_t SVIDRange[][2] =
+    {
+        { 1, 37 }, { 38, 61 }, { 63, 68 }, { 71, 106 }, { 120, 140 },
+        { 141, 180 }, { 181, 190 }, { 191, 197 }, { 223, 245 }
+    };
+    uint8_t  SVIDs[256];
+    uint32_t NrOfSVIDs = 0;
+    uint8_t  Extra[SBFGEN_MAX_SATS * 4][3];    /* RxChannel, Type, Signal */
+    uint32_t NrOfExtra = 0;
+    uint32_t NrOfType1 = 0;
+    uint32_t NrOfSats = Gen->NrOfSats;
+    uint32_t Channel = 1;
+    uint32_t ExtraSize = sbfgen_Chance(Gen, 50) ? 16 : 20;
+    uint32_t i, j, k;
+
+    for (i = 0; i < sizeof(SVIDRange) / sizeof(SVIDRange[0]); i++)
+    {
+        for (j = SVIDRange[i][0]; j <= SVIDRange[i][1]; j++)
+        {
+            SVIDs[NrOfSVIDs++] = (uint8_t)j;
+        }
+    }
+
+    if (NrOfSats * Gen->NrOfAnt > SBFGEN_MAX_SATS)
+    {
+        NrOfSats = SBFGEN_MAX_SATS / Gen->NrOfAnt;
+    }
+
+    /* the satellites are the first NrOfSats SVIDs after a shuffle */
+    for (i = 0; i < NrOfSats; i++)
+    {
+        uint32_t Pick = sbfgen_RandInt(Gen, i, NrOfSVIDs - 1);
+        uint8_t  Tmp = SVIDs[i];
+
+        SVIDs[i] = SVIDs[Pick];
+        SVIDs[Pick] = Tmp;
+    }
+
+    sbfgen_StartBlock(Gen, TOW_ms);
+    sbfgen_PutZeros(Gen, 1);                      /* N1, set below */
+    sbfgen_PutU8(Gen, 20);                        /* SB1Length */
+    sbfgen_PutU8(Gen, 12);                        /* SB2Length */
+    sbfgen_PutU8(Gen, sbfgen_Rand(Gen) & 0x6b);   /* CommonFlags */
+    sbfgen_PutU8(Gen, sbfgen_Rand(Gen));          /* CumClkJumps */
+    sbfgen_PutU8(Gen, 0);
+
+    for (i = 0; i < NrOfSats; i++)
+    {
+        uint32_t SVID = SVIDs[i];
+        uint32_t FreqNr = sbfgen_RandInt(Gen, 1, 14);
+
+        for (j = 0; j < Gen->NrOfAnt; j++)
+        {
+            uint8_t  Signals[4];
+            uint32_t NrOfSignals = sbfgen_PickSignals(Gen, SVID, Signals);
+
+            for (k = 0; k < NrOfSignals; k++)
+            {
+                uint32_t Type = Signals[k] >= 32 ? 31 : Signals[k];
+                uint32_t ObsInfo = (Signals[k] >= 32 ? (Signals[k] - 32U) << 3 :
+                                    (SVID >= 38 && SVID <= 70) ? FreqNr << 3 :
+                                    (sbfgen_Rand(Gen) & 0x1f) << 3) |
+                                   (sbfgen_Rand(Gen) & 4);
+
+                if (k == 0)
+                {
+                    /* Type1 sub-block */
+                    sbfgen_PutU8(Gen, Channel);
+                    sbfgen_PutU8(Gen, Type | (j << 5));
+                    sbfgen_PutU8(Gen, SVID);
+                    sbfgen_PutU8(Gen, sbfgen_Rand(Gen) & 0xf);
+                    sbfgen_PutU32(Gen, sbfgen_Rand(Gen));
+                    sbfgen_PutU32(Gen, sbfgen_Chance(Gen, 5) ? 0x80000000U : sbfgen_Rand(Gen) >> 1);
+                    sbfgen_PutU16(Gen, sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, sbfgen_Chance(Gen, 50) ? 255 : sbfgen_Rand(Gen));
+                    sbfgen_PutU16(Gen, sbfgen_Chance(Gen, 30) ? 65535 : sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, ObsInfo);
+                    sbfgen_PutU8(Gen, NrOfSignals - 1);
+                    NrOfType1++;
+                }
+                else
+                {
+                    /* Type2 sub-block */
+                    sbfgen_PutU8(Gen, Type | (j << 5));
+                    sbfgen_PutU8(Gen, sbfgen_Chance(Gen, 50) ? 255 : sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, sbfgen_Chance(Gen, 50) ? 255 : sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, sbfgen_Rand(Gen));
+                    sbfgen_PutU8(Gen, ObsInfo);
+                    sbfgen_PutRandom(Gen, 6);
+                }
+
+                if (sbfgen_Chance(Gen, 80))
+                {
+                    Extra[NrOfExtra][0] = (uint8_t)Channel;
+                    Extra[NrOfExtra][1] = (uint8_t)(Type | (j << 5));
+                    Extra[NrOfExtra][2] = Signals[k];
+                    NrOfExtra++;
+                }
+            }
+
+            Channel++;
+        }
+    }
+
+    Gen->Body[14] = (uint8_t)NrOfType1;
+    sbfgen_EndBlock(Gen, 4027, 1);
+
+    /* MeasExtra */
+    sbfgen_StartBlock(Gen, TOW_ms);
+    sbfgen_PutU8(Gen, NrOfExtra);
+    sbfgen_PutU8(Gen, ExtraSize);
+    sbfgen_PutU32(Gen, 0x42c80000);               /* DopplerVarFactor 100.0 */
+
+    for (i = 0; i < NrOfExtra; i++)
+    {
+        sbfgen_PutU8(Gen, Extra[i][0]);
+        sbfgen_PutU8(Gen, Extra[i][1]);
+        sbfgen_PutRandom(Gen, 12);
+        sbfgen_PutU8(Gen, Extra[i][2] < 32 ? sbfgen_Rand(Gen) : ((Extra[i][2] - 32U) << 3) | (sbfgen_Rand(Gen) & 7));
+        sbfgen_PutZeros(Gen, ExtraSize - 15);
+    }
+
+    sbfgen_EndBlock(Gen, 4000, 3);
+
+    /* MeasFullRange, for the first signals with extra data */
+    sbfgen_StartBlock(Gen, TOW_ms);
+    sbfgen_PutU8(Gen, NrOfExtra < 255 ? NrOfExtra : 255);
+    sbfgen_PutU8(Gen, 16);
+    sbfgen_PutU32(Gen, 0);
+
+    for (i = 0; i < NrOfExtra && i < 255; i++)
+    {
+        sbfgen_PutU8(Gen, Extra[i][0]);
+        sbfgen_PutU8(Gen, Extra[i][2]);
+        sbfgen_PutU8(Gen, 0);
+        sbfgen_PutU8(Gen, (Extra[i][1] >> 5) << 5);
+        sbfgen_PutU32(Gen, sbfgen_Rand(Gen));
+        sbfgen_PutU32(Gen, 0x41700000);           /* 2^24 < PR_m < 2^25 */
+        sbfgen_PutU32(Gen, 0);
+    }
+
+    sbfgen_EndBlock(Gen, 4098, 0);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    static sbfgen_t Gen;
+    uint32_t    NrOfEpochs = 1000;
+    bool        Meas3 = true;
+    const char* FileName = NULL;
+    uint32_t    Epoch;
+    int         i;
+
+    Gen.Rand     = 1;
+    Gen.NrOfSats = 40;
+    Gen.NrOfAnt  = 1;
+    Gen.Format   = FORMAT_MIXED;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char* Value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (strcmp(argv[i], "-3") == 0)
+        {
+            Meas3 = true;
+        }
+        else if (strcmp(argv[i], "-E") == 0)
+        {
+            Meas3 = false;
+        }
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            NrOfEpochs = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (strcmp(argv[i], "-n") == 0)
+        {
+            Gen.NrOfSats = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            Gen.NrOfAnt = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            Gen.Rand = (uint64_t)atoi(Value) * 0x9e3779b97f4a7c15ULL + 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "-f") == 0)
+        {
+            Gen.Format = (strcmp(Value, "short") == 0) ? FORMAT_SHORT :
+                         (strcmp(Value, "long") == 0)  ? FORMAT_LONG  :
+                         (strcmp(Value, "delta") == 0) ? FORMAT_DELTA : FORMAT_MIXED;
+            i++;
+        }
+        else if (argv[i][0] != '-' && FileName == NULL)
+        {
+            FileName = argv[i];
+        }
+        else
+        {
+            FileName = NULL;
+            break;
+        }
+    }
+
+    if (FileName == NULL || Gen.NrOfSats < 1 || Gen.NrOfSats > SBFGEN_MAX_SATS ||
+        Gen.NrOfAnt < 1 || Gen.NrOfAnt > SBFGEN_MAX_ANT)
+    {
+        fprintf(stderr, "usage: sbfgen [-3|-E] [-e Epochs] [-n Satellites (1-%d)] [-a Antennas (1-%d)]\n"
+                "              [-f mixed|short|long|delta] [-s Seed] file.sbf\n",
+                SBFGEN_MAX_SATS, SBFGEN_MAX_ANT);
+        return EXIT_FAILURE;
+    }
+
+    if ((Gen.F = fopen(FileName, "wb")) == NULL)
+    {
+        perror(FileName);
+        return EXIT_FAILURE;
+    }
+
+    for (Epoch = 0; Epoch < NrOfEpochs; Epoch++)
+    {
+        uint32_t TOW_ms = SBFGEN_TOW0_MS + Epoch * SBFGEN_STEP_MS;
+
+        if (Meas3)
+        {
+            sbfgen_Meas3Epoch(&Gen, TOW_ms);
+        }
+        else
+        {
+            sbfgen_MeasEpochEpoch(&Gen, TOW_ms);
+        }
+    }
+
+    if (fclose(Gen.F) != 0)
+    {
+        perror(FileName);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,13 +1,11 @@
 import os
+import ctypes
+import numpy as np
 import pandas as pd
-import matplotlib.pyplot as plt
 import time
 
-# File path for bin2asc.exe
-bin2asc_path = r"bin/sbf2asc/sbf2asc"
-
-# Runs command to convert the binary to ascii and extract measurement.txt files. 
-# Takes the file that you want to convert as a parameter
+# File path for the decoder library (make libsbfread.so in bin/sbf2asc)
+libsbfread_path = r"bin/sbf2asc/libsbfread.so"
 
 def svid_to_satellite(svid):
     if 1 <= svid <= 37:
@@ -39,59 +37,86 @@ def svid_to_satellite(svid):
     else:
         return "Unknown SVID"
 
-def convert(bin_file):
-
-    start = time.time()
-    #os.system(f'cd {bin2asc_path}')
-    os.system(f'{bin2asc_path} -f files/{bin_file} -m -o files/{bin_file[:-4]}')
-    #os.system(f'{bin2asc_path} -f {bin_file} -m')
-    print(f'Time taken is {time.time() - start}')
-    
-
-# Reads file and puts data into pandas dataframe.
+# Decodes the binary file in this process with libsbfread, without any
+# intermediate text file, and yields chunks of at most chunksize rows with
+# the columns SVID, UTC (ns) and SNR (C/N0)
+
+def read_sbf(bin_file, chunksize):
+
+    lib = ctypes.CDLL(libsbfread_path, use_errno=True)
+    lib.sbfread_Lib_Open.restype = ctypes.c_void_p
+    lib.sbfread_Lib_Open.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint32, ctypes.c_uint32]
+    lib.sbfread_Lib_FillColumns.restype = ctypes.c_int32
+    lib.sbfread_Lib_FillColumns.argtypes = [ctypes.c_void_p, ctypes.c_uint32,
+                                            np.ctypeslib.ndpointer(np.int64, flags='C'),
+                                            np.ctypeslib.ndpointer(np.uint8, flags='C'),
+                                            np.ctypeslib.ndpointer(np.uint8, flags='C'),
+                                            np.ctypeslib.ndpointer(np.float64, flags='C')]
+    lib.sbfread_Lib_Close.argtypes = [ctypes.c_void_p]
+
+    # only the C/N0 of the first signal (L1CA, E1, B1I), with the time in
+    # UTC nanoseconds (SBFREAD_LIB_UTC = 1)
+    handle = lib.sbfread_Lib_Open(bin_file.encode(), b'cn0/GPSL1CA+GLOL1CA+GALE1BC+BDSB1I', 0, 1)
+    if not handle:
+        raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()), bin_file)
+
+    utc = np.empty(chunksize, np.int64)
+    svid = np.empty(chunksize, np.uint8)
+    signal = np.empty(chunksize, np.uint8)
+    snr = np.empty(chunksize, np.float64)
+
+    try:
+        while True:
+            rows = lib.sbfread_Lib_FillColumns(handle, chunksize, utc, svid, signal, snr)
+            if rows < 0:
+                raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()), bin_file)
+            if rows == 0:
+                break
+            # the arrays are filled again by the next call
+            yield pd.DataFrame({'SVID': svid[:rows].copy(), 'UTC': utc[:rows].copy(), 'SNR': snr[:rows].copy()})
+    finally:
+        lib.sbfread_Lib_Close(handle)
+
+
+# Reads the binary file and puts data into pandas dataframe.
 def read(file):
     
     start = time.time()
     global df
-    gps_epoch = pd.to_datetime('1980-01-06') #gps start time
     s4=pd.DataFrame()
 
 
    
-    cols=[0,1,4] #columns of file we want
-    names=['SVID','TOW','SNR']#dataframe namers
-    rows=2 #in case of header skip some vals
     chunksize = 10 ** 7
     df=pd.DataFrame()
     buffer=pd.DataFrame()
 
     
-    with pd.read_csv(file,header=None,delim_whitespace = True, skiprows=rows, usecols=cols, names=names, chunksize=chunksize) as reader:
-        for chunk in reader:
-            
-            chunk['datetime'] = gps_epoch + pd.to_timedelta(chunk['TOW'], unit='s')
-            chunk.set_index('datetime', inplace=True)
-            chunk.sort_values(by='datetime')
-
-            chunk['linSNR']= 10 ** (chunk['SNR'] / 10) #convert SNR from dB to linear
-            chunk.drop(['TOW', 'SNR'],inplace=True,axis=1)    #remove fields we dont need anymore
-            
-            chunk=pd.concat([chunk,buffer])
-            first_minute = chunk.index.floor('T').min() 
-            last_minute = chunk.index.floor('T').max()
-            buffer=chunk[((chunk.index.floor('T') == last_minute) | (chunk.index.floor('T') == first_minute))]
-            
-            chunk=chunk.groupby(['SVID']).resample('1min')
-            
-            
-            
-            
-            s4=chunk['linSNR'].std()/chunk['linSNR'].mean() #calculate S4
-            df = pd.concat([df, s4])
-            
-            print(f'Time taken is {time.time() - start}')
-            start = time.time()
-            
+    for chunk in read_sbf(file, chunksize):
+        
+        chunk['datetime'] = pd.to_datetime(chunk['UTC'], unit='ns') #utc time, leap seconds applied by libsbfread
+        chunk.set_index('datetime', inplace=True)
+        chunk.sort_values(by='datetime')
+
+        chunk['linSNR']= 10 ** (chunk['SNR'] / 10) #convert SNR from dB to linear
+        chunk.drop(['UTC', 'SNR'],inplace=True,axis=1)    #remove fields we dont need anymore
+        
+        chunk=pd.concat([chunk,buffer])
+        first_minute = chunk.index.floor('T').min() 
+        last_minute = chunk.index.floor('T').max()
+        buffer=chunk[((chunk.index.floor('T') == last_minute) | (chunk.index.floor('T') == first_minute))]
+        
+        chunk=chunk.groupby(['SVID']).resample('1min')
+        
+        
+        
+        
+        s4=chunk['linSNR'].std()/chunk['linSNR'].mean() #calculate S4
+        df = pd.concat([df, s4])
+        
+        print(f'Time taken is {time.time() - start}')
+        start = time.time()
+        
     df.reset_index(inplace=True)
     df[['Satellite', 'Datetime']] = df['index'].apply(pd.Series)
     df['S4']=df[0]
@@ -101,57 +126,8 @@ def read(file):
     df['Satellite'] = df['Satellite'].apply(svid_to_satellite)
         
     return df
-# Function to delete all the .txt files at the end
-def clear():
-
-    for file in os.listdir('files/'):
-
-        if file.endswith("txt"):
-
-            os.remove(f'files/{file}')
+# computes the S4 of a binary file and saves it
 
-# plots all .24_ binary files
-
-convert('sept311v15.24_')
-
-data = read('files/sept311v15')
+data = read('files/sept311v15.24_')
 
 data.to_csv(path_or_buf='test.csv')
-
-'''
-def plot_all():
-
-    for file in os.listdir('files/'):
-
-            if file.endswith(".24_"):
-                
-                current_file = f'files/{file}'
-                measurement_file = f'{current_file}_measurements.txt'
-
-                convert(current_file)
-                x = read(measurement_file)
-
-                print(x)
-
-                gps1 = x[x['3']=='G01']
-
-                # List of the types of GPS Frequencies
-                type_list = ['L1','L2','L5']
-
-                # Creates 3 subplots
-                fig, ax = plt.subplots(3)
-
-                for i in range(len(type_list)):
-
-                    plotter=gps1[gps1['4'].str.contains(type_list[i])]
-
-                    ax[i].plot(plotter['1'],plotter['9'],label=f'GPS {type_list[i]}')
-
-                    ax[i].legend(loc=1)
-
-                plt.show()
-
-                clear()
-
-plot_all()
-'''